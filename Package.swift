@@ -39,6 +39,16 @@ let package = Package(
             swiftSettings: [
                 .define("SWIFTYBT_CLI", .when(platforms: [.macOS]))
             ]
+        ),
+        // Benchmarks (run with `swift run -c release swiftybt-bench <suite>`)
+        .executableTarget(
+            name: "swiftybt-bench",
+            dependencies: ["SwiftyBitTorrent", "SwiftyBitTorrentCore"]
+        ),
+        // Alert trace decoder (`swift run swiftybt-trace <file>`)
+        .executableTarget(
+            name: "swiftybt-trace",
+            dependencies: ["SwiftyBitTorrentCore"]
         )
     ]
 )
@@ -5,8 +5,74 @@ import SwiftyBitTorrentCore
 public final class BTSession {
     private var raw: UnsafeMutablePointer<swbt_session_t>?
     private let eventQueue = DispatchQueue(label: "swiftybt.session.events")
+    private let events = BTEventHub()
+    private let addResults = BTAddResultRouter()
 
     public init(config: BTSessionConfig = .init()) {
+        self.raw = BTSession.withCConfig(config) { swbt_session_new($0) }
+        attachEvents()
+    }
+
+    /// Warm start from state written by `saveState(to:)`. A missing or unreadable file
+    /// falls back to a cold start; `startupMetrics().warmStart` tells which one happened.
+    public init(config: BTSessionConfig = .init(), stateFile: URL) {
+        self.raw = BTSession.withCConfig(config) { swbt_session_new_from_state_file($0, stateFile.path) }
+        attachEvents()
+    }
+
+    public init(config: BTSessionConfig = .init(), state: Data) {
+        self.raw = BTSession.withCConfig(config) { c in
+            state.withUnsafeBytes { buf in
+                swbt_session_new_with_state(c, buf.bindMemory(to: UInt8.self).baseAddress, Int32(buf.count))
+            }
+        }
+        attachEvents()
+    }
+
+    // The hub outlives the callback registration: swbt_session_free stops the core's
+    // alert thread before the session's properties are released.
+    private func attachEvents() {
+        guard let raw else { return }
+        swbt_session_set_event_callback(raw, { context, bits in
+            guard let context else { return }
+            Unmanaged<BTEventHub>.fromOpaque(context).takeUnretainedValue().deliver(bits)
+        }, Unmanaged.passUnretained(events).toOpaque())
+    }
+
+    /// Yields whatever `drain` returns each time the core reports events in `mask`,
+    /// draining until the queue is empty. No thread waits in the core meanwhile. With
+    /// `tickMs`, torrent status updates are requested at that cadence.
+    private func eventStream<T>(_ mask: swbt_event_e, tickMs: Int? = nil, drain: @escaping (UnsafeMutablePointer<swbt_session_t>) -> [T]) -> AsyncStream<[T]> {
+        AsyncStream { continuation in
+            let subscription = events.subscribe(mask: mask.rawValue)
+            let ticker = tickMs.map { ms in
+                Task { [self] in
+                    while !Task.isCancelled {
+                        if let raw { swbt_session_post_torrent_updates(raw) }
+                        try? await Task.sleep(nanoseconds: UInt64(max(ms, 1)) * 1_000_000)
+                    }
+                }
+            }
+            let task = Task { [self] in
+                for await _ in subscription.signals {
+                    guard let raw else { break }
+                    var batch = drain(raw)
+                    while !batch.isEmpty {
+                        continuation.yield(batch)
+                        batch = drain(raw)
+                    }
+                }
+                continuation.finish()
+            }
+            continuation.onTermination = { [events] _ in
+                ticker?.cancel()
+                task.cancel()
+                events.unsubscribe(subscription.id)
+            }
+        }
+    }
+
+    private static func withCConfig<T>(_ config: BTSessionConfig, _ body: (UnsafePointer<swbt_session_config_t>) -> T) -> T {
         var savePathCString: [CChar]? = config.savePath?.path.cString(using: .utf8)
         let savePtr: UnsafePointer<CChar>? = savePathCString?.withUnsafeMutableBufferPointer { buf in
             UnsafePointer<CChar>(buf.baseAddress)
@@ -20,10 +86,14 @@ public final class BTSession {
             enable_natpmp: config.enableNATPMP ? 1 : 0,
             download_rate_limit: Int32(config.downloadRateLimit ?? 0),
             upload_rate_limit: Int32(config.uploadRateLimit ?? 0),
-            post_status_interval_ms: Int32(config.postStatusIntervalMs)
+            post_status_interval_ms: Int32(config.postStatusIntervalMs),
+            storage_backend: config.storageBackend.rawValue,
+            storage_threads: Int32(config.storageThreads),
+            storage_memory_cap_bytes: config.storageMemoryCapBytes,
+            storage_readahead_bytes: config.storageReadaheadBytes,
+            shards: Int32(config.shards)
         )
-
-        self.raw = swbt_session_new(&c)
+        return withUnsafePointer(to: &c) { body($0) }
     }
 
     deinit {
@@ -78,8 +148,9 @@ public final class BTSession {
         return BTTorrent(handle: hp)
     }
 
+    /// `flags` say how far to trust files already on disk (see `BTAddFlags`).
     @available(iOS 13.0, macOS 13.0, *)
-    public func addTorrent(fileURL: URL, resumeData: Data?, savePath: URL? = nil) async throws -> BTTorrent {
+    public func addTorrent(fileURL: URL, resumeData: Data?, savePath: URL? = nil, flags: BTAddFlags = []) async throws -> BTTorrent {
         guard let raw else { throw NSError(domain: "SwiftyBT", code: -1) }
         var handlePtr: UnsafeMutablePointer<swbt_torrent_handle_t>? = nil
         let code = fileURL.path.withCString { p in
@@ -87,19 +158,394 @@ public final class BTSession {
                 return rd.withUnsafeBytes { rb in
                     let base = rb.baseAddress?.assumingMemoryBound(to: UInt8.self)
                     return savePath?.path.withCString { s in
-                        swbt_add_torrent_file_with_resume(raw, p, s, base, Int32(rb.count), &handlePtr)
-                    } ?? swbt_add_torrent_file_with_resume(raw, p, nil, base, Int32(rb.count), &handlePtr)
+                        swbt_add_torrent_file_with_flags(raw, p, s, base, Int32(rb.count), flags.rawValue, &handlePtr)
+                    } ?? swbt_add_torrent_file_with_flags(raw, p, nil, base, Int32(rb.count), flags.rawValue, &handlePtr)
                 }
             } else {
                 return savePath?.path.withCString { s in
-                    swbt_add_torrent_file(raw, p, s, &handlePtr)
-                } ?? swbt_add_torrent_file(raw, p, nil, &handlePtr)
+                    swbt_add_torrent_file_with_flags(raw, p, s, nil, 0, flags.rawValue, &handlePtr)
+                } ?? swbt_add_torrent_file_with_flags(raw, p, nil, nil, 0, flags.rawValue, &handlePtr)
             }
         }
         guard code == SWBT_OK, let hp = handlePtr else { throw NSError(domain: "SwiftyBT", code: Int(code.rawValue)) }
         return BTTorrent(handle: hp)
     }
 
+    /// Hashes a file or directory into a new .torrent. Blocks until every piece is hashed,
+    /// so call it off the main actor; `progress` gets (pieces done, total) on this thread.
+    @available(iOS 13.0, macOS 13.0, *)
+    public static func createTorrent(at url: URL, options: BTCreateTorrentOptions = .init(), progress: ((Int, Int) -> Void)? = nil) throws -> BTCreatedTorrent {
+        try withCCreateParams(url, options, progress) { params in
+            var result = swbt_create_result_t()
+            defer { swbt_create_result_free(&result) }
+            let rc = swbt_create_torrent(params, &result)
+            return try mapCreateResult(rc, &result)
+        }
+    }
+
+    /// Creates a torrent from `url` and seeds it in place. The files were just hashed,
+    /// so the torrent starts seeding without a recheck.
+    @available(iOS 13.0, macOS 13.0, *)
+    public func createAndSeed(at url: URL, options: BTCreateTorrentOptions = .init(), progress: ((Int, Int) -> Void)? = nil) throws -> (BTCreatedTorrent, BTTorrent) {
+        guard let raw else { throw NSError(domain: "SwiftyBT", code: -1) }
+        return try Self.withCCreateParams(url, options, progress) { params in
+            var result = swbt_create_result_t()
+            defer { swbt_create_result_free(&result) }
+            var handlePtr: UnsafeMutablePointer<swbt_torrent_handle_t>? = nil
+            let rc = swbt_session_create_and_seed(raw, params, &result, &handlePtr)
+            let created = try Self.mapCreateResult(rc, &result)
+            guard let hp = handlePtr else { throw NSError(domain: "SwiftyBT", code: -1) }
+            return (created, BTTorrent(handle: hp))
+        }
+    }
+
+    private final class CreateProgressBox {
+        let body: (Int, Int) -> Void
+        init(_ body: @escaping (Int, Int) -> Void) { self.body = body }
+    }
+
+    private static func withCCreateParams<T>(_ url: URL, _ options: BTCreateTorrentOptions, _ progress: ((Int, Int) -> Void)?, _ body: (UnsafePointer<swbt_create_params_t>) throws -> T) rethrows -> T {
+        var owned: [UnsafeMutablePointer<CChar>] = []
+        defer { owned.forEach { free($0) } }
+        func dup(_ str: String) -> UnsafePointer<CChar>? {
+            guard let p = strdup(str) else { return nil }
+            owned.append(p)
+            return UnsafePointer(p)
+        }
+
+        var trackers: [UnsafePointer<CChar>?] = []
+        var tiers: [Int32] = []
+        for (tier, urls) in options.trackers.enumerated() {
+            for u in urls {
+                trackers.append(dup(u))
+                tiers.append(Int32(tier))
+            }
+        }
+        let webSeeds = options.webSeeds.map { dup($0) }
+
+        var p = swbt_create_params_t()
+        p.path = dup(url.path)
+        p.version = options.version.rawValue
+        p.piece_size = Int32(options.pieceSize ?? 0)
+        p.hash_threads = Int32(options.hashThreads)
+        p.is_private = options.isPrivate ? 1 : 0
+        p.comment = options.comment.flatMap { dup($0) }
+        p.creator = options.creator.flatMap { dup($0) }
+        p.output_path = options.outputURL.flatMap { dup($0.path) }
+        let box = progress.map { CreateProgressBox($0) }
+        if let box {
+            p.progress = { context, done, total in
+                guard let context else { return }
+                Unmanaged<CreateProgressBox>.fromOpaque(context).takeUnretainedValue().body(Int(done), Int(total))
+            }
+            p.progress_context = Unmanaged.passUnretained(box).toOpaque()
+        }
+        return try withExtendedLifetime(box) {
+            try trackers.withUnsafeBufferPointer { tb in
+                try tiers.withUnsafeBufferPointer { tr in
+                    try webSeeds.withUnsafeBufferPointer { wb in
+                        p.trackers = tb.baseAddress
+                        p.tracker_tiers = tr.baseAddress
+                        p.num_trackers = Int32(tb.count)
+                        p.web_seeds = wb.baseAddress
+                        p.num_web_seeds = Int32(wb.count)
+                        return try body(&p)
+                    }
+                }
+            }
+        }
+    }
+
+    private static func mapCreateResult(_ rc: swbt_error_code_e, _ r: inout swbt_create_result_t) throws -> BTCreatedTorrent {
+        guard rc == SWBT_OK, let data = r.data else {
+            let message = withUnsafePointer(to: &r.message) { ptr in
+                ptr.withMemoryRebound(to: CChar.self, capacity: 1) { String(cString: $0) }
+            }
+            throw NSError(domain: "SwiftyBT", code: Int(rc.rawValue), userInfo: message.isEmpty ? nil : [NSLocalizedDescriptionKey: message])
+        }
+        let id = withUnsafePointer(to: &r.info_hash) { ptr in
+            ptr.withMemoryRebound(to: CChar.self, capacity: 1) { String(cString: $0) }
+        }
+        return BTCreatedTorrent(
+            data: Data(bytes: data, count: Int(r.size)),
+            id: id,
+            numPieces: Int(r.num_pieces),
+            pieceSize: Int(r.piece_size),
+            totalSize: r.total_size
+        )
+    }
+
+    /// Adds many torrents at once. Parsing runs on the core's worker pool and every item
+    /// is submitted with libtorrent's async add, so large restores don't serialize on the
+    /// caller. Results come back in input order. Items still without a result after
+    /// `timeout` seconds (or lost to a libtorrent alert queue overflow) come back failed.
+    @available(iOS 13.0, macOS 13.0, *)
+    public func addTorrents(_ items: [BTAddItem], batch: Int = 1024, timeout: TimeInterval = 600) async -> [BTAddResult] {
+        guard let raw, !items.isEmpty else { return [] }
+        let firstTag = addResults.beginBatch()
+        // The core copies strings and resume buffers during the submit call.
+        var owned: [UnsafeMutableRawPointer] = []
+        defer { owned.forEach { free($0) } }
+        func dup(_ str: String) -> UnsafePointer<CChar>? {
+            guard let p = strdup(str) else { return nil }
+            owned.append(UnsafeMutableRawPointer(p))
+            return UnsafePointer(p)
+        }
+
+        var citems: [swbt_add_item_t] = []
+        citems.reserveCapacity(items.count)
+        for (i, item) in items.enumerated() {
+            var c = swbt_add_item_t()
+            c.user_tag = firstTag + UInt64(i)
+            c.flags = item.flags.rawValue
+            var resume = item.resumeData
+            switch item.source {
+            case .file(let url):
+                c.source = Int32(SWBT_ADD_SOURCE_FILE.rawValue)
+                c.uri = dup(url.path)
+            case .magnet(let magnet):
+                c.source = Int32(SWBT_ADD_SOURCE_MAGNET.rawValue)
+                c.uri = dup(magnet)
+            case .resume(let data):
+                c.source = Int32(SWBT_ADD_SOURCE_RESUME.rawValue)
+                resume = data
+            }
+            if let sp = item.savePath { c.save_path = dup(sp.path) }
+            if let rd = resume, !rd.isEmpty, let buf = malloc(rd.count) {
+                owned.append(buf)
+                let bytes = buf.assumingMemoryBound(to: UInt8.self)
+                rd.copyBytes(to: bytes, count: rd.count)
+                c.resume_data = UnsafePointer(bytes)
+                c.resume_size = Int32(rd.count)
+            }
+            citems.append(c)
+        }
+        _ = citems.withUnsafeBufferPointer { buf in
+            swbt_session_add_torrents_async(raw, buf.baseAddress, Int32(buf.count))
+        }
+        return await collectAddResults(raw, firstTag: firstTag, count: items.count, batch: batch, timeout: timeout)
+    }
+
+    /// Session settings and DHT routing table, for `init(config:state:)`.
+    @available(iOS 13.0, macOS 13.0, *)
+    public func saveState(_ parts: BTSessionStateParts = .all) -> Data? {
+        guard let raw else { return nil }
+        var data: UnsafeMutablePointer<UInt8>?
+        var size: Int32 = 0
+        guard swbt_session_save_state(raw, parts.rawValue, &data, &size) == SWBT_OK, let data else { return nil }
+        defer { swbt_session_state_free(data) }
+        return Data(bytes: data, count: Int(size))
+    }
+
+    @available(iOS 13.0, macOS 13.0, *)
+    public func saveState(to url: URL, parts: BTSessionStateParts = .all) throws {
+        guard let raw else { throw NSError(domain: "SwiftyBT", code: -1) }
+        let rc = swbt_session_save_state_file(raw, parts.rawValue, url.path)
+        if rc != SWBT_OK { throw NSError(domain: "SwiftyBT", code: Int(rc.rawValue)) }
+    }
+
+    @available(iOS 13.0, macOS 13.0, *)
+    public func startupMetrics() -> BTStartupMetrics {
+        var m = swbt_startup_metrics_t()
+        if let raw { swbt_session_startup_metrics(raw, &m) }
+        func ms(_ v: Int64) -> Int? { v >= 0 ? Int(v) : nil }
+        return BTStartupMetrics(
+            warmStart: m.warm_start != 0,
+            dhtNodesRestored: Int(m.dht_nodes_restored),
+            torrents: Int(m.torrents),
+            torrentsWithPeers: Int(m.torrents_with_peers),
+            firstPeerMsMin: ms(m.first_peer_ms_min),
+            firstPeerMsMedian: ms(m.first_peer_ms_median),
+            firstPeerMsMax: ms(m.first_peer_ms_max)
+        )
+    }
+
+    /// Milliseconds from add to the first connected peer, nil while there is none.
+    @available(iOS 13.0, macOS 13.0, *)
+    public func timeToFirstPeerMs(of torrent: BTTorrent) -> Int? {
+        guard let raw else { return nil }
+        let v = swbt_session_time_to_first_peer_ms(raw, torrentID(of: torrent))
+        return v >= 0 ? Int(v) : nil
+    }
+
+    /// Opens a streaming reader over one file of `torrent`. Reading moves a piece-deadline
+    /// window along with the cursor, so playback can start before the download finishes.
+    /// Streams read the downloaded file, so sessions using the `.memory` storage backend
+    /// can't open them.
+    @available(iOS 13.0, macOS 13.0, *)
+    public func openStream(_ torrent: BTTorrent, fileIndex: Int, options: BTStreamOptions = .init()) throws -> BTFileStream {
+        guard let raw else { throw NSError(domain: "SwiftyBT", code: -1) }
+        var o = swbt_stream_options_t()
+        o.readahead_bytes = options.readaheadBytes
+        o.deadline_ms = Int32(options.deadlineMs)
+        o.deadline_step_ms = Int32(options.deadlineStepMs)
+        var sp: UnsafeMutablePointer<swbt_stream_t>?
+        let rc = swbt_torrent_open_stream(raw, torrent.handle, Int32(fileIndex), &o, &sp)
+        guard rc == SWBT_OK, let sp else { throw NSError(domain: "SwiftyBT", code: Int(rc.rawValue)) }
+        return BTFileStream(raw: sp, session: self, events: events)
+    }
+
+    /// Opens the built-in resume store in `directory`. From then on resume data is
+    /// checkpointed there instead of being returned by `pollResumeData`.
+    @available(iOS 13.0, macOS 13.0, *)
+    public func openResumeStore(at directory: URL, options: BTResumeStoreOptions = .init()) throws {
+        guard let raw else { throw NSError(domain: "SwiftyBT", code: -1) }
+        var o = swbt_resume_store_options_t()
+        o.checkpoint_interval_ms = Int32(options.checkpointIntervalMs)
+        o.flush_interval_ms = Int32(options.flushIntervalMs)
+        o.fsync = options.fsync ? 1 : 0
+        o.compact_min_dead_bytes = options.compactMinDeadBytes
+        let rc = swbt_session_open_resume_store(raw, directory.path, &o)
+        if rc != SWBT_OK { throw NSError(domain: "SwiftyBT", code: Int(rc.rawValue)) }
+    }
+
+    /// Saves every changed torrent to the resume store and waits until it is on disk
+    /// (or the timeout passes). Call before shutting the session down.
+    @available(iOS 13.0, macOS 13.0, *)
+    @discardableResult
+    public func checkpoint(timeoutMs: Int = 5000) -> Int {
+        guard let raw else { return 0 }
+        return Int(swbt_session_checkpoint(raw, Int32(timeoutMs)))
+    }
+
+    /// Re-adds every torrent in the resume store. Results are in store order.
+    @available(iOS 13.0, macOS 13.0, *)
+    public func restoreAll(batch: Int = 1024, timeout: TimeInterval = 600) async -> [BTAddResult] {
+        guard let raw else { return [] }
+        let firstTag = addResults.beginBatch()
+        let n = Int(swbt_session_restore_all_tagged(raw, firstTag))
+        return await collectAddResults(raw, firstTag: firstTag, count: n, batch: batch, timeout: timeout)
+    }
+
+    @available(iOS 13.0, macOS 13.0, *)
+    public func resumeStoreStats() -> BTResumeStoreStats? {
+        guard let raw else { return nil }
+        var s = swbt_resume_store_stats_t()
+        guard swbt_session_resume_store_stats(raw, &s) == SWBT_OK else { return nil }
+        return BTResumeStoreStats(
+            liveRecords: Int(s.live_records),
+            liveBytes: s.live_bytes,
+            deadBytes: s.dead_bytes,
+            fileBytes: s.file_bytes,
+            batchesWritten: s.batches_written,
+            recordsWritten: s.records_written,
+            compactions: s.compactions,
+            writeFailures: s.write_failures,
+            lastWriteError: s.last_write_error,
+            queuedRecords: s.queued_records
+        )
+    }
+
+    /// Opens a metadata cache in `directory`. Metadata fetched for magnets is kept
+    /// there, and later magnet adds for the same info-hash skip the fetch.
+    /// `maxBytes` <= 0 uses the 256 MiB default; `maxEntries` 0 means no count limit.
+    @available(iOS 13.0, macOS 13.0, *)
+    public func openMetadataCache(at directory: URL, maxBytes: Int64 = 0, maxEntries: Int = 0) throws {
+        guard let raw else { throw NSError(domain: "SwiftyBT", code: -1) }
+        var o = swbt_metadata_cache_options_t()
+        o.max_bytes = maxBytes
+        o.max_entries = Int64(maxEntries)
+        let rc = swbt_session_open_metadata_cache(raw, directory.path, &o)
+        if rc != SWBT_OK { throw NSError(domain: "SwiftyBT", code: Int(rc.rawValue)) }
+    }
+
+    @available(iOS 13.0, macOS 13.0, *)
+    public func metadataCacheStats() -> BTMetadataCacheStats {
+        var s = swbt_metadata_cache_stats_t()
+        if let raw { swbt_session_metadata_cache_stats(raw, &s) }
+        return BTMetadataCacheStats(
+            isOpen: s.open != 0,
+            entries: Int(s.entries),
+            bytes: s.bytes,
+            lookups: s.lookups,
+            hits: s.hits,
+            corrupt: s.corrupt,
+            stores: s.stores,
+            evictions: s.evictions,
+            metadataDownloads: s.metadata_downloads,
+            timeToMetadataTotalMs: s.time_to_metadata_total_ms,
+            timeToMetadataMaxMs: s.time_to_metadata_max_ms,
+            timeToMetadataLastMs: s.time_to_metadata_last_ms
+        )
+    }
+
+    /// Waits until a result has arrived for every user_tag in firstTag..<firstTag+count.
+    /// Sleeps on core events instead of blocking in the core, and gives up on what is
+    /// missing at the deadline, or once libtorrent has dropped alerts and nothing has
+    /// arrived for a while.
+    private func collectAddResults(_ raw: UnsafeMutablePointer<swbt_session_t>, firstTag: UInt64, count: Int, batch: Int, timeout: TimeInterval) async -> [BTAddResult] {
+        defer { addResults.endBatch(firstTag) }
+        guard count > 0 else { return [] }
+        var results = [BTAddResult?](repeating: nil, count: count)
+        var received = 0
+        var buffer = Array(repeating: swbt_add_result_t(), count: max(batch, 1))
+        let subscription = events.subscribe(mask: SWBT_EVENT_ADD_RESULTS.rawValue)
+        // checks the deadline while no results come in
+        let ticker = Task { [events] in
+            while !Task.isCancelled {
+                try? await Task.sleep(nanoseconds: 1_000_000_000)
+                events.signal(subscription.id)
+            }
+        }
+        defer {
+            ticker.cancel()
+            events.unsubscribe(subscription.id)
+        }
+        let deadline = Date().addingTimeInterval(timeout)
+        let overflowsAtStart = BTSession.ltOverflowEvents(raw)
+        var lastArrival = Date()
+        var missingReason = "timed out waiting for the add result"
+        for await _ in subscription.signals {
+            var othersWaiting = false
+            while true {
+                let n = Int(max(buffer.withUnsafeMutableBufferPointer { buf in
+                    swbt_session_poll_add_results(raw, 0, buf.baseAddress, Int32(buf.count))
+                }, 0))
+                if n == 0 { break }
+                if addResults.route(buffer[0..<n], own: firstTag) { othersWaiting = true }
+            }
+            // drained results of another bulk add in flight; let it pick them up
+            if othersWaiting { events.deliver(SWBT_EVENT_ADD_RESULTS.rawValue) }
+            for var r in addResults.take(firstTag) {
+                let idx = Int(r.user_tag - firstTag)
+                guard idx < results.count, results[idx] == nil else { continue }
+                let id = withUnsafePointer(to: &r.info_hash) { ptr in
+                    ptr.withMemoryRebound(to: CChar.self, capacity: 1) { String(cString: $0) }
+                }
+                let message = withUnsafePointer(to: &r.message) { ptr in
+                    ptr.withMemoryRebound(to: CChar.self, capacity: 1) { String(cString: $0) }
+                }
+                results[idx] = BTAddResult(index: idx, errorCode: Int(r.error_code), torrentID: r.torrent_id, id: id, message: message)
+                received += 1
+                lastArrival = Date()
+            }
+            if received == count { break }
+            if Task.isCancelled {
+                missingReason = "cancelled while waiting for the add result"
+                break
+            }
+            let now = Date()
+            if now >= deadline { break }
+            if BTSession.ltOverflowEvents(raw) != overflowsAtStart && now.timeIntervalSince(lastArrival) >= BTSession.lostAddResultQuietSeconds {
+                missingReason = "add result lost: libtorrent's alert queue overflowed"
+                break
+            }
+        }
+        return results.enumerated().map { i, r in
+            r ?? BTAddResult(index: i, errorCode: Int(SWBT_ERR_GENERIC.rawValue), torrentID: 0, id: "", message: missingReason)
+        }
+    }
+
+    // After libtorrent drops alerts, an add result still missing this long after
+    // the last one arrived is taken as lost.
+    private static let lostAddResultQuietSeconds: TimeInterval = 10
+
+    private static func ltOverflowEvents(_ raw: UnsafeMutablePointer<swbt_session_t>) -> Int64 {
+        var q = swbt_alert_queue_stats_t()
+        swbt_session_alert_queue_stats(raw, &q)
+        return q.lt_overflow_events
+    }
+
     @available(iOS 13.0, macOS 13.0, *)
     public func removeTorrent(_ torrent: BTTorrent, withData: Bool = false) async {
         guard let raw else { return }
@@ -126,30 +572,130 @@ public final class BTSession {
         }
     }
 
+    /// Queries the core's cached torrent table (refreshed every `postStatusIntervalMs`)
+    /// without a round-trip to the libtorrent network thread. `state` filters on the raw
+    /// libtorrent state value (same as `swbt_torrent_status_t.state`).
+    @available(iOS 13.0, macOS 13.0, *)
+    public func querySnapshot(offset: Int = 0, limit: Int = 1024, state: Int32? = nil, onlyIncomplete: Bool = false, nameContains: String? = nil) -> BTSnapshotPage {
+        guard let raw, limit > 0 else { return BTSnapshotPage(items: [], totalMatches: 0, ageMs: -1) }
+        var buffer = Array(repeating: swbt_torrent_snapshot_t(), count: limit)
+        var total: Int32 = 0
+        let run: (UnsafePointer<CChar>?) -> Int32 = { namePtr in
+            var q = swbt_snapshot_query_t(
+                offset: Int32(offset),
+                state_filter: state ?? -1,
+                only_incomplete: onlyIncomplete ? 1 : 0,
+                name_contains: namePtr
+            )
+            return buffer.withUnsafeMutableBufferPointer { buf in
+                swbt_session_query_snapshot(raw, &q, buf.baseAddress, Int32(limit), &total)
+            }
+        }
+        let n = nameContains.map { $0.withCString { run($0) } } ?? run(nil)
+        let items: [BTTorrentSnapshot] = (0..<Int(max(n, 0))).map { i in
+            var o = buffer[i]
+            let id = withUnsafePointer(to: &o.info_hash) { ptr in
+                ptr.withMemoryRebound(to: CChar.self, capacity: 1) { String(cString: $0) }
+            }
+            let name = withUnsafePointer(to: &o.name) { ptr in
+                ptr.withMemoryRebound(to: CChar.self, capacity: 1) { String(cString: $0) }
+            }
+            return BTTorrentSnapshot(
+                torrentID: o.torrent_id,
+                id: id,
+                name: name,
+                state: mapTorrentState(o.state),
+                hasMetadata: o.has_metadata != 0,
+                progress: o.progress,
+                totalWanted: o.total_wanted,
+                totalWantedDone: o.total_wanted_done
+            )
+        }
+        return BTSnapshotPage(items: items, totalMatches: Int(total), ageMs: swbt_session_snapshot_age_ms(raw))
+    }
+
+    /// Looks up a torrent by hex info-hash (v1 or v2; hybrid torrents match either).
+    @available(iOS 13.0, macOS 13.0, *)
+    public func findTorrent(id: String) -> BTTorrent? {
+        guard let raw else { return nil }
+        var handlePtr: UnsafeMutablePointer<swbt_torrent_handle_t>? = nil
+        let code = id.withCString { swbt_session_find_torrent(raw, $0, &handlePtr) }
+        guard code == SWBT_OK, let hp = handlePtr else { return nil }
+        return BTTorrent(handle: hp)
+    }
+
+    /// Looks up a torrent by binary info-hash: 20 bytes (v1) or 32 bytes (v2).
+    @available(iOS 13.0, macOS 13.0, *)
+    public func findTorrent(infoHash: Data) -> BTTorrent? {
+        guard let raw else { return nil }
+        var handlePtr: UnsafeMutablePointer<swbt_torrent_handle_t>? = nil
+        let code = infoHash.withUnsafeBytes { rb in
+            swbt_session_find_torrent_binary(raw, rb.baseAddress?.assumingMemoryBound(to: UInt8.self), Int32(rb.count), &handlePtr)
+        }
+        guard code == SWBT_OK, let hp = handlePtr else { return nil }
+        return BTTorrent(handle: hp)
+    }
+
+    /// Lifecycle alerts, delivered as soon as the core dispatches them.
+    /// `pollIntervalMs` is no longer used and is kept for source compatibility.
     @available(iOS 13.0, macOS 13.0, *)
     public func alertsStream(pollIntervalMs: Int = 500, batch: Int = 256) -> AsyncStream<[BTAlert]> {
+        var buffer = Array(repeating: swbt_alert_t(), count: batch)
+        return eventStream(SWBT_EVENT_ALERTS) { raw in
+            let n = buffer.withUnsafeMutableBufferPointer { buf in
+                swbt_session_poll_alerts(raw, 0, buf.baseAddress, Int32(batch))
+            }
+            return (0..<Int(max(n, 0))).map { i in
+                var a = buffer[i]
+                let id = withUnsafePointer(to: &a.info_hash) { ptr in
+                    ptr.withMemoryRebound(to: CChar.self, capacity: 1) { String(cString: $0) }
+                }
+                let message = withUnsafePointer(to: &a.message) { ptr in
+                    ptr.withMemoryRebound(to: CChar.self, capacity: 1) { String(cString: $0) }
+                }
+                return BTAlert(type: BTAlertType(rawValue: Int(a.type.rawValue)) ?? .torrentError, id: id, errorCode: Int(a.error_code), message: message, progress: Double(a.progress))
+            }
+        }
+    }
+
+    /// Counters of the core alert dispatcher queues. A growing `dropped` value means the
+    /// matching stream or poll loop isn't keeping up.
+    @available(iOS 13.0, macOS 13.0, *)
+    public func alertQueueStats() -> BTAlertQueueStats {
+        guard let raw else { return BTAlertQueueStats(status: .init(), deltas: .init(), resume: .init(), lifecycle: .init(), stats: .init(), libtorrentOverflowEvents: 0) }
+        var s = swbt_alert_queue_stats_t()
+        swbt_session_alert_queue_stats(raw, &s)
+        func map(_ c: swbt_alert_queue_counters_t) -> BTAlertQueueCounters {
+            BTAlertQueueCounters(pushed: c.pushed, dropped: c.dropped, depth: Int(c.depth), capacity: Int(c.capacity))
+        }
+        return BTAlertQueueStats(
+            status: map(s.status),
+            deltas: map(s.deltas),
+            resume: map(s.resume),
+            lifecycle: map(s.lifecycle),
+            stats: map(s.stats),
+            libtorrentOverflowEvents: s.lt_overflow_events
+        )
+    }
+
+    /// Peers of every torrent, ordered by torrent id. One session round trip per
+    /// torrent visited; `onlyActive` skips torrents the cached snapshot shows without peers.
+    @available(iOS 13.0, macOS 13.0, *)
+    public func peers(onlyActive: Bool = true) -> [BTPeerInfo] {
+        guard let raw else { return [] }
+        var buffer: [swbt_peer_info_t] = []
+        return collectPeers(&buffer) { swbt_session_peers(raw, onlyActive ? 1 : 0, $0, $1, $2) }
+    }
+
+    /// Session-wide peer snapshots every `intervalMs`; the record buffer is reused between ticks.
+    @available(iOS 13.0, macOS 13.0, *)
+    public func peersStream(intervalMs: Int = 1000, onlyActive: Bool = true) -> AsyncStream<[BTPeerInfo]> {
         AsyncStream { continuation in
-            let task = Task {
-                var buffer = Array(repeating: swbt_alert_t(), count: batch)
-                while !Task.isCancelled {
-                    if let raw {
-                        let n = buffer.withUnsafeMutableBufferPointer { buf in
-                            swbt_session_poll_alerts(raw, Int32(pollIntervalMs), buf.baseAddress, Int32(batch))
-                        }
-                        if n > 0 {
-                            let mapped: [BTAlert] = (0..<Int(n)).map { i in
-                                var a = buffer[i]
-                                let id = withUnsafePointer(to: &a.info_hash) { ptr in
-                                    ptr.withMemoryRebound(to: CChar.self, capacity: 1) { String(cString: $0) }
-                                }
-                                let message = withUnsafePointer(to: &a.message) { ptr in
-                                    ptr.withMemoryRebound(to: CChar.self, capacity: 1) { String(cString: $0) }
-                                }
-                                return BTAlert(type: BTAlertType(rawValue: Int(a.type.rawValue)) ?? .torrentError, id: id, errorCode: Int(a.error_code), message: message)
-                            }
-                            continuation.yield(mapped)
-                        }
-                    }
+            let task = Task { [weak self] in
+                var buffer: [swbt_peer_info_t] = []
+                while !Task.isCancelled, let self, let raw = self.raw {
+                    continuation.yield(collectPeers(&buffer) { swbt_session_peers(raw, onlyActive ? 1 : 0, $0, $1, $2) })
+                    try? await Task.sleep(nanoseconds: UInt64(max(intervalMs, 1)) * 1_000_000)
                 }
                 continuation.finish()
             }
@@ -157,6 +703,73 @@ public final class BTSession {
         }
     }
 
+    /// Sampling cadence of session counters; 0 stops sampling.
+    @available(iOS 13.0, macOS 13.0, *)
+    public func setStatsInterval(ms: Int) {
+        guard let raw else { return }
+        swbt_session_set_stats_interval(raw, Int32(ms))
+    }
+
+    /// Session counter samples as they arrive. Sampling runs every `intervalMs` from
+    /// here on, also after the stream ends; stop it with `setStatsInterval(ms: 0)`.
+    @available(iOS 13.0, macOS 13.0, *)
+    public func sessionStatsStream(intervalMs: Int = 1000, batch: Int = 16) -> AsyncStream<[BTSessionStats]> {
+        setStatsInterval(ms: intervalMs)
+        var buffer = Array(repeating: swbt_session_stats_t(), count: batch)
+        return eventStream(SWBT_EVENT_SESSION_STATS) { raw in
+            let n = buffer.withUnsafeMutableBufferPointer { buf in
+                swbt_session_poll_stats(raw, 0, buf.baseAddress, Int32(batch))
+            }
+            return (0..<Int(max(n, 0))).map { BTSessionStats(buffer[$0]) }
+        }
+    }
+
+    @available(iOS 13.0, macOS 13.0, *)
+    public func pollSessionStats(timeoutMs: Int = 0, batch: Int = 16) -> [BTSessionStats] {
+        guard let raw else { return [] }
+        var buffer = Array(repeating: swbt_session_stats_t(), count: batch)
+        let n = buffer.withUnsafeMutableBufferPointer { buf in
+            swbt_session_poll_stats(raw, Int32(timeoutMs), buf.baseAddress, Int32(batch))
+        }
+        return (0..<Int(max(n, 0))).map { BTSessionStats(buffer[$0]) }
+    }
+
+    /// Every libtorrent counter of the newest sample; empty before the first one.
+    @available(iOS 13.0, macOS 13.0, *)
+    public func sessionCounters() -> [BTStatsMetric] {
+        guard let raw else { return [] }
+        let count = Int(swbt_stats_metric_count())
+        guard count > 0 else { return [] }
+        var values = [Int64](repeating: 0, count: count)
+        var rates = [Double](repeating: 0, count: count)
+        let n = values.withUnsafeMutableBufferPointer { v in
+            rates.withUnsafeMutableBufferPointer { r in
+                swbt_session_stats_values(raw, v.baseAddress, r.baseAddress, Int32(count), nil)
+            }
+        }
+        return (0..<Int(max(n, 0))).map { i in
+            BTStatsMetric(
+                name: swbt_stats_metric_name(Int32(i)).map { String(cString: $0) } ?? "",
+                isCounter: swbt_stats_metric_type(Int32(i)) == Int32(SWBT_METRIC_COUNTER.rawValue),
+                value: values[i],
+                perSecond: rates[i]
+            )
+        }
+    }
+
+    /// Newest sample and the core queue counters in Prometheus text format, ready to
+    /// serve from a /metrics endpoint.
+    @available(iOS 13.0, macOS 13.0, *)
+    public func prometheusMetrics() -> String {
+        guard let raw else { return "" }
+        var buffer = [CChar](repeating: 0, count: 64 << 10)
+        while true {
+            let needed = Int(buffer.withUnsafeMutableBufferPointer { swbt_session_stats_prometheus(raw, $0.baseAddress, Int32($0.count)) })
+            if needed < buffer.count { return String(cString: buffer) }
+            buffer = [CChar](repeating: 0, count: needed + 1)
+        }
+    }
+
     @available(iOS 13.0, macOS 13.0, *)
     public func pollResumeData(timeoutMs: Int = 1000, batch: Int = 128) -> [BTResumeDataItem] {
         guard let raw else { return [] }
@@ -183,123 +796,734 @@ public final class BTSession {
         return result
     }
 
+    /// Runs `body` with the underlying core session, for calling the C API directly
+    /// (benchmarks, bindings). The pointer must not escape `body`. Nil once freed.
     @available(iOS 13.0, macOS 13.0, *)
-    public func setRateLimits(download: Int?, upload: Int?) {
-        guard let raw else { return }
-        swbt_session_set_rate_limits(raw, Int32(download ?? -1), Int32(upload ?? -1))
+    public func withUnsafeCoreSession<R>(_ body: (UnsafeMutablePointer<swbt_session_t>) throws -> R) rethrows -> R? {
+        guard let raw else { return nil }
+        return try body(raw)
     }
 
+    /// False when the core was built without libtorrent and every call is a stub.
+    public static var hasLibtorrent: Bool { swbt_core_has_libtorrent() != 0 }
+
+    /// Port the session is listening on, 0 if not listening.
     @available(iOS 13.0, macOS 13.0, *)
-    public func statusUpdatesStream(intervalMs: Int = 1000, batch: Int = 256) -> AsyncStream<[BTTorrentStatus]> {
-        AsyncStream { continuation in
-            let task = Task {
-                var buffer = Array(repeating: swbt_torrent_status_t(), count: batch)
-                while !Task.isCancelled {
-                    if let raw {
-                        swbt_session_post_torrent_updates(raw)
-                        let n = buffer.withUnsafeMutableBufferPointer { buf in
-                            swbt_session_poll_updates(raw, Int32(intervalMs), buf.baseAddress, Int32(batch))
-                        }
-                        if n > 0 {
-                            let mapped: [BTTorrentStatus] = (0..<Int(n)).map { i in
-                                var s = buffer[i]
-                                let st: BTTorrentState
-                                switch s.state {
-                                case 0, 6: st = .checking
-                                case 1, 2: st = .downloading
-                                case 3:    st = .downloading
-                                case 4:    st = .seeding
-                                default:   st = .unknown
-                                }
-                                let id = withUnsafePointer(to: &s.info_hash) { ptr in
-                                    ptr.withMemoryRebound(to: CChar.self, capacity: 1) { String(cString: $0) }
-                                }
-                                let name = withUnsafePointer(to: &s.name) { ptr in
-                                    ptr.withMemoryRebound(to: CChar.self, capacity: 1) { String(cString: $0) }
-                                }
-                                return BTTorrentStatus(
-                                    progress: s.progress,
-                                    downloadRate: s.download_rate,
-                                    uploadRate: s.upload_rate,
-                                    totalDownloaded: s.total_downloaded,
-                                    totalUploaded: s.total_uploaded,
-                                    numPeers: Int(s.num_peers),
-                                    numSeeds: Int(s.num_seeds),
-                                    state: st,
-                                    hasMetadata: s.has_metadata != 0,
-                                    id: id,
-                                    name: name
-                                )
-                            }
-                            continuation.yield(mapped)
-                        }
-                    }
-                }
-                continuation.finish()
-            }
-            continuation.onTermination = { _ in task.cancel() }
-        }
+    public var listenPort: Int {
+        guard let raw else { return 0 }
+        return Int(swbt_session_listen_port(raw))
     }
-}
 
-@available(iOS 13.0, macOS 13.0, *)
-public final class BTTorrent {
-    fileprivate let handle: UnsafeMutablePointer<swbt_torrent_handle_t>
+    /// Counters of the storage backend chosen in `BTSessionConfig`. Only the memory and
+    /// mmap backends count traffic; libtorrent's own backends report zeros.
+    @available(iOS 13.0, macOS 13.0, *)
+    public func storageStats() -> BTStorageStats? {
+        guard let raw else { return nil }
+        var s = swbt_storage_stats_t()
+        guard swbt_session_storage_stats(raw, &s) == SWBT_OK else { return nil }
+        return BTStorageStats(
+            backend: BTStorageBackend(rawValue: s.backend) ?? .default,
+            memoryCapBytes: s.memory_cap_bytes,
+            residentBytes: s.resident_bytes,
+            evictedPieces: s.evicted_pieces,
+            bytesRead: s.bytes_read,
+            bytesWritten: s.bytes_written
+        )
+    }
 
-    init(handle: UnsafeMutablePointer<swbt_torrent_handle_t>) {
-        self.handle = handle
+    /// One entry per libtorrent session; a single entry unless `BTSessionConfig.shards` > 1.
+    @available(iOS 13.0, macOS 13.0, *)
+    public func shardInfo() -> [BTShardInfo] {
+        guard let raw else { return [] }
+        var buffer = Array(repeating: swbt_shard_info_t(), count: 16)
+        var total = Int(swbt_session_shard_info(raw, &buffer, Int32(buffer.count)))
+        if total > buffer.count {
+            buffer = Array(repeating: swbt_shard_info_t(), count: total)
+            total = Int(swbt_session_shard_info(raw, &buffer, Int32(buffer.count)))
+        }
+        return buffer.prefix(min(total, buffer.count)).map { s in
+            BTShardInfo(
+                shard: Int(s.shard),
+                listenPort: Int(s.listen_port),
+                numTorrents: Int(s.num_torrents),
+                downloadRateLimit: s.download_rate_limit > 0 ? Int(s.download_rate_limit) : nil,
+                uploadRateLimit: s.upload_rate_limit > 0 ? Int(s.upload_rate_limit) : nil,
+                downloadRate: s.download_rate,
+                uploadRate: s.upload_rate
+            )
+        }
     }
 
-    deinit {
-        // Freed via remove. If leaked, core stub will free on remove only.
+    /// Sets queue limits and seeding goals. Goals are checked by the core as status
+    /// updates arrive; reaching one shows up in `alertsStream` as `.seedGoalReached`.
+    @available(iOS 13.0, macOS 13.0, *)
+    public func configureQueue(_ config: BTQueueConfig) throws {
+        guard let raw else { throw NSError(domain: "SwiftyBT", code: -1) }
+        var c = swbt_queue_config_t()
+        c.active_downloads = Int32(config.activeDownloads ?? 0)
+        c.active_seeds = Int32(config.activeSeeds ?? 0)
+        c.active_checking = Int32(config.activeChecking ?? 0)
+        c.active_limit = Int32(config.activeLimit ?? 0)
+        c.dont_count_slow_torrents = config.dontCountSlowTorrents ? 1 : 0
+        c.demand_priority = config.demandPriority ? 1 : 0
+        c.share_ratio_goal = config.shareRatioGoal ?? 0
+        c.seed_time_goal_s = Int64(config.seedTimeGoalSeconds ?? 0)
+        c.goal_action = config.goalAction.rawValue
+        let rc = swbt_session_configure_queue(raw, &c)
+        if rc != SWBT_OK { throw NSError(domain: "SwiftyBT", code: Int(rc.rawValue)) }
     }
 
-    public func pause() { swbt_torrent_pause(handle) }
-    public func resume() { swbt_torrent_resume(handle) }
-    public func forceReannounce() { swbt_torrent_force_reannounce(handle) }
+    /// Goals for one torrent; nil falls back to the session's, 0 disables that goal.
+    @available(iOS 13.0, macOS 13.0, *)
+    public func setSeedGoals(for torrent: BTTorrent, shareRatio: Double?, seedTimeSeconds: Int?) throws {
+        guard let raw else { throw NSError(domain: "SwiftyBT", code: -1) }
+        let rc = swbt_session_set_torrent_goals(raw, torrent.handle, shareRatio ?? -1, Int64(seedTimeSeconds ?? -1))
+        if rc != SWBT_OK { throw NSError(domain: "SwiftyBT", code: Int(rc.rawValue)) }
+    }
 
-    public func status() -> BTTorrentStatus {
-        var cstatus = swbt_torrent_status_t()
-        _ = swbt_torrent_status(handle, &cstatus)
-        let mappedState: BTTorrentState
-        switch cstatus.state {
-        case 0, 6: mappedState = .checking           // checking_files / checking_resume_data
-        case 1, 2: mappedState = .downloading        // downloading_metadata / downloading
-        case 3:     mappedState = .downloading        // finished (not yet seeding)
-        case 4:     mappedState = .seeding
-        default:    mappedState = .unknown
-        }
-        let id = withUnsafePointer(to: &cstatus.info_hash) { ptr in
-            ptr.withMemoryRebound(to: CChar.self, capacity: 1) { String(cString: $0) }
-        }
-        let name = withUnsafePointer(to: &cstatus.name) { ptr in
-            ptr.withMemoryRebound(to: CChar.self, capacity: 1) { String(cString: $0) }
+    /// Download queue in order, then finished torrents by seed rank, from the core's snapshot.
+    @available(iOS 13.0, macOS 13.0, *)
+    public func queueSnapshot() -> [BTQueueEntry] {
+        guard let raw else { return [] }
+        var total: Int32 = 0
+        _ = swbt_session_queue_snapshot(raw, nil, 0, &total)
+        guard total > 0 else { return [] }
+        var buffer = Array(repeating: swbt_queue_entry_t(), count: Int(total))
+        let n = Int(swbt_session_queue_snapshot(raw, &buffer, Int32(buffer.count), nil))
+        return buffer.prefix(n).map { e in
+            var e = e
+            let id = withUnsafePointer(to: &e.info_hash) { ptr in
+                ptr.withMemoryRebound(to: CChar.self, capacity: 1) { String(cString: $0) }
+            }
+            let state: BTTorrentState = e.paused != 0 ? (e.auto_managed != 0 ? .queued : .paused) : mapTorrentState(e.state)
+            return BTQueueEntry(
+                torrentID: e.torrent_id,
+                id: id,
+                queuePosition: e.queue_position >= 0 ? Int(e.queue_position) : nil,
+                state: state,
+                autoManaged: e.auto_managed != 0,
+                paused: e.paused != 0,
+                seedRank: Int(e.seed_rank),
+                swarmSeeds: e.num_complete >= 0 ? Int(e.num_complete) : nil,
+                swarmLeechers: e.num_incomplete >= 0 ? Int(e.num_incomplete) : nil,
+                shareRatio: e.share_ratio,
+                seedingSeconds: e.seeding_s,
+                goalReached: e.goal_reached != 0
+            )
         }
-        return BTTorrentStatus(
-            progress: cstatus.progress,
-            downloadRate: cstatus.download_rate,
-            uploadRate: cstatus.upload_rate,
-            totalDownloaded: cstatus.total_downloaded,
-            totalUploaded: cstatus.total_uploaded,
-            numPeers: Int(cstatus.num_peers),
-            numSeeds: Int(cstatus.num_seeds),
-            state: mappedState,
-            hasMetadata: cstatus.has_metadata != 0,
-            id: id,
-            name: name
-        )
     }
 
+    /// Limits for scheduled checks (`recheck(_:)` and `BTAddFlags.scheduledCheck`).
     @available(iOS 13.0, macOS 13.0, *)
-    public func currentStatus() async -> BTTorrentStatus {
-        status()
+    public func configureRecheck(_ config: BTRecheckConfig) throws {
+        guard let raw else { throw NSError(domain: "SwiftyBT", code: -1) }
+        var c = swbt_recheck_config_t()
+        c.max_per_device = Int32(config.maxPerDevice)
+        c.max_total = Int32(config.maxTotal ?? 0)
+        c.progress_step = Int32(config.progressStep)
+        let rc = swbt_session_configure_recheck(raw, &c)
+        if rc != SWBT_OK { throw NSError(domain: "SwiftyBT", code: Int(rc.rawValue)) }
     }
 
+    /// Queues a full hash check with the recheck scheduler; progress arrives in
+    /// `alertsStream` as `.recheckStarted`, `.recheckProgress` and `.recheckFinished`.
     @available(iOS 13.0, macOS 13.0, *)
-    public func statusStream(intervalSeconds: Double = 1.0) -> AsyncStream<BTTorrentStatus> {
-        AsyncStream { continuation in
-            let task = Task {
-                while !Task.isCancelled {
+    public func recheck(_ torrent: BTTorrent) throws {
+        guard let raw else { throw NSError(domain: "SwiftyBT", code: -1) }
+        let rc = swbt_session_recheck_torrent(raw, torrent.handle)
+        if rc != SWBT_OK { throw NSError(domain: "SwiftyBT", code: Int(rc.rawValue)) }
+    }
+
+    /// Running checks, then waiting ones in start order.
+    @available(iOS 13.0, macOS 13.0, *)
+    public func recheckQueue() -> [BTRecheckEntry] {
+        guard let raw else { return [] }
+        let total = Int(swbt_session_recheck_queue(raw, nil, 0))
+        guard total > 0 else { return [] }
+        var buffer = Array(repeating: swbt_recheck_entry_t(), count: total)
+        let n = Int(swbt_session_recheck_queue(raw, &buffer, Int32(buffer.count)))
+        return buffer.prefix(min(n, buffer.count)).map { e in
+            var e = e
+            let id = withUnsafePointer(to: &e.info_hash) { ptr in
+                ptr.withMemoryRebound(to: CChar.self, capacity: 1) { String(cString: $0) }
+            }
+            return BTRecheckEntry(torrentID: e.torrent_id, id: id, checking: e.checking != 0, progress: Double(e.progress), device: e.device)
+        }
+    }
+
+    /// Creates a bandwidth group and returns its id. Peers join it by IP range
+    /// (`addBandwidthGroupRange`) or through their torrent (`assign(_:toBandwidthGroup:)`).
+    @available(iOS 13.0, macOS 13.0, *)
+    public func createBandwidthGroup(name: String, config: BTBandwidthGroupConfig) throws -> Int32 {
+        guard let raw else { throw NSError(domain: "SwiftyBT", code: -1) }
+        var c = mapBandwidthGroupConfig(config)
+        let id = swbt_session_create_bandwidth_group(raw, name, &c)
+        if id < 0 { throw NSError(domain: "SwiftyBT", code: Int(SWBT_ERR_INVALID_ARG.rawValue)) }
+        return id
+    }
+
+    /// Also accepts the built-in groups; `BTBandwidthGroup.global` sets the session rate limits.
+    @available(iOS 13.0, macOS 13.0, *)
+    public func configureBandwidthGroup(_ group: Int32, config: BTBandwidthGroupConfig) throws {
+        guard let raw else { throw NSError(domain: "SwiftyBT", code: -1) }
+        var c = mapBandwidthGroupConfig(config)
+        let rc = swbt_session_configure_bandwidth_group(raw, group, &c)
+        if rc != SWBT_OK { throw NSError(domain: "SwiftyBT", code: Int(rc.rawValue)) }
+    }
+
+    @available(iOS 13.0, macOS 13.0, *)
+    public func deleteBandwidthGroup(_ group: Int32) throws {
+        guard let raw else { throw NSError(domain: "SwiftyBT", code: -1) }
+        let rc = swbt_session_delete_bandwidth_group(raw, group)
+        if rc != SWBT_OK { throw NSError(domain: "SwiftyBT", code: Int(rc.rawValue)) }
+    }
+
+    /// Puts the torrent's peers under the group's limits; nil takes it out again.
+    /// The core manages the torrent's own rate limits while it is in a group.
+    @available(iOS 13.0, macOS 13.0, *)
+    public func assign(_ torrent: BTTorrent, toBandwidthGroup group: Int32?) throws {
+        guard let raw else { throw NSError(domain: "SwiftyBT", code: -1) }
+        let rc = swbt_session_set_torrent_bandwidth_group(raw, torrent.handle, group ?? -1)
+        if rc != SWBT_OK { throw NSError(domain: "SwiftyBT", code: Int(rc.rawValue)) }
+    }
+
+    /// Inclusive address range, e.g. `"10.1.0.0"..."10.1.255.255"`. Applies to new connections.
+    @available(iOS 13.0, macOS 13.0, *)
+    public func addBandwidthGroupRange(_ group: Int32, from first: String, to last: String) throws {
+        guard let raw else { throw NSError(domain: "SwiftyBT", code: -1) }
+        let rc = swbt_session_add_bandwidth_group_range(raw, group, first, last)
+        if rc != SWBT_OK { throw NSError(domain: "SwiftyBT", code: Int(rc.rawValue)) }
+    }
+
+    @available(iOS 13.0, macOS 13.0, *)
+    public func clearBandwidthGroupRanges(_ group: Int32) throws {
+        guard let raw else { throw NSError(domain: "SwiftyBT", code: -1) }
+        let rc = swbt_session_clear_bandwidth_group_ranges(raw, group)
+        if rc != SWBT_OK { throw NSError(domain: "SwiftyBT", code: Int(rc.rawValue)) }
+    }
+
+    /// All groups by id. `includePeers` walks every torrent's peer list; poll it sparingly.
+    @available(iOS 13.0, macOS 13.0, *)
+    public func bandwidthGroups(includePeers: Bool = false) -> [BTBandwidthGroup] {
+        guard let raw else { return [] }
+        var buffer = Array(repeating: swbt_bandwidth_group_stats_t(), count: 32)
+        let total = Int(swbt_session_bandwidth_groups(raw, includePeers ? 1 : 0, &buffer, Int32(buffer.count)))
+        return buffer.prefix(min(total, buffer.count)).map { g in
+            var g = g
+            let name = withUnsafePointer(to: &g.name) { ptr in
+                ptr.withMemoryRebound(to: CChar.self, capacity: 1) { String(cString: $0) }
+            }
+            let c = g.config
+            return BTBandwidthGroup(
+                id: g.group,
+                name: name,
+                config: BTBandwidthGroupConfig(
+                    downloadRateLimit: c.download_rate_limit > 0 ? Int(c.download_rate_limit) : nil,
+                    uploadRateLimit: c.upload_rate_limit > 0 ? Int(c.upload_rate_limit) : nil,
+                    downloadPriority: Int(max(1, c.download_priority)),
+                    uploadPriority: Int(max(1, c.upload_priority)),
+                    maxConnections: c.max_connections > 0 ? Int(c.max_connections) : nil,
+                    connectionLimitFactor: c.connection_limit_factor > 0 ? Int(c.connection_limit_factor) : 100,
+                    ignoreUnchokeSlots: c.ignore_unchoke_slots != 0
+                ),
+                numTorrents: Int(g.num_torrents),
+                torrentDownloadRate: g.torrent_download_rate,
+                torrentUploadRate: g.torrent_upload_rate,
+                numPeers: includePeers ? Int(g.num_peers) : nil,
+                peerDownloadRate: includePeers ? g.peer_download_rate : nil,
+                peerUploadRate: includePeers ? g.peer_upload_rate : nil
+            )
+        }
+    }
+
+    /// Loads P2P, DAT or CIDR blocklist files as the session's IP filter, replacing
+    /// the current one once parsed. Runs in the background; completion arrives in
+    /// `alertsStream` as `.blocklistLoaded`.
+    @available(iOS 13.0, macOS 13.0, *)
+    public func loadBlocklist(_ files: [URL]) throws {
+        guard let raw else { throw NSError(domain: "SwiftyBT", code: -1) }
+        let paths = files.map { strdup($0.path) }
+        defer { paths.forEach { free($0) } }
+        var cPaths = paths.map { UnsafePointer<CChar>($0) }
+        let rc = swbt_session_load_blocklist(raw, &cPaths, Int32(cPaths.count))
+        if rc != SWBT_OK { throw NSError(domain: "SwiftyBT", code: Int(rc.rawValue)) }
+    }
+
+    @available(iOS 13.0, macOS 13.0, *)
+    public func clearBlocklist() {
+        guard let raw else { return }
+        swbt_session_clear_blocklist(raw)
+    }
+
+    /// Whether the active blocklist covers `ip`; nil if `ip` isn't an address.
+    @available(iOS 13.0, macOS 13.0, *)
+    public func blocklistContains(_ ip: String) -> Bool? {
+        guard let raw else { return nil }
+        let rc = swbt_session_blocklist_contains(raw, ip)
+        return rc < 0 ? nil : rc != 0
+    }
+
+    @available(iOS 13.0, macOS 13.0, *)
+    public func blocklistStats() -> BTBlocklistStats {
+        var s = swbt_blocklist_stats_t()
+        if let raw { swbt_session_blocklist_stats(raw, &s) }
+        let lastError = withUnsafePointer(to: &s.last_error) { ptr in
+            ptr.withMemoryRebound(to: CChar.self, capacity: 1) { String(cString: $0) }
+        }
+        return BTBlocklistStats(
+            loading: s.loading != 0,
+            active: s.active != 0,
+            files: Int(s.files),
+            lines: s.lines,
+            entries: s.entries,
+            allowedLines: s.allowed_lines,
+            malformedLines: s.malformed_lines,
+            rangesV4: s.ranges_v4,
+            rangesV6: s.ranges_v6,
+            addressesV4: s.addresses_v4,
+            memoryBytes: s.memory_bytes,
+            filterCopies: Int(s.filter_copies),
+            filterMemoryBytes: s.filter_memory_bytes,
+            parseMilliseconds: s.parse_ms,
+            applyMilliseconds: s.apply_ms,
+            loads: s.loads,
+            failedLoads: s.failed_loads,
+            blockedPeers: s.blocked_peers,
+            lastError: lastError.isEmpty ? nil : lastError
+        )
+    }
+
+    /// Records every alert in `categories` into a ring of `capacity` 64-byte records
+    /// in a memory-mapped file at `url` (replaced), replacing a running trace.
+    /// Print it with `swiftybt-trace <file>`; it stays readable after a crash.
+    @available(iOS 13.0, macOS 13.0, *)
+    public func startTrace(at url: URL, capacity: Int = 1 << 20, categories: BTTraceCategories = .standard) throws {
+        guard let raw else { throw NSError(domain: "SwiftyBT", code: -1) }
+        let rc = swbt_session_trace_start(raw, url.path, Int64(capacity), categories.rawValue)
+        if rc != SWBT_OK { throw NSError(domain: "SwiftyBT", code: Int(rc.rawValue)) }
+    }
+
+    @available(iOS 13.0, macOS 13.0, *)
+    public func stopTrace() {
+        guard let raw else { return }
+        swbt_session_trace_stop(raw)
+    }
+
+    @available(iOS 13.0, macOS 13.0, *)
+    public func setTraceCategories(_ categories: BTTraceCategories) throws {
+        guard let raw else { throw NSError(domain: "SwiftyBT", code: -1) }
+        let rc = swbt_session_trace_set_categories(raw, categories.rawValue)
+        if rc != SWBT_OK { throw NSError(domain: "SwiftyBT", code: Int(rc.rawValue)) }
+    }
+
+    /// Adds a marker to the running trace; only the first 16 bytes of `label` are kept.
+    @available(iOS 13.0, macOS 13.0, *)
+    public func markTrace(_ label: String) {
+        guard let raw else { return }
+        swbt_session_trace_mark(raw, label)
+    }
+
+    @available(iOS 13.0, macOS 13.0, *)
+    public func traceStats() -> BTTraceStats {
+        var s = swbt_trace_stats_t()
+        if let raw { swbt_session_trace_stats(raw, &s) }
+        return BTTraceStats(active: s.active != 0, categories: BTTraceCategories(rawValue: s.categories),
+                            recordsWritten: s.records_written, capacity: s.capacity)
+    }
+
+    @available(iOS 13.0, macOS 13.0, *)
+    public func setRateLimits(download: Int?, upload: Int?) {
+        guard let raw else { return }
+        swbt_session_set_rate_limits(raw, Int32(download ?? -1), Int32(upload ?? -1))
+    }
+
+    /// Applies libtorrent settings by name (e.g. `"aio_threads": .int(8)`) in one update.
+    /// Nothing is applied if any entry is unknown or has the wrong type.
+    @available(iOS 13.0, macOS 13.0, *)
+    public func applySettings(_ settings: [String: BTSettingValue]) throws {
+        guard let raw else { throw NSError(domain: "SwiftyBT", code: -1) }
+        guard !settings.isEmpty else { return }
+        var owned: [UnsafeMutablePointer<CChar>] = []
+        defer { owned.forEach { free($0) } }
+        func dup(_ str: String) -> UnsafePointer<CChar>? {
+            guard let p = strdup(str) else { return nil }
+            owned.append(p)
+            return UnsafePointer(p)
+        }
+        let entries = Array(settings)
+        var items: [swbt_setting_t] = entries.map { name, value in
+            var it = swbt_setting_t()
+            it.name = dup(name)
+            switch value {
+            case .int(let v):
+                it.type = Int32(SWBT_SETTING_INT.rawValue)
+                it.int_value = Int64(v)
+            case .bool(let v):
+                it.type = Int32(SWBT_SETTING_BOOL.rawValue)
+                it.int_value = v ? 1 : 0
+            case .string(let v):
+                it.type = Int32(SWBT_SETTING_STRING.rawValue)
+                it.str_value = dup(v)
+            }
+            return it
+        }
+        var bad: Int32 = -1
+        let rc = items.withUnsafeMutableBufferPointer { buf in
+            swbt_session_apply_settings(raw, buf.baseAddress, Int32(buf.count), &bad)
+        }
+        if rc != SWBT_OK {
+            let key = bad >= 0 ? entries[Int(bad)].key : ""
+            throw NSError(domain: "SwiftyBT", code: Int(rc.rawValue), userInfo: [NSLocalizedDescriptionKey: "invalid setting \(key)"])
+        }
+    }
+
+    /// Current value of a libtorrent setting, nil if the name is unknown.
+    @available(iOS 13.0, macOS 13.0, *)
+    public func setting(_ name: String) -> BTSettingValue? {
+        guard let raw else { return nil }
+        switch swbt_setting_type(name) {
+        case Int32(SWBT_SETTING_INT.rawValue):
+            var v: Int64 = 0
+            return swbt_session_get_int_setting(raw, name, &v) == SWBT_OK ? .int(Int(v)) : nil
+        case Int32(SWBT_SETTING_BOOL.rawValue):
+            var v: Int64 = 0
+            return swbt_session_get_int_setting(raw, name, &v) == SWBT_OK ? .bool(v != 0) : nil
+        case Int32(SWBT_SETTING_STRING.rawValue):
+            var buf = [CChar](repeating: 0, count: 1024)
+            return swbt_session_get_str_setting(raw, name, &buf, Int32(buf.count)) == SWBT_OK ? .string(String(cString: buf)) : nil
+        default:
+            return nil
+        }
+    }
+
+    @available(iOS 13.0, macOS 13.0, *)
+    public func applyProfile(_ profile: BTSettingsProfile) throws {
+        guard let raw else { throw NSError(domain: "SwiftyBT", code: -1) }
+        let rc = swbt_session_apply_profile(raw, profile.rawValue)
+        if rc != SWBT_OK { throw NSError(domain: "SwiftyBT", code: Int(rc.rawValue)) }
+    }
+
+    @available(iOS 13.0, macOS 13.0, *)
+    public func statusUpdatesStream(intervalMs: Int = 1000, batch: Int = 256) -> AsyncStream<[BTTorrentStatus]> {
+        var buffer = Array(repeating: swbt_torrent_status_t(), count: batch)
+        return eventStream(SWBT_EVENT_STATUS, tickMs: intervalMs) { raw in
+            let n = buffer.withUnsafeMutableBufferPointer { buf in
+                swbt_session_poll_updates(raw, 0, buf.baseAddress, Int32(batch))
+            }
+            return (0..<Int(max(n, 0))).map { BTTorrentStatus(buffer[$0]) }
+        }
+    }
+
+    /// Drains status updates queued by the core without waiting for an event;
+    /// `timeoutMs` bounds the wait when the queue is empty. The core stops queueing
+    /// them after 10 s without a poll (`SWBT_STATUS_CONSUMER_WINDOW_MS`), so the
+    /// first call after a longer pause may come back empty.
+    @available(iOS 13.0, macOS 13.0, *)
+    public func pollStatusUpdates(timeoutMs: Int = 0, batch: Int = 256) -> [BTTorrentStatus] {
+        guard let raw else { return [] }
+        var buffer = Array(repeating: swbt_torrent_status_t(), count: batch)
+        let n = buffer.withUnsafeMutableBufferPointer { buf in
+            swbt_session_poll_updates(raw, Int32(timeoutMs), buf.baseAddress, Int32(batch))
+        }
+        return (0..<Int(max(n, 0))).map { BTTorrentStatus(buffer[$0]) }
+    }
+
+    /// Compact status stream keyed by session-local numeric ids. Hash and name are
+    /// resolved only when a torrent is first seen (or renamed); afterwards only the
+    /// numeric counters cross the bridge, together with a mask of changed fields.
+    @available(iOS 13.0, macOS 13.0, *)
+    public func statusEventsStream(intervalMs: Int = 1000, batch: Int = 4096) -> AsyncStream<[BTStatusEvent]> {
+        if let raw { swbt_session_set_update_mode(raw, SWBT_UPDATE_MODE_DELTA, 1) }
+        var buffer = Array(repeating: swbt_status_delta_t(), count: batch)
+        return eventStream(SWBT_EVENT_STATUS_DELTAS, tickMs: intervalMs) { raw in
+            let n = buffer.withUnsafeMutableBufferPointer { buf in
+                swbt_session_poll_status_deltas(raw, 0, buf.baseAddress, Int32(batch))
+            }
+            var events: [BTStatusEvent] = []
+            events.reserveCapacity(Int(max(n, 0)))
+            for i in 0..<Int(max(n, 0)) {
+                let d = buffer[i]
+                switch UInt32(bitPattern: d.kind) {
+                case SWBT_STATUS_RECORD_ADDED.rawValue:
+                    events.append(.added(self.identity(of: d.torrent_id), BTStatusDelta(d)))
+                case SWBT_STATUS_RECORD_REMOVED.rawValue:
+                    events.append(.removed(d.torrent_id))
+                default:
+                    if d.changed & SWBT_STATUS_FIELD_IDENTITY.rawValue != 0 {
+                        events.append(.identityChanged(self.identity(of: d.torrent_id)))
+                    }
+                    events.append(.updated(BTStatusDelta(d)))
+                }
+            }
+            return events
+        }
+    }
+
+    @available(iOS 13.0, macOS 13.0, *)
+    public func torrentID(of torrent: BTTorrent) -> UInt32 {
+        guard let raw else { return 0 }
+        return swbt_torrent_id(raw, torrent.handle)
+    }
+
+    private func identity(of torrentID: UInt32) -> BTTorrentIdentity {
+        var ident = swbt_torrent_identity_t()
+        if let raw { _ = swbt_session_torrent_identity(raw, torrentID, &ident) }
+        let id = withUnsafePointer(to: &ident.info_hash) { ptr in
+            ptr.withMemoryRebound(to: CChar.self, capacity: 1) { String(cString: $0) }
+        }
+        let name = withUnsafePointer(to: &ident.name) { ptr in
+            ptr.withMemoryRebound(to: CChar.self, capacity: 1) { String(cString: $0) }
+        }
+        return BTTorrentIdentity(torrentID: torrentID, id: id, name: name)
+    }
+}
+
+@available(iOS 13.0, macOS 13.0, *)
+extension BTPieceMap {
+    public func hasPiece(_ index: Int) -> Bool {
+        guard index >= 0, index < numPieces else { return false }
+        return have[index >> 3] & (0x80 >> UInt8(index & 7)) != 0
+    }
+
+    public func haveCount(in range: Range<Int>? = nil) -> Int {
+        let r = range ?? 0..<numPieces
+        return Int(have.withUnsafeBufferPointer {
+            swbt_bitfield_count($0.baseAddress, Int32(numPieces), Int32(r.lowerBound), Int32(r.upperBound))
+        })
+    }
+
+    /// Fraction of pieces had per range, e.g. per file from `BTTorrent.filePieceRanges()`.
+    /// Empty ranges count as complete.
+    public func completion(of ranges: [Range<Int>]) -> [Double] {
+        guard !ranges.isEmpty else { return [] }
+        let raw = ranges.map { swbt_piece_range_t(first: Int32($0.lowerBound), last: Int32($0.upperBound)) }
+        var counts = [Int32](repeating: 0, count: ranges.count)
+        have.withUnsafeBufferPointer { bits in
+            raw.withUnsafeBufferPointer { r in
+                counts.withUnsafeMutableBufferPointer { c in
+                    swbt_bitfield_count_ranges(bits.baseAddress, Int32(numPieces), r.baseAddress, Int32(r.count), c.baseAddress)
+                }
+            }
+        }
+        return zip(ranges, counts).map { range, had in range.isEmpty ? 1.0 : Double(had) / Double(range.count) }
+    }
+
+    /// Rarity over `range` (all pieces by default); with `missingOnly`, pieces
+    /// already had are left out. Needs a map taken with availability.
+    public func availabilityStats(in range: Range<Int>? = nil, missingOnly: Bool = true) -> BTAvailabilityStats {
+        let r = (range ?? 0..<numPieces).clamped(to: 0..<(availability.isEmpty ? 0 : numPieces))
+        var s = swbt_availability_stats_t()
+        availability.withUnsafeBufferPointer { a in
+            have.withUnsafeBufferPointer { h in
+                swbt_availability_stats(a.baseAddress, missingOnly ? h.baseAddress : nil, Int32(r.lowerBound), Int32(r.upperBound), &s)
+            }
+        }
+        return BTAvailabilityStats(
+            pieces: Int(s.pieces),
+            minAvailability: s.min_availability >= 0 ? Int(s.min_availability) : nil,
+            piecesAtMin: Int(s.pieces_at_min),
+            unavailable: Int(s.unavailable),
+            meanAvailability: s.mean_availability,
+            distributedCopies: s.distributed_copies
+        )
+    }
+}
+
+/// Fills `buffer` through `call` (records, capacity, total out), growing it and
+/// retrying when more peers are connected than it holds.
+@available(iOS 13.0, macOS 13.0, *)
+private func collectPeers(_ buffer: inout [swbt_peer_info_t],
+                          _ call: (UnsafeMutablePointer<swbt_peer_info_t>?, Int32, UnsafeMutablePointer<Int32>) -> Int32) -> [BTPeerInfo] {
+    if buffer.isEmpty { buffer = Array(repeating: swbt_peer_info_t(), count: 64) }
+    var total: Int32 = 0
+    var n = buffer.withUnsafeMutableBufferPointer { call($0.baseAddress, Int32($0.count), &total) }
+    if Int(total) > buffer.count {
+        buffer = Array(repeating: swbt_peer_info_t(), count: Int(total) + Int(total) / 4)
+        n = buffer.withUnsafeMutableBufferPointer { call($0.baseAddress, Int32($0.count), &total) }
+    }
+    return (0..<Int(max(n, 0))).map { BTPeerInfo(buffer[$0]) }
+}
+
+@available(iOS 13.0, macOS 13.0, *)
+extension BTPeerInfo {
+    init(_ raw: swbt_peer_info_t) {
+        var p = raw
+        let ip = withUnsafePointer(to: &p.ip) { ptr in
+            ptr.withMemoryRebound(to: CChar.self, capacity: 1) { String(cString: $0) }
+        }
+        let client = withUnsafePointer(to: &p.client) { ptr in
+            ptr.withMemoryRebound(to: CChar.self, capacity: 1) { String(cString: $0) }
+        }
+        self.init(
+            torrentID: p.torrent_id,
+            ip: ip,
+            port: Int(p.port),
+            client: client,
+            flags: BTPeerFlags(rawValue: p.flags),
+            source: BTPeerSource(rawValue: p.source),
+            downloadRate: Int(p.download_rate),
+            uploadRate: Int(p.upload_rate),
+            payloadDownloadRate: Int(p.payload_download_rate),
+            payloadUploadRate: Int(p.payload_upload_rate),
+            totalDownload: p.total_download,
+            totalUpload: p.total_upload,
+            progress: p.progress,
+            downloadQueueLength: Int(p.download_queue_length),
+            uploadQueueLength: Int(p.upload_queue_length),
+            sendQueueBytes: Int(p.send_queue_bytes),
+            pendingDiskBytes: Int(p.pending_disk_bytes),
+            rttMs: Int(p.rtt_ms),
+            hashFailures: Int(p.num_hashfails)
+        )
+    }
+}
+
+@available(iOS 13.0, macOS 13.0, *)
+extension BTSessionStats {
+    init(_ s: swbt_session_stats_t) {
+        self.init(
+            timestampUs: s.timestamp_us,
+            intervalUs: s.interval_us,
+            peersConnected: s.peers_connected,
+            peersHalfOpen: s.peers_half_open,
+            peersUpInterested: s.peers_up_interested,
+            peersDownInterested: s.peers_down_interested,
+            peersUpUnchoked: s.peers_up_unchoked,
+            peersDownUnchoked: s.peers_down_unchoked,
+            peersUpDisk: s.peers_up_disk,
+            peersDownDisk: s.peers_down_disk,
+            torrentsChecking: s.torrents_checking,
+            torrentsDownloading: s.torrents_downloading,
+            torrentsSeeding: s.torrents_seeding,
+            torrentsQueued: s.torrents_queued,
+            torrentsStopped: s.torrents_stopped,
+            torrentsError: s.torrents_error,
+            diskQueuedJobs: s.disk_queued_jobs,
+            diskRunningJobs: s.disk_running_jobs,
+            diskQueuedWriteBytes: s.disk_queued_write_bytes,
+            diskBlocksInUse: s.disk_blocks_in_use,
+            limiterUpBytes: s.limiter_up_bytes,
+            limiterDownBytes: s.limiter_down_bytes,
+            recvBytes: s.recv_bytes,
+            sentBytes: s.sent_bytes,
+            alertsDropped: s.alerts_dropped,
+            recvBytesPerSecond: s.recv_bytes_per_s,
+            sentBytesPerSecond: s.sent_bytes_per_s,
+            recvPayloadPerSecond: s.recv_payload_per_s,
+            sentPayloadPerSecond: s.sent_payload_per_s,
+            diskBlocksReadPerSecond: s.disk_blocks_read_per_s,
+            diskBlocksWrittenPerSecond: s.disk_blocks_written_per_s,
+            diskBlocksHashedPerSecond: s.disk_blocks_hashed_per_s
+        )
+    }
+}
+
+@available(iOS 13.0, macOS 13.0, *)
+extension BTTorrentStatus {
+    init(_ raw: swbt_torrent_status_t) {
+        var s = raw
+        let id = withUnsafePointer(to: &s.info_hash) { ptr in
+            ptr.withMemoryRebound(to: CChar.self, capacity: 1) { String(cString: $0) }
+        }
+        let name = withUnsafePointer(to: &s.name) { ptr in
+            ptr.withMemoryRebound(to: CChar.self, capacity: 1) { String(cString: $0) }
+        }
+        self.init(
+            progress: s.progress,
+            downloadRate: s.download_rate,
+            uploadRate: s.upload_rate,
+            totalDownloaded: s.total_downloaded,
+            totalUploaded: s.total_uploaded,
+            numPeers: Int(s.num_peers),
+            numSeeds: Int(s.num_seeds),
+            state: mapTorrentState(s.state),
+            hasMetadata: s.has_metadata != 0,
+            id: id,
+            name: name
+        )
+    }
+}
+
+@available(iOS 13.0, macOS 13.0, *)
+extension BTStatusDelta {
+    init(_ d: swbt_status_delta_t) {
+        self.init(
+            torrentID: d.torrent_id,
+            changed: BTStatusFields(rawValue: d.changed),
+            progress: d.progress,
+            downloadRate: d.download_rate,
+            uploadRate: d.upload_rate,
+            totalDownloaded: d.total_downloaded,
+            totalUploaded: d.total_uploaded,
+            numPeers: Int(d.num_peers),
+            numSeeds: Int(d.num_seeds),
+            state: mapTorrentState(d.state),
+            hasMetadata: d.has_metadata != 0
+        )
+    }
+}
+
+@available(iOS 13.0, macOS 13.0, *)
+private func mapBandwidthGroupConfig(_ config: BTBandwidthGroupConfig) -> swbt_bandwidth_group_config_t {
+    var c = swbt_bandwidth_group_config_t()
+    c.download_rate_limit = Int32(config.downloadRateLimit ?? 0)
+    c.upload_rate_limit = Int32(config.uploadRateLimit ?? 0)
+    c.download_priority = Int32(config.downloadPriority)
+    c.upload_priority = Int32(config.uploadPriority)
+    c.max_connections = Int32(config.maxConnections ?? 0)
+    c.connection_limit_factor = Int32(config.connectionLimitFactor)
+    c.ignore_unchoke_slots = config.ignoreUnchokeSlots ? 1 : 0
+    return c
+}
+
+@available(iOS 13.0, macOS 13.0, *)
+private func mapTorrentState(_ raw: Int32) -> BTTorrentState {
+    switch raw {
+    case 0, 6: return .checking
+    case 1, 2: return .downloading
+    case 3:    return .downloading
+    case 4:    return .seeding
+    default:   return .unknown
+    }
+}
+
+@available(iOS 13.0, macOS 13.0, *)
+public final class BTTorrent {
+    fileprivate let handle: UnsafeMutablePointer<swbt_torrent_handle_t>
+
+    init(handle: UnsafeMutablePointer<swbt_torrent_handle_t>) {
+        self.handle = handle
+    }
+
+    deinit {
+        // Freed via remove. If leaked, core stub will free on remove only.
+    }
+
+    /// Pauses and takes the torrent out of the queue.
+    public func pause() { swbt_torrent_pause(handle) }
+    /// Resumes the torrent. One that `pause()` took out of the queue goes back to it,
+    /// which starts it when a slot is free.
+    public func resume() { swbt_torrent_resume(handle) }
+    public func moveInQueue(_ move: BTQueueMove) { swbt_torrent_queue_move(handle, move.rawValue) }
+    public func setAutoManaged(_ autoManaged: Bool) { swbt_torrent_set_auto_managed(handle, autoManaged ? 1 : 0) }
+    public func forceReannounce() { swbt_torrent_force_reannounce(handle) }
+
+    public func status() -> BTTorrentStatus {
+        var cstatus = swbt_torrent_status_t()
+        _ = swbt_torrent_status(handle, &cstatus)
+        return BTTorrentStatus(cstatus)
+    }
+
+    @available(iOS 13.0, macOS 13.0, *)
+    public func currentStatus() async -> BTTorrentStatus {
+        status()
+    }
+
+    @available(iOS 13.0, macOS 13.0, *)
+    public func statusStream(intervalSeconds: Double = 1.0) -> AsyncStream<BTTorrentStatus> {
+        AsyncStream { continuation in
+            let task = Task {
+                while !Task.isCancelled {
                     continuation.yield(self.status())
                     try? await Task.sleep(nanoseconds: UInt64(intervalSeconds * 1_000_000_000))
                 }
@@ -309,6 +1533,29 @@ public final class BTTorrent {
         }
     }
 
+    /// Connected peers. Blocks on the session thread for this torrent.
+    @available(iOS 13.0, macOS 13.0, *)
+    public func peers() -> [BTPeerInfo] {
+        var buffer: [swbt_peer_info_t] = []
+        return collectPeers(&buffer) { swbt_torrent_peers(handle, $0, $1, $2) }
+    }
+
+    /// Peer snapshots every `intervalSeconds`; the record buffer is reused between ticks.
+    @available(iOS 13.0, macOS 13.0, *)
+    public func peersStream(intervalSeconds: Double = 1.0) -> AsyncStream<[BTPeerInfo]> {
+        AsyncStream { continuation in
+            let task = Task {
+                var buffer: [swbt_peer_info_t] = []
+                while !Task.isCancelled {
+                    continuation.yield(collectPeers(&buffer) { swbt_torrent_peers(self.handle, $0, $1, $2) })
+                    try? await Task.sleep(nanoseconds: UInt64(intervalSeconds * 1_000_000_000))
+                }
+                continuation.finish()
+            }
+            continuation.onTermination = { _ in task.cancel() }
+        }
+    }
+
     public func id() -> String {
         var buf = [CChar](repeating: 0, count: 65)
         _ = swbt_torrent_infohash(handle, &buf, 65)
@@ -317,23 +1564,108 @@ public final class BTTorrent {
 
     public func saveResumeData() { swbt_torrent_save_resume(handle) }
 
+    /// Connects straight to a known peer, bypassing trackers and DHT.
+    public func connectPeer(ip: String, port: Int) throws {
+        let rc = swbt_torrent_connect_peer(handle, ip, Int32(port))
+        if rc != SWBT_OK { throw NSError(domain: "SwiftyBT", code: Int(rc.rawValue)) }
+    }
+
     public func totalSize() -> Int64 { swbt_torrent_total_size(handle) }
 
+    /// The whole file table from one core call; empty without metadata.
     public func files() -> [BTFileInfo] {
-        let count = Int(swbt_torrent_file_count(handle))
-        guard count > 0 else { return [] }
-        var result: [BTFileInfo] = []
-        result.reserveCapacity(count)
-        for i in 0..<count {
-            var fi = swbt_file_info_t()
-            if swbt_torrent_file_info(handle, Int32(i), &fi) == SWBT_OK {
-                let path = withUnsafePointer(to: &fi.path) { ptr in
-                    ptr.withMemoryRebound(to: CChar.self, capacity: 1) { String(cString: $0) }
-                }
-                result.append(BTFileInfo(index: Int(fi.index), size: fi.size, offset: fi.offset, path: path, priority: Int(fi.priority)))
+        var table = swbt_file_table_t()
+        guard swbt_torrent_file_table(handle, &table) == SWBT_OK else { return [] }
+        defer { swbt_file_table_free(&table) }
+        guard table.count > 0, let entries = table.files, let paths = table.paths else { return [] }
+        return (0..<Int(table.count)).map { i in
+            let e = entries[i]
+            return BTFileInfo(
+                index: i,
+                size: e.size,
+                offset: e.offset,
+                path: String(cString: paths + Int(e.path_offset)),
+                priority: Int(e.priority),
+                flags: BTFileFlags(rawValue: e.flags)
+            )
+        }
+    }
+
+    /// Downloaded bytes per file, in file order. `pieceGranularity` counts only
+    /// complete pieces, which is much cheaper on torrents with many pieces.
+    @available(iOS 13.0, macOS 13.0, *)
+    public func fileProgress(pieceGranularity: Bool = false) -> [Int64] {
+        let flags: UInt32 = pieceGranularity ? UInt32(SWBT_FILE_PROGRESS_PIECE_GRANULARITY.rawValue) : 0
+        var buffer = [Int64](repeating: 0, count: max(Int(swbt_torrent_file_count(handle)), 1))
+        var n = buffer.withUnsafeMutableBufferPointer { swbt_torrent_file_progress(handle, flags, $0.baseAddress, Int32($0.count)) }
+        if Int(n) > buffer.count {
+            buffer = [Int64](repeating: 0, count: Int(n))
+            n = buffer.withUnsafeMutableBufferPointer { swbt_torrent_file_progress(handle, flags, $0.baseAddress, Int32($0.count)) }
+        }
+        return Array(buffer.prefix(Int(n)))
+    }
+
+    /// Every file's priority in one update, in file order; files past the end get the default (4).
+    @available(iOS 13.0, macOS 13.0, *)
+    public func prioritizeFiles(_ priorities: [Int]) {
+        let raw = priorities.map { Int32($0) }
+        _ = raw.withUnsafeBufferPointer { swbt_torrent_prioritize_files(handle, $0.baseAddress, Int32($0.count)) }
+    }
+
+    /// Priorities by file index in one update; other files keep theirs.
+    @available(iOS 13.0, macOS 13.0, *)
+    public func setFilePriorities(_ priorities: [Int: Int]) throws {
+        let indices = priorities.keys.map { Int32($0) }
+        let values = indices.map { Int32(priorities[Int($0)]!) }
+        let rc = indices.withUnsafeBufferPointer { ip in
+            values.withUnsafeBufferPointer { vp in
+                swbt_torrent_set_file_priorities(handle, ip.baseAddress, vp.baseAddress, Int32(ip.count))
             }
         }
-        return result
+        if rc != SWBT_OK { throw NSError(domain: "SwiftyBT", code: Int(rc.rawValue)) }
+    }
+
+    /// Have-bitfield and, with `includeAvailability`, per-piece peer counts. Nil without metadata.
+    @available(iOS 13.0, macOS 13.0, *)
+    public func pieceMap(includeAvailability: Bool = true) -> BTPieceMap? {
+        var numPieces: Int32 = 0
+        var pieceLength: Int32 = 0
+        guard swbt_torrent_piece_info(handle, &numPieces, &pieceLength) == SWBT_OK, numPieces > 0 else { return nil }
+        var have = [UInt8](repeating: 0, count: (Int(numPieces) + 7) / 8)
+        let n = have.withUnsafeMutableBufferPointer { swbt_torrent_piece_bitfield(handle, $0.baseAddress, Int32($0.count)) }
+        guard n == numPieces else { return nil }
+        var availability: [UInt8] = []
+        if includeAvailability {
+            availability = [UInt8](repeating: 0, count: Int(numPieces))
+            let a = availability.withUnsafeMutableBufferPointer { swbt_torrent_piece_availability(handle, $0.baseAddress, Int32($0.count)) }
+            if a != numPieces { availability = [] }
+        }
+        return BTPieceMap(numPieces: Int(numPieces), pieceLength: Int(pieceLength), have: have, availability: availability)
+    }
+
+    /// Pieces overlapping each file, in file order.
+    @available(iOS 13.0, macOS 13.0, *)
+    public func filePieceRanges() -> [Range<Int>] {
+        let count = Int(swbt_torrent_file_piece_ranges(handle, nil, 0))
+        guard count > 0 else { return [] }
+        var raw = Array(repeating: swbt_piece_range_t(), count: count)
+        _ = raw.withUnsafeMutableBufferPointer { swbt_torrent_file_piece_ranges(handle, $0.baseAddress, Int32($0.count)) }
+        return raw.map { Int($0.first)..<Int($0.last) }
+    }
+
+    /// Share of each file's pieces already downloaded, in file order.
+    @available(iOS 13.0, macOS 13.0, *)
+    public func fileCompletion() -> [Double] {
+        guard let map = pieceMap(includeAvailability: false) else { return [] }
+        return map.completion(of: filePieceRanges())
+    }
+
+    /// Checks without waiting for a slot in the session's recheck scheduler;
+    /// progress still arrives as `.recheckStarted`, `.recheckProgress` and `.recheckFinished`.
+    /// Throws if the torrent has no metadata yet or has left the session.
+    public func forceRecheck() throws {
+        let rc = swbt_torrent_force_recheck(handle)
+        if rc != SWBT_OK { throw NSError(domain: "SwiftyBT", code: Int(rc.rawValue)) }
     }
 
     public func setFilePriority(index: Int, priority: Int) {
@@ -349,4 +1681,190 @@ public final class BTTorrent {
     }
 }
 
+/// Byte stream over one torrent file. Iterating yields the file in order as `Data` chunks,
+/// suspending while the covering pieces download. Use `chunks(from:length:chunkSize:)`
+/// for ranges.
+@available(iOS 13.0, macOS 13.0, *)
+public final class BTFileStream: AsyncSequence {
+    public typealias Element = Data
 
+    private let raw: UnsafeMutablePointer<swbt_stream_t>
+    // The core stream must be closed before its session is freed.
+    private let session: BTSession
+    private let events: BTEventHub
+    public let size: Int64
+
+    init(raw: UnsafeMutablePointer<swbt_stream_t>, session: BTSession, events: BTEventHub) {
+        self.raw = raw
+        self.session = session
+        self.events = events
+        self.size = swbt_stream_size(raw)
+    }
+
+    deinit {
+        swbt_stream_close(raw)
+    }
+
+    /// Reads up to `length` bytes at `offset`; may return less than asked when the next
+    /// piece isn't there yet. Returns empty data at end of file. Suspends on the core's
+    /// piece events while the piece downloads instead of blocking in the core, and throws
+    /// once the torrent is removed.
+    public func read(offset: Int64, length: Int) async throws -> Data {
+        guard length > 0 else { return Data() }
+        var data = Data(count: length)
+        let subscription = events.subscribe(mask: SWBT_EVENT_PIECES.rawValue)
+        // notices a removed torrent while no pieces finish
+        let ticker = Task { [events] in
+            while !Task.isCancelled {
+                try? await Task.sleep(nanoseconds: 1_000_000_000)
+                events.signal(subscription.id)
+            }
+        }
+        defer {
+            ticker.cancel()
+            events.unsubscribe(subscription.id)
+        }
+        for await _ in subscription.signals {
+            try Task.checkCancellation()
+            let n = data.withUnsafeMutableBytes { buf in
+                swbt_stream_read(raw, offset, buf.bindMemory(to: UInt8.self).baseAddress, Int64(length), 0)
+            }
+            if n == -1 { continue } // piece not there yet
+            if n < 0 { throw NSError(domain: "SwiftyBT", code: Int(n)) }
+            data.count = Int(n)
+            return data
+        }
+        throw CancellationError()
+    }
+
+    public func chunks(from offset: Int64 = 0, length: Int64? = nil, chunkSize: Int = 1 << 20) -> Chunks {
+        let end = min(size, length.map { offset + $0 } ?? size)
+        return Chunks(stream: self, start: offset, end: end, chunkSize: chunkSize)
+    }
+
+    public func makeAsyncIterator() -> Chunks.AsyncIterator {
+        chunks().makeAsyncIterator()
+    }
+
+    public struct Chunks: AsyncSequence {
+        public typealias Element = Data
+        let stream: BTFileStream
+        let start: Int64
+        let end: Int64
+        let chunkSize: Int
+
+        public func makeAsyncIterator() -> AsyncIterator {
+            AsyncIterator(stream: stream, offset: start, end: end, chunkSize: chunkSize)
+        }
+
+        public struct AsyncIterator: AsyncIteratorProtocol {
+            let stream: BTFileStream
+            var offset: Int64
+            let end: Int64
+            let chunkSize: Int
+
+            public mutating func next() async throws -> Data? {
+                guard offset < end else { return nil }
+                let want = Int(min(Int64(chunkSize), end - offset))
+                let data = try await stream.read(offset: offset, length: want)
+                if data.isEmpty { return nil }
+                offset += Int64(data.count)
+                return data
+            }
+        }
+    }
+}
+
+/// Fans the core's event callback out to stream subscribers. The callback runs on the
+/// core's alert thread, so it only signals; each stream drains its own queue.
+final class BTEventHub {
+    private let lock = NSLock()
+    private var subscribers: [UInt64: (mask: UInt32, continuation: AsyncStream<Void>.Continuation)] = [:]
+    private var nextID: UInt64 = 0
+
+    func subscribe(mask: UInt32) -> (id: UInt64, signals: AsyncStream<Void>) {
+        var continuation: AsyncStream<Void>.Continuation!
+        // bursts coalesce into one pending wakeup
+        let signals = AsyncStream<Void>(bufferingPolicy: .bufferingNewest(1)) { continuation = $0 }
+        lock.lock()
+        let id = nextID
+        nextID += 1
+        subscribers[id] = (mask, continuation)
+        lock.unlock()
+        // pick up anything queued before subscribing
+        continuation.yield(())
+        return (id, signals)
+    }
+
+    func unsubscribe(_ id: UInt64) {
+        lock.lock()
+        let sub = subscribers.removeValue(forKey: id)
+        lock.unlock()
+        sub?.continuation.finish()
+    }
+
+    // Wakes one subscriber without an event, e.g. for its own timeout checks.
+    func signal(_ id: UInt64) {
+        lock.lock()
+        defer { lock.unlock() }
+        subscribers[id]?.continuation.yield(())
+    }
+
+    func deliver(_ events: UInt32) {
+        lock.lock()
+        defer { lock.unlock() }
+        for sub in subscribers.values where sub.mask & events != 0 {
+            sub.continuation.yield(())
+        }
+    }
+}
+
+// Bulk add results share one core queue. Whichever collector drains it sorts the
+// results here by batch, so concurrent addTorrents/restoreAll calls never take
+// each other's. A batch's tags are its number in the upper 32 bits and the item
+// index in the lower.
+final class BTAddResultRouter {
+    private let lock = NSLock()
+    private var nextBatch: UInt64 = 1
+    private var unclaimed: [UInt64: [swbt_add_result_t]] = [:]   // keyed by batch, open batches only
+
+    /// Opens a batch and returns its first tag.
+    func beginBatch() -> UInt64 {
+        lock.lock()
+        defer { lock.unlock() }
+        let b = nextBatch
+        nextBatch += 1
+        unclaimed[b] = []
+        return b << 32
+    }
+
+    func endBatch(_ firstTag: UInt64) {
+        lock.lock()
+        unclaimed.removeValue(forKey: firstTag >> 32)
+        lock.unlock()
+    }
+
+    /// Files results under their batch; those of closed batches are dropped.
+    /// Returns whether any belong to a batch other than the caller's.
+    func route(_ results: ArraySlice<swbt_add_result_t>, own firstTag: UInt64) -> Bool {
+        lock.lock()
+        defer { lock.unlock() }
+        var others = false
+        for r in results {
+            let b = r.user_tag >> 32
+            guard unclaimed[b] != nil else { continue }
+            unclaimed[b]!.append(r)
+            if b != firstTag >> 32 { others = true }
+        }
+        return others
+    }
+
+    func take(_ firstTag: UInt64) -> [swbt_add_result_t] {
+        lock.lock()
+        defer { lock.unlock() }
+        let b = firstTag >> 32
+        guard let taken = unclaimed[b], !taken.isEmpty else { return [] }
+        unclaimed[b] = []
+        return taken
+    }
+}
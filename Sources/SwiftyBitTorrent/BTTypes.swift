@@ -11,6 +11,18 @@ public struct BTSessionConfig {
     public var downloadRateLimit: Int?
     public var uploadRateLimit: Int?
     public var postStatusIntervalMs: Int
+    public var storageBackend: BTStorageBackend
+    /// Disk job threads for the memory and mmap backends, 0 for the core default.
+    public var storageThreads: Int
+    /// Memory backend: least recently used pieces are evicted above this, 0 for no cap.
+    /// Split evenly across shards; a torrent larger than its shard's part is put in an
+    /// error state (ENOSPC) instead of being evicted and re-downloaded forever.
+    public var storageMemoryCapBytes: Int64
+    /// Mmap backend: bytes past each read handed to madvise(WILLNEED), 0 to leave it to the kernel.
+    public var storageReadaheadBytes: Int64
+    /// libtorrent sessions behind this one, each with its own network thread. Torrents
+    /// are routed by info-hash and rate limits are split between shards by demand.
+    public var shards: Int
 
     public init(
         savePath: URL? = nil,
@@ -21,7 +33,12 @@ public struct BTSessionConfig {
         enableNATPMP: Bool = true,
         downloadRateLimit: Int? = nil,
         uploadRateLimit: Int? = nil,
-        postStatusIntervalMs: Int = 1000
+        postStatusIntervalMs: Int = 1000,
+        storageBackend: BTStorageBackend = .default,
+        storageThreads: Int = 0,
+        storageMemoryCapBytes: Int64 = 0,
+        storageReadaheadBytes: Int64 = 0,
+        shards: Int = 1
     ) {
         self.savePath = savePath
         self.listenPort = listenPort
@@ -32,9 +49,26 @@ public struct BTSessionConfig {
         self.downloadRateLimit = downloadRateLimit
         self.uploadRateLimit = uploadRateLimit
         self.postStatusIntervalMs = postStatusIntervalMs
+        self.storageBackend = storageBackend
+        self.storageThreads = storageThreads
+        self.storageMemoryCapBytes = storageMemoryCapBytes
+        self.storageReadaheadBytes = storageReadaheadBytes
+        self.shards = shards
     }
 }
 
+@available(iOS 13.0, macOS 13.0, *)
+public enum BTStorageBackend: Int32, Sendable, CaseIterable {
+    /// libtorrent's default disk I/O.
+    case `default` = 0
+    /// libtorrent's portable pread/pwrite disk I/O.
+    case posix = 1
+    /// Pieces held in RAM only. Evicted pieces are downloaded again after a recheck.
+    case memory = 2
+    /// Memory-mapped files with madvise read-ahead.
+    case mmap = 3
+}
+
 @available(iOS 13.0, macOS 13.0, *)
 public enum BTTorrentState: String, Sendable {
     case unknown
@@ -67,6 +101,38 @@ public struct BTTorrentOverview: Sendable {
     public let name: String
 }
 
+@available(iOS 13.0, macOS 13.0, *)
+public struct BTTorrentSnapshot: Sendable {
+    public let torrentID: UInt32
+    public let id: String
+    public let name: String
+    public let state: BTTorrentState
+    public let hasMetadata: Bool
+    public let progress: Double
+    public let totalWanted: Int64
+    public let totalWantedDone: Int64
+}
+
+@available(iOS 13.0, macOS 13.0, *)
+public struct BTSnapshotPage: Sendable {
+    public let items: [BTTorrentSnapshot]
+    public let totalMatches: Int
+    /// Age of the cached snapshot in milliseconds, -1 if it was never refreshed.
+    public let ageMs: Int64
+}
+
+@available(iOS 13.0, macOS 13.0, *)
+public struct BTFileFlags: OptionSet, Sendable {
+    public let rawValue: UInt32
+    public init(rawValue: UInt32) { self.rawValue = rawValue }
+
+    /// Alignment padding; never written to disk.
+    public static let pad = BTFileFlags(rawValue: 1 << 0)
+    public static let hidden = BTFileFlags(rawValue: 1 << 1)
+    public static let executable = BTFileFlags(rawValue: 1 << 2)
+    public static let symlink = BTFileFlags(rawValue: 1 << 3)
+}
+
 @available(iOS 13.0, macOS 13.0, *)
 public struct BTFileInfo: Sendable {
     public let index: Int
@@ -74,6 +140,7 @@ public struct BTFileInfo: Sendable {
     public let offset: Int64
     public let path: String
     public let priority: Int
+    public let flags: BTFileFlags
 }
 
 @available(iOS 13.0, macOS 13.0, *)
@@ -82,6 +149,15 @@ public enum BTAlertType: Int, Sendable {
     case torrentError = 2
     case metadataReceived = 3
     case trackerError = 4
+    /// Share-ratio or seed-time goal met (see `BTQueueConfig`).
+    case seedGoalReached = 5
+    /// Scheduled check started, advanced by `BTRecheckConfig.progressStep`, or ended.
+    case recheckStarted = 6
+    case recheckProgress = 7
+    /// `errorCode` is non-zero if the check failed or the torrent was removed.
+    case recheckFinished = 8
+    /// A blocklist load or clear finished; `errorCode` is non-zero if a file couldn't be read.
+    case blocklistLoaded = 9
 }
 
 @available(iOS 13.0, macOS 13.0, *)
@@ -90,6 +166,582 @@ public struct BTAlert: Sendable {
     public let id: String
     public let errorCode: Int
     public let message: String
+    /// Share checked, for the recheck alerts.
+    public let progress: Double
+}
+
+@available(iOS 13.0, macOS 13.0, *)
+public enum BTAddSource: Sendable {
+    case file(URL)
+    case magnet(String)
+    /// Resume data that carries the info dict (or at least the info-hash)
+    case resume(Data)
+}
+
+/// How much to trust data already on disk when adding.
+@available(iOS 13.0, macOS 13.0, *)
+public struct BTAddFlags: OptionSet, Sendable {
+    public let rawValue: UInt32
+    public init(rawValue: UInt32) { self.rawValue = rawValue }
+
+    /// No check at add; each piece is verified the first time a peer asks for it.
+    /// Needs metadata, so it is ignored for bare magnets.
+    public static let seedMode = BTAddFlags(rawValue: 1 << 0)
+    /// With resume data, don't check that the files exist and have the right sizes.
+    public static let skipCheck = BTAddFlags(rawValue: 1 << 1)
+    /// Add stopped, check through the recheck scheduler, then start.
+    public static let scheduledCheck = BTAddFlags(rawValue: 1 << 2)
+}
+
+@available(iOS 13.0, macOS 13.0, *)
+public struct BTAddItem: Sendable {
+    public var source: BTAddSource
+    public var savePath: URL?
+    public var resumeData: Data?
+    public var flags: BTAddFlags
+
+    public init(_ source: BTAddSource, savePath: URL? = nil, resumeData: Data? = nil, flags: BTAddFlags = []) {
+        self.source = source
+        self.savePath = savePath
+        self.resumeData = resumeData
+        self.flags = flags
+    }
+}
+
+@available(iOS 13.0, macOS 13.0, *)
+public struct BTAddResult: Sendable {
+    public let index: Int
+    public let errorCode: Int
+    public let torrentID: UInt32
+    public let id: String
+    public let message: String
+
+    public var succeeded: Bool { errorCode == 0 }
+}
+
+@available(iOS 13.0, macOS 13.0, *)
+public struct BTSessionStateParts: OptionSet, Sendable {
+    public let rawValue: UInt32
+    public init(rawValue: UInt32) { self.rawValue = rawValue }
+
+    public static let settings = BTSessionStateParts(rawValue: 1 << 0)
+    public static let dht = BTSessionStateParts(rawValue: 1 << 1)
+    public static let all: BTSessionStateParts = [.settings, .dht]
+}
+
+@available(iOS 13.0, macOS 13.0, *)
+public struct BTStartupMetrics: Sendable {
+    public let warmStart: Bool
+    public let dhtNodesRestored: Int
+    public let torrents: Int
+    public let torrentsWithPeers: Int
+    /// Time from add to first connected peer across torrents; nil until one connects.
+    public let firstPeerMsMin: Int?
+    public let firstPeerMsMedian: Int?
+    public let firstPeerMsMax: Int?
+}
+
+@available(iOS 13.0, macOS 13.0, *)
+public enum BTSettingValue: Sendable, Equatable {
+    case int(Int)
+    case bool(Bool)
+    case string(String)
+}
+
+@available(iOS 13.0, macOS 13.0, *)
+public enum BTSettingsProfile: Int32, Sendable, CaseIterable {
+    /// High-throughput seeding (libtorrent's high_performance_seed).
+    case seedbox = 1
+    /// Small buffers and queues (libtorrent's min_memory_usage).
+    case lowMemory = 2
+    /// Thousands of mostly idle torrents: tight active limits, slow housekeeping.
+    case manyIdle = 3
+}
+
+@available(iOS 13.0, macOS 13.0, *)
+public struct BTStreamOptions: Sendable {
+    /// Bytes ahead of the read cursor that get piece deadlines.
+    public var readaheadBytes: Int64
+    /// Deadline for the piece under the cursor.
+    public var deadlineMs: Int
+    /// Extra deadline per piece further into the read-ahead window.
+    public var deadlineStepMs: Int
+
+    public init(readaheadBytes: Int64 = 8 << 20, deadlineMs: Int = 1000, deadlineStepMs: Int = 250) {
+        self.readaheadBytes = readaheadBytes
+        self.deadlineMs = deadlineMs
+        self.deadlineStepMs = deadlineStepMs
+    }
+}
+
+@available(iOS 13.0, macOS 13.0, *)
+public struct BTResumeStoreOptions: Sendable {
+    public var checkpointIntervalMs: Int
+    public var flushIntervalMs: Int
+    public var fsync: Bool
+    public var compactMinDeadBytes: Int64
+
+    public init(checkpointIntervalMs: Int = 30_000, flushIntervalMs: Int = 1000, fsync: Bool = true, compactMinDeadBytes: Int64 = 32 << 20) {
+        self.checkpointIntervalMs = checkpointIntervalMs
+        self.flushIntervalMs = flushIntervalMs
+        self.fsync = fsync
+        self.compactMinDeadBytes = compactMinDeadBytes
+    }
+}
+
+@available(iOS 13.0, macOS 13.0, *)
+public struct BTResumeStoreStats: Sendable {
+    public let liveRecords: Int
+    public let liveBytes: Int64
+    public let deadBytes: Int64
+    public let fileBytes: Int64
+    public let batchesWritten: Int64
+    public let recordsWritten: Int64
+    public let compactions: Int64
+    /// Batches that failed to write; they stay queued and are retried.
+    public let writeFailures: Int64
+    /// errno of the latest failed write, 0 once a batch is written again.
+    public let lastWriteError: Int32
+    public let queuedRecords: Int64
+}
+
+@available(iOS 13.0, macOS 13.0, *)
+public struct BTMetadataCacheStats: Sendable {
+    public let isOpen: Bool
+    public let entries: Int
+    public let bytes: Int64
+    /// Magnet adds that looked for their metadata in the cache.
+    public let lookups: Int64
+    public let hits: Int64
+    /// Entries dropped because they didn't match their info-hash.
+    public let corrupt: Int64
+    public let stores: Int64
+    public let evictions: Int64
+    /// Magnets that fetched their metadata from peers, and how long that took from the add.
+    public let metadataDownloads: Int64
+    public let timeToMetadataTotalMs: Int64
+    public let timeToMetadataMaxMs: Int64
+    public let timeToMetadataLastMs: Int64
+
+    public var hitRate: Double { lookups > 0 ? Double(hits) / Double(lookups) : 0 }
+    public var averageTimeToMetadataMs: Double {
+        metadataDownloads > 0 ? Double(timeToMetadataTotalMs) / Double(metadataDownloads) : 0
+    }
+}
+
+@available(iOS 13.0, macOS 13.0, *)
+public struct BTStorageStats: Sendable {
+    public let backend: BTStorageBackend
+    public let memoryCapBytes: Int64
+    /// Piece bytes held by the memory backend.
+    public let residentBytes: Int64
+    public let evictedPieces: Int64
+    public let bytesRead: Int64
+    public let bytesWritten: Int64
+}
+
+@available(iOS 13.0, macOS 13.0, *)
+public struct BTShardInfo: Sendable {
+    public let shard: Int
+    public let listenPort: Int
+    public let numTorrents: Int
+    /// This shard's current part of the session limit, nil when unlimited.
+    public let downloadRateLimit: Int?
+    public let uploadRateLimit: Int?
+    public let downloadRate: Int64
+    public let uploadRate: Int64
+}
+
+@available(iOS 13.0, macOS 13.0, *)
+public enum BTGoalAction: Int32, Sendable {
+    /// Only raise `BTAlertType.seedGoalReached`.
+    case none = 0
+    /// Raise the alert, then pause the torrent and take it out of the queue.
+    case pause = 1
+}
+
+/// Auto-managed queueing and seeding goals. Active limits of nil keep libtorrent's
+/// defaults, -1 means unlimited; in a sharded session they are split between shards.
+@available(iOS 13.0, macOS 13.0, *)
+public struct BTQueueConfig: Sendable {
+    public var activeDownloads: Int?
+    public var activeSeeds: Int?
+    public var activeChecking: Int?
+    public var activeLimit: Int?
+    /// Torrents below libtorrent's slow-rate thresholds don't take an active slot.
+    public var dontCountSlowTorrents: Bool
+    /// Queued downloads are ordered by swarm seeds, best seeded first.
+    public var demandPriority: Bool
+    /// Uploaded bytes over torrent size.
+    public var shareRatioGoal: Double?
+    public var seedTimeGoalSeconds: Int?
+    public var goalAction: BTGoalAction
+
+    public init(activeDownloads: Int? = nil, activeSeeds: Int? = nil, activeChecking: Int? = nil, activeLimit: Int? = nil, dontCountSlowTorrents: Bool = true, demandPriority: Bool = false, shareRatioGoal: Double? = nil, seedTimeGoalSeconds: Int? = nil, goalAction: BTGoalAction = .none) {
+        self.activeDownloads = activeDownloads
+        self.activeSeeds = activeSeeds
+        self.activeChecking = activeChecking
+        self.activeLimit = activeLimit
+        self.dontCountSlowTorrents = dontCountSlowTorrents
+        self.demandPriority = demandPriority
+        self.shareRatioGoal = shareRatioGoal
+        self.seedTimeGoalSeconds = seedTimeGoalSeconds
+        self.goalAction = goalAction
+    }
+}
+
+@available(iOS 13.0, macOS 13.0, *)
+public enum BTQueueMove: Int32, Sendable {
+    case up = 0
+    case down = 1
+    case top = 2
+    case bottom = 3
+}
+
+@available(iOS 13.0, macOS 13.0, *)
+public struct BTQueueEntry: Sendable {
+    public let torrentID: UInt32
+    public let id: String
+    /// Download queue slot, nil once finished.
+    public let queuePosition: Int?
+    public let state: BTTorrentState
+    public let autoManaged: Bool
+    public let paused: Bool
+    public let seedRank: Int
+    /// Swarm seeds and leechers from the last scrape, nil if unknown.
+    public let swarmSeeds: Int?
+    public let swarmLeechers: Int?
+    public let shareRatio: Double
+    public let seedingSeconds: Int64
+    public let goalReached: Bool
+}
+
+/// Limits of the recheck scheduler; a device is the filesystem holding the save path.
+@available(iOS 13.0, macOS 13.0, *)
+public struct BTRecheckConfig: Sendable {
+    public var maxPerDevice: Int
+    /// Across devices, nil = unlimited. Also caps the checks libtorrent starts on its own.
+    public var maxTotal: Int?
+    /// Percent between `.recheckProgress` alerts.
+    public var progressStep: Int
+
+    public init(maxPerDevice: Int = 1, maxTotal: Int? = nil, progressStep: Int = 10) {
+        self.maxPerDevice = maxPerDevice
+        self.maxTotal = maxTotal
+        self.progressStep = progressStep
+    }
+}
+
+@available(iOS 13.0, macOS 13.0, *)
+public struct BTRecheckEntry: Sendable {
+    public let torrentID: UInt32
+    public let id: String
+    public let checking: Bool
+    public let progress: Double
+    public let device: UInt64
+}
+
+/// Limits of a bandwidth group. Rates are bytes/sec and nil means unlimited.
+@available(iOS 13.0, macOS 13.0, *)
+public struct BTBandwidthGroupConfig: Sendable {
+    public var downloadRateLimit: Int?
+    public var uploadRateLimit: Int?
+    /// 1...255, the group's share when a parent limit (e.g. the session's) is contended.
+    public var downloadPriority: Int
+    public var uploadPriority: Int
+    /// Connection cap split between the group's torrents, nil = unlimited.
+    public var maxConnections: Int?
+    /// Percent of the connection limit a peer matched by IP range counts for.
+    public var connectionLimitFactor: Int
+    /// Peers matched by IP range don't use up unchoke slots.
+    public var ignoreUnchokeSlots: Bool
+
+    public init(downloadRateLimit: Int? = nil, uploadRateLimit: Int? = nil, downloadPriority: Int = 1, uploadPriority: Int = 1, maxConnections: Int? = nil, connectionLimitFactor: Int = 100, ignoreUnchokeSlots: Bool = false) {
+        self.downloadRateLimit = downloadRateLimit
+        self.uploadRateLimit = uploadRateLimit
+        self.downloadPriority = downloadPriority
+        self.uploadPriority = uploadPriority
+        self.maxConnections = maxConnections
+        self.connectionLimitFactor = connectionLimitFactor
+        self.ignoreUnchokeSlots = ignoreUnchokeSlots
+    }
+}
+
+@available(iOS 13.0, macOS 13.0, *)
+public struct BTBandwidthGroup: Sendable {
+    /// Built-in groups: all WAN peers, peers on TCP sockets, peers on local networks.
+    public static let global: Int32 = 0
+    public static let tcp: Int32 = 1
+    public static let local: Int32 = 2
+
+    public let id: Int32
+    public let name: String
+    public let config: BTBandwidthGroupConfig
+    public let numTorrents: Int
+    /// Summed over the member torrents.
+    public let torrentDownloadRate: Int64
+    public let torrentUploadRate: Int64
+    /// Peers matched by IP range or connected to a member torrent; nil unless requested.
+    public let numPeers: Int?
+    public let peerDownloadRate: Int64?
+    public let peerUploadRate: Int64?
+}
+
+@available(iOS 13.0, macOS 13.0, *)
+public struct BTBlocklistStats: Sendable {
+    /// A load or clear is queued or running.
+    public let loading: Bool
+    public let active: Bool
+    public let files: Int
+    public let lines: Int64
+    /// Ranges read, before overlapping and adjacent ones were merged.
+    public let entries: Int64
+    /// DAT entries above access level 127, which are allowed rather than blocked.
+    public let allowedLines: Int64
+    public let malformedLines: Int64
+    public let rangesV4: Int64
+    public let rangesV6: Int64
+    public let addressesV4: UInt64
+    public let memoryBytes: Int64
+    /// libtorrent keeps its own filter per shard, so this grows with the shard count.
+    public let filterCopies: Int
+    /// Estimate across all filter copies.
+    public let filterMemoryBytes: Int64
+    public let parseMilliseconds: Int64
+    public let applyMilliseconds: Int64
+    public let loads: Int64
+    public let failedLoads: Int64
+    /// Peers refused by the filter since the session started.
+    public let blockedPeers: UInt64
+    public let lastError: String?
+}
+
+/// Alert categories recorded by an alert trace (`BTSession.startTrace`).
+@available(iOS 13.0, macOS 13.0, *)
+public struct BTTraceCategories: OptionSet, Sendable {
+    public let rawValue: UInt32
+    public init(rawValue: UInt32) { self.rawValue = rawValue }
+
+    public static let error = BTTraceCategories(rawValue: 1 << 0)
+    public static let peer = BTTraceCategories(rawValue: 1 << 1)
+    public static let portMapping = BTTraceCategories(rawValue: 1 << 2)
+    public static let storage = BTTraceCategories(rawValue: 1 << 3)
+    public static let tracker = BTTraceCategories(rawValue: 1 << 4)
+    public static let connect = BTTraceCategories(rawValue: 1 << 5)
+    public static let status = BTTraceCategories(rawValue: 1 << 6)
+    public static let ipBlock = BTTraceCategories(rawValue: 1 << 7)
+    public static let performance = BTTraceCategories(rawValue: 1 << 8)
+    public static let dht = BTTraceCategories(rawValue: 1 << 9)
+    public static let stats = BTTraceCategories(rawValue: 1 << 10)
+    public static let fileProgress = BTTraceCategories(rawValue: 1 << 11)
+    /// One record per finished piece; busy on fast transfers.
+    public static let pieceProgress = BTTraceCategories(rawValue: 1 << 12)
+    /// One record per block request and completion; very busy.
+    public static let blockProgress = BTTraceCategories(rawValue: 1 << 13)
+    public static let upload = BTTraceCategories(rawValue: 1 << 14)
+
+    /// Lifecycle, errors and swarm health without the per-piece categories.
+    public static let standard: BTTraceCategories = [.error, .storage, .tracker, .status, .performance, .peer, .connect]
+}
+
+@available(iOS 13.0, macOS 13.0, *)
+public struct BTTraceStats: Sendable {
+    public let active: Bool
+    public let categories: BTTraceCategories
+    /// Since the start, including records the ring has since overwritten.
+    public let recordsWritten: UInt64
+    public let capacity: UInt64
+}
+
+@available(iOS 13.0, macOS 13.0, *)
+public struct BTPeerFlags: OptionSet, Sendable {
+    public let rawValue: UInt32
+    public init(rawValue: UInt32) { self.rawValue = rawValue }
+
+    /// We want pieces the peer has.
+    public static let interesting = BTPeerFlags(rawValue: 1 << 0)
+    /// We are choking the peer.
+    public static let choked = BTPeerFlags(rawValue: 1 << 1)
+    public static let remoteInterested = BTPeerFlags(rawValue: 1 << 2)
+    /// The peer is choking us.
+    public static let remoteChoked = BTPeerFlags(rawValue: 1 << 3)
+    public static let snubbed = BTPeerFlags(rawValue: 1 << 4)
+    public static let seed = BTPeerFlags(rawValue: 1 << 5)
+    public static let uploadOnly = BTPeerFlags(rawValue: 1 << 6)
+    /// We opened the connection.
+    public static let outgoing = BTPeerFlags(rawValue: 1 << 7)
+    /// uTP; TCP otherwise.
+    public static let utp = BTPeerFlags(rawValue: 1 << 8)
+    public static let encrypted = BTPeerFlags(rawValue: 1 << 9)
+    public static let ssl = BTPeerFlags(rawValue: 1 << 10)
+    public static let connecting = BTPeerFlags(rawValue: 1 << 11)
+    public static let optimisticUnchoke = BTPeerFlags(rawValue: 1 << 12)
+    public static let endgame = BTPeerFlags(rawValue: 1 << 13)
+}
+
+@available(iOS 13.0, macOS 13.0, *)
+public struct BTPeerSource: OptionSet, Sendable {
+    public let rawValue: UInt32
+    public init(rawValue: UInt32) { self.rawValue = rawValue }
+
+    public static let tracker = BTPeerSource(rawValue: 1 << 0)
+    public static let dht = BTPeerSource(rawValue: 1 << 1)
+    public static let pex = BTPeerSource(rawValue: 1 << 2)
+    public static let lsd = BTPeerSource(rawValue: 1 << 3)
+    public static let resumeData = BTPeerSource(rawValue: 1 << 4)
+    public static let incoming = BTPeerSource(rawValue: 1 << 5)
+}
+
+@available(iOS 13.0, macOS 13.0, *)
+public struct BTPeerInfo: Sendable {
+    /// Session-local torrent id for session-wide listings, 0 for per-torrent ones.
+    public let torrentID: UInt32
+    public let ip: String
+    public let port: Int
+    public let client: String
+    public let flags: BTPeerFlags
+    public let source: BTPeerSource
+    public let downloadRate: Int
+    public let uploadRate: Int
+    public let payloadDownloadRate: Int
+    public let payloadUploadRate: Int
+    public let totalDownload: Int64
+    public let totalUpload: Int64
+    public let progress: Double
+    /// Our requests outstanding to the peer.
+    public let downloadQueueLength: Int
+    /// The peer's requests outstanding to us.
+    public let uploadQueueLength: Int
+    public let sendQueueBytes: Int
+    public let pendingDiskBytes: Int
+    public let rttMs: Int
+    public let hashFailures: Int
+}
+
+/// Piece state of one torrent, copied out in one call per array.
+@available(iOS 13.0, macOS 13.0, *)
+public struct BTPieceMap: Sendable {
+    public let numPieces: Int
+    public let pieceLength: Int
+    /// Pieces we have, packed MSB first as on the wire.
+    public let have: [UInt8]
+    /// Connected peers holding each piece, saturated at 255. Empty unless requested.
+    public let availability: [UInt8]
+}
+
+@available(iOS 13.0, macOS 13.0, *)
+public struct BTAvailabilityStats: Sendable {
+    public let pieces: Int
+    /// Copies of the rarest piece, nil when no piece was considered.
+    public let minAvailability: Int?
+    public let piecesAtMin: Int
+    /// Pieces no connected peer has.
+    public let unavailable: Int
+    public let meanAvailability: Double
+    public let distributedCopies: Double
+}
+
+@available(iOS 13.0, macOS 13.0, *)
+public enum BTTorrentVersion: Int32, Sendable {
+    /// v1 and v2 metadata in one file, joinable from either swarm.
+    case hybrid = 0
+    case v1 = 1
+    case v2 = 2
+}
+
+@available(iOS 13.0, macOS 13.0, *)
+public struct BTCreateTorrentOptions: Sendable {
+    public var version: BTTorrentVersion
+    /// Power of two of at least 16 KiB; nil lets libtorrent pick from the total size.
+    public var pieceSize: Int?
+    /// 0 = one per core.
+    public var hashThreads: Int
+    /// Announce URLs as tiers; each inner array is one tier.
+    public var trackers: [[String]]
+    public var webSeeds: [String]
+    public var isPrivate: Bool
+    public var comment: String?
+    public var creator: String?
+    /// Also write the .torrent file here.
+    public var outputURL: URL?
+
+    public init(version: BTTorrentVersion = .hybrid, pieceSize: Int? = nil, hashThreads: Int = 0, trackers: [[String]] = [], webSeeds: [String] = [], isPrivate: Bool = false, comment: String? = nil, creator: String? = nil, outputURL: URL? = nil) {
+        self.version = version
+        self.pieceSize = pieceSize
+        self.hashThreads = hashThreads
+        self.trackers = trackers
+        self.webSeeds = webSeeds
+        self.isPrivate = isPrivate
+        self.comment = comment
+        self.creator = creator
+        self.outputURL = outputURL
+    }
+}
+
+@available(iOS 13.0, macOS 13.0, *)
+public struct BTCreatedTorrent: Sendable {
+    /// Bencoded .torrent file.
+    public let data: Data
+    /// Hex id as returned by `BTTorrent.id()`.
+    public let id: String
+    public let numPieces: Int
+    public let pieceSize: Int
+    public let totalSize: Int64
+}
+
+/// One session_stats sample. Metrics the linked libtorrent lacks read -1.
+@available(iOS 13.0, macOS 13.0, *)
+public struct BTSessionStats: Sendable {
+    public let timestampUs: Int64
+    /// Since the previous sample, 0 for the first; rates are 0 until there is one.
+    public let intervalUs: Int64
+
+    public let peersConnected: Int64
+    public let peersHalfOpen: Int64
+    public let peersUpInterested: Int64
+    public let peersDownInterested: Int64
+    public let peersUpUnchoked: Int64
+    public let peersDownUnchoked: Int64
+    /// Peers waiting on disk reads before they can be sent to.
+    public let peersUpDisk: Int64
+    /// Peers waiting on disk writes before more is received from them.
+    public let peersDownDisk: Int64
+
+    public let torrentsChecking: Int64
+    public let torrentsDownloading: Int64
+    public let torrentsSeeding: Int64
+    public let torrentsQueued: Int64
+    public let torrentsStopped: Int64
+    public let torrentsError: Int64
+
+    public let diskQueuedJobs: Int64
+    public let diskRunningJobs: Int64
+    public let diskQueuedWriteBytes: Int64
+    public let diskBlocksInUse: Int64
+    public let limiterUpBytes: Int64
+    public let limiterDownBytes: Int64
+
+    public let recvBytes: Int64
+    public let sentBytes: Int64
+    /// Drops in the core's queues plus libtorrent alert queue overflows.
+    public let alertsDropped: Int64
+
+    public let recvBytesPerSecond: Double
+    public let sentBytesPerSecond: Double
+    public let recvPayloadPerSecond: Double
+    public let sentPayloadPerSecond: Double
+    public let diskBlocksReadPerSecond: Double
+    public let diskBlocksWrittenPerSecond: Double
+    public let diskBlocksHashedPerSecond: Double
+}
+
+/// A libtorrent counter by name ("net.recv_bytes"). For gauges `perSecond` is the value.
+@available(iOS 13.0, macOS 13.0, *)
+public struct BTStatsMetric: Sendable {
+    public let name: String
+    public let isCounter: Bool
+    public let value: Int64
+    public let perSecond: Double
 }
 
 @available(iOS 13.0, macOS 13.0, *)
@@ -99,3 +751,68 @@ public struct BTResumeDataItem: Sendable {
 }
 
 
+
+@available(iOS 13.0, macOS 13.0, *)
+public struct BTAlertQueueCounters: Sendable {
+    public var pushed: Int64 = 0
+    public var dropped: Int64 = 0
+    public var depth: Int = 0
+    public var capacity: Int = 0
+}
+
+@available(iOS 13.0, macOS 13.0, *)
+public struct BTAlertQueueStats: Sendable {
+    public let status: BTAlertQueueCounters
+    public let deltas: BTAlertQueueCounters
+    public let resume: BTAlertQueueCounters
+    public let lifecycle: BTAlertQueueCounters
+    public let stats: BTAlertQueueCounters
+    public let libtorrentOverflowEvents: Int64
+}
+
+@available(iOS 13.0, macOS 13.0, *)
+public struct BTStatusFields: OptionSet, Sendable {
+    public let rawValue: UInt32
+    public init(rawValue: UInt32) { self.rawValue = rawValue }
+
+    public static let progress = BTStatusFields(rawValue: 1 << 0)
+    public static let downloadRate = BTStatusFields(rawValue: 1 << 1)
+    public static let uploadRate = BTStatusFields(rawValue: 1 << 2)
+    public static let totalDownloaded = BTStatusFields(rawValue: 1 << 3)
+    public static let totalUploaded = BTStatusFields(rawValue: 1 << 4)
+    public static let numPeers = BTStatusFields(rawValue: 1 << 5)
+    public static let numSeeds = BTStatusFields(rawValue: 1 << 6)
+    public static let state = BTStatusFields(rawValue: 1 << 7)
+    public static let hasMetadata = BTStatusFields(rawValue: 1 << 8)
+    public static let identity = BTStatusFields(rawValue: 1 << 9)
+}
+
+@available(iOS 13.0, macOS 13.0, *)
+public struct BTTorrentIdentity: Sendable {
+    public let torrentID: UInt32
+    public let id: String
+    public let name: String
+}
+
+@available(iOS 13.0, macOS 13.0, *)
+public struct BTStatusDelta: Sendable {
+    public let torrentID: UInt32
+    public let changed: BTStatusFields
+    public let progress: Double
+    public let downloadRate: Int64
+    public let uploadRate: Int64
+    public let totalDownloaded: Int64
+    public let totalUploaded: Int64
+    public let numPeers: Int
+    public let numSeeds: Int
+    public let state: BTTorrentState
+    public let hasMetadata: Bool
+}
+
+@available(iOS 13.0, macOS 13.0, *)
+public enum BTStatusEvent: Sendable {
+    case added(BTTorrentIdentity, BTStatusDelta)
+    case updated(BTStatusDelta)
+    case identityChanged(BTTorrentIdentity)
+    case removed(UInt32)
+}
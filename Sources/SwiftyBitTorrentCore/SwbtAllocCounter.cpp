@@ -0,0 +1,52 @@
+// Opt-in allocation counting for benchmarks. Build the core with
+// -DSWBT_COUNT_ALLOCATIONS to replace the global operator new/delete with
+// versions that count per thread; otherwise this only provides the query,
+// which reports that counting is unavailable.
+//
+// Counts cover C++ allocations made on the calling thread (the bridge and any
+// libtorrent code it runs inline). Work the call hands to libtorrent's network
+// thread, and Swift-side mallocs, are not included.
+
+#include "SwiftyBitTorrentCore.h"
+
+#include <cstdlib>
+#include <new>
+
+namespace {
+thread_local uint64_t t_alloc_count = 0;
+thread_local uint64_t t_alloc_bytes = 0;
+} // namespace
+
+#if defined(SWBT_COUNT_ALLOCATIONS)
+
+void* operator new(std::size_t size) {
+    ++t_alloc_count;
+    t_alloc_bytes += size;
+    if (size == 0) size = 1;
+    while (true) {
+        if (void* p = std::malloc(size)) return p;
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) throw std::bad_alloc();
+        handler();
+    }
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+#endif
+
+int swbt_debug_thread_allocations(uint64_t* out_count, uint64_t* out_bytes) {
+    if (out_count) *out_count = t_alloc_count;
+    if (out_bytes) *out_bytes = t_alloc_bytes;
+#if defined(SWBT_COUNT_ALLOCATIONS)
+    return 1;
+#else
+    return 0;
+#endif
+}
@@ -0,0 +1,288 @@
+#include "SwbtBlocklist.h"
+
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+using V4Range = SwbtBlocklist::V4Range;
+using V6Address = SwbtBlocklist::V6Address;
+using V6Range = SwbtBlocklist::V6Range;
+
+struct Address {
+    bool v6 = false;
+    uint32_t v4 = 0;
+    V6Address a6{0, 0};
+};
+
+bool v6_less(const V6Address& a, const V6Address& b) {
+    return a.hi != b.hi ? a.hi < b.hi : a.lo < b.lo;
+}
+
+bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+void trim(const char*& begin, const char*& end) {
+    while (begin < end && is_space(*begin)) ++begin;
+    while (end > begin && is_space(end[-1])) --end;
+}
+
+const char* find_last(const char* begin, const char* end, char c) {
+    for (const char* p = end; p > begin; --p) {
+        if (p[-1] == c) return p - 1;
+    }
+    return end;
+}
+
+bool parse_uint(const char* begin, const char* end, int max_digits, uint32_t& out) {
+    trim(begin, end);
+    if (begin == end || end - begin > max_digits) return false;
+    uint32_t v = 0;
+    for (const char* p = begin; p < end; ++p) {
+        if (*p < '0' || *p > '9') return false;
+        v = v * 10 + static_cast<uint32_t>(*p - '0');
+    }
+    out = v;
+    return true;
+}
+
+// Dotted quad; octets may have leading zeros (DAT pads them) and are decimal.
+bool parse_v4(const char* begin, const char* end, uint32_t& out) {
+    uint32_t v = 0;
+    for (int i = 0; i < 4; ++i) {
+        const char* dot = i < 3 ? std::find(begin, end, '.') : end;
+        uint32_t octet = 0;
+        if (dot == end && i < 3) return false;
+        if (!parse_uint(begin, dot, 3, octet) || octet > 255) return false;
+        v = (v << 8) | octet;
+        begin = dot + (i < 3 ? 1 : 0);
+    }
+    out = v;
+    return true;
+}
+
+bool parse_address(const char* begin, const char* end, Address& out) {
+    trim(begin, end);
+    if (begin == end) return false;
+    if (std::find(begin, end, ':') == end) {
+        out.v6 = false;
+        return parse_v4(begin, end, out.v4);
+    }
+    char buf[64];
+    if (end - begin >= static_cast<long>(sizeof(buf))) return false;
+    std::memcpy(buf, begin, static_cast<size_t>(end - begin));
+    buf[end - begin] = '\0';
+    uint8_t bytes[16];
+    if (::inet_pton(AF_INET6, buf, bytes) != 1) return false;
+    out.v6 = true;
+    out.a6 = SwbtBlocklist::v6_from_bytes(bytes);
+    return true;
+}
+
+// "first - last" with plain addresses on both sides.
+bool parse_range(const char* begin, const char* end, Address& first, Address& last) {
+    const char* dash = find_last(begin, end, '-');
+    return dash != end && parse_address(begin, dash, first) && parse_address(dash + 1, end, last);
+}
+
+bool parse_prefix(const char* begin, const char* end, Address& first, Address& last) {
+    const char* slash = std::find(begin, end, '/');
+    if (!parse_address(begin, slash, first)) return false;
+    last = first;
+    if (slash == end) return true;
+    uint32_t bits = 0;
+    if (!parse_uint(slash + 1, end, 3, bits) || bits > (first.v6 ? 128u : 32u)) return false;
+    if (!first.v6) {
+        uint32_t mask = bits == 0 ? 0 : ~uint32_t{0} << (32 - bits);
+        first.v4 &= mask;
+        last.v4 = first.v4 | ~mask;
+        return true;
+    }
+    uint64_t hi_mask = bits >= 64 ? ~uint64_t{0} : (bits == 0 ? 0 : ~uint64_t{0} << (64 - bits));
+    uint64_t lo_mask = bits <= 64 ? 0 : (bits == 128 ? ~uint64_t{0} : ~uint64_t{0} << (128 - bits));
+    first.a6.hi &= hi_mask;
+    first.a6.lo &= lo_mask;
+    last.a6.hi = first.a6.hi | ~hi_mask;
+    last.a6.lo = first.a6.lo | ~lo_mask;
+    return true;
+}
+
+enum class LineKind { blocked, allowed, malformed };
+
+LineKind parse_line(const char* begin, const char* end, Address& first, Address& last) {
+    // DAT: the part before the first comma is a range and the next field the level
+    const char* comma = std::find(begin, end, ',');
+    if (comma != end && parse_range(begin, comma, first, last)) {
+        const char* level_end = std::find(comma + 1, end, ',');
+        uint32_t level = 0;
+        if (!parse_uint(comma + 1, level_end, 3, level)) return LineKind::malformed;
+        if (level > 127) return LineKind::allowed;
+    } else if (std::find(begin, end, '-') != end) {
+        if (!parse_range(begin, end, first, last)) {
+            // P2P: the description runs up to the last ':' before the start address
+            const char* dash = find_last(begin, end, '-');
+            const char* colon = find_last(begin, dash, ':');
+            if (colon == dash || !parse_address(colon + 1, dash, first) || !parse_address(dash + 1, end, last)) {
+                return LineKind::malformed;
+            }
+        }
+    } else if (!parse_prefix(begin, end, first, last)) {
+        return LineKind::malformed;
+    }
+    if (first.v6 != last.v6) return LineKind::malformed;
+    if (first.v6 ? v6_less(last.a6, first.a6) : last.v4 < first.v4) return LineKind::malformed;
+    return LineKind::blocked;
+}
+
+void add_line(const char* begin, const char* end, std::vector<V4Range>& v4, std::vector<V6Range>& v6,
+              SwbtBlocklistLoadStats& stats) {
+    trim(begin, end);
+    if (begin == end || *begin == '#' || (end - begin >= 2 && begin[0] == '/' && begin[1] == '/')) return;
+    ++stats.lines;
+    Address first, last;
+    switch (parse_line(begin, end, first, last)) {
+    case LineKind::allowed:
+        ++stats.allowed_lines;
+        return;
+    case LineKind::malformed:
+        ++stats.malformed_lines;
+        return;
+    case LineKind::blocked:
+        break;
+    }
+    ++stats.entries;
+    if (first.v6) v6.push_back(V6Range{first.a6, last.a6});
+    else v4.push_back(V4Range{first.v4, last.v4});
+}
+
+// Lists are often rewritten in place by updaters, so the file is read in
+// chunks rather than mapped: a truncation mid-parse only shortens the input.
+const size_t kReadChunk = 1 << 20;
+
+bool parse_file(const std::string& path, std::vector<V4Range>& v4, std::vector<V6Range>& v6,
+                SwbtBlocklistLoadStats& stats, std::string& error) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error = "open " + path + ": " + std::strerror(errno);
+        return false;
+    }
+    std::vector<char> buf(kReadChunk);
+    size_t held = 0;          // unfinished line carried over at the front of buf
+    bool first_line = true;
+    auto line = [&](const char* begin, const char* end) {
+        if (first_line && end - begin >= 3 && std::memcmp(begin, "\xEF\xBB\xBF", 3) == 0) begin += 3;
+        first_line = false;
+        add_line(begin, end, v4, v6, stats);
+    };
+    for (;;) {
+        if (held == buf.size()) buf.resize(buf.size() * 2);
+        ssize_t n = ::read(fd, buf.data() + held, buf.size() - held);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            error = "read " + path + ": " + std::strerror(errno);
+            ::close(fd);
+            return false;
+        }
+        const char* p = buf.data();
+        const char* data_end = p + held + n;
+        if (n == 0) {
+            if (p < data_end) line(p, data_end);
+            break;
+        }
+        while (const char* eol = static_cast<const char*>(std::memchr(p, '\n', static_cast<size_t>(data_end - p)))) {
+            line(p, eol);
+            p = eol + 1;
+        }
+        held = static_cast<size_t>(data_end - p);
+        std::memmove(buf.data(), p, held);
+    }
+    ::close(fd);
+    ++stats.files;
+    return true;
+}
+
+void merge_v4(std::vector<V4Range>& ranges) {
+    std::sort(ranges.begin(), ranges.end(), [](const V4Range& a, const V4Range& b) { return a.first < b.first; });
+    std::size_t n = 0;
+    for (const V4Range& r : ranges) {
+        if (n > 0 && uint64_t{r.first} <= uint64_t{ranges[n - 1].last} + 1) {
+            ranges[n - 1].last = std::max(ranges[n - 1].last, r.last);
+        } else {
+            ranges[n++] = r;
+        }
+    }
+    ranges.resize(n);
+    ranges.shrink_to_fit();
+}
+
+void merge_v6(std::vector<V6Range>& ranges) {
+    std::sort(ranges.begin(), ranges.end(), [](const V6Range& a, const V6Range& b) { return v6_less(a.first, b.first); });
+    std::size_t n = 0;
+    for (const V6Range& r : ranges) {
+        if (n > 0) {
+            V6Address& last = ranges[n - 1].last;
+            V6Address next{last.lo == ~uint64_t{0} ? last.hi + 1 : last.hi, last.lo + 1};
+            bool at_end = last.hi == ~uint64_t{0} && last.lo == ~uint64_t{0};
+            if (at_end || !v6_less(next, r.first)) {
+                if (v6_less(last, r.last)) last = r.last;
+                continue;
+            }
+        }
+        ranges[n++] = r;
+    }
+    ranges.resize(n);
+    ranges.shrink_to_fit();
+}
+
+} // namespace
+
+std::shared_ptr<const SwbtBlocklist> SwbtBlocklist::load(const std::vector<std::string>& paths,
+                                                         SwbtBlocklistLoadStats& stats,
+                                                         std::string& error) {
+    auto list = std::make_shared<SwbtBlocklist>();
+    for (const std::string& path : paths) {
+        if (!parse_file(path, list->v4_, list->v6_, stats, error)) return nullptr;
+    }
+    merge_v4(list->v4_);
+    merge_v6(list->v6_);
+    return list;
+}
+
+bool SwbtBlocklist::contains(uint32_t address) const {
+    auto it = std::upper_bound(v4_.begin(), v4_.end(), address,
+                               [](uint32_t a, const V4Range& r) { return a < r.first; });
+    return it != v4_.begin() && address <= std::prev(it)->last;
+}
+
+bool SwbtBlocklist::contains(const V6Address& address) const {
+    auto it = std::upper_bound(v6_.begin(), v6_.end(), address,
+                               [](const V6Address& a, const V6Range& r) { return v6_less(a, r.first); });
+    return it != v6_.begin() && !v6_less(std::prev(it)->last, address);
+}
+
+uint64_t SwbtBlocklist::v4_addresses() const {
+    uint64_t n = 0;
+    for (const V4Range& r : v4_) n += uint64_t{r.last} - r.first + 1;
+    return n;
+}
+
+int64_t SwbtBlocklist::memory_bytes() const {
+    return static_cast<int64_t>(sizeof(*this) + v4_.capacity() * sizeof(V4Range) + v6_.capacity() * sizeof(V6Range));
+}
+
+SwbtBlocklist::V6Address SwbtBlocklist::v6_from_bytes(const uint8_t bytes[16]) {
+    V6Address a{0, 0};
+    for (int i = 0; i < 8; ++i) a.hi = (a.hi << 8) | bytes[i];
+    for (int i = 8; i < 16; ++i) a.lo = (a.lo << 8) | bytes[i];
+    return a;
+}
+
+void SwbtBlocklist::v6_to_bytes(const V6Address& address, uint8_t bytes[16]) {
+    for (int i = 0; i < 8; ++i) bytes[i] = static_cast<uint8_t>(address.hi >> (56 - 8 * i));
+    for (int i = 0; i < 8; ++i) bytes[8 + i] = static_cast<uint8_t>(address.lo >> (56 - 8 * i));
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+// IP blocklist parsed into sorted, merged ranges: two flat arrays (IPv4, IPv6)
+// answered by binary search. Independent of libtorrent; the session turns it
+// into its ip_filter.
+//
+// Line formats, detected per line (one file may mix them):
+//   P2P (PeerGuardian)   some description:1.2.3.0-1.2.3.255
+//   DAT (eMule)          001.002.003.000 - 001.002.003.255 , 000 , description
+//                        entries with an access level above 127 are allowed, not blocked
+//   CIDR, ranges, IPs    1.2.3.0/24   2001:db8::/32   1.2.3.0-1.2.3.255   1.2.3.4
+// Blank lines and lines starting with '#' or '//' are skipped.
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct SwbtBlocklistLoadStats {
+    int64_t files = 0;
+    int64_t lines = 0;              // non-blank, non-comment lines
+    int64_t entries = 0;            // ranges parsed, before merging
+    int64_t allowed_lines = 0;      // DAT entries above level 127
+    int64_t malformed_lines = 0;
+};
+
+class SwbtBlocklist {
+public:
+    struct V4Range {
+        uint32_t first;
+        uint32_t last;
+    };
+    struct V6Address {
+        uint64_t hi;
+        uint64_t lo;
+    };
+    struct V6Range {
+        V6Address first;
+        V6Address last;
+    };
+
+    // Reads and merges every file. Returns nullptr and fills error if a file
+    // can't be read; malformed lines are only counted.
+    static std::shared_ptr<const SwbtBlocklist> load(const std::vector<std::string>& paths,
+                                                     SwbtBlocklistLoadStats& stats,
+                                                     std::string& error);
+
+    bool contains(uint32_t address) const;
+    bool contains(const V6Address& address) const;
+
+    const std::vector<V4Range>& v4() const { return v4_; }
+    const std::vector<V6Range>& v6() const { return v6_; }
+    uint64_t v4_addresses() const;
+    int64_t memory_bytes() const;
+
+    static V6Address v6_from_bytes(const uint8_t bytes[16]);
+    static void v6_to_bytes(const V6Address& address, uint8_t bytes[16]);
+
+private:
+    std::vector<V4Range> v4_;
+    std::vector<V6Range> v6_;
+};
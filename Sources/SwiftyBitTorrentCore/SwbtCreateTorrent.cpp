@@ -0,0 +1,189 @@
+#include "SwiftyBitTorrentCore.h"
+
+#if defined(SWBT_USE_LIBTORRENT)
+
+#include "SwbtCreateTorrent.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <thread>
+
+#include <libtorrent/create_torrent.hpp>
+#include <libtorrent/bencode.hpp>
+#include <libtorrent/bdecode.hpp>
+#include <libtorrent/settings_pack.hpp>
+
+namespace {
+
+void set_message(swbt_create_result_t* out, const std::string& msg) {
+    if (!out) return;
+    std::size_t n = std::min(sizeof(out->message) - 1, msg.size());
+    std::memcpy(out->message, msg.data(), n);
+    out->message[n] = '\0';
+}
+
+template <typename Digest>
+void hex_id(const Digest& d, char* out, std::size_t out_len) {
+    static const char kHex[] = "0123456789abcdef";
+    auto bytes = reinterpret_cast<const unsigned char*>(d.data());
+    std::size_t n = 0;
+    for (std::size_t i = 0; i < static_cast<std::size_t>(d.size()) && n + 2 < out_len; ++i) {
+        unsigned char b = bytes[i];
+        out[n++] = kHex[b >> 4];
+        out[n++] = kHex[b & 0xF];
+    }
+    out[n] = '\0';
+}
+
+// "/a/b/dir/" -> ("/a/b", "/a/b/dir")
+void split_path(std::string path, std::string& parent, std::string& target) {
+    while (path.size() > 1 && path.back() == '/') path.pop_back();
+    target = path;
+    std::size_t slash = path.find_last_of('/');
+    if (slash == std::string::npos) parent = ".";
+    else if (slash == 0) parent = "/";
+    else parent = path.substr(0, slash);
+}
+
+bool valid_piece_size(int32_t size) {
+    return size == 0 || (size >= 16 * 1024 && (size & (size - 1)) == 0);
+}
+
+} // namespace
+
+swbt_error_code_e swbt_build_torrent(const swbt_create_params_t* params,
+                                     SwbtCreatedTorrent& out,
+                                     swbt_create_result_t* out_result) {
+    if (!params || !params->path || params->path[0] == '\0') return SWBT_ERR_INVALID_ARG;
+    if (params->version < SWBT_TORRENT_HYBRID || params->version > SWBT_TORRENT_V2) return SWBT_ERR_INVALID_ARG;
+    if (!valid_piece_size(params->piece_size)) {
+        set_message(out_result, "piece_size must be 0 or a power of two >= 16 KiB");
+        return SWBT_ERR_INVALID_ARG;
+    }
+    if ((params->num_trackers > 0 && !params->trackers) || (params->num_web_seeds > 0 && !params->web_seeds)) {
+        return SWBT_ERR_INVALID_ARG;
+    }
+
+    std::string parent, target;
+    split_path(params->path, parent, target);
+
+    lt::file_storage fs;
+    lt::add_files(fs, target, [](std::string const& p) {
+        std::size_t slash = p.find_last_of('/');
+        std::size_t start = slash == std::string::npos ? 0 : slash + 1;
+        return start >= p.size() || p[start] != '.';
+    });
+    if (fs.num_files() == 0) {
+        set_message(out_result, "no files under " + target);
+        return SWBT_ERR_GENERIC;
+    }
+
+    lt::create_flags_t flags{};
+    if (params->version == SWBT_TORRENT_V1) flags |= lt::create_torrent::v1_only;
+    else if (params->version == SWBT_TORRENT_V2) flags |= lt::create_torrent::v2_only;
+    lt::create_torrent ct(fs, params->piece_size, flags);
+
+    for (int i = 0; i < params->num_trackers; ++i) {
+        if (!params->trackers[i] || params->trackers[i][0] == '\0') continue;
+        ct.add_tracker(params->trackers[i], params->tracker_tiers ? params->tracker_tiers[i] : i);
+    }
+    for (int i = 0; i < params->num_web_seeds; ++i) {
+        if (params->web_seeds[i] && params->web_seeds[i][0] != '\0') ct.add_url_seed(params->web_seeds[i]);
+    }
+    if (params->comment) ct.set_comment(params->comment);
+    if (params->creator) ct.set_creator(params->creator);
+    ct.set_priv(params->is_private != 0);
+
+    // set_piece_hashes runs its own disk I/O; these size its hashing pool
+    int threads = params->hash_threads > 0 ? params->hash_threads
+                                           : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    lt::settings_pack sp;
+    sp.set_int(lt::settings_pack::hashing_threads, threads);
+    sp.set_int(lt::settings_pack::aio_threads, std::min(threads, 4));
+
+    const int32_t num_pieces = ct.num_pieces();
+    int32_t done = 0;
+    lt::error_code ec;
+    lt::set_piece_hashes(ct, parent, sp, [&](lt::piece_index_t) {
+        ++done;
+        if (params->progress) params->progress(params->progress_context, done, num_pieces);
+    }, ec);
+    if (ec) {
+        set_message(out_result, ec.message());
+        return SWBT_ERR_GENERIC;
+    }
+
+    out.buf.clear();
+    lt::bencode(std::back_inserter(out.buf), ct.generate());
+    lt::bdecode_node node = lt::bdecode(lt::span<char const>(out.buf.data(), static_cast<std::ptrdiff_t>(out.buf.size())), ec);
+    if (!ec) out.ti = std::make_shared<lt::torrent_info>(node, ec);
+    if (ec) {
+        set_message(out_result, ec.message());
+        return SWBT_ERR_GENERIC;
+    }
+    out.save_path = parent;
+
+    if (params->output_path && params->output_path[0] != '\0') {
+        FILE* f = std::fopen(params->output_path, "wb");
+        bool ok = f && std::fwrite(out.buf.data(), 1, out.buf.size(), f) == out.buf.size();
+        if (f && std::fclose(f) != 0) ok = false;
+        if (!ok) {
+            set_message(out_result, std::string("cannot write ") + params->output_path);
+            return SWBT_ERR_GENERIC;
+        }
+    }
+
+    if (out_result) {
+        out_result->data = static_cast<uint8_t*>(std::malloc(out.buf.size()));
+        if (!out_result->data) return SWBT_ERR_GENERIC;
+        std::memcpy(out_result->data, out.buf.data(), out.buf.size());
+        out_result->size = static_cast<int32_t>(out.buf.size());
+        lt::info_hash_t ih = out.ti->info_hashes();
+        if (ih.has_v2()) hex_id(ih.v2, out_result->info_hash, sizeof(out_result->info_hash));
+        else hex_id(ih.v1, out_result->info_hash, sizeof(out_result->info_hash));
+        out_result->num_pieces = num_pieces;
+        out_result->piece_size = ct.piece_length();
+        out_result->total_size = fs.total_size();
+    }
+    return SWBT_OK;
+}
+
+swbt_error_code_e swbt_create_torrent(const swbt_create_params_t* params,
+                                      swbt_create_result_t* out_result) {
+    if (!out_result) return SWBT_ERR_INVALID_ARG;
+    *out_result = swbt_create_result_t{};
+    SwbtCreatedTorrent created;
+    return swbt_build_torrent(params, created, out_result);
+}
+
+#else // non-macOS (stubs)
+
+#include <cstdlib>
+#include <cstring>
+
+swbt_error_code_e swbt_create_torrent(const swbt_create_params_t* /*params*/,
+                                      swbt_create_result_t* out_result) {
+    if (out_result) std::memset(out_result, 0, sizeof(*out_result));
+    return SWBT_ERR_GENERIC;
+}
+
+swbt_error_code_e swbt_session_create_and_seed(swbt_session_t* /*session*/,
+                                               const swbt_create_params_t* /*params*/,
+                                               swbt_create_result_t* out_result,
+                                               swbt_torrent_handle_t** out_handle) {
+    if (out_result) std::memset(out_result, 0, sizeof(*out_result));
+    if (out_handle) *out_handle = nullptr;
+    return SWBT_ERR_GENERIC;
+}
+
+#endif
+
+void swbt_create_result_free(swbt_create_result_t* result) {
+    if (!result) return;
+    std::free(result->data);
+    result->data = nullptr;
+    result->size = 0;
+}
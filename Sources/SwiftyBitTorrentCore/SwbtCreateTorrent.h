@@ -0,0 +1,28 @@
+#pragma once
+
+// Torrent creation shared by swbt_create_torrent and swbt_session_create_and_seed.
+
+#if defined(SWBT_USE_LIBTORRENT)
+
+#include "SwiftyBitTorrentCore.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <libtorrent/torrent_info.hpp>
+
+namespace lt = libtorrent;
+
+struct SwbtCreatedTorrent {
+    std::vector<char> buf;                  // bencoded .torrent
+    std::shared_ptr<lt::torrent_info> ti;   // parsed back from buf
+    std::string save_path;                  // directory holding params->path
+};
+
+// Hashes params->path and fills out. On failure out_result->message has the reason.
+swbt_error_code_e swbt_build_torrent(const swbt_create_params_t* params,
+                                     SwbtCreatedTorrent& out,
+                                     swbt_create_result_t* out_result);
+
+#endif // SWBT_USE_LIBTORRENT
@@ -0,0 +1,768 @@
+#include "SwbtDiskIO.h"
+
+#if defined(SWBT_USE_LIBTORRENT)
+
+#include "SwiftyBitTorrentCore.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <list>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <libtorrent/add_torrent_params.hpp>
+#include <libtorrent/disk_buffer_holder.hpp>
+#include <libtorrent/error_code.hpp>
+#include <libtorrent/file_storage.hpp>
+#include <libtorrent/hasher.hpp>
+#include <libtorrent/io_context.hpp>
+#include <libtorrent/posix_disk_io.hpp>
+#include <libtorrent/storage_defs.hpp>
+
+void SwbtDiskIOShared::note_evicted(const lt::sha1_hash& info_hash) {
+    std::lock_guard<std::mutex> lk(mutex_);
+    evicted_.insert(info_hash);
+}
+
+std::vector<lt::sha1_hash> SwbtDiskIOShared::take_evicted() {
+    std::lock_guard<std::mutex> lk(mutex_);
+    std::vector<lt::sha1_hash> out(evicted_.begin(), evicted_.end());
+    evicted_.clear();
+    return out;
+}
+
+namespace {
+
+const int kBlockSize = 0x4000;                    // libtorrent's request size
+const int64_t kMaxQueuedWriteBytes = 64 << 20;    // past this, writers wait for on_disk()
+
+lt::storage_error errno_error(int err, lt::operation_t op) {
+    return lt::storage_error(lt::error_code(err, lt::generic_category()), op);
+}
+
+lt::storage_error errno_error(int err, lt::file_index_t file, lt::operation_t op) {
+    return lt::storage_error(lt::error_code(err, lt::generic_category()), file, op);
+}
+
+// Data that was never written (or was evicted) reads as ENOENT; hashing treats
+// it as a mismatch rather than a disk error.
+bool is_missing(const lt::storage_error& se) {
+    return se.ec == lt::error_code(ENOENT, lt::generic_category());
+}
+
+// Reserves the file's blocks up to size, then extends it there. Returns 0 or an errno.
+int preallocate(int fd, int64_t current, int64_t size) {
+#if defined(__APPLE__)
+    fstore_t fs{};
+    fs.fst_flags = F_ALLOCATECONTIG | F_ALLOCATEALL;
+    fs.fst_posmode = F_PEOFPOSMODE;
+    fs.fst_offset = 0;
+    fs.fst_length = size - current;
+    if (::fcntl(fd, F_PREALLOCATE, &fs) != 0) {
+        fs.fst_flags = F_ALLOCATEALL;
+        if (::fcntl(fd, F_PREALLOCATE, &fs) != 0) return errno;
+    }
+    return ::ftruncate(fd, size) == 0 ? 0 : errno;
+#else
+    (void)current;
+    return ::posix_fallocate(fd, 0, size);
+#endif
+}
+
+bool pwrite_all(int fd, const char* data, int64_t len, int64_t offset) {
+    while (len > 0) {
+        ssize_t n = ::pwrite(fd, data, static_cast<size_t>(len), offset);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += n;
+        offset += n;
+        len -= n;
+    }
+    return true;
+}
+
+void make_parent_dirs(const std::string& path) {
+    for (size_t pos = path.find('/', 1); pos != std::string::npos; pos = path.find('/', pos + 1)) {
+        ::mkdir(path.substr(0, pos).c_str(), 0755);
+    }
+}
+
+class SwbtStorage {
+public:
+    explicit SwbtStorage(const lt::storage_params& p)
+        : files_(p.mapped_files ? *p.mapped_files : p.files), info_hash_(p.info_hash) {}
+    virtual ~SwbtStorage() = default;
+
+    virtual void read(lt::piece_index_t piece, int start, int len, char* out, lt::storage_error& se) = 0;
+    virtual void write(lt::piece_index_t piece, int start, const char* data, int len, lt::storage_error& se) = 0;
+    virtual lt::status_t check(bool resume_has_pieces, lt::storage_error& se) = 0;
+    virtual lt::status_t move(const std::string& path, lt::storage_error& se) = 0;
+    virtual void rename(lt::file_index_t index, const std::string& name, lt::storage_error& se) = 0;
+    virtual void remove(lt::storage_error& se) = 0;
+    virtual void release() {}
+    virtual void clear_piece(lt::piece_index_t) {}
+
+    // Job threads read this unlocked; only the mmap storage's rename() writes it.
+    const lt::file_storage& files() const { return files_; }
+    const lt::sha1_hash& info_hash() const { return info_hash_; }
+
+protected:
+    lt::file_storage files_;
+    const lt::sha1_hash info_hash_;
+};
+
+// ---------------------------------------------------------------------------
+// memory
+
+class SwbtMemoryStorage;
+
+// LRU of every piece held by one disk I/O object. Its mutex also guards the
+// piece maps of all storages attached to it.
+class SwbtMemoryPool {
+public:
+    struct Entry {
+        SwbtMemoryStorage* owner;
+        int piece;
+    };
+    using Iter = std::list<Entry>::iterator;
+
+    SwbtMemoryPool(int64_t cap, std::shared_ptr<SwbtDiskIOShared> shared)
+        : cap_(cap), shared_(std::move(shared)) {}
+
+    std::mutex mutex;
+
+    int64_t cap() const { return cap_; }
+
+    // Caller holds mutex. Charges bytes for a new piece, then evicts from the cold
+    // end until under the cap; the new piece itself is never evicted.
+    Iter add(SwbtMemoryStorage* owner, int piece, int64_t bytes);
+    void touch(Iter it) { lru_.splice(lru_.end(), lru_, it); }
+    void forget(Iter it, int64_t bytes) {
+        lru_.erase(it);
+        shared_->resident_bytes.fetch_sub(bytes, std::memory_order_relaxed);
+    }
+
+private:
+    const int64_t cap_;
+    std::shared_ptr<SwbtDiskIOShared> shared_;
+    std::list<Entry> lru_;
+};
+
+class SwbtMemoryStorage final : public SwbtStorage {
+public:
+    SwbtMemoryStorage(const lt::storage_params& p, SwbtMemoryPool& pool) : SwbtStorage(p), pool_(pool) {}
+
+    ~SwbtMemoryStorage() override {
+        std::lock_guard<std::mutex> lk(pool_.mutex);
+        drop_all();
+    }
+
+    void read(lt::piece_index_t piece, int start, int len, char* out, lt::storage_error& se) override {
+        std::lock_guard<std::mutex> lk(pool_.mutex);
+        auto it = pieces_.find(static_cast<int>(piece));
+        if (it == pieces_.end() || start + len > it->second.size) {
+            se = errno_error(ENOENT, lt::operation_t::file_read);
+            return;
+        }
+        std::memcpy(out, it->second.data.get() + start, static_cast<size_t>(len));
+        pool_.touch(it->second.lru);
+    }
+
+    void write(lt::piece_index_t piece, int start, const char* data, int len, lt::storage_error& se) override {
+        std::lock_guard<std::mutex> lk(pool_.mutex);
+        int p = static_cast<int>(piece);
+        auto it = pieces_.find(p);
+        if (it == pieces_.end()) {
+            int size = files_.piece_size(piece);
+            Piece fresh;
+            fresh.data.reset(new (std::nothrow) char[static_cast<size_t>(size)]());
+            if (!fresh.data) {
+                se = errno_error(ENOMEM, lt::operation_t::file_write);
+                return;
+            }
+            fresh.size = size;
+            it = pieces_.emplace(p, std::move(fresh)).first;
+            it->second.lru = pool_.add(this, p, size);
+        }
+        Piece& pc = it->second;
+        if (start + len > pc.size) {
+            se = errno_error(EINVAL, lt::operation_t::file_write);
+            return;
+        }
+        std::memcpy(pc.data.get() + start, data, static_cast<size_t>(len));
+        pc.written += len;
+        pool_.touch(pc.lru);
+    }
+
+    lt::status_t check(bool resume_has_pieces, lt::storage_error& se) override {
+        // Would evict itself, get rechecked and download the same pieces again, forever.
+        if (pool_.cap() > 0 && files_.total_size() > pool_.cap()) {
+            se = errno_error(ENOSPC, lt::operation_t::check_resume);
+            return lt::status_t::fatal_disk_error;
+        }
+        // Nothing survives a restart: pieces claimed by resume data have to be
+        // re-verified, which fails them and puts them back on the wanted list.
+        std::lock_guard<std::mutex> lk(pool_.mutex);
+        return (resume_has_pieces || !pieces_.empty()) ? lt::status_t::need_full_check : lt::status_t::no_error;
+    }
+
+    lt::status_t move(const std::string&, lt::storage_error&) override { return lt::status_t::no_error; }
+    void rename(lt::file_index_t, const std::string&, lt::storage_error&) override {}
+
+    void remove(lt::storage_error&) override {
+        std::lock_guard<std::mutex> lk(pool_.mutex);
+        drop_all();
+    }
+
+    void clear_piece(lt::piece_index_t piece) override {
+        std::lock_guard<std::mutex> lk(pool_.mutex);
+        auto it = pieces_.find(static_cast<int>(piece));
+        if (it == pieces_.end()) return;
+        pool_.forget(it->second.lru, it->second.size);
+        pieces_.erase(it);
+    }
+
+    // Pool mutex held. Returns true when the piece had been fully written, i.e.
+    // libtorrent may already count it as verified.
+    bool evict(int piece, int64_t& bytes) {
+        auto it = pieces_.find(piece);
+        if (it == pieces_.end()) return false;
+        bytes = it->second.size;
+        bool complete = it->second.written >= it->second.size;
+        pieces_.erase(it);
+        return complete;
+    }
+
+private:
+    struct Piece {
+        std::unique_ptr<char[]> data;
+        int size = 0;
+        int written = 0;          // may overcount rewrites; only used as "complete" hint
+        SwbtMemoryPool::Iter lru;
+    };
+
+    void drop_all() {
+        for (auto& kv : pieces_) pool_.forget(kv.second.lru, kv.second.size);
+        pieces_.clear();
+    }
+
+    SwbtMemoryPool& pool_;
+    std::unordered_map<int, Piece> pieces_;
+};
+
+SwbtMemoryPool::Iter SwbtMemoryPool::add(SwbtMemoryStorage* owner, int piece, int64_t bytes) {
+    Iter fresh = lru_.insert(lru_.end(), Entry{owner, piece});
+    int64_t resident = shared_->resident_bytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    while (cap_ > 0 && resident > cap_ && lru_.begin() != fresh) {
+        Entry victim = lru_.front();
+        lru_.pop_front();
+        int64_t freed = 0;
+        if (victim.owner->evict(victim.piece, freed)) shared_->note_evicted(victim.owner->info_hash());
+        resident = shared_->resident_bytes.fetch_sub(freed, std::memory_order_relaxed) - freed;
+        shared_->evicted_pieces.fetch_add(1, std::memory_order_relaxed);
+    }
+    return fresh;
+}
+
+// ---------------------------------------------------------------------------
+// mmap
+
+class SwbtMmapStorage final : public SwbtStorage {
+public:
+    SwbtMmapStorage(const lt::storage_params& p, int64_t readahead)
+        : SwbtStorage(p), save_path_(p.path), readahead_(readahead),
+          maps_(static_cast<size_t>(files_.num_files())) {}
+
+    void read(lt::piece_index_t piece, int start, int len, char* out, lt::storage_error& se) override {
+        for (const lt::file_slice& s : slices(piece, start, len)) {
+            if (files_.pad_file_at(s.file_index)) {
+                std::memset(out, 0, static_cast<size_t>(s.size));
+            } else {
+                std::shared_ptr<Mapping> m = mapping(s.file_index, false, se);
+                if (!m) return;
+                if (s.offset + s.size > m->size) {
+                    se = errno_error(ENOENT, s.file_index, lt::operation_t::file_read);
+                    return;
+                }
+                prefetch(*m, s.offset + s.size);
+                std::memcpy(out, m->base + s.offset, static_cast<size_t>(s.size));
+            }
+            out += s.size;
+        }
+    }
+
+    void write(lt::piece_index_t piece, int start, const char* data, int len, lt::storage_error& se) override {
+        for (const lt::file_slice& s : slices(piece, start, len)) {
+            if (!files_.pad_file_at(s.file_index)) {
+                std::shared_ptr<Mapping> m = mapping(s.file_index, true, se);
+                if (!m) return;
+                // through the fd: a store into the mapping would SIGBUS on I/O errors
+                if (!pwrite_all(m->fd, data, s.size, s.offset)) {
+                    se = errno_error(errno, s.file_index, lt::operation_t::file_write);
+                    return;
+                }
+            }
+            data += s.size;
+        }
+    }
+
+    lt::status_t check(bool resume_has_pieces, lt::storage_error&) override {
+        bool any_data = false;
+        {
+            std::lock_guard<std::mutex> lk(mutex_);
+            for (lt::file_index_t f : files_.file_range()) {
+                struct stat st{};
+                if (files_.pad_file_at(f)) continue;
+                if (::stat(files_.file_path(f, save_path_).c_str(), &st) == 0 && st.st_size > 0) {
+                    any_data = true;
+                    break;
+                }
+            }
+        }
+        // Trust resume data when files are there; otherwise hash whatever exists.
+        if (any_data) return resume_has_pieces ? lt::status_t::no_error : lt::status_t::need_full_check;
+        return resume_has_pieces ? lt::status_t::need_full_check : lt::status_t::no_error;
+    }
+
+    lt::status_t move(const std::string& path, lt::storage_error& se) override {
+        std::lock_guard<std::mutex> lk(mutex_);
+        reset_maps();
+        for (lt::file_index_t f : files_.file_range()) {
+            if (files_.pad_file_at(f)) continue;
+            std::string from = files_.file_path(f, save_path_);
+            std::string to = files_.file_path(f, path);
+            struct stat st{};
+            if (::stat(from.c_str(), &st) != 0) continue;
+            make_parent_dirs(to);
+            if (::rename(from.c_str(), to.c_str()) != 0) {
+                // no copy fallback: moves across filesystems fail
+                se = errno_error(errno, f, lt::operation_t::file_rename);
+                return lt::status_t::fatal_disk_error;
+            }
+        }
+        save_path_ = path;
+        return lt::status_t::no_error;
+    }
+
+    void rename(lt::file_index_t index, const std::string& name, lt::storage_error& se) override {
+        std::lock_guard<std::mutex> lk(mutex_);
+        std::string from = files_.file_path(index, save_path_);
+        files_.rename_file(index, name);
+        std::string to = files_.file_path(index, save_path_);
+        maps_[static_cast<size_t>(static_cast<int>(index))].reset();
+        struct stat st{};
+        if (::stat(from.c_str(), &st) != 0) return;
+        make_parent_dirs(to);
+        if (::rename(from.c_str(), to.c_str()) != 0) se = errno_error(errno, index, lt::operation_t::file_rename);
+    }
+
+    void remove(lt::storage_error& se) override {
+        std::lock_guard<std::mutex> lk(mutex_);
+        reset_maps();
+        for (lt::file_index_t f : files_.file_range()) {
+            if (files_.pad_file_at(f)) continue;
+            if (::unlink(files_.file_path(f, save_path_).c_str()) != 0 && errno != ENOENT) {
+                se = errno_error(errno, f, lt::operation_t::file_remove);
+            }
+        }
+    }
+
+    void release() override {
+        std::lock_guard<std::mutex> lk(mutex_);
+        reset_maps();
+    }
+
+private:
+    // One mapping per file. Readers hold a reference while copying, so release()
+    // or a remap never unmaps memory under them.
+    struct Mapping {
+        int fd = -1;
+        char* base = nullptr;
+        int64_t size = 0;        // mapped bytes, may be short of the file entry when reading
+        bool writable = false;   // fd opened for pwrite; the mapping itself is read-only
+        ~Mapping() {
+            if (base) ::munmap(base, static_cast<size_t>(size));
+            if (fd >= 0) ::close(fd);
+        }
+    };
+
+    std::vector<lt::file_slice> slices(lt::piece_index_t piece, int start, int len) {
+        std::lock_guard<std::mutex> lk(mutex_);
+        return files_.map_block(piece, start, len);
+    }
+
+    std::shared_ptr<Mapping> mapping(lt::file_index_t f, bool write, lt::storage_error& se) {
+        std::lock_guard<std::mutex> lk(mutex_);
+        std::shared_ptr<Mapping>& slot = maps_[static_cast<size_t>(static_cast<int>(f))];
+        if (slot && (slot->writable || !write)) return slot;
+
+        auto m = std::make_shared<Mapping>();
+        std::string path = files_.file_path(f, save_path_);
+        const int64_t want = files_.file_size(f);
+        if (write) make_parent_dirs(path);
+        m->fd = ::open(path.c_str(), (write ? O_RDWR | O_CREAT : O_RDONLY) | O_CLOEXEC, 0644);
+        if (m->fd < 0) {
+            se = errno_error(errno, f, lt::operation_t::file_open);
+            return nullptr;
+        }
+        struct stat st{};
+        if (::fstat(m->fd, &st) != 0) {
+            se = errno_error(errno, f, lt::operation_t::file_stat);
+            return nullptr;
+        }
+        if (write && st.st_size < want) {
+            // all blocks up front, so running out of space shows up here and not as a fault later
+            if (int err = preallocate(m->fd, st.st_size, want)) {
+                se = errno_error(err, f, lt::operation_t::file_fallocate);
+                return nullptr;
+            }
+            st.st_size = want;
+        }
+        // never map past EOF: touching those pages would SIGBUS
+        m->size = std::min<int64_t>(want, st.st_size);
+        m->writable = write;
+        if (m->size > 0) {
+            void* p = ::mmap(nullptr, static_cast<size_t>(m->size), PROT_READ, MAP_SHARED, m->fd, 0);
+            if (p == MAP_FAILED) {
+                se = errno_error(errno, f, lt::operation_t::file_mmap);
+                return nullptr;
+            }
+            m->base = static_cast<char*>(p);
+            if (readahead_ > 0) ::madvise(p, static_cast<size_t>(m->size), MADV_RANDOM);
+        }
+        slot = m;
+        return m;
+    }
+
+    // Ask for the pages after a read before a peer requests them.
+    void prefetch(const Mapping& m, int64_t from) {
+        if (readahead_ <= 0) return;
+        static const int64_t page = ::sysconf(_SC_PAGESIZE);
+        int64_t begin = from / page * page;
+        int64_t end = std::min(m.size, from + readahead_);
+        if (end > begin) ::madvise(m.base + begin, static_cast<size_t>(end - begin), MADV_WILLNEED);
+    }
+
+    void reset_maps() {
+        for (auto& m : maps_) m.reset();
+    }
+
+    std::mutex mutex_;            // files_, save_path_, maps_
+    std::string save_path_;
+    const int64_t readahead_;
+    std::vector<std::shared_ptr<Mapping>> maps_;
+};
+
+// ---------------------------------------------------------------------------
+// disk_interface
+
+// Reads a range for hashing; missing data yields false with se cleared.
+bool read_for_hash(SwbtStorage& st, lt::piece_index_t piece, int start, int len, char* out, lt::storage_error& se) {
+    st.read(piece, start, len, out, se);
+    if (!se) return true;
+    if (is_missing(se)) se = lt::storage_error();
+    return false;
+}
+
+std::vector<char>& hash_buffer() {
+    thread_local std::vector<char> buf;
+    return buf;
+}
+
+class SwbtDiskIO final : public lt::disk_interface, public lt::buffer_allocator_interface {
+public:
+    SwbtDiskIO(lt::io_context& ioc, const SwbtDiskIOOptions& options, std::shared_ptr<SwbtDiskIOShared> shared)
+        : ioc_(ioc), options_(options), shared_(std::move(shared)) {
+        if (options_.backend == SWBT_STORAGE_MEMORY) pool_ = std::make_unique<SwbtMemoryPool>(options_.memory_cap_bytes, shared_);
+        int threads = std::max(1, options_.threads);
+        for (int i = 0; i < threads; ++i) workers_.emplace_back([this] { worker_main(); });
+    }
+
+    ~SwbtDiskIO() override { abort(true); }
+
+    lt::storage_holder new_torrent(const lt::storage_params& p, const std::shared_ptr<void>&) override {
+        std::shared_ptr<SwbtStorage> st;
+        if (pool_) st = std::make_shared<SwbtMemoryStorage>(p, *pool_);
+        else st = std::make_shared<SwbtMmapStorage>(p, options_.readahead_bytes);
+        lt::storage_index_t idx;
+        if (!free_slots_.empty()) {
+            idx = free_slots_.back();
+            free_slots_.pop_back();
+            storages_[idx] = std::move(st);
+        } else {
+            idx = storages_.end_index();
+            storages_.push_back(std::move(st));
+        }
+        return lt::storage_holder(idx, *this);
+    }
+
+    void remove_torrent(lt::storage_index_t idx) override {
+        // queued jobs keep their own reference
+        storages_[idx].reset();
+        free_slots_.push_back(idx);
+    }
+
+    void async_read(lt::storage_index_t idx, const lt::peer_request& r,
+                    std::function<void(lt::disk_buffer_holder, const lt::storage_error&)> handler,
+                    lt::disk_job_flags_t) override {
+        std::shared_ptr<SwbtStorage> st = storages_[idx];
+        run([this, st, r, handler = std::move(handler)] {
+            lt::storage_error se;
+            char* buf = new char[static_cast<size_t>(r.length)];
+            st->read(r.piece, r.start, r.length, buf, se);
+            if (se) {
+                delete[] buf;
+                buf = nullptr;
+            } else {
+                shared_->bytes_read.fetch_add(r.length, std::memory_order_relaxed);
+            }
+            post(ioc_, [this, buf, len = r.length, se, handler] {
+                handler(buf ? lt::disk_buffer_holder(*this, buf, len) : lt::disk_buffer_holder(), se);
+            });
+        });
+    }
+
+    bool async_write(lt::storage_index_t idx, const lt::peer_request& r, const char* buf,
+                     std::shared_ptr<lt::disk_observer> o,
+                     std::function<void(const lt::storage_error&)> handler,
+                     lt::disk_job_flags_t) override {
+        std::shared_ptr<SwbtStorage> st = storages_[idx];
+        int64_t queued = queued_write_bytes_.fetch_add(r.length, std::memory_order_relaxed) + r.length;
+        bool over = queued > kMaxQueuedWriteBytes && o;
+        if (over) {
+            std::lock_guard<std::mutex> lk(observer_mutex_);
+            observers_.push_back(o);
+        }
+        // buf is only valid for the duration of this call
+        run([this, st, r, data = std::vector<char>(buf, buf + r.length), handler = std::move(handler)] {
+            lt::storage_error se;
+            st->write(r.piece, r.start, data.data(), r.length, se);
+            if (!se) shared_->bytes_written.fetch_add(r.length, std::memory_order_relaxed);
+            post(ioc_, [se, handler] { handler(se); });
+            write_done(r.length);
+        });
+        return over;
+    }
+
+    void async_hash(lt::storage_index_t idx, lt::piece_index_t piece, lt::span<lt::sha256_hash> v2,
+                    lt::disk_job_flags_t flags,
+                    std::function<void(lt::piece_index_t, const lt::sha1_hash&, const lt::storage_error&)> handler) override {
+        std::shared_ptr<SwbtStorage> st = storages_[idx];
+        bool v1 = bool(flags & lt::disk_interface::v1_hash);
+        // v2 points into the torrent's hash picker, which outlives the job
+        run([this, st, piece, v1, v2, handler = std::move(handler)] {
+            lt::storage_error se;
+            const lt::file_storage& fs = st->files();
+            int v1_size = v1 ? fs.piece_size(piece) : 0;
+            int v2_size = v2.size() > 0 ? static_cast<int>(fs.piece_size2(piece)) : 0;
+            std::vector<char>& buf = hash_buffer();
+            buf.resize(static_cast<size_t>(std::max(v1_size, v2_size)));
+            bool have = read_for_hash(*st, piece, 0, static_cast<int>(buf.size()), buf.data(), se);
+
+            lt::sha1_hash h1;
+            if (have && v1) h1 = lt::hasher(buf.data(), v1_size).final();
+            for (size_t i = 0; i < v2.size(); ++i) {
+                int off = static_cast<int>(i) * kBlockSize;
+                int len = std::min(kBlockSize, v2_size - off);
+                if (have && len > 0) v2[i] = lt::hasher256().update(buf.data() + off, len).final();
+                else v2[i].clear();
+            }
+            post(ioc_, [piece, h1, se, handler] { handler(piece, h1, se); });
+        });
+    }
+
+    void async_hash2(lt::storage_index_t idx, lt::piece_index_t piece, int offset, lt::disk_job_flags_t,
+                     std::function<void(lt::piece_index_t, const lt::sha256_hash&, const lt::storage_error&)> handler) override {
+        std::shared_ptr<SwbtStorage> st = storages_[idx];
+        run([this, st, piece, offset, handler = std::move(handler)] {
+            lt::storage_error se;
+            int len = std::min(kBlockSize, static_cast<int>(st->files().piece_size2(piece)) - offset);
+            lt::sha256_hash h;
+            std::vector<char>& buf = hash_buffer();
+            buf.resize(static_cast<size_t>(std::max(len, 0)));
+            if (len > 0 && read_for_hash(*st, piece, offset, len, buf.data(), se)) {
+                h = lt::hasher256().update(buf.data(), len).final();
+            }
+            post(ioc_, [piece, h, se, handler] { handler(piece, h, se); });
+        });
+    }
+
+    void async_move_storage(lt::storage_index_t idx, std::string p, lt::move_flags_t,
+                            std::function<void(lt::status_t, const std::string&, const lt::storage_error&)> handler) override {
+        std::shared_ptr<SwbtStorage> st = storages_[idx];
+        run([this, st, p = std::move(p), handler = std::move(handler)] {
+            lt::storage_error se;
+            lt::status_t rc = st->move(p, se);
+            post(ioc_, [rc, p, se, handler] { handler(rc, p, se); });
+        });
+    }
+
+    void async_release_files(lt::storage_index_t idx, std::function<void()> handler) override {
+        std::shared_ptr<SwbtStorage> st = storages_[idx];
+        run([this, st, handler = std::move(handler)] {
+            st->release();
+            if (handler) post(ioc_, handler);
+        });
+    }
+
+    void async_check_files(lt::storage_index_t idx, const lt::add_torrent_params* resume_data,
+                           lt::aux::vector<std::string, lt::file_index_t>,
+                           std::function<void(lt::status_t, const lt::storage_error&)> handler) override {
+        std::shared_ptr<SwbtStorage> st = storages_[idx];
+        bool resume_has_pieces = resume_data && !resume_data->have_pieces.empty();
+        run([this, st, resume_has_pieces, handler = std::move(handler)] {
+            lt::storage_error se;
+            lt::status_t rc = st->check(resume_has_pieces, se);
+            post(ioc_, [rc, se, handler] { handler(rc, se); });
+        });
+    }
+
+    void async_stop_torrent(lt::storage_index_t idx, std::function<void()> handler) override {
+        async_release_files(idx, std::move(handler));
+    }
+
+    void async_rename_file(lt::storage_index_t idx, lt::file_index_t index, std::string name,
+                           std::function<void(const std::string&, lt::file_index_t, const lt::storage_error&)> handler) override {
+        std::shared_ptr<SwbtStorage> st = storages_[idx];
+        run([this, st, index, name = std::move(name), handler = std::move(handler)] {
+            lt::storage_error se;
+            st->rename(index, name, se);
+            post(ioc_, [name, index, se, handler] { handler(name, index, se); });
+        });
+    }
+
+    void async_delete_files(lt::storage_index_t idx, lt::remove_flags_t,
+                            std::function<void(const lt::storage_error&)> handler) override {
+        std::shared_ptr<SwbtStorage> st = storages_[idx];
+        run([this, st, handler = std::move(handler)] {
+            lt::storage_error se;
+            st->remove(se);
+            post(ioc_, [se, handler] { handler(se); });
+        });
+    }
+
+    void async_set_file_priority(lt::storage_index_t, lt::aux::vector<lt::download_priority_t, lt::file_index_t> prio,
+                                 std::function<void(const lt::storage_error&, lt::aux::vector<lt::download_priority_t, lt::file_index_t>)> handler) override {
+        // files are created on first write, so priorities need no storage work
+        post(ioc_, [prio = std::move(prio), handler = std::move(handler)]() mutable {
+            handler(lt::storage_error(), std::move(prio));
+        });
+    }
+
+    void async_clear_piece(lt::storage_index_t idx, lt::piece_index_t piece,
+                           std::function<void(lt::piece_index_t)> handler) override {
+        std::shared_ptr<SwbtStorage> st = storages_[idx];
+        run([this, st, piece, handler = std::move(handler)] {
+            st->clear_piece(piece);
+            post(ioc_, [piece, handler] { handler(piece); });
+        });
+    }
+
+    void update_stats_counters(lt::counters&) const override {}
+    std::vector<lt::open_file_state> get_status(lt::storage_index_t) const override { return {}; }
+    void submit_jobs() override {}
+    void settings_updated() override {}
+
+    void abort(bool) override {
+        {
+            std::lock_guard<std::mutex> lk(jobs_mutex_);
+            if (stopping_) return;
+            stopping_ = true;
+        }
+        jobs_cv_.notify_all();
+        // workers drain the queue before exiting, so every handler still gets posted
+        for (auto& t : workers_) {
+            if (t.joinable()) t.join();
+        }
+    }
+
+    void free_disk_buffer(char* buf) override { delete[] buf; }
+
+private:
+    void run(std::function<void()> job) {
+        {
+            std::lock_guard<std::mutex> lk(jobs_mutex_);
+            jobs_.push_back(std::move(job));
+        }
+        jobs_cv_.notify_one();
+    }
+
+    void worker_main() {
+        std::unique_lock<std::mutex> lk(jobs_mutex_);
+        while (true) {
+            jobs_cv_.wait(lk, [this] { return stopping_ || !jobs_.empty(); });
+            if (jobs_.empty()) return;
+            std::function<void()> job = std::move(jobs_.front());
+            jobs_.pop_front();
+            lk.unlock();
+            job();
+            lk.lock();
+        }
+    }
+
+    void write_done(int len) {
+        int64_t left = queued_write_bytes_.fetch_sub(len, std::memory_order_relaxed) - len;
+        if (left > kMaxQueuedWriteBytes / 2) return;
+        std::vector<std::weak_ptr<lt::disk_observer>> observers;
+        {
+            std::lock_guard<std::mutex> lk(observer_mutex_);
+            if (observers_.empty()) return;
+            observers.swap(observers_);
+        }
+        post(ioc_, [observers] {
+            for (const auto& w : observers) {
+                if (auto o = w.lock()) o->on_disk();
+            }
+        });
+    }
+
+    lt::io_context& ioc_;
+    const SwbtDiskIOOptions options_;
+    std::shared_ptr<SwbtDiskIOShared> shared_;
+    std::unique_ptr<SwbtMemoryPool> pool_;
+
+    // network thread only
+    lt::aux::vector<std::shared_ptr<SwbtStorage>, lt::storage_index_t> storages_;
+    std::vector<lt::storage_index_t> free_slots_;
+
+    std::mutex jobs_mutex_;
+    std::condition_variable jobs_cv_;
+    std::deque<std::function<void()>> jobs_;
+    bool stopping_ = false;                         // guarded by jobs_mutex_
+    std::vector<std::thread> workers_;
+
+    std::atomic<int64_t> queued_write_bytes_{0};
+    std::mutex observer_mutex_;
+    std::vector<std::weak_ptr<lt::disk_observer>> observers_;
+};
+
+} // namespace
+
+lt::disk_io_constructor_type swbt_make_disk_io(const SwbtDiskIOOptions& options,
+                                               std::shared_ptr<SwbtDiskIOShared> shared) {
+    switch (options.backend) {
+    case SWBT_STORAGE_POSIX:
+        return lt::posix_disk_io_constructor;
+    case SWBT_STORAGE_MEMORY:
+    case SWBT_STORAGE_MMAP:
+        return [options, shared](lt::io_context& ioc, const lt::settings_interface&, lt::counters&)
+                   -> std::unique_ptr<lt::disk_interface> {
+            return std::make_unique<SwbtDiskIO>(ioc, options, shared);
+        };
+    default:
+        return {};
+    }
+}
+
+#endif // SWBT_USE_LIBTORRENT
@@ -0,0 +1,62 @@
+#pragma once
+
+// Custom libtorrent disk I/O selected by swbt_session_config_t.storage_backend.
+//
+//   memory  Pieces live in RAM under a byte cap. Above the cap the least recently
+//           used pieces are dropped; torrents that lose a fully written piece are
+//           reported through SwbtDiskIOShared so the session can recheck them.
+//           A torrent larger than the cap could only ever evict its own pieces
+//           and download them again, so its file check fails with ENOSPC.
+//   mmap    Files are preallocated on first write and written with pwrite, so a
+//           full disk fails the write instead of faulting. Reads come from a
+//           read-only MAP_SHARED mapping and madvise(MADV_WILLNEED) a window past
+//           the requested range (and MADV_RANDOM the mapping so the kernel's own
+//           fault-around does not double up). A file truncated by another
+//           process under a mapping still faults the reader.
+//
+// Both run storage work on a few job threads and post completions back to
+// libtorrent's network thread, so page faults and hashing never stall it.
+
+#if defined(SWBT_USE_LIBTORRENT)
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <vector>
+
+#include <libtorrent/disk_interface.hpp>
+#include <libtorrent/session_params.hpp>
+#include <libtorrent/sha1_hash.hpp>
+
+namespace lt = libtorrent;
+
+struct SwbtDiskIOOptions {
+    int backend = 0;                // swbt_storage_backend_e
+    int threads = 2;
+    int64_t memory_cap_bytes = 0;   // memory: 0 = unbounded
+    int64_t readahead_bytes = 0;    // mmap: 0 = leave read-ahead to the kernel
+};
+
+// Shared by the disk I/O object libtorrent owns and the session that configured it.
+struct SwbtDiskIOShared {
+    std::atomic<int64_t> resident_bytes{0};
+    std::atomic<int64_t> evicted_pieces{0};
+    std::atomic<int64_t> bytes_read{0};
+    std::atomic<int64_t> bytes_written{0};
+
+    void note_evicted(const lt::sha1_hash& info_hash);
+    // Info-hashes (v1, or truncated v2) noted since the last call.
+    std::vector<lt::sha1_hash> take_evicted();
+
+private:
+    std::mutex mutex_;
+    std::set<lt::sha1_hash> evicted_;
+};
+
+// Empty for SWBT_STORAGE_DEFAULT, meaning keep libtorrent's own constructor.
+lt::disk_io_constructor_type swbt_make_disk_io(const SwbtDiskIOOptions& options,
+                                               std::shared_ptr<SwbtDiskIOShared> shared);
+
+#endif // SWBT_USE_LIBTORRENT
@@ -0,0 +1,248 @@
+#include "SwbtMetadataCache.h"
+
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <iterator>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+namespace {
+
+const char kSuffix[] = ".torrent";
+const char kTempSuffix[] = ".tmp";
+
+bool has_suffix(const std::string& s, const char* suffix) {
+    std::size_t n = std::strlen(suffix);
+    return s.size() >= n && s.compare(s.size() - n, n, suffix) == 0;
+}
+
+// v1 (40) or v2 (64) lowercase hex digest
+bool valid_key(const std::string& key) {
+    if (key.size() != 40 && key.size() != 64) return false;
+    return std::all_of(key.begin(), key.end(), [](char c) { return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f'); });
+}
+
+bool write_file(const std::string& path, const std::vector<char>& data) {
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return false;
+    const char* p = data.data();
+    std::size_t left = data.size();
+    while (left > 0) {
+        ssize_t n = ::write(fd, p, left);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            ::close(fd);
+            return false;
+        }
+        p += n;
+        left -= static_cast<std::size_t>(n);
+    }
+    return ::close(fd) == 0;
+}
+
+bool read_file(const std::string& path, std::vector<char>& out) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st{};
+    bool ok = ::fstat(fd, &st) == 0;
+    if (ok) {
+        out.resize(static_cast<std::size_t>(st.st_size));
+        std::size_t done = 0;
+        while (ok && done < out.size()) {
+            ssize_t n = ::pread(fd, out.data() + done, out.size() - done, static_cast<off_t>(done));
+            if (n < 0 && errno == EINTR) continue;
+            ok = n > 0;
+            if (ok) done += static_cast<std::size_t>(n);
+        }
+    }
+    ::close(fd);
+    return ok;
+}
+
+} // namespace
+
+std::unique_ptr<SwbtMetadataCache> SwbtMetadataCache::open(const std::string& directory,
+                                                           const SwbtMetadataCacheOptions& options,
+                                                           std::string& error) {
+    if (::mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST) {
+        error = "mkdir " + directory + ": " + std::strerror(errno);
+        return nullptr;
+    }
+    std::unique_ptr<SwbtMetadataCache> cache(new SwbtMetadataCache(directory, options));
+    cache->scan();
+    std::lock_guard<std::mutex> lk(cache->mutex_);
+    cache->evict_locked();
+    return cache;
+}
+
+SwbtMetadataCache::SwbtMetadataCache(std::string directory, const SwbtMetadataCacheOptions& options)
+    : directory_(std::move(directory)), options_(options) {}
+
+std::string SwbtMetadataCache::path_of(const std::string& key) const {
+    return directory_ + "/" + key + kSuffix;
+}
+
+// Indexes existing entries, oldest use last, and drops temp files of writes
+// that never completed and aliases whose entry is gone.
+void SwbtMetadataCache::scan() {
+    DIR* dir = ::opendir(directory_.c_str());
+    if (!dir) return;
+    struct Found {
+        std::string key;
+        int64_t size;
+        int64_t mtime;
+    };
+    std::vector<Found> found;
+    std::vector<std::pair<std::string, std::string>> links;   // alias, key
+    while (dirent* e = ::readdir(dir)) {
+        std::string name = e->d_name;
+        std::string path = directory_ + "/" + name;
+        if (has_suffix(name, kTempSuffix)) {
+            ::unlink(path.c_str());
+            continue;
+        }
+        if (!has_suffix(name, kSuffix)) continue;
+        std::string key = name.substr(0, name.size() - std::strlen(kSuffix));
+        struct stat st{};
+        if (!valid_key(key) || ::lstat(path.c_str(), &st) != 0) continue;
+        if (S_ISLNK(st.st_mode)) {
+            char target[128];
+            ssize_t n = ::readlink(path.c_str(), target, sizeof(target));
+            std::string t = n > 0 ? std::string(target, static_cast<std::size_t>(n)) : std::string();
+            if (has_suffix(t, kSuffix)) links.emplace_back(key, t.substr(0, t.size() - std::strlen(kSuffix)));
+            else ::unlink(path.c_str());
+            continue;
+        }
+        if (!S_ISREG(st.st_mode)) continue;
+        found.push_back(Found{key, static_cast<int64_t>(st.st_size), static_cast<int64_t>(st.st_mtime)});
+    }
+    ::closedir(dir);
+    std::sort(found.begin(), found.end(), [](const Found& a, const Found& b) { return a.mtime > b.mtime; });
+    std::lock_guard<std::mutex> lk(mutex_);
+    for (const Found& f : found) {
+        lru_.push_back(f.key);
+        index_[f.key] = Entry{f.size, std::prev(lru_.end()), std::string()};
+        bytes_ += f.size;
+    }
+    for (const auto& link : links) {
+        auto it = index_.find(link.second);
+        if (it == index_.end() || !it->second.alias.empty() || index_.count(link.first)) {
+            ::unlink(path_of(link.first).c_str());
+            continue;
+        }
+        it->second.alias = link.first;
+        aliases_[link.first] = link.second;
+    }
+}
+
+std::string SwbtMetadataCache::resolve_locked(const std::string& key) const {
+    auto a = aliases_.find(key);
+    return a != aliases_.end() ? a->second : key;
+}
+
+bool SwbtMetadataCache::get(const std::string& key, std::vector<char>& out) {
+    std::string target;
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        target = resolve_locked(key);
+        auto it = index_.find(target);
+        if (it == index_.end()) return false;
+        lru_.splice(lru_.begin(), lru_, it->second.lru);
+    }
+    std::string path = path_of(target);
+    if (!read_file(path, out)) {
+        // evicted meanwhile, or removed behind our back
+        std::lock_guard<std::mutex> lk(mutex_);
+        erase_locked(target);
+        return false;
+    }
+    ::utimes(path.c_str(), nullptr);
+    return true;
+}
+
+bool SwbtMetadataCache::put(const std::string& key, const std::vector<char>& data, const std::string& alias) {
+    if (!valid_key(key) || static_cast<int64_t>(data.size()) > options_.max_bytes) return false;
+    std::string path = path_of(key);
+    std::string temp = directory_ + "/" + key + kTempSuffix;
+    if (!write_file(temp, data) || ::rename(temp.c_str(), path.c_str()) != 0) {
+        ::unlink(temp.c_str());
+        return false;
+    }
+    std::lock_guard<std::mutex> lk(mutex_);
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+        if (!it->second.alias.empty()) {
+            ::unlink(path_of(it->second.alias).c_str());
+            aliases_.erase(it->second.alias);
+        }
+        bytes_ -= it->second.size;
+        lru_.erase(it->second.lru);
+        index_.erase(it);
+    }
+    std::string linked;
+    if (valid_key(alias) && alias != key) {
+        // an alias replaces whatever was stored or linked under that name
+        auto other = aliases_.find(alias);
+        if (other == aliases_.end()) {
+            erase_locked(alias);
+        } else {
+            auto owner = index_.find(other->second);
+            if (owner != index_.end()) owner->second.alias.clear();
+            aliases_.erase(other);
+        }
+        std::string alias_path = path_of(alias);
+        ::unlink(alias_path.c_str());
+        // relative, so the directory can be moved
+        if (::symlink((key + kSuffix).c_str(), alias_path.c_str()) == 0) {
+            linked = alias;
+            aliases_[alias] = key;
+        }
+    }
+    lru_.push_front(key);
+    index_[key] = Entry{static_cast<int64_t>(data.size()), lru_.begin(), linked};
+    bytes_ += static_cast<int64_t>(data.size());
+    ++stores_;
+    evict_locked();
+    return true;
+}
+
+void SwbtMetadataCache::erase(const std::string& key) {
+    std::lock_guard<std::mutex> lk(mutex_);
+    erase_locked(resolve_locked(key));
+}
+
+void SwbtMetadataCache::erase_locked(const std::string& key) {
+    auto it = index_.find(key);
+    if (it == index_.end()) return;
+    ::unlink(path_of(key).c_str());
+    if (!it->second.alias.empty()) {
+        ::unlink(path_of(it->second.alias).c_str());
+        aliases_.erase(it->second.alias);
+    }
+    bytes_ -= it->second.size;
+    lru_.erase(it->second.lru);
+    index_.erase(it);
+}
+
+void SwbtMetadataCache::evict_locked() {
+    while (!lru_.empty() && (bytes_ > options_.max_bytes
+                             || (options_.max_entries > 0 && static_cast<int64_t>(index_.size()) > options_.max_entries))) {
+        std::string victim = lru_.back();
+        erase_locked(victim);
+        ++evictions_;
+    }
+}
+
+SwbtMetadataCacheStats SwbtMetadataCache::stats() {
+    std::lock_guard<std::mutex> lk(mutex_);
+    SwbtMetadataCacheStats s;
+    s.entries = static_cast<int64_t>(index_.size());
+    s.bytes = bytes_;
+    s.stores = stores_;
+    s.evictions = evictions_;
+    return s;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+// Content-addressed cache of torrent metadata for magnet adds. Independent of
+// libtorrent: keys are lowercase hex info-hashes, values opaque .torrent bytes.
+//
+// Directory layout: one <key>.torrent per entry, written to <key>.tmp and
+// renamed into place, plus an optional <alias>.torrent symlink to it. An
+// entry's mtime is its last use, so the LRU order survives restarts; open()
+// rebuilds the index from a directory scan.
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct SwbtMetadataCacheOptions {
+    int64_t max_bytes = 256 << 20;   // least recently used entries go first past this
+    int64_t max_entries = 0;         // 0 = no count limit
+};
+
+struct SwbtMetadataCacheStats {
+    int64_t entries = 0;
+    int64_t bytes = 0;
+    int64_t stores = 0;
+    int64_t evictions = 0;
+};
+
+class SwbtMetadataCache {
+public:
+    // Opens (or creates) the directory. Returns nullptr and fills error on failure.
+    static std::unique_ptr<SwbtMetadataCache> open(const std::string& directory,
+                                                   const SwbtMetadataCacheOptions& options,
+                                                   std::string& error);
+
+    SwbtMetadataCache(const SwbtMetadataCache&) = delete;
+    SwbtMetadataCache& operator=(const SwbtMetadataCache&) = delete;
+
+    // Reads the entry (by key or alias) into out and marks it used. False if
+    // there is none.
+    bool get(const std::string& key, std::vector<char>& out);
+    // Writes (or replaces) the entry, then evicts past the limits. A non-empty
+    // alias, such as the v2 hash of a hybrid torrent, finds the same entry and
+    // goes away with it.
+    bool put(const std::string& key, const std::vector<char>& data, const std::string& alias = std::string());
+    // Removes the entry, by key or alias.
+    void erase(const std::string& key);
+
+    SwbtMetadataCacheStats stats();
+
+private:
+    struct Entry {
+        int64_t size;
+        std::list<std::string>::iterator lru;
+        std::string alias;
+    };
+
+    SwbtMetadataCache(std::string directory, const SwbtMetadataCacheOptions& options);
+    std::string path_of(const std::string& key) const;
+    void scan();
+    std::string resolve_locked(const std::string& key) const;   // caller holds mutex_
+    void erase_locked(const std::string& key);   // caller holds mutex_
+    void evict_locked();                         // caller holds mutex_
+
+    const std::string directory_;
+    const SwbtMetadataCacheOptions options_;
+
+    std::mutex mutex_;                            // index and counters
+    std::unordered_map<std::string, Entry> index_;
+    std::unordered_map<std::string, std::string> aliases_;   // alias -> key
+    std::list<std::string> lru_;                  // most recently used first
+    int64_t bytes_ = 0;
+    int64_t stores_ = 0;
+    int64_t evictions_ = 0;
+};
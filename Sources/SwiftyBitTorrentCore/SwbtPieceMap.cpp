@@ -0,0 +1,151 @@
+// Piece map helpers: counting and rarity over packed have-bitfields and
+// byte-per-piece availability arrays in caller memory. They don't touch
+// libtorrent, so stub builds have them too.
+//
+// Bit counts run on 64-bit words and availability reductions on contiguous byte
+// runs, which the compiler keeps in vector registers. On arm64 a word costs
+// CNT + ADDV; x86_64 gets a single POPCNT only when built for a CPU that has it
+// (-mpopcnt or a later -march), and the package's default flags don't ask for
+// one, so there __builtin_popcountll is the runtime library's bit-twiddling
+// fallback: still per word, but several instructions. Per-piece code only runs
+// for bytes of the have-bitfield that are partly set.
+
+#include "SwiftyBitTorrentCore.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+int64_t popcount_bytes(const uint8_t* p, std::size_t len) {
+    int64_t n = 0;
+    std::size_t i = 0;
+    // four independent words per step so the adds don't serialize
+    for (; i + 32 <= len; i += 32) {
+        uint64_t w[4];
+        std::memcpy(w, p + i, sizeof(w));
+        n += __builtin_popcountll(w[0]) + __builtin_popcountll(w[1])
+           + __builtin_popcountll(w[2]) + __builtin_popcountll(w[3]);
+    }
+    for (; i + 8 <= len; i += 8) {
+        uint64_t w;
+        std::memcpy(&w, p + i, sizeof(w));
+        n += __builtin_popcountll(w);
+    }
+    for (; i < len; ++i) n += __builtin_popcount(p[i]);
+    return n;
+}
+
+inline bool have_bit(const uint8_t* bits, int i) {
+    return (bits[i >> 3] & (0x80u >> (i & 7))) != 0;
+}
+
+// Calls f(begin, end) for each run of pieces in [first, last) not set in have
+// (all of it when have is null). Whole bytes are skipped or merged into runs.
+template <typename F>
+void for_each_missing_run(const uint8_t* have, int first, int last, F&& f) {
+    if (!have) {
+        f(first, last);
+        return;
+    }
+    int i = first;
+    while (i < last) {
+        if ((i & 7) != 0 || last - i < 8) {
+            if (!have_bit(have, i)) f(i, i + 1);
+            ++i;
+            continue;
+        }
+        uint8_t b = have[i >> 3];
+        if (b == 0xFF) {
+            i += 8;
+        } else if (b == 0) {
+            int j = i + 8;
+            while (last - j >= 8 && have[j >> 3] == 0) j += 8;
+            f(i, j);
+            i = j;
+        } else {
+            for (int k = 0; k < 8; ++k) {
+                if (!(b & (0x80u >> k))) f(i + k, i + k + 1);
+            }
+            i += 8;
+        }
+    }
+}
+
+} // namespace
+
+int64_t swbt_bitfield_count(const uint8_t* bits, int num_bits, int first, int last) {
+    if (!bits) return 0;
+    first = std::max(first, 0);
+    last = std::min(last, num_bits);
+    if (first >= last) return 0;
+    int fb = first >> 3;
+    int lb = (last - 1) >> 3;
+    uint8_t head = static_cast<uint8_t>(0xFFu >> (first & 7));
+    uint8_t tail = static_cast<uint8_t>(0xFFu << (7 - ((last - 1) & 7)));
+    if (fb == lb) return __builtin_popcount(bits[fb] & head & tail);
+    return __builtin_popcount(bits[fb] & head) + __builtin_popcount(bits[lb] & tail)
+         + popcount_bytes(bits + fb + 1, static_cast<std::size_t>(lb - fb - 1));
+}
+
+void swbt_bitfield_count_ranges(const uint8_t* bits,
+                                int num_bits,
+                                const swbt_piece_range_t* ranges,
+                                int count,
+                                int32_t* out_counts) {
+    if (!ranges || !out_counts) return;
+    for (int i = 0; i < count; ++i) {
+        out_counts[i] = static_cast<int32_t>(swbt_bitfield_count(bits, num_bits, ranges[i].first, ranges[i].last));
+    }
+}
+
+void swbt_availability_stats(const uint8_t* availability,
+                             const uint8_t* have_bits,
+                             int first,
+                             int last,
+                             swbt_availability_stats_t* out_stats) {
+    if (!out_stats) return;
+    *out_stats = swbt_availability_stats_t{};
+    out_stats->min_availability = -1;
+    if (!availability || first < 0 || first >= last) return;
+
+    // pass 1: min, sum and zero count
+    int pieces = 0;
+    int zeros = 0;
+    int min_value = 256;
+    uint64_t sum = 0;
+    for_each_missing_run(have_bits, first, last, [&](int b, int e) {
+        const uint8_t* a = availability + b;
+        int n = e - b;
+        uint8_t m = 0xFF;
+        uint64_t s = 0;
+        int z = 0;
+        for (int i = 0; i < n; ++i) {
+            m = std::min(m, a[i]);
+            s += a[i];
+            z += a[i] == 0;
+        }
+        min_value = std::min<int>(min_value, m);
+        sum += s;
+        zeros += z;
+        pieces += n;
+    });
+    if (pieces == 0) return;
+
+    // pass 2: how many pieces sit at the minimum
+    int at_min = 0;
+    const uint8_t target = static_cast<uint8_t>(min_value);
+    for_each_missing_run(have_bits, first, last, [&](int b, int e) {
+        const uint8_t* a = availability + b;
+        int c = 0;
+        for (int i = 0, n = e - b; i < n; ++i) c += a[i] == target;
+        at_min += c;
+    });
+
+    out_stats->pieces = pieces;
+    out_stats->min_availability = min_value;
+    out_stats->pieces_at_min = at_min;
+    out_stats->unavailable = zeros;
+    out_stats->mean_availability = static_cast<double>(sum) / pieces;
+    out_stats->distributed_copies = min_value + static_cast<double>(pieces - at_min) / pieces;
+}
@@ -0,0 +1,343 @@
+#include "SwbtResumeStore.h"
+
+#include <chrono>
+#include <iterator>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const char kFileMagic[8] = {'S', 'W', 'B', 'T', 'R', 'S', '\0', '\1'};
+const uint32_t kRecordMagic = 0x52425753;  // "SWBR"
+const uint8_t kOpPut = 1;
+const uint8_t kOpErase = 2;
+const size_t kMaxKeyLen = 64;
+
+struct RecordHeader {
+    uint32_t magic;
+    uint32_t crc;          // over op, key_len, reserved, key and payload
+    uint32_t payload_len;
+    uint8_t op;
+    uint8_t key_len;
+    uint16_t reserved;
+};
+static_assert(sizeof(RecordHeader) == 16, "record header must stay 16 bytes");
+
+uint32_t crc32_update(uint32_t crc, const void* data, size_t len) {
+    static const auto table = [] {
+        std::vector<uint32_t> t(256);
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            t[i] = c;
+        }
+        return t;
+    }();
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    crc = ~crc;
+    for (size_t i = 0; i < len; ++i) crc = table[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+uint32_t record_crc(const RecordHeader& h, const char* key, const char* payload) {
+    uint32_t crc = crc32_update(0, &h.op, sizeof(h.op) + sizeof(h.key_len) + sizeof(h.reserved));
+    crc = crc32_update(crc, key, h.key_len);
+    return crc32_update(crc, payload, h.payload_len);
+}
+
+int64_t record_bytes(size_t key_len, size_t payload_len) {
+    return static_cast<int64_t>(sizeof(RecordHeader) + key_len + payload_len);
+}
+
+void append_record(std::vector<char>& out, uint8_t op, const std::string& key, const char* payload, size_t payload_len) {
+    RecordHeader h{};
+    h.magic = kRecordMagic;
+    h.payload_len = static_cast<uint32_t>(payload_len);
+    h.op = op;
+    h.key_len = static_cast<uint8_t>(key.size());
+    h.crc = record_crc(h, key.data(), payload);
+    const char* hp = reinterpret_cast<const char*>(&h);
+    out.insert(out.end(), hp, hp + sizeof(h));
+    out.insert(out.end(), key.begin(), key.end());
+    out.insert(out.end(), payload, payload + payload_len);
+}
+
+bool write_all(int fd, const char* data, size_t len, int64_t offset) {
+    while (len > 0) {
+        ssize_t n = ::pwrite(fd, data, len, offset);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += n;
+        len -= static_cast<size_t>(n);
+        offset += n;
+    }
+    return true;
+}
+
+void sync_fd(int fd) {
+#if defined(__APPLE__)
+    ::fsync(fd);
+#else
+    ::fdatasync(fd);
+#endif
+}
+
+// Read-only mapping that unmaps itself.
+struct Mapping {
+    const char* data = nullptr;
+    size_t size = 0;
+    Mapping(int fd, size_t len) : size(len) {
+        if (len == 0) return;
+        void* p = ::mmap(nullptr, len, PROT_READ, MAP_SHARED, fd, 0);
+        if (p != MAP_FAILED) data = static_cast<const char*>(p);
+    }
+    ~Mapping() {
+        if (data) ::munmap(const_cast<char*>(data), size);
+    }
+};
+
+} // namespace
+
+std::unique_ptr<SwbtResumeStore> SwbtResumeStore::open(const std::string& directory,
+                                                       const SwbtResumeStoreOptions& options,
+                                                       std::string& error) {
+    if (::mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST) {
+        error = "mkdir " + directory + ": " + std::strerror(errno);
+        return nullptr;
+    }
+    std::string path = directory + "/resume.log";
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        error = "open " + path + ": " + std::strerror(errno);
+        return nullptr;
+    }
+    std::unique_ptr<SwbtResumeStore> store(new SwbtResumeStore(path, fd, options));
+    if (!store->load(error)) return nullptr;
+    store->flusher_ = std::thread([s = store.get()] { s->flusher_main(); });
+    return store;
+}
+
+SwbtResumeStore::SwbtResumeStore(std::string path, int fd, const SwbtResumeStoreOptions& options)
+    : path_(std::move(path)), fd_(fd), options_(options) {}
+
+SwbtResumeStore::~SwbtResumeStore() {
+    {
+        std::lock_guard<std::mutex> lk(queue_mutex_);
+        stopping_ = true;
+    }
+    queue_cv_.notify_all();
+    if (flusher_.joinable()) flusher_.join();
+    flush();
+    ::close(fd_);
+}
+
+bool SwbtResumeStore::load(std::string& error) {
+    struct stat st{};
+    if (::fstat(fd_, &st) != 0) {
+        error = std::strerror(errno);
+        return false;
+    }
+    if (st.st_size == 0) {
+        if (!write_all(fd_, kFileMagic, sizeof(kFileMagic), 0)) {
+            error = std::strerror(errno);
+            return false;
+        }
+        file_size_ = sizeof(kFileMagic);
+        return true;
+    }
+
+    Mapping map(fd_, static_cast<size_t>(st.st_size));
+    if (!map.data || map.size < sizeof(kFileMagic) || std::memcmp(map.data, kFileMagic, sizeof(kFileMagic)) != 0) {
+        error = path_ + " is not a resume store";
+        return false;
+    }
+    int64_t off = sizeof(kFileMagic);
+    const int64_t end = static_cast<int64_t>(map.size);
+    while (off + static_cast<int64_t>(sizeof(RecordHeader)) <= end) {
+        RecordHeader h;
+        std::memcpy(&h, map.data + off, sizeof(h));
+        int64_t len = record_bytes(h.key_len, h.payload_len);
+        if (h.magic != kRecordMagic || h.key_len > kMaxKeyLen || off + len > end) break;
+        const char* key = map.data + off + sizeof(h);
+        const char* payload = key + h.key_len;
+        if (record_crc(h, key, payload) != h.crc) break;
+
+        std::string k(key, h.key_len);
+        auto it = index_.find(k);
+        if (it != index_.end()) {
+            live_bytes_ -= it->second.record_bytes;
+            dead_bytes_ += it->second.record_bytes;
+        }
+        if (h.op == kOpPut) {
+            index_[k] = Location{off + static_cast<int64_t>(sizeof(h)) + h.key_len, h.payload_len, len};
+            live_bytes_ += len;
+        } else {
+            if (it != index_.end()) index_.erase(it);
+            dead_bytes_ += len;
+        }
+        off += len;
+    }
+    // drop a torn tail left by a crash mid-append
+    if (off < end && ::ftruncate(fd_, off) != 0) {
+        error = std::strerror(errno);
+        return false;
+    }
+    file_size_ = off;
+    return true;
+}
+
+void SwbtResumeStore::put(std::string key, std::vector<char> blob) {
+    if (key.empty() || key.size() > kMaxKeyLen) return;
+    std::lock_guard<std::mutex> lk(queue_mutex_);
+    queue_.push_back(Op{kOpPut, std::move(key), std::move(blob)});
+}
+
+void SwbtResumeStore::erase(std::string key) {
+    if (key.empty() || key.size() > kMaxKeyLen) return;
+    std::lock_guard<std::mutex> lk(queue_mutex_);
+    queue_.push_back(Op{kOpErase, std::move(key), {}});
+}
+
+void SwbtResumeStore::flush() {
+    // file_mutex_ first so batches hit the file in the order they were queued
+    std::lock_guard<std::mutex> file(file_mutex_);
+    std::vector<Op> ops;
+    {
+        std::lock_guard<std::mutex> lk(queue_mutex_);
+        ops.swap(queue_);
+    }
+    if (ops.empty()) return;
+    if (!write_batch(ops)) {
+        // put the batch back in front of anything queued meanwhile; the next
+        // flush retries it
+        std::lock_guard<std::mutex> lk(queue_mutex_);
+        ops.insert(ops.end(), std::make_move_iterator(queue_.begin()), std::make_move_iterator(queue_.end()));
+        queue_.swap(ops);
+        return;
+    }
+    maybe_compact();
+}
+
+void SwbtResumeStore::flusher_main() {
+    std::unique_lock<std::mutex> lk(queue_mutex_);
+    while (!stopping_) {
+        queue_cv_.wait_for(lk, std::chrono::milliseconds(options_.flush_interval_ms));
+        if (stopping_) break;
+        if (queue_.empty()) continue;
+        lk.unlock();
+        flush();
+        lk.lock();
+    }
+}
+
+bool SwbtResumeStore::write_batch(std::vector<Op>& ops) {
+    std::vector<char> buf;
+    size_t total = 0;
+    for (const Op& op : ops) total += static_cast<size_t>(record_bytes(op.key.size(), op.blob.size()));
+    buf.reserve(total);
+    for (const Op& op : ops) append_record(buf, op.type, op.key, op.blob.data(), op.blob.size());
+    if (!write_all(fd_, buf.data(), buf.size(), file_size_)) {
+        last_write_error_ = errno;
+        ++write_failures_;
+        // Cut whatever part made it: the retried batch must not be preceded by
+        // a stale copy on the next load. If even that fails, the next batch
+        // overwrites it from the same offset.
+        if (::ftruncate(fd_, file_size_) != 0) last_write_error_ = errno;
+        return false;
+    }
+    if (options_.fsync) sync_fd(fd_);
+
+    int64_t off = file_size_;
+    for (const Op& op : ops) {
+        int64_t len = record_bytes(op.key.size(), op.blob.size());
+        auto it = index_.find(op.key);
+        if (it != index_.end()) {
+            live_bytes_ -= it->second.record_bytes;
+            dead_bytes_ += it->second.record_bytes;
+        }
+        if (op.type == kOpPut) {
+            index_[op.key] = Location{off + static_cast<int64_t>(sizeof(RecordHeader) + op.key.size()),
+                                      static_cast<uint32_t>(op.blob.size()), len};
+            live_bytes_ += len;
+        } else {
+            if (it != index_.end()) index_.erase(it);
+            dead_bytes_ += len;
+        }
+        off += len;
+    }
+    file_size_ = off;
+    ++batches_written_;
+    records_written_ += static_cast<int64_t>(ops.size());
+    last_write_error_ = 0;
+    return true;
+}
+
+void SwbtResumeStore::maybe_compact() {
+    if (dead_bytes_ < options_.compact_min_dead_bytes || dead_bytes_ < live_bytes_) return;
+
+    std::string tmp = path_ + ".compact";
+    int nfd = ::open(tmp.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (nfd < 0) return;
+
+    Mapping map(fd_, static_cast<size_t>(file_size_));
+    if (!map.data) {
+        ::close(nfd);
+        ::unlink(tmp.c_str());
+        return;
+    }
+    std::vector<char> buf(kFileMagic, kFileMagic + sizeof(kFileMagic));
+    std::unordered_map<std::string, Location> index;
+    index.reserve(index_.size());
+    for (const auto& kv : index_) {
+        int64_t payload_off = static_cast<int64_t>(buf.size() + sizeof(RecordHeader) + kv.first.size());
+        append_record(buf, kOpPut, kv.first, map.data + kv.second.offset, kv.second.size);
+        index[kv.first] = Location{payload_off, kv.second.size, kv.second.record_bytes};
+    }
+    if (!write_all(nfd, buf.data(), buf.size(), 0)) {
+        ::close(nfd);
+        ::unlink(tmp.c_str());
+        return;
+    }
+    ::fsync(nfd);
+    if (::rename(tmp.c_str(), path_.c_str()) != 0) {
+        ::close(nfd);
+        ::unlink(tmp.c_str());
+        return;
+    }
+    ::close(fd_);
+    fd_ = nfd;
+    index_.swap(index);
+    file_size_ = static_cast<int64_t>(buf.size());
+    dead_bytes_ = 0;
+    ++compactions_;
+}
+
+void SwbtResumeStore::for_each(const std::function<void(const std::string& key, const char* data, size_t size)>& fn) {
+    std::lock_guard<std::mutex> file(file_mutex_);
+    Mapping map(fd_, static_cast<size_t>(file_size_));
+    if (!map.data) return;
+    for (const auto& kv : index_) fn(kv.first, map.data + kv.second.offset, kv.second.size);
+}
+
+SwbtResumeStoreStats SwbtResumeStore::stats() {
+    std::lock_guard<std::mutex> file(file_mutex_);
+    SwbtResumeStoreStats s;
+    s.live_records = static_cast<int64_t>(index_.size());
+    s.live_bytes = live_bytes_;
+    s.dead_bytes = dead_bytes_;
+    s.file_bytes = file_size_;
+    s.batches_written = batches_written_;
+    s.records_written = records_written_;
+    s.compactions = compactions_;
+    s.write_failures = write_failures_;
+    s.last_write_error = last_write_error_;
+    std::lock_guard<std::mutex> lk(queue_mutex_);
+    s.queued_records = static_cast<int64_t>(queue_.size());
+    return s;
+}
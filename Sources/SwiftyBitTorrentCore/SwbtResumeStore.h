@@ -0,0 +1,106 @@
+#pragma once
+
+// Append-only, checksummed resume-data log used by the session's built-in
+// resume store. Independent of libtorrent: keys are binary info-hashes and
+// values are opaque bencoded blobs.
+//
+// File layout (host byte order, the store is never shared between machines):
+//   "SWBTRS\0\1"                                        file header
+//   { magic, crc32, payload_len, op, key_len, reserved } 16-byte record header
+//   key bytes, payload bytes                            (repeated)
+// A torn or corrupt record ends the log; open() truncates it away.
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+struct SwbtResumeStoreOptions {
+    int flush_interval_ms = 1000;               // batch window for queued writes
+    bool fsync = true;                          // fdatasync after each batch
+    int64_t compact_min_dead_bytes = 32 << 20;  // compact once dead bytes exceed this and the live bytes
+};
+
+struct SwbtResumeStoreStats {
+    int64_t live_records = 0;
+    int64_t live_bytes = 0;
+    int64_t dead_bytes = 0;
+    int64_t file_bytes = 0;
+    int64_t batches_written = 0;
+    int64_t records_written = 0;
+    int64_t compactions = 0;
+    int64_t write_failures = 0;    // batches that failed to write and were queued again
+    int last_write_error = 0;      // errno of the latest failure, 0 once a batch succeeds
+    int64_t queued_records = 0;    // ops waiting for the next batch
+};
+
+class SwbtResumeStore {
+public:
+    // Opens (or creates) <directory>/resume.log. Returns nullptr and fills
+    // error on failure.
+    static std::unique_ptr<SwbtResumeStore> open(const std::string& directory,
+                                                 const SwbtResumeStoreOptions& options,
+                                                 std::string& error);
+    ~SwbtResumeStore();
+
+    SwbtResumeStore(const SwbtResumeStore&) = delete;
+    SwbtResumeStore& operator=(const SwbtResumeStore&) = delete;
+
+    // Queue a write; the flusher thread writes queued ops as one batch.
+    void put(std::string key, std::vector<char> blob);
+    void erase(std::string key);
+
+    // Write everything queued so far and sync, on the calling thread.
+    void flush();
+
+    // Visit every live record straight from a read-only mapping of the log.
+    // The pointers are only valid during the callback.
+    void for_each(const std::function<void(const std::string& key, const char* data, size_t size)>& fn);
+
+    SwbtResumeStoreStats stats();
+
+private:
+    struct Op {
+        uint8_t type;
+        std::string key;
+        std::vector<char> blob;
+    };
+    struct Location {
+        int64_t offset;    // start of the payload
+        uint32_t size;
+        int64_t record_bytes;
+    };
+
+    SwbtResumeStore(std::string path, int fd, const SwbtResumeStoreOptions& options);
+    bool load(std::string& error);
+    void flusher_main();
+    bool write_batch(std::vector<Op>& ops);   // caller holds file_mutex_; false leaves the file as it was
+    void maybe_compact();                     // caller holds file_mutex_
+
+    const std::string path_;
+    int fd_;
+    const SwbtResumeStoreOptions options_;
+
+    std::mutex file_mutex_;                   // fd_, index_, file_size_, counters
+    std::unordered_map<std::string, Location> index_;
+    int64_t file_size_ = 0;
+    int64_t live_bytes_ = 0;
+    int64_t dead_bytes_ = 0;
+    int64_t batches_written_ = 0;
+    int64_t records_written_ = 0;
+    int64_t compactions_ = 0;
+    int64_t write_failures_ = 0;
+    int last_write_error_ = 0;
+
+    std::mutex queue_mutex_;
+    std::condition_variable queue_cv_;
+    std::vector<Op> queue_;
+    bool stopping_ = false;
+    std::thread flusher_;
+};
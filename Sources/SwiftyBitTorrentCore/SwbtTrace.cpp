@@ -0,0 +1,131 @@
+#include "SwbtTrace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace {
+
+const char kTraceMagic[8] = {'S', 'W', 'B', 'T', 'T', 'R', 'C', '\0'};
+const uint32_t kTraceVersion = 2;   // 2: category holds every matching bit
+const uint32_t kNameLen = 48;
+
+static_assert(sizeof(swbt_trace_record_t) == 64, "trace records must stay 64 bytes");
+static_assert(sizeof(swbt_trace_header_t) == 72, "trace header layout changed");
+
+uint64_t align_up(uint64_t n, uint64_t to) {
+    return (n + to - 1) / to * to;
+}
+
+// Allocates size bytes for an empty file; returns 0 or an errno.
+int preallocate(int fd, off_t size) {
+#if defined(__APPLE__)
+    fstore_t fs{};
+    fs.fst_flags = F_ALLOCATECONTIG | F_ALLOCATEALL;
+    fs.fst_posmode = F_PEOFPOSMODE;
+    fs.fst_length = size;
+    if (::fcntl(fd, F_PREALLOCATE, &fs) != 0) {
+        fs.fst_flags = F_ALLOCATEALL;
+        if (::fcntl(fd, F_PREALLOCATE, &fs) != 0) return errno;
+    }
+    return ::ftruncate(fd, size) == 0 ? 0 : errno;
+#else
+    return ::posix_fallocate(fd, 0, size);
+#endif
+}
+
+} // namespace
+
+std::unique_ptr<SwbtTraceRecorder> SwbtTraceRecorder::open(const std::string& path,
+                                                           uint64_t capacity,
+                                                           uint32_t categories,
+                                                           const std::vector<std::string>& names,
+                                                           std::string& error) {
+    uint64_t names_offset = align_up(sizeof(swbt_trace_header_t), 64);
+    uint64_t records_offset = align_up(names_offset + names.size() * kNameLen, 64);
+    uint64_t size = records_offset + capacity * sizeof(swbt_trace_record_t);
+
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        error = "open " + path + ": " + std::strerror(errno);
+        return nullptr;
+    }
+    // Reserve the blocks now: in a sparse file the first store into a page could
+    // find the disk full and raise SIGBUS in whichever thread records.
+    if (int err = preallocate(fd, static_cast<off_t>(size))) {
+        error = "preallocate " + path + ": " + std::strerror(err);
+        ::close(fd);
+        ::unlink(path.c_str());
+        return nullptr;
+    }
+    void* p = ::mmap(nullptr, static_cast<size_t>(size), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED) {
+        error = "mmap " + path + ": " + std::strerror(errno);
+        ::close(fd);
+        return nullptr;
+    }
+    char* base = static_cast<char*>(p);
+    std::unique_ptr<SwbtTraceRecorder> rec(new SwbtTraceRecorder(fd, base, static_cast<size_t>(size), capacity));
+
+    // The file is fresh (zero-filled), so only the header and names need writing.
+    for (std::size_t i = 0; i < names.size(); ++i) {
+        std::memcpy(base + names_offset + i * kNameLen, names[i].data(), std::min<std::size_t>(names[i].size(), kNameLen - 1));
+    }
+    swbt_trace_header_t* h = rec->header_;
+    h->version = kTraceVersion;
+    h->record_size = sizeof(swbt_trace_record_t);
+    h->capacity = capacity;
+    h->names_offset = names_offset;
+    h->name_count = static_cast<uint32_t>(names.size());
+    h->name_len = kNameLen;
+    h->records_offset = records_offset;
+    h->next_seq = 1;
+    h->started_us = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    h->categories = categories;
+    // magic last: a file without it was never fully initialized
+    std::memcpy(h->magic, kTraceMagic, sizeof(kTraceMagic));
+    rec->records_ = reinterpret_cast<swbt_trace_record_t*>(base + records_offset);
+    return rec;
+}
+
+SwbtTraceRecorder::SwbtTraceRecorder(int fd, char* base, size_t size, uint64_t capacity)
+    : fd_(fd), base_(base), size_(size), capacity_(capacity),
+      header_(reinterpret_cast<swbt_trace_header_t*>(base)), records_(nullptr) {}
+
+SwbtTraceRecorder::~SwbtTraceRecorder() {
+    ::msync(base_, size_, MS_SYNC);
+    ::munmap(base_, size_);
+    ::close(fd_);
+}
+
+swbt_trace_record_t* SwbtTraceRecorder::claim(uint64_t& seq) {
+    seq = __atomic_fetch_add(&header_->next_seq, 1, __ATOMIC_RELAXED);
+    swbt_trace_record_t* r = &records_[(seq - 1) % capacity_];
+    __atomic_store_n(&r->seq, 0, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    std::memset(reinterpret_cast<char*>(r) + sizeof(r->seq), 0, sizeof(*r) - sizeof(r->seq));
+    return r;
+}
+
+void SwbtTraceRecorder::publish(swbt_trace_record_t* record, uint64_t seq) {
+    __atomic_store_n(&record->seq, seq, __ATOMIC_RELEASE);
+}
+
+void SwbtTraceRecorder::mark(int64_t time_us, const char* label) {
+    uint64_t seq = 0;
+    swbt_trace_record_t* r = claim(seq);
+    r->time_us = time_us;
+    r->alert_type = SWBT_TRACE_TYPE_MARK;
+    r->category = SWBT_TRACE_MARK;
+    if (label) std::memcpy(r->data, label, strnlen(label, sizeof(r->data)));
+    publish(r, seq);
+}
+
+uint64_t SwbtTraceRecorder::records_written() const {
+    return __atomic_load_n(&header_->next_seq, __ATOMIC_RELAXED) - 1;
+}
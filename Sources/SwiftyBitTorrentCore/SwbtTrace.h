@@ -0,0 +1,53 @@
+#pragma once
+
+// Alert trace file: a ring of fixed-size swbt_trace_record_t in a shared file
+// mapping (layout in SwiftyBitTorrentCore.h). Independent of libtorrent; the
+// session turns alerts into records.
+//
+// Writers claim a sequence number with one atomic add on the header's next_seq,
+// fill the slot with its seq zeroed and publish it by storing the seq last, so
+// several threads can record at once and a reader never mistakes a half-written
+// slot for a record. Nothing on that path allocates or makes a system call.
+
+#include "SwiftyBitTorrentCore.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+class SwbtTraceRecorder {
+public:
+    // Creates (or replaces) the file at path, sized for `capacity` records, with
+    // `names` as the alert type -> name table. Returns nullptr and fills error on
+    // failure.
+    static std::unique_ptr<SwbtTraceRecorder> open(const std::string& path,
+                                                   uint64_t capacity,
+                                                   uint32_t categories,
+                                                   const std::vector<std::string>& names,
+                                                   std::string& error);
+    ~SwbtTraceRecorder();
+
+    SwbtTraceRecorder(const SwbtTraceRecorder&) = delete;
+    SwbtTraceRecorder& operator=(const SwbtTraceRecorder&) = delete;
+
+    // Claims the next slot and clears it; fill it in, then publish() it.
+    swbt_trace_record_t* claim(uint64_t& seq);
+    void publish(swbt_trace_record_t* record, uint64_t seq);
+
+    void mark(int64_t time_us, const char* label);
+
+    int64_t started_us() const { return header_->started_us; }
+    uint64_t capacity() const { return capacity_; }
+    uint64_t records_written() const;
+
+private:
+    SwbtTraceRecorder(int fd, char* base, size_t size, uint64_t capacity);
+
+    const int fd_;
+    char* const base_;
+    const size_t size_;
+    const uint64_t capacity_;
+    swbt_trace_header_t* header_;
+    swbt_trace_record_t* records_;
+};
@@ -1,11 +1,34 @@
 #include "SwiftyBitTorrentCore.h"
+#include "SwbtResumeStore.h"
+#include "SwbtDiskIO.h"
+#include "SwbtCreateTorrent.h"
+#include "SwbtTrace.h"
+#include "SwbtBlocklist.h"
+#include "SwbtMetadataCache.h"
 
 #include <string>
 #include <memory>
 #include <cstdio>
 #include <vector>
 #include <cstring>
+#include <cstdlib>
+#include <cerrno>
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <map>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #ifdef __APPLE__
 #include <TargetConditionals.h>
 #endif
@@ -23,18 +46,456 @@
 #include <libtorrent/alert.hpp>
 #include <libtorrent/bencode.hpp>
 #include <libtorrent/write_resume_data.hpp>
+#include <libtorrent/read_resume_data.hpp>
+#include <libtorrent/session_params.hpp>
+#include <libtorrent/bdecode.hpp>
+#include <libtorrent/address.hpp>
+#include <libtorrent/socket.hpp>
+#include <libtorrent/session_stats.hpp>
+#include <libtorrent/peer_info.hpp>
 
 namespace lt = libtorrent;
 
+// Bounded ring with a single producer (the alert pump thread) and consumers
+// serialized by consumer_mutex_. The producer never takes a lock: when the ring
+// is full the new item is rejected and counted as dropped.
+template <typename T>
+class SwbtRing {
+public:
+    explicit SwbtRing(std::size_t capacity_pow2)
+        : slots_(capacity_pow2), mask_(capacity_pow2 - 1) {}
+
+    // Producer side. On failure `value` is left untouched so the caller can
+    // release whatever it owns.
+    bool push(T&& value) {
+        std::size_t head = head_.load(std::memory_order_relaxed);
+        std::size_t tail = tail_.load(std::memory_order_acquire);
+        if (head - tail >= slots_.size()) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        slots_[head & mask_] = std::move(value);
+        head_.store(head + 1, std::memory_order_release);
+        pushed_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Wake consumers blocked in wait_and_pop. Called once per drained batch.
+    void notify() {
+        { std::lock_guard<std::mutex> lk(wait_mutex_); }
+        cv_.notify_all();
+    }
+
+    // Consumer side: wait up to timeout_ms for data, then move up to max items out.
+    int wait_and_pop(int timeout_ms, T* out, int max) {
+        std::lock_guard<std::mutex> consumer(consumer_mutex_);
+        last_poll_ms_.store(std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count(), std::memory_order_relaxed);
+        if (empty() && timeout_ms > 0) {
+            std::unique_lock<std::mutex> lk(wait_mutex_);
+            cv_.wait_for(lk, std::chrono::milliseconds(timeout_ms), [this] { return !empty(); });
+        }
+        int n = 0;
+        std::size_t tail = tail_.load(std::memory_order_relaxed);
+        std::size_t head = head_.load(std::memory_order_acquire);
+        while (n < max && tail != head) {
+            out[n++] = std::move(slots_[tail & mask_]);
+            ++tail;
+        }
+        tail_.store(tail, std::memory_order_release);
+        return n;
+    }
+
+    // True if a consumer polled within the last window_ms.
+    bool has_recent_consumer(int64_t now_ms, int64_t window_ms) const {
+        int64_t last = last_poll_ms_.load(std::memory_order_relaxed);
+        return last >= 0 && now_ms - last <= window_ms;
+    }
+
+    bool empty() const {
+        return tail_.load(std::memory_order_acquire) == head_.load(std::memory_order_acquire);
+    }
+
+    // Producer side: true if the next push would be rejected.
+    bool full() const {
+        return head_.load(std::memory_order_relaxed) - tail_.load(std::memory_order_acquire) >= slots_.size();
+    }
+
+    void fill_counters(swbt_alert_queue_counters_t* out) const {
+        std::size_t head = head_.load(std::memory_order_acquire);
+        std::size_t tail = tail_.load(std::memory_order_acquire);
+        out->pushed = static_cast<int64_t>(pushed_.load(std::memory_order_relaxed));
+        out->dropped = static_cast<int64_t>(dropped_.load(std::memory_order_relaxed));
+        out->depth = static_cast<int32_t>(head - tail);
+        out->capacity = static_cast<int32_t>(slots_.size());
+    }
+
+private:
+    std::vector<T> slots_;
+    const std::size_t mask_;
+    std::atomic<std::size_t> head_{0};
+    std::atomic<std::size_t> tail_{0};
+    std::atomic<uint64_t> pushed_{0};
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<int64_t> last_poll_ms_{-1};
+    std::mutex consumer_mutex_;
+    std::mutex wait_mutex_;
+    std::condition_variable cv_;
+};
+
+// Fixed-size pool for CPU-bound work that must stay off the caller's thread
+// (torrent parsing, bdecoding). Jobs run in FIFO order; the destructor
+// finishes queued jobs before joining.
+class SwbtWorkerPool {
+public:
+    explicit SwbtWorkerPool(unsigned threads) {
+        for (unsigned i = 0; i < threads; ++i) workers_.emplace_back([this] { run(); });
+    }
+
+    ~SwbtWorkerPool() {
+        {
+            std::lock_guard<std::mutex> lk(mutex_);
+            stopping_ = true;
+        }
+        cv_.notify_all();
+        for (auto& t : workers_) t.join();
+    }
+
+    void submit(std::function<void()> job) {
+        {
+            std::lock_guard<std::mutex> lk(mutex_);
+            jobs_.push_back(std::move(job));
+        }
+        cv_.notify_one();
+    }
+
+private:
+    void run() {
+        for (;;) {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lk(mutex_);
+                cv_.wait(lk, [this] { return stopping_ || !jobs_.empty(); });
+                if (jobs_.empty()) return;
+                job = std::move(jobs_.front());
+                jobs_.pop_front();
+            }
+            job();
+        }
+    }
+
+    std::vector<std::thread> workers_;
+    std::deque<std::function<void()>> jobs_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stopping_ = false;
+};
+
+// Correlates an async_add_torrent with the caller's tag. Travels as
+// add_torrent_params::userdata and is released when add_torrent_alert arrives.
+struct SwbtPendingAdd {
+    uint64_t user_tag = 0;
+    bool from_store = false;   // restored from the resume store, already persisted
+    bool scheduled_check = false;  // SWBT_ADD_SCHEDULED_CHECK: hand to the recheck scheduler once added
+};
+
+// One session_stats_alert worth of counters, indexed as session_stats_metrics().
+struct SwbtStatsSample {
+    int64_t timestamp_us = 0;
+    std::vector<int64_t> counters;
+};
+
+// Info-hashes are uniformly distributed, so a prefix of the digest is a good bucket key.
+struct SwbtDigestHasher {
+    template <typename Digest>
+    std::size_t operator()(const Digest& d) const {
+        std::size_t h = 0;
+        std::memcpy(&h, d.data(), sizeof(h));
+        return h;
+    }
+};
+
+// Per-torrent bookkeeping keyed by the session-local id.
+struct SwbtTorrentRecord {
+    uint32_t id = 0;
+    lt::info_hash_t info_hashes;
+    lt::torrent_handle handle;
+    uint32_t handle_id = 0;        // handle.id(), the key in the registry's by_handle
+    std::string name;
+    bool announced = false;        // ADDED record emitted to the delta consumer
+    swbt_status_delta_t last{};    // values of the last emitted delta record
+    bool need_save_resume = false; // picked up by the next resume store checkpoint
+    int64_t added_ms = 0;          // steady clock, first seen by the registry
+    int32_t shard = -1;            // owning shard, fixed when added (see record_shard)
+    int64_t first_peer_ms = -1;    // added_ms to the first update with a connected peer
+
+    // Cached snapshot answered by overview/snapshot queries without a session round-trip
+    int32_t state = 0;
+    bool has_metadata = false;
+    double progress = 0.0;
+    int64_t total_wanted = 0;
+    int64_t total_wanted_done = 0;
+    int32_t num_peers = 0;
+    int64_t download_rate = 0;
+    int64_t upload_rate = 0;
+
+    // Queue and seeding goals
+    int32_t queue_position = -1;
+    bool auto_managed = false;
+    bool paused = false;
+    bool pause_unmanaged = false;      // swbt_torrent_pause cleared auto_managed; resume sets it back
+    int32_t seed_rank = 0;
+    int32_t num_complete = -1;
+    int32_t num_incomplete = -1;
+    int64_t all_time_upload = 0;
+    int64_t seeding_s = 0;             // as of seeding_observed_ms
+    int64_t seeding_observed_ms = 0;
+    double goal_ratio = -1.0;          // per-torrent override, negative = session goal
+    int64_t goal_seed_s = -1;
+    bool goal_reached = false;         // alert raised; cleared when goals change
+
+    int32_t bandwidth_group = -1;      // user bandwidth group, -1 = none
+};
+
+// Torrent index. Hybrid torrents are reachable through either hash. by_id is
+// ordered so snapshot paging is stable (ids grow in add order).
+struct SwbtTorrentRegistry {
+    std::mutex mutex;
+    uint32_t next_id = 1;
+    int64_t snapshot_updated_ms = -1;  // steady clock, last state_update_alert applied
+    std::map<uint32_t, SwbtTorrentRecord> by_id;
+    std::unordered_map<lt::sha1_hash, uint32_t, SwbtDigestHasher> by_v1;
+    std::unordered_map<lt::sha256_hash, uint32_t, SwbtDigestHasher> by_v2;
+    std::unordered_map<uint32_t, uint32_t> by_handle;  // torrent_handle::id(), for alerts that carry only a handle
+};
+
+// A running alert trace. Alert timestamps are on libtorrent's clock; a record's
+// time is the recorder's start time plus the alert's offset from t0.
+struct SwbtTrace {
+    std::unique_ptr<SwbtTraceRecorder> recorder;
+    lt::time_point t0;
+};
+
+// Bandwidth group. Built-ins (ids 0-2) map to libtorrent's classes of the same
+// id; a created group has one peer class per shard. Group ids double as bits of
+// the mirror filter, hence the 32 group cap.
+struct SwbtBandwidthGroup {
+    std::string name;
+    swbt_bandwidth_group_config_t config{};
+    std::vector<lt::peer_class_t> classes;   // per shard
+};
+
+struct SwbtGroupRange {
+    int32_t group;
+    lt::address first;
+    lt::address last;
+};
+
+// A check waiting for, or holding, a recheck scheduler slot.
+struct SwbtRecheckJob {
+    uint32_t torrent_id = 0;
+    lt::info_hash_t info_hashes;
+    lt::torrent_handle handle;
+    uint64_t device = 0;
+    bool start_after = false;          // added with SWBT_ADD_SCHEDULED_CHECK: start it once checked
+    bool restore_auto_managed = false; // queue and pause state to put back afterwards
+    bool restore_paused = false;
+    int last_step = 0;                 // progress alerts sent so far
+    bool immediate = false;            // swbt_torrent_force_recheck: starts outside the limits
+    bool check_seen = false;           // the torrent entered a checking state after force_recheck
+};
+
+// Per-torrent part of a group's limits as last applied by the balancer.
+struct SwbtGroupShare {
+    lt::torrent_handle handle;
+    int download = 0;
+    int upload = 0;
+    int connections = -1;
+};
+
 struct SwbtSessionImpl {
-    std::unique_ptr<lt::session> session;
+    // One lt::session per shard. shard_of picks a torrent's shard when it is added;
+    // from then on it is routed through the shard recorded with it.
+    // Everything below (registry, rings, pump) is shared, so callers see a single
+    // session. shards[0] holds the saved state and answers settings reads.
+    std::vector<std::unique_ptr<lt::session>> shards;
     std::string default_save_path;
+    bool warm_start = false;           // built from saved session state
+    int dht_nodes_restored = 0;
+    SwbtTorrentRegistry registry;
+    std::atomic<uint32_t> update_modes{SWBT_UPDATE_MODE_FULL};
+    std::atomic<int> snapshot_refresh_ms{1000};
+
+    // Alert dispatcher: the pump thread is the only caller of pop_alerts and
+    // sorts alerts into per-category rings read by the swbt_session_poll_* calls.
+    std::thread alert_pump;
+    std::atomic<bool> pump_stop{false};
+    std::mutex wake_mutex;                // libtorrent's alert notify and add workers wake the pump here
+    std::condition_variable wake_cv;
+    bool wake_pending = false;            // guarded by wake_mutex
+    std::atomic<uint64_t> lt_overflow_events{0};
+    SwbtRing<swbt_torrent_status_t> status_ring{16384};
+    SwbtRing<swbt_status_delta_t> delta_ring{32768};
+    SwbtRing<swbt_resume_data_t> resume_ring{4096};
+    SwbtRing<swbt_alert_t> lifecycle_ring{4096};
+    SwbtRing<swbt_session_stats_t> stats_ring{64};
+    SwbtRing<swbt_add_result_t> add_result_ring{16384};
+    // Pump-owned overflow of the status and resume rings, moved over as the
+    // pollers make room. Full records coalesce per torrent (torrent_handle::id()),
+    // so the backlog stays within one record per torrent; resume data is never dropped.
+    std::unordered_map<uint32_t, swbt_torrent_status_t> status_waiting;
+    std::deque<swbt_resume_data_t> resume_waiting;
+    std::atomic<bool> rings_spilled{false};
+
+    // Bulk add: parsing runs on the pool, results come back through add_torrent_alert.
+    std::mutex add_mutex;
+    std::unique_ptr<SwbtWorkerPool> add_pool;
+    std::unordered_set<SwbtPendingAdd*> pending_adds;   // guarded by add_mutex
+    std::vector<swbt_add_result_t> add_results_waiting; // parse failures and results that found the ring full
+
+    // Optional resume store. The pump writes save_resume_data_alerts into it and
+    // requests checkpoints; checkpoint_saves lets swbt_session_checkpoint wait.
+    std::mutex store_mutex;
+    std::shared_ptr<SwbtResumeStore> resume_store;
+    std::atomic<int> checkpoint_interval_ms{0};
+    std::mutex checkpoint_mutex;
+    std::condition_variable checkpoint_cv;
+    std::unordered_set<uint32_t> checkpoint_saves;      // torrent ids with a checkpoint save in flight, guarded by checkpoint_mutex
+
+    // Optional magnet metadata cache. Magnet adds look it up on the adding thread;
+    // metadata captured by the pump is written out on metadata_pool.
+    std::mutex metadata_mutex;
+    std::shared_ptr<SwbtMetadataCache> metadata_cache;      // guarded by metadata_mutex
+    std::unique_ptr<SwbtWorkerPool> metadata_pool;          // guarded by metadata_mutex
+    std::atomic<int64_t> metadata_lookups{0};
+    std::atomic<int64_t> metadata_hits{0};
+    std::atomic<int64_t> metadata_corrupt{0};
+    std::atomic<int64_t> metadata_downloads{0};             // time-to-metadata samples, pump only
+    std::atomic<int64_t> time_to_metadata_total_ms{0};
+    std::atomic<int64_t> time_to_metadata_max_ms{0};
+    std::atomic<int64_t> time_to_metadata_last_ms{0};
+
+    // File streams. piece_finished_alerts are only requested while one is open;
+    // each one bumps piece_events to wake readers waiting for a piece.
+    std::mutex stream_mutex;
+    int open_streams = 0;                               // guarded by stream_mutex
+    std::mutex piece_mutex;
+    std::condition_variable piece_cv;
+    uint64_t piece_events = 0;                          // guarded by piece_mutex
+
+    // Consumer wakeups, raised by the pump after each dispatch that queued something:
+    // a registered callback, and a pipe whose read end can sit in a run loop.
+    std::mutex event_mutex;
+    swbt_event_callback_t event_callback = nullptr;     // guarded by event_mutex
+    void* event_context = nullptr;
+    int event_pipe[2] = {-1, -1};
+    std::atomic<uint32_t> pending_events{0};
+
+    // Session counters: the pump posts session_stats every stats_interval_ms and
+    // keeps the two newest samples for rates, value queries and Prometheus text.
+    std::atomic<int> stats_interval_ms{0};
+    std::mutex stats_mutex;
+    SwbtStatsSample stats_latest;                       // guarded by stats_mutex
+    SwbtStatsSample stats_previous;                     // guarded by stats_mutex
+
+    // Set when a custom storage backend is configured; the pump rechecks torrents
+    // whose complete pieces the memory backend evicted.
+    SwbtDiskIOOptions disk_options;
+    std::shared_ptr<SwbtDiskIOShared> disk_shared;
+
+    // Sharded sessions: the session-wide rate limits (0 = unlimited) that the pump
+    // splits between shards, and each shard's half of a stats round. A summed
+    // sample is recorded once every shard has answered.
+    std::atomic<int> global_download_limit{0};
+    std::atomic<int> global_upload_limit{0};
+    std::vector<SwbtStatsSample> stats_parts;           // pump only
+    std::vector<char> stats_parts_seen;                 // pump only
+
+    // Seeding goals and queue ordering from swbt_session_configure_queue. Checked
+    // by the pump as state updates arrive, plus a slow tick for idle seeds.
+    std::atomic<double> goal_ratio{0.0};
+    std::atomic<int64_t> goal_seed_s{0};
+    std::atomic<int> goal_action{SWBT_GOAL_ACTION_NONE};
+    std::atomic<bool> torrent_goals{false};             // some torrent has its own goals
+    std::atomic<bool> demand_priority{false};
+
+    // Bandwidth groups. IP ranges go into each shard's peer class filter in add
+    // order; class_filter mirrors them with group ids as bits, for attributing
+    // peers in stats. Member torrents are balanced by the pump once a second.
+    std::mutex group_mutex;
+    std::map<int32_t, SwbtBandwidthGroup> groups;              // guarded by group_mutex
+    std::vector<SwbtGroupRange> group_ranges;                  // guarded by group_mutex
+    lt::ip_filter class_filter;                                // guarded by group_mutex
+    std::unordered_map<uint32_t, SwbtGroupShare> group_shares; // pump only, by torrent id
+    std::atomic<bool> grouped_torrents{false};
+
+    // Recheck scheduler: explicit rechecks and SWBT_ADD_SCHEDULED_CHECK adds wait
+    // in recheck_queue; the pump starts them within the per-device limits and
+    // retires them on torrent_checked_alert.
+    std::mutex recheck_mutex;
+    std::deque<SwbtRecheckJob> recheck_queue;               // guarded by recheck_mutex
+    std::vector<SwbtRecheckJob> rechecks_running;           // guarded by recheck_mutex
+    int recheck_max_per_device = 1;                         // guarded by recheck_mutex
+    int recheck_max_total = 0;                              // guarded by recheck_mutex
+    int recheck_step = 10;                                  // guarded by recheck_mutex
+    std::atomic<bool> rechecks_pending{false};
+
+    // Alert trace. The pump takes the recorder once per batch, like the resume
+    // store; categories can change under a running trace and also widen the
+    // session's alert mask (see apply_alert_mask_locked).
+    std::mutex trace_mutex;
+    std::shared_ptr<SwbtTrace> trace;                       // guarded by trace_mutex
+    std::atomic<uint32_t> trace_categories{0};              // 0 while no trace runs
+
+    // IP blocklist. Loads run one at a time on blocklist_pool; each request bumps
+    // blocklist_generation and a job that is no longer the newest skips. Results
+    // reach lifecycle_ring through the pump.
+    std::mutex blocklist_mutex;
+    std::unique_ptr<SwbtWorkerPool> blocklist_pool;         // guarded by blocklist_mutex
+    std::shared_ptr<const SwbtBlocklist> blocklist;         // guarded by blocklist_mutex
+    swbt_blocklist_stats_t blocklist_stats{};               // guarded by blocklist_mutex
+    std::vector<swbt_alert_t> blocklist_alerts;             // guarded by blocklist_mutex
+    std::atomic<uint64_t> blocklist_generation{0};
+    std::atomic<int> blocklist_jobs{0};
+    std::atomic<bool> blocklist_active{false};
+    std::atomic<uint64_t> blocklist_blocked{0};
 };
 
 struct SwbtTorrentHandleImpl {
     lt::torrent_handle handle;
+    std::size_t shard = 0;         // owning shard, as in SwbtTorrentRecord::shard
+    SwbtSessionImpl* session = nullptr;
 };
 
+// Shard of a torrent from the leading bytes of its routing hash: v1 when the
+// torrent has one, else v2 (whose truncation is what the disk layer reports).
+static std::size_t shard_of_digest(const SwbtSessionImpl* impl, const char* digest) {
+    if (impl->shards.size() <= 1) return 0;
+    uint32_t key = 0;
+    std::memcpy(&key, digest, sizeof(key));
+    return key % impl->shards.size();
+}
+
+static std::size_t shard_of(const SwbtSessionImpl* impl, const lt::info_hash_t& ih) {
+    return shard_of_digest(impl, ih.has_v1() ? ih.v1.data() : ih.v2.data());
+}
+
+// Only valid when adding: a torrent's hashes can grow afterwards (a v2 magnet
+// that turns out hybrid routes by v1 from then on), so later calls go through
+// the shard recorded at add time.
+static std::size_t shard_of(const SwbtSessionImpl* impl, const lt::add_torrent_params& p) {
+    return shard_of(impl, p.ti ? p.ti->info_hashes() : p.info_hashes);
+}
+
+static std::size_t record_shard(const SwbtSessionImpl* impl, const SwbtTorrentRecord& rec) {
+    // -1 only until the add is registered
+    return rec.shard >= 0 ? static_cast<std::size_t>(rec.shard) : shard_of(impl, rec.info_hashes);
+}
+
+static void apply_to_shards(SwbtSessionImpl* impl, const lt::settings_pack& pack) {
+    for (auto& shard : impl->shards) shard->apply_settings(pack);
+}
+
 static void hex_encode(const unsigned char* data, int len, char* out, int out_len) {
     static const char* hex = "0123456789abcdef";
     int need = len * 2 + 1;
@@ -48,6 +509,31 @@ static void hex_encode(const unsigned char* data, int len, char* out, int out_le
     out[std::min(out_len - 1, pairs * 2)] = '\0';
 }
 
+// Decodes a hex string into out. Returns the number of bytes written, or -1 on
+// malformed input or if it doesn't fit.
+static int hex_decode(const char* hex, uint8_t* out, int out_len) {
+    auto nibble = [](char c) -> int {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    };
+    int n = 0;
+    for (; hex[0] != '\0'; hex += 2) {
+        if (hex[1] == '\0' || n >= out_len) return -1;
+        int hi = nibble(hex[0]), lo = nibble(hex[1]);
+        if (hi < 0 || lo < 0) return -1;
+        out[n++] = static_cast<uint8_t>((hi << 4) | lo);
+    }
+    return n;
+}
+
+static void fill_infohash_hex(const lt::info_hash_t& ih, char* out, int out_len) {
+    if (ih.has_v2()) hex_encode(reinterpret_cast<const unsigned char*>(ih.v2.data()), ih.v2.size(), out, out_len);
+    else if (ih.has_v1()) hex_encode(reinterpret_cast<const unsigned char*>(ih.v1.data()), ih.v1.size(), out, out_len);
+    else if (out_len > 0) out[0] = '\0';
+}
+
 static void fill_infohash_hex(const lt::torrent_handle& th, char* out, int out_len) {
 #if LT_VERSION_NUM >= 10200
     auto ih = th.info_hashes();
@@ -73,8 +559,17 @@ static void copy_cstr_safe(char* dst, int dst_len, const std::string& s) {
     dst[n] = '\0';
 }
 
-static lt::settings_pack build_settings(const swbt_session_config_t* c) {
-    lt::settings_pack pack;
+// Categories the alert pump dispatches (status updates, resume data, lifecycle/errors)
+static const lt::alert_category_t kBaseAlertMask = lt::alert_category::error
+    | lt::alert_category::status
+    | lt::alert_category::storage;
+
+// Applies the config on top of `pack`, which is empty for a cold start or holds
+// the saved settings for a warm one; explicit config values win.
+static void apply_config_settings(lt::settings_pack& pack, const swbt_session_config_t* c) {
+    pack.set_int(lt::settings_pack::alert_mask, kBaseAlertMask);
+    // Bulk adds post one add_torrent_alert per torrent; leave headroom between pump drains.
+    pack.set_int(lt::settings_pack::alert_queue_size, 20000);
     if (c) {
         // Networking / discovery toggles
         pack.set_bool(lt::settings_pack::enable_dht, c->enable_dht != 0);
@@ -90,226 +585,2055 @@ static lt::settings_pack build_settings(const swbt_session_config_t* c) {
             pack.set_str(lt::settings_pack::listen_interfaces, buf);
         }
     }
-    return pack;
 }
 
-swbt_session_t* swbt_session_new(const swbt_session_config_t* config) {
-    auto s = new swbt_session_t{};
-    auto impl = new SwbtSessionImpl{};
-    lt::settings_pack pack = build_settings(config);
-    impl->session = std::make_unique<lt::session>(pack);
-    if (config && config->save_path) impl->default_save_path = config->save_path;
-    s->impl = impl;
-    return s;
+static void fill_status_from_lt(const lt::torrent_status& st, swbt_torrent_status_t& o) {
+    o.progress = st.progress;
+    o.download_rate = st.download_rate;
+    o.upload_rate = st.upload_rate;
+    o.total_downloaded = st.total_download;
+    o.total_uploaded = st.total_upload;
+    o.num_peers = st.num_peers;
+    o.num_seeds = st.num_seeds;
+    o.state = static_cast<int32_t>(st.state);
+    o.has_metadata = st.has_metadata ? 1 : 0;
+    // fill id and name
+#if LT_VERSION_NUM >= 10200
+    if (st.info_hashes.has_v2()) hex_encode(reinterpret_cast<const unsigned char*>(st.info_hashes.v2.data()), st.info_hashes.v2.size(), o.info_hash, sizeof(o.info_hash));
+    else if (st.info_hashes.has_v1()) hex_encode(reinterpret_cast<const unsigned char*>(st.info_hashes.v1.data()), st.info_hashes.v1.size(), o.info_hash, sizeof(o.info_hash));
+    else if (sizeof(o.info_hash) > 0) o.info_hash[0] = '\0';
+#else
+    hex_encode(reinterpret_cast<const unsigned char*>(st.info_hash.data()), st.info_hash.size(), o.info_hash, sizeof(o.info_hash));
+#endif
+    copy_cstr_safe(o.name, sizeof(o.name), st.name);
 }
 
-void swbt_session_free(swbt_session_t* session) {
-    if (!session) return;
-    delete static_cast<SwbtSessionImpl*>(session->impl);
-    delete session;
+// Maps finished/metadata/error alerts to swbt_alert_t. Returns false for alerts
+// that don't belong to the lifecycle category.
+static bool map_lifecycle_alert(lt::alert* a, swbt_alert_t& out) {
+    if (auto* fin = lt::alert_cast<lt::torrent_finished_alert>(a)) {
+        out.type = SWBT_ALERT_TORRENT_FINISHED;
+        fill_infohash_hex(fin->handle, out.info_hash, sizeof(out.info_hash));
+        out.error_code = 0;
+        copy_cstr_safe(out.message, sizeof(out.message), a->message());
+        return true;
+    }
+    if (auto* md = lt::alert_cast<lt::metadata_received_alert>(a)) {
+        out.type = SWBT_ALERT_METADATA_RECEIVED;
+        fill_infohash_hex(md->handle, out.info_hash, sizeof(out.info_hash));
+        out.error_code = 0;
+        copy_cstr_safe(out.message, sizeof(out.message), a->message());
+        return true;
+    }
+    if (auto* te = lt::alert_cast<lt::torrent_error_alert>(a)) {
+        out.type = SWBT_ALERT_TORRENT_ERROR;
+        fill_infohash_hex(te->handle, out.info_hash, sizeof(out.info_hash));
+        out.error_code = te->error.value();
+        copy_cstr_safe(out.message, sizeof(out.message), te->error.message());
+        return true;
+    }
+    if (auto* tr = lt::alert_cast<lt::tracker_error_alert>(a)) {
+        out.type = SWBT_ALERT_TRACKER_ERROR;
+        fill_infohash_hex(tr->handle, out.info_hash, sizeof(out.info_hash));
+        out.error_code = tr->error.value();
+        copy_cstr_safe(out.message, sizeof(out.message), tr->error.message());
+        return true;
+    }
+    return false;
 }
 
-swbt_error_code_e swbt_add_magnet(swbt_session_t* session,
-                                  const char* magnet_uri,
-                                  const char* save_path,
-                                  swbt_torrent_handle_t** out_handle) {
-    if (!session || !magnet_uri || !out_handle) return SWBT_ERR_INVALID_ARG;
-    lt::error_code ec;
-    lt::add_torrent_params p = lt::parse_magnet_uri(magnet_uri, ec);
-    if (ec) return SWBT_ERR_GENERIC;
-    if (save_path && save_path[0] != '\0') p.save_path = save_path;
-    else if (!static_cast<SwbtSessionImpl*>(session->impl)->default_save_path.empty()) p.save_path = static_cast<SwbtSessionImpl*>(session->impl)->default_save_path;
-    else p.save_path = ".";
+static int64_t steady_now_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
 
-    lt::torrent_handle th = static_cast<SwbtSessionImpl*>(session->impl)->session->add_torrent(std::move(p), ec);
-    if (ec) return SWBT_ERR_GENERIC;
-    auto h = new swbt_torrent_handle_t{};
-    h->impl = new SwbtTorrentHandleImpl{th};
-    *out_handle = h;
-    return SWBT_OK;
+// Id of the torrent known under any hash of `ih`, 0 if none. Caller holds registry.mutex.
+static uint32_t registry_find_locked(const SwbtTorrentRegistry& reg, const lt::info_hash_t& ih) {
+    if (ih.has_v1()) {
+        auto it = reg.by_v1.find(ih.v1);
+        if (it != reg.by_v1.end()) return it->second;
+    }
+    if (ih.has_v2()) {
+        auto it = reg.by_v2.find(ih.v2);
+        if (it != reg.by_v2.end()) return it->second;
+    }
+    return 0;
 }
 
-swbt_error_code_e swbt_add_torrent_file(swbt_session_t* session,
-                                        const char* torrent_file_path,
-                                        const char* save_path,
-                                        swbt_torrent_handle_t** out_handle) {
-    if (!session || !torrent_file_path || !out_handle) return SWBT_ERR_INVALID_ARG;
-    lt::error_code ec;
-    auto ti = std::make_shared<lt::torrent_info>(torrent_file_path, ec);
-    if (ec) return SWBT_ERR_GENERIC;
-    lt::add_torrent_params p;
-    p.ti = std::move(ti);
-    if (save_path && save_path[0] != '\0') p.save_path = save_path;
-    else if (!static_cast<SwbtSessionImpl*>(session->impl)->default_save_path.empty()) p.save_path = static_cast<SwbtSessionImpl*>(session->impl)->default_save_path;
-    else p.save_path = ".";
+// Returns the record for `ih`, assigning a fresh id on first sight and indexing
+// hashes that became known later (a v1 magnet that turned out to be hybrid).
+// Caller holds registry.mutex.
+static SwbtTorrentRecord& registry_ensure_locked(SwbtTorrentRegistry& reg, const lt::info_hash_t& ih) {
+    uint32_t id = registry_find_locked(reg, ih);
+    if (id == 0) {
+        id = reg.next_id++;
+        reg.by_id[id].id = id;
+        reg.by_id[id].added_ms = steady_now_ms();
+    }
+    SwbtTorrentRecord& rec = reg.by_id[id];
+    if (ih.has_v1() && !rec.info_hashes.has_v1()) {
+        rec.info_hashes.v1 = ih.v1;
+        reg.by_v1.emplace(ih.v1, id);
+    }
+    if (ih.has_v2() && !rec.info_hashes.has_v2()) {
+        rec.info_hashes.v2 = ih.v2;
+        reg.by_v2.emplace(ih.v2, id);
+    }
+    return rec;
+}
 
-    lt::torrent_handle th = static_cast<SwbtSessionImpl*>(session->impl)->session->add_torrent(std::move(p), ec);
-    if (ec) return SWBT_ERR_GENERIC;
-    auto h = new swbt_torrent_handle_t{};
-    h->impl = new SwbtTorrentHandleImpl{th};
-    *out_handle = h;
-    return SWBT_OK;
+// Caller holds registry.mutex.
+static void registry_set_handle_locked(SwbtTorrentRegistry& reg, SwbtTorrentRecord& rec, const lt::torrent_handle& th) {
+    rec.handle = th;
+    uint32_t handle_id = th.id();
+    if (handle_id == 0 || handle_id == rec.handle_id) return;
+    if (rec.handle_id != 0) reg.by_handle.erase(rec.handle_id);
+    rec.handle_id = handle_id;
+    reg.by_handle[handle_id] = rec.id;
 }
 
-void swbt_remove_torrent(swbt_session_t* session,
-                         swbt_torrent_handle_t* handle,
-                         int with_data) {
-    if (!session || !handle) return;
-    lt::remove_flags_t flags = {};
-    if (with_data) flags |= lt::session::delete_files;
-    auto himpl = static_cast<SwbtTorrentHandleImpl*>(handle->impl);
-    static_cast<SwbtSessionImpl*>(session->impl)->session->remove_torrent(himpl->handle, flags);
-    delete himpl;
-    delete handle;
+static uint32_t registry_add(SwbtTorrentRegistry& reg, const lt::torrent_handle& th, std::size_t shard) {
+    std::lock_guard<std::mutex> lk(reg.mutex);
+    SwbtTorrentRecord& rec = registry_ensure_locked(reg, th.info_hashes());
+    registry_set_handle_locked(reg, rec, th);
+    if (rec.shard < 0) rec.shard = static_cast<int32_t>(shard);
+    return rec.id;
 }
 
-void swbt_torrent_pause(swbt_torrent_handle_t* handle) {
-    if (!handle) return;
-    static_cast<SwbtTorrentHandleImpl*>(handle->impl)->handle.pause();
+static uint32_t registry_remove(SwbtTorrentRegistry& reg, const lt::info_hash_t& ih) {
+    std::lock_guard<std::mutex> lk(reg.mutex);
+    uint32_t id = registry_find_locked(reg, ih);
+    if (id == 0) return 0;
+    auto it = reg.by_id.find(id);
+    if (it->second.info_hashes.has_v1()) reg.by_v1.erase(it->second.info_hashes.v1);
+    if (it->second.info_hashes.has_v2()) reg.by_v2.erase(it->second.info_hashes.v2);
+    // handle ids are only unique among live torrents
+    auto h = reg.by_handle.find(it->second.handle_id);
+    if (h != reg.by_handle.end() && h->second == id) reg.by_handle.erase(h);
+    reg.by_id.erase(it);
+    return id;
 }
 
-void swbt_torrent_resume(swbt_torrent_handle_t* handle) {
-    if (!handle) return;
-    static_cast<SwbtTorrentHandleImpl*>(handle->impl)->handle.resume();
+// Handle and owning shard of a torrent in the index, or an invalid handle if it
+// isn't (or is no longer) in the session.
+static lt::torrent_handle registry_find_handle(SwbtSessionImpl* impl, const lt::info_hash_t& ih, std::size_t& shard) {
+    SwbtTorrentRegistry& reg = impl->registry;
+    std::lock_guard<std::mutex> lk(reg.mutex);
+    uint32_t id = registry_find_locked(reg, ih);
+    if (id == 0) return lt::torrent_handle();
+    const SwbtTorrentRecord& rec = reg.by_id[id];
+    if (!rec.handle.is_valid()) return lt::torrent_handle();
+    shard = record_shard(impl, rec);
+    return rec.handle;
 }
 
-void swbt_torrent_force_reannounce(swbt_torrent_handle_t* handle) {
-    if (!handle) return;
-    static_cast<SwbtTorrentHandleImpl*>(handle->impl)->handle.force_reannounce();
+static void fill_delta_values(const lt::torrent_status& st, swbt_status_delta_t& d) {
+    d.state = static_cast<int32_t>(st.state);
+    d.progress = st.progress;
+    d.download_rate = st.download_rate;
+    d.upload_rate = st.upload_rate;
+    d.total_downloaded = st.total_download;
+    d.total_uploaded = st.total_upload;
+    d.num_peers = st.num_peers;
+    d.num_seeds = st.num_seeds;
+    d.has_metadata = st.has_metadata ? 1 : 0;
 }
 
-swbt_error_code_e swbt_torrent_status(swbt_torrent_handle_t* handle,
-                                      swbt_torrent_status_t* out_status) {
-    if (!handle || !out_status) return SWBT_ERR_INVALID_ARG;
-    lt::status_flags_t flags = lt::torrent_handle::query_name
-        | lt::torrent_handle::query_accurate_download_counters;
-    lt::torrent_status st = static_cast<SwbtTorrentHandleImpl*>(handle->impl)->handle.status(flags);
+static uint32_t diff_delta_fields(const swbt_status_delta_t& a, const swbt_status_delta_t& b) {
+    uint32_t changed = 0;
+    if (a.progress != b.progress) changed |= SWBT_STATUS_FIELD_PROGRESS;
+    if (a.download_rate != b.download_rate) changed |= SWBT_STATUS_FIELD_DOWNLOAD_RATE;
+    if (a.upload_rate != b.upload_rate) changed |= SWBT_STATUS_FIELD_UPLOAD_RATE;
+    if (a.total_downloaded != b.total_downloaded) changed |= SWBT_STATUS_FIELD_TOTAL_DOWNLOADED;
+    if (a.total_uploaded != b.total_uploaded) changed |= SWBT_STATUS_FIELD_TOTAL_UPLOADED;
+    if (a.num_peers != b.num_peers) changed |= SWBT_STATUS_FIELD_NUM_PEERS;
+    if (a.num_seeds != b.num_seeds) changed |= SWBT_STATUS_FIELD_NUM_SEEDS;
+    if (a.state != b.state) changed |= SWBT_STATUS_FIELD_STATE;
+    if (a.has_metadata != b.has_metadata) changed |= SWBT_STATUS_FIELD_HAS_METADATA;
+    return changed;
+}
 
-    out_status->progress = st.progress;
-    out_status->download_rate = st.download_rate;
-    out_status->upload_rate = st.upload_rate;
-    out_status->total_downloaded = st.total_download;
-    out_status->total_uploaded = st.total_upload;
-    out_status->num_peers = st.num_peers;
-#ifdef __APPLE__
-    // num_seeds exists in libtorrent 1.2/2.0; if absent, leave zero
-#endif
-    out_status->num_seeds = st.num_seeds;
-    out_status->state = static_cast<int32_t>(st.state);
-    out_status->has_metadata = st.has_metadata ? 1 : 0;
-    // id and name
-    fill_infohash_hex(static_cast<SwbtTorrentHandleImpl*>(handle->impl)->handle, out_status->info_hash, sizeof(out_status->info_hash));
-    copy_cstr_safe(out_status->name, sizeof(out_status->name), st.name);
-    return SWBT_OK;
+static void wake_pump(SwbtSessionImpl* impl) {
+    std::lock_guard<std::mutex> lk(impl->wake_mutex);
+    impl->wake_pending = true;
+    impl->wake_cv.notify_one();
 }
 
-void swbt_session_post_torrent_updates(swbt_session_t* session) {
-    if (!session) return;
-    static_cast<SwbtSessionImpl*>(session->impl)->session->post_torrent_updates();
+static void signal_events(SwbtSessionImpl* impl, uint32_t events) {
+    impl->pending_events.fetch_or(events, std::memory_order_acq_rel);
+    std::lock_guard<std::mutex> lk(impl->event_mutex);
+    if (impl->event_callback) impl->event_callback(impl->event_context, events);
+    if (impl->event_pipe[1] >= 0) {
+        char b = 1;
+        // a full pipe already guarantees a wakeup
+        (void)!::write(impl->event_pipe[1], &b, 1);
+    }
 }
 
-int swbt_session_poll_updates(swbt_session_t* session,
-                              int timeout_ms,
-                              swbt_torrent_status_t* out_statuses,
-                              int max_count) {
-    if (!session || !out_statuses || max_count <= 0) return 0;
-    lt::session* s = static_cast<SwbtSessionImpl*>(session->impl)->session.get();
-    s->wait_for_alert(lt::milliseconds(timeout_ms));
-    std::vector<lt::alert*> alerts;
-    s->pop_alerts(&alerts);
-    int written = 0;
-    for (lt::alert* a : alerts) {
-        if (auto* upd = lt::alert_cast<lt::state_update_alert>(a)) {
-            for (const auto& st : upd->status) {
-                if (written >= max_count) return written;
-                swbt_torrent_status_t& o = out_statuses[written++];
-                o.progress = st.progress;
-                o.download_rate = st.download_rate;
-                o.upload_rate = st.upload_rate;
-                o.total_downloaded = st.total_download;
-                o.total_uploaded = st.total_upload;
-                o.num_peers = st.num_peers;
-                o.num_seeds = st.num_seeds;
-                o.state = static_cast<int32_t>(st.state);
-                o.has_metadata = st.has_metadata ? 1 : 0;
-                // fill id and name
-#if LT_VERSION_NUM >= 10200
-                if (st.info_hashes.has_v2()) hex_encode(reinterpret_cast<const unsigned char*>(st.info_hashes.v2.data()), st.info_hashes.v2.size(), o.info_hash, sizeof(o.info_hash));
-                else if (st.info_hashes.has_v1()) hex_encode(reinterpret_cast<const unsigned char*>(st.info_hashes.v1.data()), st.info_hashes.v1.size(), o.info_hash, sizeof(o.info_hash));
-                else if (sizeof(o.info_hash) > 0) o.info_hash[0] = '\0';
-#else
-                hex_encode(reinterpret_cast<const unsigned char*>(st.info_hash.data()), st.info_hash.size(), o.info_hash, sizeof(o.info_hash));
-#endif
-                copy_cstr_safe(o.name, sizeof(o.name), st.name);
-            }
-        }
+static std::shared_ptr<SwbtResumeStore> current_store(SwbtSessionImpl* impl) {
+    std::lock_guard<std::mutex> lk(impl->store_mutex);
+    return impl->resume_store;
+}
+
+static std::shared_ptr<SwbtTrace> current_trace(SwbtSessionImpl* impl) {
+    std::lock_guard<std::mutex> lk(impl->trace_mutex);
+    return impl->trace;
+}
+
+// swbt_trace_category_e bits in order, with the libtorrent category of each.
+static const lt::alert_category_t kTraceCategories[] = {
+    lt::alert_category::error, lt::alert_category::peer, lt::alert_category::port_mapping,
+    lt::alert_category::storage, lt::alert_category::tracker, lt::alert_category::connect,
+    lt::alert_category::status, lt::alert_category::ip_block, lt::alert_category::performance_warning,
+    lt::alert_category::dht, lt::alert_category::stats, lt::alert_category::file_progress,
+    lt::alert_category::piece_progress, lt::alert_category::block_progress, lt::alert_category::upload,
+};
+
+static lt::alert_category_t trace_alert_mask(uint32_t categories) {
+    lt::alert_category_t mask{};
+    for (std::size_t i = 0; i < sizeof(kTraceCategories) / sizeof(kTraceCategories[0]); ++i) {
+        if (categories & (1u << i)) mask |= kTraceCategories[i];
     }
-    return written;
+    return mask;
 }
 
-swbt_error_code_e swbt_torrent_infohash(swbt_torrent_handle_t* handle, char* out_hex, int out_len) {
-    if (!handle || !out_hex || out_len <= 0) return SWBT_ERR_INVALID_ARG;
-    fill_infohash_hex(static_cast<SwbtTorrentHandleImpl*>(handle->impl)->handle, out_hex, out_len);
-    return SWBT_OK;
+// Every swbt_trace_category_e bit matching an alert's (already masked) categories.
+static uint16_t trace_category_of(lt::alert_category_t category) {
+    uint16_t bits = 0;
+    for (std::size_t i = 0; i < sizeof(kTraceCategories) / sizeof(kTraceCategories[0]); ++i) {
+        if (category & kTraceCategories[i]) bits |= static_cast<uint16_t>(1u << i);
+    }
+    return bits;
 }
 
-void swbt_torrent_save_resume(swbt_torrent_handle_t* handle) {
-    if (!handle) return;
-#if LT_VERSION_NUM >= 10200
-    static_cast<SwbtTorrentHandleImpl*>(handle->impl)->handle.save_resume_data(lt::torrent_handle::save_info_dict);
-#else
-    static_cast<SwbtTorrentHandleImpl*>(handle->impl)->handle.save_resume_data(lt::torrent_handle::save_info_dict);
-#endif
+static void trace_hash_prefix(const lt::info_hash_t& ih, uint8_t* out, std::size_t len) {
+    if (ih.has_v2()) std::memcpy(out, ih.v2.data(), std::min<std::size_t>(len, ih.v2.size()));
+    else if (ih.has_v1()) std::memcpy(out, ih.v1.data(), std::min<std::size_t>(len, ih.v1.size()));
 }
 
-int swbt_session_poll_resume(swbt_session_t* session,
-                             int timeout_ms,
-                             swbt_resume_data_t* out_items,
-                             int max_count) {
-    if (!session || !out_items || max_count <= 0) return 0;
-    lt::session* s = static_cast<SwbtSessionImpl*>(session->impl)->session.get();
-    s->wait_for_alert(lt::milliseconds(timeout_ms));
-    std::vector<lt::alert*> alerts;
-    s->pop_alerts(&alerts);
-    int written = 0;
-    for (lt::alert* a : alerts) {
-        if (auto* ok = lt::alert_cast<lt::save_resume_data_alert>(a)) {
-            if (written >= max_count) return written;
-            auto& item = out_items[written++];
-            fill_infohash_hex(ok->handle, item.info_hash, sizeof(item.info_hash));
-            // encode resume data to buffer
-            std::vector<char> buf = lt::write_resume_data_buf(ok->params);
-            uint8_t* raw = static_cast<uint8_t*>(std::malloc(buf.size()));
-            if (raw && !buf.empty()) std::memcpy(raw, buf.data(), buf.size());
-            item.data = raw;
-            item.size = static_cast<int32_t>(buf.size());
+// Type-specific fields of a trace record; the layout is documented with
+// swbt_trace_record_t. Reads alert members only, so it never allocates.
+static void fill_trace_payload(lt::alert* a, swbt_trace_record_t& r) {
+    if (auto* pa = dynamic_cast<lt::peer_alert*>(a)) {
+        lt::address addr = pa->endpoint.address();
+        if (addr.is_v4()) {
+            auto v4 = addr.to_v4().to_bytes();
+            r.data[10] = r.data[11] = 0xFF;
+            std::memcpy(r.data + 12, v4.data(), v4.size());
+        } else {
+            auto v6 = addr.to_v6().to_bytes();
+            std::memcpy(r.data, v6.data(), v6.size());
         }
+        r.value2 = pa->endpoint.port();
+        if (auto* pd = lt::alert_cast<lt::peer_disconnected_alert>(a)) r.error_code = pd->error.value();
+        else if (auto* pb = lt::alert_cast<lt::peer_blocked_alert>(a)) r.value0 = pb->reason;
+        return;
+    }
+    if (auto* sc = lt::alert_cast<lt::state_changed_alert>(a)) {
+        r.value0 = static_cast<int64_t>(sc->state);
+        r.value1 = static_cast<int64_t>(sc->prev_state);
+    } else if (auto* added = lt::alert_cast<lt::add_torrent_alert>(a)) {
+        r.error_code = added->error.value();
+        trace_hash_prefix(added->params.ti ? added->params.ti->info_hashes() : added->params.info_hashes, r.data, sizeof(r.data));
+    } else if (auto* upd = lt::alert_cast<lt::state_update_alert>(a)) {
+        r.value0 = static_cast<int64_t>(upd->status.size());
+    } else if (auto* pf = lt::alert_cast<lt::piece_finished_alert>(a)) {
+        r.value0 = static_cast<int>(pf->piece_index);
+    } else if (auto* hf = lt::alert_cast<lt::hash_failed_alert>(a)) {
+        r.value0 = static_cast<int>(hf->piece_index);
+    } else if (auto* fc = lt::alert_cast<lt::file_completed_alert>(a)) {
+        r.value0 = static_cast<int>(fc->index);
+    } else if (auto* reply = lt::alert_cast<lt::tracker_reply_alert>(a)) {
+        r.value0 = reply->num_peers;
+    } else if (auto* te = lt::alert_cast<lt::tracker_error_alert>(a)) {
+        r.error_code = te->error.value();
+        r.value0 = te->times_in_row;
+    } else if (auto* perf = lt::alert_cast<lt::performance_alert>(a)) {
+        r.value0 = static_cast<int>(perf->warning_code);
+    } else if (auto* ls = lt::alert_cast<lt::listen_succeeded_alert>(a)) {
+        r.value2 = ls->port;
+    } else if (auto* lf = lt::alert_cast<lt::listen_failed_alert>(a)) {
+        r.value2 = lf->port;
+        r.error_code = lf->error.value();
+    } else if (auto* dropped = lt::alert_cast<lt::alerts_dropped_alert>(a)) {
+        r.value0 = static_cast<int64_t>(dropped->dropped_alerts.count());
+    } else if (auto* tor = lt::alert_cast<lt::torrent_error_alert>(a)) {
+        r.error_code = tor->error.value();
+    } else if (auto* fe = lt::alert_cast<lt::file_error_alert>(a)) {
+        r.error_code = fe->error.value();
+    } else if (auto* mf = lt::alert_cast<lt::metadata_failed_alert>(a)) {
+        r.error_code = mf->error.value();
+    } else if (auto* sf = lt::alert_cast<lt::save_resume_data_failed_alert>(a)) {
+        r.error_code = sf->error.value();
     }
-    return written;
 }
 
-void swbt_resume_data_free(swbt_resume_data_t* items, int count) {
-    if (!items || count <= 0) return;
-    for (int i = 0; i < count; ++i) {
-        if (items[i].data) std::free(const_cast<uint8_t*>(items[i].data));
-        items[i].data = nullptr;
-        items[i].size = 0;
+// Session-local id for a torrent alert, by lookup only: registry writes stay in
+// dispatch_alerts. Runs before the batch is dispatched, so a removal is still
+// found, while an async add isn't entered yet and records 0 (its data carries
+// the hash). Caller holds registry.mutex.
+static uint32_t trace_torrent_id_locked(const SwbtTorrentRegistry& reg, lt::alert* a, const lt::torrent_alert& ta) {
+    if (auto* removed = lt::alert_cast<lt::torrent_removed_alert>(a)) return registry_find_locked(reg, removed->info_hashes);
+    if (auto* added = lt::alert_cast<lt::add_torrent_alert>(a)) {
+        if (added->error) return 0;
+        return registry_find_locked(reg, added->params.ti ? added->params.ti->info_hashes() : added->params.info_hashes);
     }
+    auto it = reg.by_handle.find(ta.handle.id());
+    return it != reg.by_handle.end() ? it->second : 0;
 }
 
-static lt::add_torrent_params build_add_params_with_resume(const lt::add_torrent_params& base,
-                                                           const uint8_t* resume_data,
-                                                           int resume_size) {
-    lt::add_torrent_params p = base;
-    if (resume_data && resume_size > 0) {
-        p.resume_data.assign(reinterpret_cast<const char*>(resume_data), reinterpret_cast<const char*>(resume_data) + resume_size);
+// Records the batch's alerts in the trace's categories.
+static void trace_alerts(SwbtSessionImpl* impl, SwbtTrace& trace, const std::vector<lt::alert*>& alerts) {
+    lt::alert_category_t mask = trace_alert_mask(impl->trace_categories.load(std::memory_order_relaxed));
+    SwbtTraceRecorder& recorder = *trace.recorder;
+    std::lock_guard<std::mutex> lk(impl->registry.mutex);
+    for (lt::alert* a : alerts) {
+        lt::alert_category_t category = a->category() & mask;
+        if (!category) continue;
+        uint64_t seq = 0;
+        swbt_trace_record_t* r = recorder.claim(seq);
+        r->time_us = recorder.started_us()
+            + std::chrono::duration_cast<std::chrono::microseconds>(a->timestamp() - trace.t0).count();
+        r->alert_type = static_cast<uint16_t>(a->type());
+        r->category = trace_category_of(category);
+        if (auto* ta = dynamic_cast<lt::torrent_alert*>(a)) r->torrent_id = trace_torrent_id_locked(impl->registry, a, *ta);
+        fill_trace_payload(a, *r);
+        recorder.publish(r, seq);
     }
-    return p;
 }
 
-swbt_error_code_e swbt_add_magnet_with_resume(swbt_session_t* session,
-                                              const char* magnet_uri,
-                                              const char* save_path,
+static std::shared_ptr<SwbtMetadataCache> current_metadata_cache(SwbtSessionImpl* impl) {
+    std::lock_guard<std::mutex> lk(impl->metadata_mutex);
+    return impl->metadata_cache;
+}
+
+// Metadata cache key: the hex v1 hash, or the v2 hash for v2-only torrents.
+static std::string metadata_cache_key(const lt::info_hash_t& ih) {
+    char hex[65];
+    if (ih.has_v1()) hex_encode(reinterpret_cast<const unsigned char*>(ih.v1.data()), ih.v1.size(), hex, sizeof(hex));
+    else if (ih.has_v2()) hex_encode(reinterpret_cast<const unsigned char*>(ih.v2.data()), ih.v2.size(), hex, sizeof(hex));
+    else return std::string();
+    return hex;
+}
+
+// Hybrid torrents are also found by their v2 hash, for btmh-only magnets.
+static std::string metadata_cache_alias(const lt::info_hash_t& ih) {
+    if (!ih.has_v1() || !ih.has_v2()) return std::string();
+    char hex[65];
+    hex_encode(reinterpret_cast<const unsigned char*>(ih.v2.data()), ih.v2.size(), hex, sizeof(hex));
+    return hex;
+}
+
+// Gives a magnet add the cached metadata for its info-hash, if there is any.
+static void fill_from_metadata_cache(SwbtSessionImpl* impl, lt::add_torrent_params& p) {
+    if (p.ti) return;
+    std::shared_ptr<SwbtMetadataCache> cache = current_metadata_cache(impl);
+    if (!cache) return;
+    std::string key = metadata_cache_key(p.info_hashes);
+    if (key.empty()) return;
+    impl->metadata_lookups.fetch_add(1, std::memory_order_relaxed);
+    std::vector<char> buf;
+    if (!cache->get(key, buf)) return;
+    lt::error_code ec;
+    lt::bdecode_node node = lt::bdecode(lt::span<char const>(buf.data(), static_cast<std::ptrdiff_t>(buf.size())), ec);
+    std::shared_ptr<lt::torrent_info> ti;
+    if (!ec) ti = std::make_shared<lt::torrent_info>(node, ec);
+    // the entry has to hash to the key it is stored or aliased under
+    if (ec || (metadata_cache_key(ti->info_hashes()) != key && metadata_cache_alias(ti->info_hashes()) != key)) {
+        cache->erase(key);
+        impl->metadata_corrupt.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    p.ti = std::move(ti);
+    // the metadata carries the hashes; a v1 magnet of a hybrid torrent knows only one
+    p.info_hashes = lt::info_hash_t();
+    impl->metadata_hits.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Runs on the pump for metadata fetched from peers: records the time since the
+// add and queues the info dict for the cache.
+static void note_metadata_received(SwbtSessionImpl* impl, uint32_t id, const lt::torrent_handle& th) {
+    int64_t added_ms = 0;
+    {
+        std::lock_guard<std::mutex> lk(impl->registry.mutex);
+        auto it = impl->registry.by_id.find(id);
+        if (it != impl->registry.by_id.end()) added_ms = it->second.added_ms;
+    }
+    if (added_ms > 0) {
+        int64_t ms = steady_now_ms() - added_ms;
+        impl->metadata_downloads.fetch_add(1, std::memory_order_relaxed);
+        impl->time_to_metadata_total_ms.fetch_add(ms, std::memory_order_relaxed);
+        impl->time_to_metadata_last_ms.store(ms, std::memory_order_relaxed);
+        if (ms > impl->time_to_metadata_max_ms.load(std::memory_order_relaxed)) {
+            impl->time_to_metadata_max_ms.store(ms, std::memory_order_relaxed);
+        }
+    }
+    std::shared_ptr<SwbtMetadataCache> cache = current_metadata_cache(impl);
+    if (!cache) return;
+    std::shared_ptr<const lt::torrent_info> ti = th.torrent_file();
+    if (!ti) return;
+    std::string key = metadata_cache_key(ti->info_hashes());
+    if (key.empty()) return;
+    std::string alias = metadata_cache_alias(ti->info_hashes());
+    // a minimal .torrent: just the info dict
+    static const char kPrefix[] = "d4:info";
+    auto info = ti->info_section();
+    std::vector<char> buf;
+    buf.reserve(sizeof(kPrefix) + info.size());
+    buf.insert(buf.end(), kPrefix, kPrefix + sizeof(kPrefix) - 1);
+    buf.insert(buf.end(), info.begin(), info.end());
+    buf.push_back('e');
+    std::lock_guard<std::mutex> lk(impl->metadata_mutex);
+    if (!impl->metadata_pool) impl->metadata_pool = std::make_unique<SwbtWorkerPool>(1);
+    impl->metadata_pool->submit([cache, key, alias, buf = std::move(buf)] { cache->put(key, buf, alias); });
+}
+
+// Store key: the binary v1 hash, or the v2 hash for v2-only torrents.
+static std::string resume_store_key(const lt::info_hash_t& ih) {
+    if (ih.has_v1()) return std::string(ih.v1.data(), ih.v1.size());
+    if (ih.has_v2()) return std::string(ih.v2.data(), ih.v2.size());
+    return std::string();
+}
+
+// Asks libtorrent for resume data of every torrent marked dirty since the last
+// checkpoint. Returns the number of requests issued.
+static int request_checkpoint(SwbtSessionImpl* impl) {
+    std::vector<uint32_t> requested;
+    {
+        std::lock_guard<std::mutex> lk(impl->registry.mutex);
+        for (auto& kv : impl->registry.by_id) {
+            SwbtTorrentRecord& rec = kv.second;
+            if (!rec.need_save_resume || !rec.handle.is_valid()) continue;
+            rec.handle.save_resume_data(lt::torrent_handle::save_info_dict);
+            rec.need_save_resume = false;
+            requested.push_back(kv.first);
+        }
+    }
+    if (!requested.empty()) {
+        std::lock_guard<std::mutex> lk(impl->checkpoint_mutex);
+        impl->checkpoint_saves.insert(requested.begin(), requested.end());
+    }
+    return static_cast<int>(requested.size());
+}
+
+// Counts a checkpoint save as answered. Saves requested outside a checkpoint
+// (swbt_torrent_save_resume) also land in the store but aren't waited for.
+static void release_checkpoint_save(SwbtSessionImpl* impl, uint32_t torrent_id) {
+    if (torrent_id == 0) return;
+    std::lock_guard<std::mutex> lk(impl->checkpoint_mutex);
+    if (impl->checkpoint_saves.erase(torrent_id) && impl->checkpoint_saves.empty()) impl->checkpoint_cv.notify_all();
+}
+
+static uint32_t registry_id_of(SwbtTorrentRegistry& reg, const lt::torrent_handle& th) {
+    std::lock_guard<std::mutex> lk(reg.mutex);
+    auto h = reg.by_handle.find(th.id());
+    return h != reg.by_handle.end() ? h->second : 0;
+}
+
+// Sets the record's pause_unmanaged and returns its previous value (false for
+// torrents not in the registry).
+static bool registry_exchange_pause_unmanaged(SwbtTorrentRegistry& reg, const lt::torrent_handle& th, bool value) {
+    std::lock_guard<std::mutex> lk(reg.mutex);
+    auto h = reg.by_handle.find(th.id());
+    if (h == reg.by_handle.end()) return false;
+    auto it = reg.by_id.find(h->second);
+    if (it == reg.by_id.end()) return false;
+    bool previous = it->second.pause_unmanaged;
+    it->second.pause_unmanaged = value;
+    return previous;
+}
+
+struct SwbtGoalHit {
+    lt::torrent_handle handle;
+    lt::info_hash_t info_hashes;
+    double ratio = 0.0;
+    int64_t seeding_s = 0;
+};
+
+static double record_ratio(const SwbtTorrentRecord& rec) {
+    return rec.total_wanted > 0 ? static_cast<double>(rec.all_time_upload) / static_cast<double>(rec.total_wanted) : 0.0;
+}
+
+// Idle seeds post no updates, so seeding time is extrapolated from the last one.
+static int64_t record_seeding_s(const SwbtTorrentRecord& rec, int64_t now_ms) {
+    if (rec.state != lt::torrent_status::seeding || rec.paused) return rec.seeding_s;
+    return rec.seeding_s + (now_ms - rec.seeding_observed_ms) / 1000;
+}
+
+static void check_goals_locked(SwbtSessionImpl* impl, SwbtTorrentRecord& rec, int64_t now_ms, std::vector<SwbtGoalHit>& hits) {
+    if (rec.goal_reached || !rec.has_metadata) return;
+    if (rec.state != lt::torrent_status::seeding && rec.state != lt::torrent_status::finished) return;
+    double ratio_goal = rec.goal_ratio >= 0 ? rec.goal_ratio : impl->goal_ratio.load(std::memory_order_relaxed);
+    int64_t seed_goal = rec.goal_seed_s >= 0 ? rec.goal_seed_s : impl->goal_seed_s.load(std::memory_order_relaxed);
+    double ratio = record_ratio(rec);
+    int64_t seeded = record_seeding_s(rec, now_ms);
+    if (!((ratio_goal > 0 && ratio >= ratio_goal) || (seed_goal > 0 && seeded >= seed_goal))) return;
+    rec.goal_reached = true;
+    hits.push_back(SwbtGoalHit{rec.handle, rec.info_hashes, ratio, seeded});
+}
+
+// Queues a goal alert per hit and applies the session's action. Returns true if
+// anything went into the lifecycle ring.
+static bool apply_goal_hits(SwbtSessionImpl* impl, const std::vector<SwbtGoalHit>& hits) {
+    if (hits.empty()) return false;
+    const bool pause = impl->goal_action.load(std::memory_order_relaxed) == SWBT_GOAL_ACTION_PAUSE;
+    for (const SwbtGoalHit& hit : hits) {
+        if (pause && hit.handle.is_valid()) {
+            // out of the queue first, or auto-management would resume it
+            hit.handle.unset_flags(lt::torrent_flags::auto_managed);
+            hit.handle.pause();
+        }
+        swbt_alert_t out{};
+        out.type = SWBT_ALERT_SEED_GOAL_REACHED;
+        fill_infohash_hex(hit.info_hashes, out.info_hash, sizeof(out.info_hash));
+        std::snprintf(out.message, sizeof(out.message), "seeding goal reached: ratio %.2f, seeded %lld s",
+                      hit.ratio, static_cast<long long>(hit.seeding_s));
+        impl->lifecycle_ring.push(std::move(out));
+    }
+    return true;
+}
+
+// Applies one state_update_alert to the registry snapshot and, in delta mode,
+// turns it into ADDED/UPDATE records. Torrents whose numeric fields are
+// unchanged since the last record produce no delta. Torrents that just met a
+// seeding goal are appended to goal_hits.
+static void apply_state_updates(SwbtSessionImpl* impl, const std::vector<lt::torrent_status>& statuses, bool emit_deltas,
+                                std::vector<SwbtGoalHit>& goal_hits) {
+    std::lock_guard<std::mutex> lk(impl->registry.mutex);
+    int64_t now = steady_now_ms();
+    impl->registry.snapshot_updated_ms = now;
+    for (const auto& st : statuses) {
+        SwbtTorrentRecord& rec = registry_ensure_locked(impl->registry, st.info_hashes);
+        if (!rec.handle.is_valid()) registry_set_handle_locked(impl->registry, rec, st.handle);
+        rec.state = static_cast<int32_t>(st.state);
+        rec.has_metadata = st.has_metadata;
+        rec.progress = st.progress;
+        rec.total_wanted = st.total_wanted;
+        rec.total_wanted_done = st.total_wanted_done;
+        rec.num_peers = st.num_peers;
+        rec.download_rate = st.download_rate;
+        rec.upload_rate = st.upload_rate;
+        rec.queue_position = static_cast<int32_t>(st.queue_position);
+        rec.auto_managed = static_cast<bool>(st.flags & lt::torrent_flags::auto_managed);
+        rec.paused = static_cast<bool>(st.flags & lt::torrent_flags::paused);
+        rec.seed_rank = st.seed_rank;
+        rec.num_complete = st.num_complete;
+        rec.num_incomplete = st.num_incomplete;
+        rec.all_time_upload = st.all_time_upload;
+        rec.seeding_s = std::chrono::duration_cast<std::chrono::seconds>(st.seeding_duration).count();
+        rec.seeding_observed_ms = now;
+        check_goals_locked(impl, rec, now, goal_hits);
+        if (st.need_save_resume) rec.need_save_resume = true;
+        if (rec.first_peer_ms < 0 && st.num_peers > 0) rec.first_peer_ms = now - rec.added_ms;
+        bool renamed = false;
+        if (!st.name.empty() && st.name != rec.name) {
+            rec.name = st.name;
+            renamed = true;
+        }
+        if (!emit_deltas) continue;
+
+        swbt_status_delta_t d{};
+        d.torrent_id = rec.id;
+        fill_delta_values(st, d);
+        if (!rec.announced) {
+            d.kind = SWBT_STATUS_RECORD_ADDED;
+            d.changed = 0xFFFFFFFFu;
+        } else {
+            uint32_t changed = diff_delta_fields(rec.last, d);
+            if (renamed) changed |= SWBT_STATUS_FIELD_IDENTITY;
+            if (changed == 0) continue;
+            d.kind = SWBT_STATUS_RECORD_UPDATE;
+            d.changed = changed;
+        }
+        // Only advance the baseline for records the consumer will actually see.
+        swbt_status_delta_t pushed = d;
+        if (impl->delta_ring.push(std::move(pushed))) {
+            rec.last = d;
+            rec.announced = true;
+        }
+    }
+}
+
+// Counter positions of the swbt_session_stats_t fields, -1 for metrics this
+// libtorrent build does not have.
+struct SwbtStatsIndices {
+    int peers_connected = lt::find_metric_idx("peer.num_peers_connected");
+    int peers_half_open = lt::find_metric_idx("peer.num_peers_half_open");
+    int peers_up_interested = lt::find_metric_idx("peer.num_peers_up_interested");
+    int peers_down_interested = lt::find_metric_idx("peer.num_peers_down_interested");
+    int peers_up_unchoked = lt::find_metric_idx("peer.num_peers_up_unchoked");
+    int peers_down_unchoked = lt::find_metric_idx("peer.num_peers_down_unchoked");
+    int peers_up_disk = lt::find_metric_idx("peer.num_peers_up_disk");
+    int peers_down_disk = lt::find_metric_idx("peer.num_peers_down_disk");
+    int torrents_checking = lt::find_metric_idx("ses.num_checking_torrents");
+    int torrents_downloading = lt::find_metric_idx("ses.num_downloading_torrents");
+    int torrents_seeding = lt::find_metric_idx("ses.num_seeding_torrents");
+    int torrents_queued_download = lt::find_metric_idx("ses.num_queued_download_torrents");
+    int torrents_queued_seeding = lt::find_metric_idx("ses.num_queued_seeding_torrents");
+    int torrents_stopped = lt::find_metric_idx("ses.num_stopped_torrents");
+    int torrents_error = lt::find_metric_idx("ses.num_error_torrents");
+    int disk_queued_jobs = lt::find_metric_idx("disk.queued_disk_jobs");
+    int disk_running_jobs = lt::find_metric_idx("disk.num_running_disk_jobs");
+    int disk_queued_write_bytes = lt::find_metric_idx("disk.queued_write_bytes");
+    int disk_blocks_in_use = lt::find_metric_idx("disk.disk_blocks_in_use");
+    int limiter_up_bytes = lt::find_metric_idx("net.limiter_up_bytes");
+    int limiter_down_bytes = lt::find_metric_idx("net.limiter_down_bytes");
+    int recv_bytes = lt::find_metric_idx("net.recv_bytes");
+    int sent_bytes = lt::find_metric_idx("net.sent_bytes");
+    int recv_payload = lt::find_metric_idx("net.recv_payload_bytes");
+    int sent_payload = lt::find_metric_idx("net.sent_payload_bytes");
+    int disk_blocks_read = lt::find_metric_idx("disk.num_blocks_read");
+    int disk_blocks_written = lt::find_metric_idx("disk.num_blocks_written");
+    int disk_blocks_hashed = lt::find_metric_idx("disk.num_blocks_hashed");
+};
+
+static const SwbtStatsIndices& stats_indices() {
+    static const SwbtStatsIndices indices;
+    return indices;
+}
+
+static const std::vector<lt::stats_metric>& stats_metrics() {
+    static const std::vector<lt::stats_metric> metrics = lt::session_stats_metrics();
+    return metrics;
+}
+
+static int64_t sample_value(const SwbtStatsSample& s, int idx) {
+    return idx >= 0 && idx < static_cast<int>(s.counters.size()) ? s.counters[idx] : -1;
+}
+
+static double sample_rate(const SwbtStatsSample& cur, const SwbtStatsSample& prev, int idx) {
+    int64_t dt = cur.timestamp_us - prev.timestamp_us;
+    if (idx < 0 || dt <= 0 || idx >= static_cast<int>(cur.counters.size()) || idx >= static_cast<int>(prev.counters.size())) return 0.0;
+    return static_cast<double>(cur.counters[idx] - prev.counters[idx]) * 1e6 / static_cast<double>(dt);
+}
+
+// Everything the core's own queues refused, plus libtorrent's queue overflows.
+static int64_t core_alert_drops(SwbtSessionImpl* impl) {
+    swbt_alert_queue_stats_t q{};
+    impl->status_ring.fill_counters(&q.status);
+    impl->delta_ring.fill_counters(&q.deltas);
+    impl->resume_ring.fill_counters(&q.resume);
+    impl->lifecycle_ring.fill_counters(&q.lifecycle);
+    impl->stats_ring.fill_counters(&q.stats);
+    impl->add_result_ring.fill_counters(&q.add_results);
+    return q.status.dropped + q.deltas.dropped + q.resume.dropped + q.lifecycle.dropped + q.stats.dropped
+        + q.add_results.dropped + static_cast<int64_t>(impl->lt_overflow_events.load(std::memory_order_relaxed));
+}
+
+// Makes `sample` the newest and maps it, against the one before, to the stable struct.
+static swbt_session_stats_t record_stats_sample(SwbtSessionImpl* impl, SwbtStatsSample sample) {
+    const SwbtStatsIndices& ix = stats_indices();
+    std::lock_guard<std::mutex> lk(impl->stats_mutex);
+    impl->stats_previous = std::move(impl->stats_latest);
+    impl->stats_latest = std::move(sample);
+    const SwbtStatsSample& cur = impl->stats_latest;
+    const SwbtStatsSample& prev = impl->stats_previous;
+
+    swbt_session_stats_t o{};
+    o.timestamp_us = cur.timestamp_us;
+    o.interval_us = prev.counters.empty() ? 0 : cur.timestamp_us - prev.timestamp_us;
+    o.peers_connected = sample_value(cur, ix.peers_connected);
+    o.peers_half_open = sample_value(cur, ix.peers_half_open);
+    o.peers_up_interested = sample_value(cur, ix.peers_up_interested);
+    o.peers_down_interested = sample_value(cur, ix.peers_down_interested);
+    o.peers_up_unchoked = sample_value(cur, ix.peers_up_unchoked);
+    o.peers_down_unchoked = sample_value(cur, ix.peers_down_unchoked);
+    o.peers_up_disk = sample_value(cur, ix.peers_up_disk);
+    o.peers_down_disk = sample_value(cur, ix.peers_down_disk);
+    o.torrents_checking = sample_value(cur, ix.torrents_checking);
+    o.torrents_downloading = sample_value(cur, ix.torrents_downloading);
+    o.torrents_seeding = sample_value(cur, ix.torrents_seeding);
+    int64_t queued_dl = sample_value(cur, ix.torrents_queued_download);
+    int64_t queued_seed = sample_value(cur, ix.torrents_queued_seeding);
+    o.torrents_queued = queued_dl < 0 || queued_seed < 0 ? -1 : queued_dl + queued_seed;
+    o.torrents_stopped = sample_value(cur, ix.torrents_stopped);
+    o.torrents_error = sample_value(cur, ix.torrents_error);
+    o.disk_queued_jobs = sample_value(cur, ix.disk_queued_jobs);
+    o.disk_running_jobs = sample_value(cur, ix.disk_running_jobs);
+    o.disk_queued_write_bytes = sample_value(cur, ix.disk_queued_write_bytes);
+    o.disk_blocks_in_use = sample_value(cur, ix.disk_blocks_in_use);
+    o.limiter_up_bytes = sample_value(cur, ix.limiter_up_bytes);
+    o.limiter_down_bytes = sample_value(cur, ix.limiter_down_bytes);
+    o.recv_bytes = sample_value(cur, ix.recv_bytes);
+    o.sent_bytes = sample_value(cur, ix.sent_bytes);
+    o.alerts_dropped = core_alert_drops(impl);
+    o.recv_bytes_per_s = sample_rate(cur, prev, ix.recv_bytes);
+    o.sent_bytes_per_s = sample_rate(cur, prev, ix.sent_bytes);
+    o.recv_payload_per_s = sample_rate(cur, prev, ix.recv_payload);
+    o.sent_payload_per_s = sample_rate(cur, prev, ix.sent_payload);
+    o.disk_blocks_read_per_s = sample_rate(cur, prev, ix.disk_blocks_read);
+    o.disk_blocks_written_per_s = sample_rate(cur, prev, ix.disk_blocks_written);
+    o.disk_blocks_hashed_per_s = sample_rate(cur, prev, ix.disk_blocks_hashed);
+    return o;
+}
+
+// Holds a shard's sample until every shard has answered the round, then turns
+// `sample` into their sum. Gauges and counters both add up across shards.
+static bool merge_shard_stats(SwbtSessionImpl* impl, std::size_t shard, SwbtStatsSample& sample) {
+    std::size_t n = impl->shards.size();
+    if (impl->stats_parts.size() != n) {
+        impl->stats_parts.assign(n, SwbtStatsSample{});
+        impl->stats_parts_seen.assign(n, 0);
+    }
+    impl->stats_parts[shard] = std::move(sample);
+    impl->stats_parts_seen[shard] = 1;
+    for (char seen : impl->stats_parts_seen) {
+        if (!seen) return false;
+    }
+    SwbtStatsSample sum;
+    for (const SwbtStatsSample& part : impl->stats_parts) {
+        sum.timestamp_us = std::max(sum.timestamp_us, part.timestamp_us);
+        if (sum.counters.size() < part.counters.size()) sum.counters.resize(part.counters.size(), 0);
+        for (std::size_t i = 0; i < part.counters.size(); ++i) sum.counters[i] += part.counters[i];
+    }
+    std::fill(impl->stats_parts_seen.begin(), impl->stats_parts_seen.end(), 0);
+    sample = std::move(sum);
+    return true;
+}
+
+// Device holding a save path, from the nearest existing ancestor; 0 if none.
+static uint64_t storage_device_of(std::string path) {
+    struct stat st;
+    while (!path.empty()) {
+        if (::stat(path.c_str(), &st) == 0) return static_cast<uint64_t>(st.st_dev);
+        std::size_t slash = path.find_last_of('/');
+        if (slash == std::string::npos || path == "/") break;
+        path.resize(slash == 0 ? 1 : slash);
+    }
+    return 0;
+}
+
+static swbt_alert_t recheck_alert(swbt_alert_type_e type, const SwbtRecheckJob& job, float progress, int32_t error_code, const std::string& message) {
+    swbt_alert_t out{};
+    out.type = type;
+    fill_infohash_hex(job.info_hashes, out.info_hash, sizeof(out.info_hash));
+    out.error_code = error_code;
+    copy_cstr_safe(out.message, sizeof(out.message), message);
+    out.progress = progress;
+    return out;
+}
+
+static void enqueue_recheck(SwbtSessionImpl* impl, uint32_t torrent_id, const lt::torrent_handle& th,
+                            const std::string& save_path, bool start_after, bool immediate = false) {
+    SwbtRecheckJob job;
+    job.torrent_id = torrent_id;
+    job.info_hashes = th.info_hashes();
+    job.handle = th;
+    job.device = storage_device_of(save_path);
+    job.start_after = start_after;
+    job.immediate = immediate;
+    {
+        std::lock_guard<std::mutex> lk(impl->recheck_mutex);
+        auto same = [torrent_id](const SwbtRecheckJob& j) { return j.torrent_id == torrent_id; };
+        auto queued = std::find_if(impl->recheck_queue.begin(), impl->recheck_queue.end(), same);
+        if (queued != impl->recheck_queue.end()) {
+            queued->immediate = queued->immediate || immediate;
+            if (immediate) wake_pump(impl);
+            return;
+        }
+        if (std::any_of(impl->rechecks_running.begin(), impl->rechecks_running.end(), same)) return;
+        impl->recheck_queue.push_back(std::move(job));
+    }
+    impl->rechecks_pending.store(true, std::memory_order_relaxed);
+    wake_pump(impl);
+}
+
+// Keeps the registry state current between status refreshes, which the
+// scheduler waits on before starting a check, and marks running checks whose
+// torrent has started checking. force_recheck passes through
+// checking_resume_data first and skips checking_files when no file exists yet.
+static void note_state_changed(SwbtSessionImpl* impl, const lt::torrent_handle& th, lt::torrent_status::state_t state) {
+    {
+        std::lock_guard<std::mutex> lk(impl->registry.mutex);
+        auto h = impl->registry.by_handle.find(th.id());
+        if (h != impl->registry.by_handle.end()) {
+            auto rec = impl->registry.by_id.find(h->second);
+            if (rec != impl->registry.by_id.end()) rec->second.state = static_cast<int32_t>(state);
+        }
+    }
+    if (state != lt::torrent_status::checking_files && state != lt::torrent_status::checking_resume_data) return;
+    if (!impl->rechecks_pending.load(std::memory_order_relaxed)) return;
+    std::lock_guard<std::mutex> lk(impl->recheck_mutex);
+    for (SwbtRecheckJob& j : impl->rechecks_running) {
+        if (j.handle == th) j.check_seen = true;
+    }
+}
+
+// Retires the running check of th, if any, and restores its queue state. A
+// completed check only counts once the torrent was seen checking, so the
+// checked alert of an earlier resume data check doesn't end the job.
+static bool finish_recheck(SwbtSessionImpl* impl, const lt::torrent_handle& th, int32_t error_code, const std::string& message) {
+    std::lock_guard<std::mutex> lk(impl->recheck_mutex);
+    auto& running = impl->rechecks_running;
+    auto it = std::find_if(running.begin(), running.end(), [&th](const SwbtRecheckJob& j) { return j.handle == th; });
+    if (it == running.end()) return false;
+    if (error_code == 0 && !it->check_seen) return false;
+    try {
+        if (it->restore_auto_managed) th.set_flags(lt::torrent_flags::auto_managed);
+        else if (it->restore_paused) th.pause();
+    } catch (const std::exception&) {
+        // removed meanwhile
+    }
+    impl->lifecycle_ring.push(recheck_alert(SWBT_ALERT_RECHECK_FINISHED, *it, error_code == 0 ? 1.0f : 0.0f, error_code, message));
+    running.erase(it);
+    return true;
+}
+
+// Once a ring has spilled, later records wait behind the spilled ones so the
+// poller still sees them in order.
+static void queue_status(SwbtSessionImpl* impl, uint32_t key, swbt_torrent_status_t&& o) {
+    if (impl->status_waiting.empty() && !impl->status_ring.full()) {
+        impl->status_ring.push(std::move(o));
+        return;
+    }
+    impl->status_waiting[key] = std::move(o);
+    impl->rings_spilled.store(true, std::memory_order_relaxed);
+}
+
+static void queue_resume_data(SwbtSessionImpl* impl, swbt_resume_data_t&& item) {
+    if (impl->resume_waiting.empty() && !impl->resume_ring.full()) {
+        impl->resume_ring.push(std::move(item));
+        return;
+    }
+    impl->resume_waiting.push_back(std::move(item));
+    impl->rings_spilled.store(true, std::memory_order_relaxed);
+}
+
+// Returns the swbt_event_e bits of the rings that received records.
+static uint32_t dispatch_alerts(SwbtSessionImpl* impl, const std::vector<lt::alert*>& alerts, std::size_t shard) {
+    bool status_touched = false, delta_touched = false, resume_touched = false, lifecycle_touched = false, stats_touched = false, add_touched = false;
+    bool pieces_finished = false;
+    std::shared_ptr<SwbtResumeStore> store = current_store(impl);
+    if (std::shared_ptr<SwbtTrace> trace = current_trace(impl)) trace_alerts(impl, *trace, alerts);
+    for (lt::alert* a : alerts) {
+        if (auto* upd = lt::alert_cast<lt::state_update_alert>(a)) {
+            uint32_t modes = impl->update_modes.load(std::memory_order_relaxed);
+            // The pump posts updates on its own for the snapshot; don't let them pile
+            // up in the full-record queue while nobody is polling it.
+            if ((modes & SWBT_UPDATE_MODE_FULL) && impl->status_ring.has_recent_consumer(steady_now_ms(), SWBT_STATUS_CONSUMER_WINDOW_MS)) {
+                for (const auto& st : upd->status) {
+                    swbt_torrent_status_t o{};
+                    fill_status_from_lt(st, o);
+                    queue_status(impl, st.handle.id(), std::move(o));
+                }
+                status_touched = true;
+            }
+            bool emit_deltas = (modes & SWBT_UPDATE_MODE_DELTA) != 0;
+            std::vector<SwbtGoalHit> goal_hits;
+            apply_state_updates(impl, upd->status, emit_deltas, goal_hits);
+            delta_touched = delta_touched || emit_deltas;
+            if (apply_goal_hits(impl, goal_hits)) lifecycle_touched = true;
+        } else if (auto* added = lt::alert_cast<lt::add_torrent_alert>(a)) {
+            bool restored = false;
+            if (auto* pending = added->params.userdata.get<SwbtPendingAdd*>()) {
+                restored = pending->from_store;
+                swbt_add_result_t r{};
+                r.user_tag = pending->user_tag;
+                if (added->error) {
+                    r.error_code = SWBT_ERR_GENERIC;
+                    copy_cstr_safe(r.message, sizeof(r.message), added->error.message());
+                } else {
+                    r.error_code = SWBT_OK;
+                }
+                fill_infohash_hex(added->params.ti ? added->params.ti->info_hashes() : added->params.info_hashes,
+                                  r.info_hash, sizeof(r.info_hash));
+                if (!added->error) r.torrent_id = registry_add(impl->registry, added->handle, shard);
+                if (!added->error && pending->scheduled_check) {
+                    enqueue_recheck(impl, r.torrent_id, added->handle, added->params.save_path, true);
+                }
+                add_touched = true;
+                std::lock_guard<std::mutex> lk(impl->add_mutex);
+                // add results are never dropped: when the ring is full they wait for the consumer
+                if (!impl->add_results_waiting.empty() || impl->add_result_ring.full()) impl->add_results_waiting.push_back(r);
+                else impl->add_result_ring.push(std::move(r));
+                impl->pending_adds.erase(pending);
+                delete pending;
+            }
+            if (!added->error) {
+                std::lock_guard<std::mutex> lk(impl->registry.mutex);
+                SwbtTorrentRecord& rec = registry_ensure_locked(impl->registry, added->handle.info_hashes());
+                registry_set_handle_locked(impl->registry, rec, added->handle);
+                rec.need_save_resume = !restored;
+                if (rec.name.empty()) rec.name = added->params.ti ? added->params.ti->name() : added->params.name;
+                if (added->params.ti) {
+                    rec.has_metadata = true;
+                    if (rec.total_wanted == 0) rec.total_wanted = added->params.ti->total_size();
+                }
+            }
+        } else if (auto* removed = lt::alert_cast<lt::torrent_removed_alert>(a)) {
+            uint32_t id = registry_remove(impl->registry, removed->info_hashes);
+            release_checkpoint_save(impl, id);
+            if (store) store->erase(resume_store_key(removed->info_hashes));
+            if (id != 0 && (impl->update_modes.load(std::memory_order_relaxed) & SWBT_UPDATE_MODE_DELTA)) {
+                swbt_status_delta_t d{};
+                d.torrent_id = id;
+                d.kind = SWBT_STATUS_RECORD_REMOVED;
+                impl->delta_ring.push(std::move(d));
+                delta_touched = true;
+            }
+        } else if (auto* rd = lt::alert_cast<lt::save_resume_data_alert>(a)) {
+            if (store) {
+                store->put(resume_store_key(rd->handle.info_hashes()), lt::write_resume_data_buf(rd->params));
+                release_checkpoint_save(impl, registry_id_of(impl->registry, rd->handle));
+                continue;
+            }
+            swbt_resume_data_t item{};
+            fill_infohash_hex(rd->handle, item.info_hash, sizeof(item.info_hash));
+            // encode resume data to buffer
+            std::vector<char> buf = lt::write_resume_data_buf(rd->params);
+            uint8_t* raw = static_cast<uint8_t*>(std::malloc(buf.size()));
+            if (raw && !buf.empty()) std::memcpy(raw, buf.data(), buf.size());
+            item.data = raw;
+            item.size = static_cast<int32_t>(buf.size());
+            queue_resume_data(impl, std::move(item));
+            resume_touched = true;
+        } else if (auto* ss = lt::alert_cast<lt::session_stats_alert>(a)) {
+            auto counters = ss->counters();
+            SwbtStatsSample sample;
+            sample.timestamp_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                ss->timestamp().time_since_epoch()).count();
+            sample.counters.assign(counters.begin(), counters.end());
+            if (impl->shards.size() > 1 && !merge_shard_stats(impl, shard, sample)) continue;
+            impl->stats_ring.push(record_stats_sample(impl, std::move(sample)));
+            stats_touched = true;
+        } else if (lt::alert_cast<lt::piece_finished_alert>(a)) {
+            pieces_finished = true;
+        } else if (lt::alert_cast<lt::alerts_dropped_alert>(a)) {
+            impl->lt_overflow_events.fetch_add(1, std::memory_order_relaxed);
+        } else if (auto* blocked = lt::alert_cast<lt::peer_blocked_alert>(a)) {
+            if (blocked->reason == lt::peer_blocked_alert::ip_filter) impl->blocklist_blocked.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            if (auto* md = lt::alert_cast<lt::metadata_received_alert>(a)) {
+                // hybrid torrents added by v1 magnet only learn their v2 hash here
+                uint32_t id = registry_add(impl->registry, md->handle, shard);
+                note_metadata_received(impl, id, md->handle);
+            } else if (auto* save_failed = lt::alert_cast<lt::save_resume_data_failed_alert>(a)) {
+                release_checkpoint_save(impl, registry_id_of(impl->registry, save_failed->handle));
+            } else if (auto* changed = lt::alert_cast<lt::state_changed_alert>(a)) {
+                note_state_changed(impl, changed->handle, changed->state);
+            } else if (auto* checked = lt::alert_cast<lt::torrent_checked_alert>(a)) {
+                if (finish_recheck(impl, checked->handle, 0, "check complete")) lifecycle_touched = true;
+            } else if (auto* failed = lt::alert_cast<lt::torrent_error_alert>(a)) {
+                if (finish_recheck(impl, failed->handle, failed->error.value(), failed->error.message())) lifecycle_touched = true;
+            }
+            swbt_alert_t out{};
+            if (map_lifecycle_alert(a, out)) {
+                impl->lifecycle_ring.push(std::move(out));
+                lifecycle_touched = true;
+            }
+        }
+    }
+    if (status_touched) impl->status_ring.notify();
+    if (delta_touched) impl->delta_ring.notify();
+    if (resume_touched) impl->resume_ring.notify();
+    if (lifecycle_touched) impl->lifecycle_ring.notify();
+    if (stats_touched) impl->stats_ring.notify();
+    if (add_touched) impl->add_result_ring.notify();
+    if (pieces_finished) {
+        std::lock_guard<std::mutex> lk(impl->piece_mutex);
+        ++impl->piece_events;
+        impl->piece_cv.notify_all();
+    }
+    return (status_touched ? SWBT_EVENT_STATUS : 0)
+        | (delta_touched ? SWBT_EVENT_STATUS_DELTAS : 0)
+        | (resume_touched ? SWBT_EVENT_RESUME_DATA : 0)
+        | (lifecycle_touched ? SWBT_EVENT_ALERTS : 0)
+        | (stats_touched ? SWBT_EVENT_SESSION_STATS : 0)
+        | (add_touched ? SWBT_EVENT_ADD_RESULTS : 0)
+        | (pieces_finished ? SWBT_EVENT_PIECES : 0);
+}
+
+// Parse failures are reported by pool threads, and results that found the ring
+// full wait with them; the pump stays the only producer of add_result_ring by
+// moving them over here, as many as fit.
+static uint32_t drain_add_results_waiting(SwbtSessionImpl* impl) {
+    std::lock_guard<std::mutex> lk(impl->add_mutex);
+    auto& waiting = impl->add_results_waiting;
+    std::size_t n = 0;
+    while (n < waiting.size() && !impl->add_result_ring.full()) impl->add_result_ring.push(std::move(waiting[n++]));
+    if (n == 0) return 0;
+    waiting.erase(waiting.begin(), waiting.begin() + static_cast<std::ptrdiff_t>(n));
+    impl->add_result_ring.notify();
+    return SWBT_EVENT_ADD_RESULTS;
+}
+
+// Moves spilled status and resume records into their rings, as many as fit.
+static uint32_t drain_spilled_records(SwbtSessionImpl* impl) {
+    if (!impl->rings_spilled.load(std::memory_order_relaxed)) return 0;
+    uint32_t events = 0;
+    auto& statuses = impl->status_waiting;
+    for (auto it = statuses.begin(); it != statuses.end() && !impl->status_ring.full(); it = statuses.erase(it)) {
+        impl->status_ring.push(std::move(it->second));
+        events |= SWBT_EVENT_STATUS;
+    }
+    auto& resume = impl->resume_waiting;
+    while (!resume.empty() && !impl->resume_ring.full()) {
+        impl->resume_ring.push(std::move(resume.front()));
+        resume.pop_front();
+        events |= SWBT_EVENT_RESUME_DATA;
+    }
+    if (events & SWBT_EVENT_STATUS) impl->status_ring.notify();
+    if (events & SWBT_EVENT_RESUME_DATA) impl->resume_ring.notify();
+    impl->rings_spilled.store(!statuses.empty() || !resume.empty(), std::memory_order_relaxed);
+    return events;
+}
+
+// Same for blocklist loads finishing on their pool thread.
+static uint32_t drain_blocklist_alerts(SwbtSessionImpl* impl) {
+    std::vector<swbt_alert_t> alerts;
+    {
+        std::lock_guard<std::mutex> lk(impl->blocklist_mutex);
+        if (impl->blocklist_alerts.empty()) return 0;
+        alerts.swap(impl->blocklist_alerts);
+    }
+    for (auto& a : alerts) impl->lifecycle_ring.push(std::move(a));
+    impl->lifecycle_ring.notify();
+    return SWBT_EVENT_ALERTS;
+}
+
+// The memory backend dropped pieces these torrents already had; their piece
+// bitfields are stale until a recheck finds the holes.
+static void recheck_evicted(SwbtSessionImpl* impl) {
+    for (const lt::sha1_hash& ih : impl->disk_shared->take_evicted()) {
+        // the storage's hash is v1 or a truncated v2, neither of which says which shard
+        // the torrent was added to, so ask them all
+        lt::torrent_handle th;
+        for (std::size_t i = 0; i < impl->shards.size() && !th.is_valid(); ++i) th = impl->shards[i]->find_torrent(ih);
+        if (!th.is_valid()) continue;
+        th.clear_error();
+        th.force_recheck();
+    }
+}
+
+// Share of a session-wide limit for each shard, weighted by what the shard moved
+// over the last snapshot. A shard using most of its current share is weighted up
+// so bandwidth can migrate to it; a floor lets idle shards ramp up.
+static std::vector<int> split_rate_limit(int limit, const std::vector<int64_t>& used, const std::vector<int>& current) {
+    std::size_t n = used.size();
+    std::vector<int> out(n, 0);
+    if (limit <= 0 || n == 0) return out;
+    const double floor = std::max(1.0, limit / (4.0 * static_cast<double>(n)));
+    std::vector<double> weight(n);
+    double total = 0.0;
+    for (std::size_t i = 0; i < n; ++i) {
+        double u = static_cast<double>(used[i]);
+        if (current[i] > 0 && u >= 0.9 * current[i]) u *= 1.5;
+        weight[i] = u + floor;
+        total += weight[i];
+    }
+    for (std::size_t i = 0; i < n; ++i) {
+        out[i] = std::max(1, static_cast<int>(static_cast<double>(limit) * weight[i] / total));
+    }
+    return out;
+}
+
+// Small moves aren't worth a round-trip to the network thread.
+static bool share_moved(int from, int to) {
+    return from <= 0 || std::abs(to - from) * 20 > from;
+}
+
+// Spreads the global limits evenly; the pump refines the split from then on.
+static void set_global_rate_limits(SwbtSessionImpl* impl, int download_rate, int upload_rate) {
+    const int n = static_cast<int>(impl->shards.size());
+    lt::settings_pack p;
+    if (download_rate >= 0) {
+        impl->global_download_limit.store(download_rate, std::memory_order_relaxed);
+        p.set_int(lt::settings_pack::download_rate_limit, download_rate > 0 ? std::max(1, download_rate / n) : 0);
+    }
+    if (upload_rate >= 0) {
+        impl->global_upload_limit.store(upload_rate, std::memory_order_relaxed);
+        p.set_int(lt::settings_pack::upload_rate_limit, upload_rate > 0 ? std::max(1, upload_rate / n) : 0);
+    }
+    apply_to_shards(impl, p);
+}
+
+static void rebalance_rate_limits(SwbtSessionImpl* impl) {
+    const std::size_t n = impl->shards.size();
+    int dl_limit = impl->global_download_limit.load(std::memory_order_relaxed);
+    int ul_limit = impl->global_upload_limit.load(std::memory_order_relaxed);
+    if (n <= 1 || (dl_limit <= 0 && ul_limit <= 0)) return;
+    std::vector<int64_t> dl_used(n, 0), ul_used(n, 0);
+    {
+        std::lock_guard<std::mutex> lk(impl->registry.mutex);
+        for (const auto& kv : impl->registry.by_id) {
+            std::size_t k = record_shard(impl, kv.second);
+            dl_used[k] += kv.second.download_rate;
+            ul_used[k] += kv.second.upload_rate;
+        }
+    }
+    std::vector<int> dl_current(n), ul_current(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        lt::settings_pack cur = impl->shards[i]->get_settings();
+        dl_current[i] = cur.get_int(lt::settings_pack::download_rate_limit);
+        ul_current[i] = cur.get_int(lt::settings_pack::upload_rate_limit);
+    }
+    std::vector<int> dl_share = split_rate_limit(dl_limit, dl_used, dl_current);
+    std::vector<int> ul_share = split_rate_limit(ul_limit, ul_used, ul_current);
+    for (std::size_t i = 0; i < n; ++i) {
+        lt::settings_pack p;
+        bool dirty = false;
+        if (dl_limit > 0 && share_moved(dl_current[i], dl_share[i])) {
+            p.set_int(lt::settings_pack::download_rate_limit, dl_share[i]);
+            dirty = true;
+        }
+        if (ul_limit > 0 && share_moved(ul_current[i], ul_share[i])) {
+            p.set_int(lt::settings_pack::upload_rate_limit, ul_share[i]);
+            dirty = true;
+        }
+        if (dirty) impl->shards[i]->apply_settings(p);
+    }
+}
+
+// Part of a group's session-wide limit for one shard.
+static int per_shard_limit(const SwbtSessionImpl* impl, int limit) {
+    const int n = static_cast<int>(impl->shards.size());
+    return limit > 0 ? std::max(1, (limit + n - 1) / n) : 0;
+}
+
+// Session rate limits, which are GLOBAL's limits.
+static void global_rate_limits(SwbtSessionImpl* impl, int32_t& download_rate, int32_t& upload_rate) {
+    if (impl->shards.size() > 1) {
+        download_rate = impl->global_download_limit.load(std::memory_order_relaxed);
+        upload_rate = impl->global_upload_limit.load(std::memory_order_relaxed);
+        return;
+    }
+    lt::settings_pack pack = impl->shards[0]->get_settings();
+    download_rate = pack.get_int(lt::settings_pack::download_rate_limit);
+    upload_rate = pack.get_int(lt::settings_pack::upload_rate_limit);
+}
+
+// Pushes a group's config into its peer class on every shard. In a sharded
+// session the limits are split evenly. GLOBAL's limits are the session rate
+// limits, so they go through the settings (and the shard balancer).
+static void apply_group_config_locked(SwbtSessionImpl* impl, int32_t group, const SwbtBandwidthGroup& g) {
+    const swbt_bandwidth_group_config_t& c = g.config;
+    const bool global = group == SWBT_BANDWIDTH_GROUP_GLOBAL;
+    if (global && impl->shards.size() > 1) {
+        set_global_rate_limits(impl, c.download_rate_limit, c.upload_rate_limit);
+    } else if (global) {
+        lt::settings_pack p;
+        p.set_int(lt::settings_pack::download_rate_limit, c.download_rate_limit);
+        p.set_int(lt::settings_pack::upload_rate_limit, c.upload_rate_limit);
+        impl->shards[0]->apply_settings(p);
+    }
+    for (std::size_t i = 0; i < impl->shards.size(); ++i) {
+        lt::peer_class_info info = impl->shards[i]->get_peer_class(g.classes[i]);
+        if (!global) {
+            info.download_limit = per_shard_limit(impl, c.download_rate_limit);
+            info.upload_limit = per_shard_limit(impl, c.upload_rate_limit);
+        }
+        info.download_priority = std::clamp(c.download_priority > 0 ? c.download_priority : 1, 1, 255);
+        info.upload_priority = std::clamp(c.upload_priority > 0 ? c.upload_priority : 1, 1, 255);
+        info.connection_limit_factor = c.connection_limit_factor > 0 ? c.connection_limit_factor : 100;
+        info.ignore_unchoke_slots = c.ignore_unchoke_slots != 0;
+        impl->shards[i]->set_peer_class(g.classes[i], info);
+    }
+}
+
+// Private, link-local and loopback networks, which libtorrent's default filter
+// puts in the LOCAL class.
+static const char* const kLocalRanges[][2] = {
+    {"10.0.0.0", "10.255.255.255"},
+    {"172.16.0.0", "172.31.255.255"},
+    {"192.168.0.0", "192.168.255.255"},
+    {"169.254.0.0", "169.254.255.255"},
+    {"127.0.0.0", "127.255.255.255"},
+    {"fe80::", "febf:ffff:ffff:ffff:ffff:ffff:ffff:ffff"},
+    {"fc00::", "fdff:ffff:ffff:ffff:ffff:ffff:ffff:ffff"},
+    {"::1", "::1"},
+};
+
+// Builds a peer class filter from libtorrent's default layout plus the group
+// ranges in add order (a later rule overwrites an earlier one where they
+// overlap). class_of maps a group id to the class mask to store for it.
+template <typename ClassOf>
+static lt::ip_filter build_class_filter(const std::vector<SwbtGroupRange>& ranges, ClassOf class_of) {
+    lt::ip_filter base;
+    base.add_rule(lt::make_address("0.0.0.0"), lt::make_address("255.255.255.255"), class_of(SWBT_BANDWIDTH_GROUP_GLOBAL));
+    base.add_rule(lt::make_address("::"), lt::make_address("ffff:ffff:ffff:ffff:ffff:ffff:ffff:ffff"), class_of(SWBT_BANDWIDTH_GROUP_GLOBAL));
+    for (const auto& r : kLocalRanges) {
+        base.add_rule(lt::make_address(r[0]), lt::make_address(r[1]), class_of(SWBT_BANDWIDTH_GROUP_LOCAL));
+    }
+    lt::ip_filter out = base;
+    const auto pieces = base.export_filter();
+    // Keep the range's peers under the GLOBAL or LOCAL limits as well. A range
+    // may span both, so it is cut at the base layout's boundaries.
+    auto add_pieces = [&out](const SwbtGroupRange& r, uint32_t group_class, const auto& base_pieces) {
+        for (const auto& p : base_pieces) {
+            lt::address first = p.first, last = p.last;
+            if (r.last < first || last < r.first) continue;
+            out.add_rule(first < r.first ? r.first : first, r.last < last ? r.last : last, group_class | p.flags);
+        }
+    };
+    for (const SwbtGroupRange& r : ranges) {
+        if (r.first.is_v4()) add_pieces(r, class_of(r.group), std::get<0>(pieces));
+        else add_pieces(r, class_of(r.group), std::get<1>(pieces));
+    }
+    return out;
+}
+
+static void rebuild_class_filters_locked(SwbtSessionImpl* impl) {
+    for (std::size_t i = 0; i < impl->shards.size(); ++i) {
+        impl->shards[i]->set_peer_class_filter(build_class_filter(impl->group_ranges, [impl, i](int32_t group) {
+            return uint32_t{1} << static_cast<uint32_t>(impl->groups[group].classes[i]);
+        }));
+    }
+    impl->class_filter = build_class_filter(impl->group_ranges, [](int32_t group) { return uint32_t{1} << group; });
+}
+
+// Splits each group's limits between its member torrents by recent transfer, the
+// way the shard balancer splits the session limits. The connection cap is split
+// evenly. Torrents that left a group get their limits cleared.
+static void rebalance_bandwidth_groups(SwbtSessionImpl* impl) {
+    struct Member {
+        uint32_t id;
+        lt::torrent_handle handle;
+        int64_t download_rate;
+        int64_t upload_rate;
+    };
+    std::map<int32_t, std::vector<Member>> members;
+    {
+        std::lock_guard<std::mutex> lk(impl->registry.mutex);
+        for (const auto& kv : impl->registry.by_id) {
+            const SwbtTorrentRecord& rec = kv.second;
+            if (rec.bandwidth_group < 0 || !rec.handle.is_valid()) continue;
+            members[rec.bandwidth_group].push_back(Member{rec.id, rec.handle, rec.download_rate, rec.upload_rate});
+        }
+    }
+    std::map<int32_t, swbt_bandwidth_group_config_t> configs;
+    {
+        std::lock_guard<std::mutex> lk(impl->group_mutex);
+        for (const auto& kv : members) {
+            auto it = impl->groups.find(kv.first);
+            if (it != impl->groups.end()) configs[kv.first] = it->second.config;
+        }
+    }
+    std::unordered_map<uint32_t, SwbtGroupShare> next;
+    for (const auto& kv : members) {
+        auto cfg = configs.find(kv.first);
+        if (cfg == configs.end()) continue;  // group deleted meanwhile
+        const std::vector<Member>& m = kv.second;
+        const std::size_t n = m.size();
+        std::vector<int64_t> dl_used(n), ul_used(n);
+        std::vector<int> dl_current(n), ul_current(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            const SwbtGroupShare& prev = impl->group_shares[m[i].id];
+            dl_used[i] = m[i].download_rate;
+            ul_used[i] = m[i].upload_rate;
+            dl_current[i] = prev.download;
+            ul_current[i] = prev.upload;
+        }
+        std::vector<int> dl_share = split_rate_limit(cfg->second.download_rate_limit, dl_used, dl_current);
+        std::vector<int> ul_share = split_rate_limit(cfg->second.upload_rate_limit, ul_used, ul_current);
+        const int cap = cfg->second.max_connections;
+        const int connections = cap > 0 ? std::max(2, cap / static_cast<int>(n)) : -1;
+        for (std::size_t i = 0; i < n; ++i) {
+            SwbtGroupShare& share = impl->group_shares[m[i].id];
+            const lt::torrent_handle& th = m[i].handle;
+            // an unlimited share is 0 and only needs applying on the way from a limit
+            try {
+                if (dl_share[i] != share.download && (dl_share[i] == 0 || share_moved(share.download, dl_share[i]))) {
+                    th.set_download_limit(dl_share[i]);
+                    share.download = dl_share[i];
+                }
+                if (ul_share[i] != share.upload && (ul_share[i] == 0 || share_moved(share.upload, ul_share[i]))) {
+                    th.set_upload_limit(ul_share[i]);
+                    share.upload = ul_share[i];
+                }
+                if (connections != share.connections) {
+                    th.set_max_connections(connections);
+                    share.connections = connections;
+                }
+            } catch (const std::exception&) {
+                // removed meanwhile
+                continue;
+            }
+            share.handle = th;
+            next[m[i].id] = share;
+        }
+    }
+    for (const auto& kv : impl->group_shares) {
+        if (next.count(kv.first) || !kv.second.handle.is_valid()) continue;
+        const lt::torrent_handle& th = kv.second.handle;
+        try {
+            th.set_download_limit(0);
+            th.set_upload_limit(0);
+            th.set_max_connections(-1);
+        } catch (const std::exception&) {
+        }
+    }
+    impl->group_shares.swap(next);
+}
+
+// Seeds that stopped transferring post no state updates; their seed-time goals
+// are checked here instead.
+static void check_idle_goals(SwbtSessionImpl* impl) {
+    if (impl->goal_seed_s.load(std::memory_order_relaxed) <= 0 && !impl->torrent_goals.load(std::memory_order_relaxed)) return;
+    std::vector<SwbtGoalHit> hits;
+    {
+        std::lock_guard<std::mutex> lk(impl->registry.mutex);
+        int64_t now = steady_now_ms();
+        for (auto& kv : impl->registry.by_id) check_goals_locked(impl, kv.second, now, hits);
+    }
+    if (apply_goal_hits(impl, hits)) {
+        impl->lifecycle_ring.notify();
+        signal_events(impl, SWBT_EVENT_ALERTS);
+    }
+}
+
+// Orders each shard's queued downloads by swarm seeds, most first, within the
+// queue positions they already hold, so running torrents keep their slots.
+static void reorder_queue_by_demand(SwbtSessionImpl* impl) {
+    struct Queued {
+        lt::torrent_handle handle;
+        int32_t position;
+        int32_t seeds;
+    };
+    std::vector<std::vector<Queued>> per_shard(impl->shards.size());
+    {
+        std::lock_guard<std::mutex> lk(impl->registry.mutex);
+        for (const auto& kv : impl->registry.by_id) {
+            const SwbtTorrentRecord& rec = kv.second;
+            if (rec.queue_position < 0 || !rec.auto_managed || !rec.paused || !rec.handle.is_valid()) continue;
+            per_shard[record_shard(impl, rec)].push_back(Queued{rec.handle, rec.queue_position, rec.num_complete});
+        }
+    }
+    for (auto& queued : per_shard) {
+        if (queued.size() < 2) continue;
+        std::sort(queued.begin(), queued.end(), [](const Queued& a, const Queued& b) { return a.position < b.position; });
+        std::vector<int32_t> slots;
+        slots.reserve(queued.size());
+        for (const Queued& q : queued) slots.push_back(q.position);
+        std::stable_sort(queued.begin(), queued.end(), [](const Queued& a, const Queued& b) { return a.seeds > b.seeds; });
+        // ascending targets: each move only shifts torrents behind the ones already placed
+        for (std::size_t i = 0; i < queued.size(); ++i) {
+            if (queued[i].position != slots[i]) queued[i].handle.queue_position_set(lt::queue_position_t{slots[i]});
+        }
+    }
+}
+
+// Reports progress of running checks, drops jobs whose torrent is gone and
+// starts queued ones while their device and the session have a free slot.
+// Forced checks skip the limits. A torrent still loading its resume data isn't
+// started: force_recheck would be a no-op there.
+static void service_rechecks(SwbtSessionImpl* impl) {
+    bool alerted = false;
+    std::lock_guard<std::mutex> lk(impl->recheck_mutex);
+    std::unordered_set<uint32_t> ready;
+    {
+        std::lock_guard<std::mutex> rlk(impl->registry.mutex);
+        const auto& by_id = impl->registry.by_id;
+        auto& running = impl->rechecks_running;
+        for (auto it = running.begin(); it != running.end();) {
+            auto rec = by_id.find(it->torrent_id);
+            if (rec == by_id.end()) {
+                impl->lifecycle_ring.push(recheck_alert(SWBT_ALERT_RECHECK_FINISHED, *it, 0.0f, SWBT_ERR_GENERIC, "torrent removed"));
+                alerted = true;
+                it = running.erase(it);
+                continue;
+            }
+            // before the first state update the record still shows the pre-check state
+            if (rec->second.state == static_cast<int32_t>(lt::torrent_status::checking_files)) {
+                int step = static_cast<int>(rec->second.progress * 100.0) / impl->recheck_step;
+                if (step > it->last_step && step * impl->recheck_step < 100) {
+                    it->last_step = step;
+                    char msg[64];
+                    std::snprintf(msg, sizeof(msg), "checked %d%%", step * impl->recheck_step);
+                    impl->lifecycle_ring.push(recheck_alert(SWBT_ALERT_RECHECK_PROGRESS, *it, static_cast<float>(rec->second.progress), 0, msg));
+                    alerted = true;
+                }
+            }
+            ++it;
+        }
+        auto& queue = impl->recheck_queue;
+        queue.erase(std::remove_if(queue.begin(), queue.end(), [&by_id](const SwbtRecheckJob& j) { return !by_id.count(j.torrent_id); }), queue.end());
+        for (const SwbtRecheckJob& j : queue) {
+            const SwbtTorrentRecord& r = by_id.find(j.torrent_id)->second;
+            if (r.has_metadata && r.state != 0 && r.state != static_cast<int32_t>(lt::torrent_status::checking_resume_data)) ready.insert(j.torrent_id);
+        }
+    }
+    std::map<uint64_t, int> per_device;
+    for (const SwbtRecheckJob& j : impl->rechecks_running) per_device[j.device] += 1;
+    auto& queue = impl->recheck_queue;
+    for (auto it = queue.begin(); it != queue.end();) {
+        if (!ready.count(it->torrent_id)) {
+            ++it;
+            continue;
+        }
+        if (!it->immediate) {
+            if (impl->recheck_max_total > 0 && static_cast<int>(impl->rechecks_running.size()) >= impl->recheck_max_total) {
+                ++it;
+                continue;
+            }
+            if (per_device[it->device] >= impl->recheck_max_per_device) {
+                ++it;
+                continue;
+            }
+        }
+        SwbtRecheckJob job = std::move(*it);
+        it = queue.erase(it);
+        const lt::torrent_handle& th = job.handle;
+        try {
+            lt::torrent_flags_t flags = th.flags();
+            job.restore_auto_managed = job.start_after || static_cast<bool>(flags & lt::torrent_flags::auto_managed);
+            job.restore_paused = !job.start_after && static_cast<bool>(flags & lt::torrent_flags::paused);
+            // out of the auto-managed queue, so active_checking doesn't hold it back
+            th.unset_flags(lt::torrent_flags::auto_managed);
+            th.force_recheck();
+            th.resume();
+        } catch (const std::exception&) {
+            continue;
+        }
+        per_device[job.device] += 1;
+        impl->lifecycle_ring.push(recheck_alert(SWBT_ALERT_RECHECK_STARTED, job, 0.0f, 0, "check started"));
+        alerted = true;
+        impl->rechecks_running.push_back(std::move(job));
+    }
+    impl->rechecks_pending.store(!queue.empty() || !impl->rechecks_running.empty(), std::memory_order_relaxed);
+    if (alerted) {
+        impl->lifecycle_ring.notify();
+        signal_events(impl, SWBT_EVENT_ALERTS);
+    }
+}
+
+static void alert_pump_main(SwbtSessionImpl* impl) {
+    std::vector<lt::alert*> alerts;
+    int64_t next_refresh_ms = 0;
+    int64_t next_checkpoint_ms = 0;
+    int64_t next_stats_ms = 0;
+    int64_t next_rebalance_ms = 0;
+    int64_t next_goal_ms = 0;
+    int64_t next_demand_ms = 0;
+    int64_t next_group_ms = 0;
+    int64_t next_recheck_ms = 0;
+    const bool sharded = impl->shards.size() > 1;
+    while (!impl->pump_stop.load(std::memory_order_acquire)) {
+        int64_t now = steady_now_ms();
+        // Keep the snapshot fresh even when no status stream is running.
+        int refresh_ms = impl->snapshot_refresh_ms.load(std::memory_order_relaxed);
+        if (refresh_ms > 0 && now >= next_refresh_ms) {
+            for (auto& shard : impl->shards) shard->post_torrent_updates();
+            next_refresh_ms = now + refresh_ms;
+        }
+        int checkpoint_ms = impl->checkpoint_interval_ms.load(std::memory_order_relaxed);
+        if (checkpoint_ms > 0 && now >= next_checkpoint_ms) {
+            if (next_checkpoint_ms != 0) request_checkpoint(impl);
+            next_checkpoint_ms = now + checkpoint_ms;
+        }
+        int stats_ms = impl->stats_interval_ms.load(std::memory_order_relaxed);
+        if (stats_ms > 0 && now >= next_stats_ms) {
+            for (auto& shard : impl->shards) shard->post_session_stats();
+            next_stats_ms = now + stats_ms;
+        }
+        if (sharded && now >= next_rebalance_ms) {
+            rebalance_rate_limits(impl);
+            next_rebalance_ms = now + 1000;
+        }
+        if (now >= next_goal_ms) {
+            check_idle_goals(impl);
+            next_goal_ms = now + 5000;
+        }
+        if (impl->demand_priority.load(std::memory_order_relaxed) && now >= next_demand_ms) {
+            reorder_queue_by_demand(impl);
+            next_demand_ms = now + 30000;
+        }
+        const bool grouped = impl->grouped_torrents.load(std::memory_order_relaxed);
+        if (grouped && now >= next_group_ms) {
+            rebalance_bandwidth_groups(impl);
+            next_group_ms = now + 1000;
+        }
+        const bool rechecking = impl->rechecks_pending.load(std::memory_order_relaxed);
+        if (rechecking && now >= next_recheck_ms) {
+            service_rechecks(impl);
+            next_recheck_ms = now + 1000;
+        }
+        // Sleep until libtorrent signals alerts or the next timer is due.
+        int64_t wait_ms = 500;
+        if (refresh_ms > 0) wait_ms = std::min(wait_ms, next_refresh_ms - now);
+        if (checkpoint_ms > 0) wait_ms = std::min(wait_ms, next_checkpoint_ms - now);
+        if (stats_ms > 0) wait_ms = std::min(wait_ms, next_stats_ms - now);
+        if (sharded) wait_ms = std::min(wait_ms, next_rebalance_ms - now);
+        if (grouped) wait_ms = std::min(wait_ms, next_group_ms - now);
+        if (rechecking) wait_ms = std::min(wait_ms, next_recheck_ms - now);
+        {
+            std::unique_lock<std::mutex> lk(impl->wake_mutex);
+            impl->wake_cv.wait_for(lk, std::chrono::milliseconds(std::max<int64_t>(0, wait_ms)), [impl] {
+                return impl->wake_pending || impl->pump_stop.load(std::memory_order_acquire);
+            });
+            impl->wake_pending = false;
+        }
+        uint32_t events = 0;
+        for (std::size_t i = 0; i < impl->shards.size(); ++i) {
+            // alerts stay valid until the next pop on the same shard
+            impl->shards[i]->pop_alerts(&alerts);
+            if (!alerts.empty()) events |= dispatch_alerts(impl, alerts, i);
+        }
+        events |= drain_add_results_waiting(impl);
+        events |= drain_spilled_records(impl);
+        events |= drain_blocklist_alerts(impl);
+        if (events) signal_events(impl, events);
+        if (impl->disk_shared) recheck_evicted(impl);
+    }
+}
+
+static void stop_alert_pump(SwbtSessionImpl* impl) {
+    // no new async adds once the pump is gone
+    impl->add_pool.reset();
+    // queued blocklist loads skip; a running one finishes first
+    std::unique_ptr<SwbtWorkerPool> blocklist_pool;
+    {
+        std::lock_guard<std::mutex> lk(impl->blocklist_mutex);
+        impl->blocklist_generation.fetch_add(1, std::memory_order_acq_rel);
+        blocklist_pool = std::move(impl->blocklist_pool);
+    }
+    blocklist_pool.reset();
+    // pending metadata cache writes still complete
+    std::unique_ptr<SwbtWorkerPool> metadata_pool;
+    {
+        std::lock_guard<std::mutex> lk(impl->metadata_mutex);
+        metadata_pool = std::move(impl->metadata_pool);
+    }
+    metadata_pool.reset();
+    // the notify callback must not outlive the mutex it signals
+    for (auto& shard : impl->shards) shard->set_alert_notify(std::function<void()>());
+    impl->pump_stop.store(true, std::memory_order_release);
+    wake_pump(impl);
+    if (impl->alert_pump.joinable()) impl->alert_pump.join();
+    // release resume buffers nobody polled
+    swbt_resume_data_t leftover[64];
+    int n;
+    while ((n = impl->resume_ring.wait_and_pop(0, leftover, 64)) > 0) {
+        swbt_resume_data_free(leftover, n);
+    }
+    for (swbt_resume_data_t& item : impl->resume_waiting) swbt_resume_data_free(&item, 1);
+    impl->resume_waiting.clear();
+    // adds whose add_torrent_alert never arrived
+    std::lock_guard<std::mutex> lk(impl->add_mutex);
+    for (SwbtPendingAdd* pending : impl->pending_adds) delete pending;
+    impl->pending_adds.clear();
+}
+
+static swbt_session_t* start_session(const swbt_session_config_t* config, lt::session_params params, bool warm_start) {
+    auto s = new swbt_session_t{};
+    auto impl = new SwbtSessionImpl{};
+    apply_config_settings(params.settings, config);
+    impl->warm_start = warm_start;
+    impl->dht_nodes_restored = static_cast<int>(params.dht_state.nodes.size() + params.dht_state.nodes6.size());
+    const int num_shards = config && config->shards > 1 ? config->shards : 1;
+    if (config && config->storage_backend != SWBT_STORAGE_DEFAULT) {
+        impl->disk_options.backend = config->storage_backend;
+        impl->disk_options.threads = config->storage_threads > 0 ? config->storage_threads : 2;
+        impl->disk_options.memory_cap_bytes = std::max<int64_t>(0, config->storage_memory_cap_bytes);
+        impl->disk_options.readahead_bytes = std::max<int64_t>(0, config->storage_readahead_bytes);
+        impl->disk_shared = std::make_shared<SwbtDiskIOShared>();
+    }
+    // Each shard gets its own disk I/O and an equal part of the memory cap.
+    const auto dht_nodes = params.dht_state.nodes;
+    const auto dht_nodes6 = params.dht_state.nodes6;
+    SwbtDiskIOOptions shard_disk = impl->disk_options;
+    shard_disk.memory_cap_bytes /= num_shards;
+    for (int i = 0; i < num_shards; ++i) {
+        lt::session_params sp;
+        if (i == 0) {
+            sp = std::move(params);
+            // like the other shards, rather than libtorrent's default port
+            if (num_shards > 1 && !(config && config->listen_port > 0)) {
+                sp.settings.set_str(lt::settings_pack::listen_interfaces, "0.0.0.0:0,[::]:0");
+            }
+        } else {
+            // same settings, own DHT node id, shared bootstrap nodes
+            sp.settings = impl->shards[0]->get_settings();
+            sp.dht_state.nodes = dht_nodes;
+            sp.dht_state.nodes6 = dht_nodes6;
+            char buf[64];
+            int port = config && config->listen_port > 0 ? config->listen_port + i : 0;
+            std::snprintf(buf, sizeof(buf), "0.0.0.0:%d,[::]:%d", port, port);
+            sp.settings.set_str(lt::settings_pack::listen_interfaces, buf);
+        }
+        if (impl->disk_shared) {
+            if (auto ctor = swbt_make_disk_io(shard_disk, impl->disk_shared)) sp.disk_io_constructor = std::move(ctor);
+        }
+        impl->shards.push_back(std::make_unique<lt::session>(std::move(sp)));
+    }
+    if (num_shards > 1 && config) set_global_rate_limits(impl, config->download_rate_limit, config->upload_rate_limit);
+    // GLOBAL's limits aren't kept here: they follow the session rate limits
+    static const char* const kBuiltinGroups[] = {"global", "tcp", "local"};
+    for (int32_t g = SWBT_BANDWIDTH_GROUP_GLOBAL; g <= SWBT_BANDWIDTH_GROUP_LOCAL; ++g) {
+        SwbtBandwidthGroup& group = impl->groups[g];
+        group.name = kBuiltinGroups[g];
+        group.classes.assign(impl->shards.size(), lt::peer_class_t{static_cast<uint32_t>(g)});
+        lt::peer_class_info info = impl->shards[0]->get_peer_class(group.classes[0]);
+        group.config.download_rate_limit = info.download_limit;
+        group.config.upload_rate_limit = info.upload_limit;
+        group.config.download_priority = info.download_priority;
+        group.config.upload_priority = info.upload_priority;
+        group.config.connection_limit_factor = info.connection_limit_factor;
+        group.config.ignore_unchoke_slots = info.ignore_unchoke_slots ? 1 : 0;
+    }
+    impl->class_filter = build_class_filter(impl->group_ranges, [](int32_t group) { return uint32_t{1} << group; });
+    if (config && config->save_path) impl->default_save_path = config->save_path;
+    if (config && config->post_status_interval_ms > 0) impl->snapshot_refresh_ms = config->post_status_interval_ms;
+    // Runs on whichever libtorrent thread posts into an empty alert queue: only flag
+    // the pump, never call back into the session from here.
+    for (auto& shard : impl->shards) shard->set_alert_notify([impl] { wake_pump(impl); });
+    impl->alert_pump = std::thread(alert_pump_main, impl);
+    s->impl = impl;
+    return s;
+}
+
+swbt_session_t* swbt_session_new(const swbt_session_config_t* config) {
+    return start_session(config, lt::session_params{}, false);
+}
+
+static lt::save_state_flags_t map_state_flags(uint32_t flags) {
+    if (flags == 0) flags = SWBT_SESSION_STATE_ALL;
+    lt::save_state_flags_t out{};
+    if (flags & SWBT_SESSION_STATE_SETTINGS) out |= lt::session_handle::save_settings;
+    if (flags & SWBT_SESSION_STATE_DHT) out |= lt::session_handle::save_dht_state;
+    return out;
+}
+
+swbt_session_t* swbt_session_new_with_state(const swbt_session_config_t* config,
+                                            const uint8_t* state,
+                                            int state_size) {
+    if (state && state_size > 0) {
+        lt::error_code ec;
+        lt::bdecode_node node = lt::bdecode(lt::span<char const>(reinterpret_cast<const char*>(state), state_size), ec);
+        if (!ec) return start_session(config, lt::read_session_params(node, map_state_flags(SWBT_SESSION_STATE_ALL)), true);
+    }
+    // unreadable state is not fatal, the session just bootstraps from scratch
+    return start_session(config, lt::session_params{}, false);
+}
+
+swbt_session_t* swbt_session_new_from_state_file(const swbt_session_config_t* config, const char* path) {
+    std::vector<char> buf;
+    if (path) {
+        if (FILE* f = std::fopen(path, "rb")) {
+            char chunk[16384];
+            size_t n;
+            while ((n = std::fread(chunk, 1, sizeof(chunk), f)) > 0) buf.insert(buf.end(), chunk, chunk + n);
+            std::fclose(f);
+        }
+    }
+    return swbt_session_new_with_state(config, reinterpret_cast<const uint8_t*>(buf.data()), static_cast<int>(buf.size()));
+}
+
+void swbt_session_free(swbt_session_t* session) {
+    if (!session) return;
+    auto impl = static_cast<SwbtSessionImpl*>(session->impl);
+    stop_alert_pump(impl);
+    // the store's destructor writes out anything still queued
+    impl->resume_store.reset();
+    for (int fd : impl->event_pipe) {
+        if (fd >= 0) ::close(fd);
+    }
+    // shards shut down in parallel; each proxy's destructor waits for its own
+    std::vector<lt::session_proxy> proxies;
+    for (auto& shard : impl->shards) proxies.push_back(shard->abort());
+    impl->shards.clear();
+    proxies.clear();
+    delete impl;
+    delete session;
+}
+
+swbt_error_code_e swbt_session_save_state(swbt_session_t* session,
+                                          uint32_t flags,
+                                          uint8_t** out_data,
+                                          int32_t* out_size) {
+    if (!session || !out_data || !out_size) return SWBT_ERR_INVALID_ARG;
+    auto impl = static_cast<SwbtSessionImpl*>(session->impl);
+    lt::save_state_flags_t f = map_state_flags(flags);
+    std::vector<char> buf = lt::write_session_params_buf(impl->shards[0]->session_state(f), f);
+    uint8_t* raw = static_cast<uint8_t*>(std::malloc(buf.size()));
+    if (!raw) return SWBT_ERR_GENERIC;
+    std::memcpy(raw, buf.data(), buf.size());
+    *out_data = raw;
+    *out_size = static_cast<int32_t>(buf.size());
+    return SWBT_OK;
+}
+
+void swbt_session_state_free(uint8_t* data) {
+    std::free(data);
+}
+
+swbt_error_code_e swbt_session_save_state_file(swbt_session_t* session, uint32_t flags, const char* path) {
+    if (!session || !path) return SWBT_ERR_INVALID_ARG;
+    auto impl = static_cast<SwbtSessionImpl*>(session->impl);
+    lt::save_state_flags_t f = map_state_flags(flags);
+    std::vector<char> buf = lt::write_session_params_buf(impl->shards[0]->session_state(f), f);
+    // write-then-rename so a crash never leaves a truncated state file behind
+    std::string tmp = std::string(path) + ".tmp";
+    FILE* out = std::fopen(tmp.c_str(), "wb");
+    if (!out) return SWBT_ERR_GENERIC;
+    bool ok = std::fwrite(buf.data(), 1, buf.size(), out) == buf.size();
+    ok = (std::fclose(out) == 0) && ok;
+    if (!ok || std::rename(tmp.c_str(), path) != 0) {
+        std::remove(tmp.c_str());
+        return SWBT_ERR_GENERIC;
+    }
+    return SWBT_OK;
+}
+
+void swbt_session_startup_metrics(swbt_session_t* session, swbt_startup_metrics_t* out_metrics) {
+    if (!session || !out_metrics) return;
+    auto impl = static_cast<SwbtSessionImpl*>(session->impl);
+    *out_metrics = swbt_startup_metrics_t{};
+    out_metrics->warm_start = impl->warm_start ? 1 : 0;
+    out_metrics->dht_nodes_restored = impl->dht_nodes_restored;
+    std::vector<int64_t> samples;
+    {
+        std::lock_guard<std::mutex> lk(impl->registry.mutex);
+        out_metrics->torrents = static_cast<int32_t>(impl->registry.by_id.size());
+        for (const auto& kv : impl->registry.by_id) {
+            if (kv.second.first_peer_ms >= 0) samples.push_back(kv.second.first_peer_ms);
+        }
+    }
+    out_metrics->torrents_with_peers = static_cast<int32_t>(samples.size());
+    if (samples.empty()) {
+        out_metrics->first_peer_ms_min = out_metrics->first_peer_ms_median = out_metrics->first_peer_ms_max = -1;
+        return;
+    }
+    std::sort(samples.begin(), samples.end());
+    out_metrics->first_peer_ms_min = samples.front();
+    out_metrics->first_peer_ms_median = samples[samples.size() / 2];
+    out_metrics->first_peer_ms_max = samples.back();
+}
+
+int64_t swbt_session_time_to_first_peer_ms(swbt_session_t* session, uint32_t torrent_id) {
+    if (!session) return -1;
+    auto impl = static_cast<SwbtSessionImpl*>(session->impl);
+    std::lock_guard<std::mutex> lk(impl->registry.mutex);
+    auto it = impl->registry.by_id.find(torrent_id);
+    return it == impl->registry.by_id.end() ? -1 : it->second.first_peer_ms;
+}
+
+swbt_error_code_e swbt_add_magnet(swbt_session_t* session,
+                                  const char* magnet_uri,
+                                  const char* save_path,
+                                  swbt_torrent_handle_t** out_handle) {
+    if (!session || !magnet_uri || !out_handle) return SWBT_ERR_INVALID_ARG;
+    lt::error_code ec;
+    lt::add_torrent_params p = lt::parse_magnet_uri(magnet_uri, ec);
+    if (ec) return SWBT_ERR_GENERIC;
+    if (save_path && save_path[0] != '\0') p.save_path = save_path;
+    else if (!static_cast<SwbtSessionImpl*>(session->impl)->default_save_path.empty()) p.save_path = static_cast<SwbtSessionImpl*>(session->impl)->default_save_path;
+    else p.save_path = ".";
+    fill_from_metadata_cache(static_cast<SwbtSessionImpl*>(session->impl), p);
+
+    std::size_t shard = shard_of(static_cast<SwbtSessionImpl*>(session->impl), p);
+    lt::torrent_handle th = static_cast<SwbtSessionImpl*>(session->impl)->shards[shard]->add_torrent(std::move(p), ec);
+    if (ec) return SWBT_ERR_GENERIC;
+    registry_add(static_cast<SwbtSessionImpl*>(session->impl)->registry, th, shard);
+    auto h = new swbt_torrent_handle_t{};
+    h->impl = new SwbtTorrentHandleImpl{th, shard, static_cast<SwbtSessionImpl*>(session->impl)};
+    *out_handle = h;
+    return SWBT_OK;
+}
+
+swbt_error_code_e swbt_add_torrent_file(swbt_session_t* session,
+                                        const char* torrent_file_path,
+                                        const char* save_path,
+                                        swbt_torrent_handle_t** out_handle) {
+    if (!session || !torrent_file_path || !out_handle) return SWBT_ERR_INVALID_ARG;
+    lt::error_code ec;
+    auto ti = std::make_shared<lt::torrent_info>(torrent_file_path, ec);
+    if (ec) return SWBT_ERR_GENERIC;
+    lt::add_torrent_params p;
+    p.ti = std::move(ti);
+    if (save_path && save_path[0] != '\0') p.save_path = save_path;
+    else if (!static_cast<SwbtSessionImpl*>(session->impl)->default_save_path.empty()) p.save_path = static_cast<SwbtSessionImpl*>(session->impl)->default_save_path;
+    else p.save_path = ".";
+
+    std::size_t shard = shard_of(static_cast<SwbtSessionImpl*>(session->impl), p);
+    lt::torrent_handle th = static_cast<SwbtSessionImpl*>(session->impl)->shards[shard]->add_torrent(std::move(p), ec);
+    if (ec) return SWBT_ERR_GENERIC;
+    registry_add(static_cast<SwbtSessionImpl*>(session->impl)->registry, th, shard);
+    auto h = new swbt_torrent_handle_t{};
+    h->impl = new SwbtTorrentHandleImpl{th, shard, static_cast<SwbtSessionImpl*>(session->impl)};
+    *out_handle = h;
+    return SWBT_OK;
+}
+
+swbt_error_code_e swbt_session_create_and_seed(swbt_session_t* session,
+                                               const swbt_create_params_t* params,
+                                               swbt_create_result_t* out_result,
+                                               swbt_torrent_handle_t** out_handle) {
+    if (out_handle) *out_handle = nullptr;
+    if (!session || !out_result) return SWBT_ERR_INVALID_ARG;
+    *out_result = swbt_create_result_t{};
+    SwbtCreatedTorrent created;
+    swbt_error_code_e rc = swbt_build_torrent(params, created, out_result);
+    if (rc != SWBT_OK) return rc;
+
+    lt::add_torrent_params p;
+    p.ti = std::move(created.ti);
+    p.save_path = created.save_path;
+    p.flags |= lt::torrent_flags::seed_mode;
+    lt::error_code ec;
+    std::size_t shard = shard_of(static_cast<SwbtSessionImpl*>(session->impl), p);
+    lt::torrent_handle th = static_cast<SwbtSessionImpl*>(session->impl)->shards[shard]->add_torrent(std::move(p), ec);
+    if (ec) {
+        copy_cstr_safe(out_result->message, sizeof(out_result->message), ec.message());
+        return SWBT_ERR_GENERIC;
+    }
+    registry_add(static_cast<SwbtSessionImpl*>(session->impl)->registry, th, shard);
+    if (out_handle) {
+        auto h = new swbt_torrent_handle_t{};
+        h->impl = new SwbtTorrentHandleImpl{th, shard, static_cast<SwbtSessionImpl*>(session->impl)};
+        *out_handle = h;
+    }
+    return SWBT_OK;
+}
+
+void swbt_remove_torrent(swbt_session_t* session,
+                         swbt_torrent_handle_t* handle,
+                         int with_data) {
+    if (!session || !handle) return;
+    lt::remove_flags_t flags = {};
+    if (with_data) flags |= lt::session::delete_files;
+    auto himpl = static_cast<SwbtTorrentHandleImpl*>(handle->impl);
+    auto impl = static_cast<SwbtSessionImpl*>(session->impl);
+    impl->shards[himpl->shard]->remove_torrent(himpl->handle, flags);
+    delete himpl;
+    delete handle;
+}
+
+void swbt_torrent_handle_free(swbt_torrent_handle_t* handle) {
+    if (!handle) return;
+    delete static_cast<SwbtTorrentHandleImpl*>(handle->impl);
+    delete handle;
+}
+
+void swbt_torrent_pause(swbt_torrent_handle_t* handle) {
+    if (!handle) return;
+    auto himpl = static_cast<SwbtTorrentHandleImpl*>(handle->impl);
+    const lt::torrent_handle& th = himpl->handle;
+    // An auto-managed torrent would just be resumed by the queue. Pausing again
+    // keeps the note from the first pause.
+    if (static_cast<bool>(th.flags() & lt::torrent_flags::auto_managed)) {
+        registry_exchange_pause_unmanaged(himpl->session->registry, th, true);
+        th.unset_flags(lt::torrent_flags::auto_managed);
+    }
+    th.pause();
+}
+
+void swbt_torrent_resume(swbt_torrent_handle_t* handle) {
+    if (!handle) return;
+    auto himpl = static_cast<SwbtTorrentHandleImpl*>(handle->impl);
+    const lt::torrent_handle& th = himpl->handle;
+    if (registry_exchange_pause_unmanaged(himpl->session->registry, th, false)) {
+        th.set_flags(lt::torrent_flags::auto_managed);
+    }
+    th.resume();
+}
+
+void swbt_torrent_force_reannounce(swbt_torrent_handle_t* handle) {
+    if (!handle) return;
+    static_cast<SwbtTorrentHandleImpl*>(handle->impl)->handle.force_reannounce();
+}
+
+swbt_error_code_e swbt_torrent_status(swbt_torrent_handle_t* handle,
+                                      swbt_torrent_status_t* out_status) {
+    if (!handle || !out_status) return SWBT_ERR_INVALID_ARG;
+    lt::status_flags_t flags = lt::torrent_handle::query_name
+        | lt::torrent_handle::query_accurate_download_counters;
+    lt::torrent_status st = static_cast<SwbtTorrentHandleImpl*>(handle->impl)->handle.status(flags);
+
+    out_status->progress = st.progress;
+    out_status->download_rate = st.download_rate;
+    out_status->upload_rate = st.upload_rate;
+    out_status->total_downloaded = st.total_download;
+    out_status->total_uploaded = st.total_upload;
+    out_status->num_peers = st.num_peers;
+#ifdef __APPLE__
+    // num_seeds exists in libtorrent 1.2/2.0; if absent, leave zero
+#endif
+    out_status->num_seeds = st.num_seeds;
+    out_status->state = static_cast<int32_t>(st.state);
+    out_status->has_metadata = st.has_metadata ? 1 : 0;
+    // id and name
+    fill_infohash_hex(static_cast<SwbtTorrentHandleImpl*>(handle->impl)->handle, out_status->info_hash, sizeof(out_status->info_hash));
+    copy_cstr_safe(out_status->name, sizeof(out_status->name), st.name);
+    return SWBT_OK;
+}
+
+void swbt_session_post_torrent_updates(swbt_session_t* session) {
+    if (!session) return;
+    for (auto& shard : static_cast<SwbtSessionImpl*>(session->impl)->shards) shard->post_torrent_updates();
+}
+
+int swbt_session_poll_updates(swbt_session_t* session,
+                              int timeout_ms,
+                              swbt_torrent_status_t* out_statuses,
+                              int max_count) {
+    if (!session || !out_statuses || max_count <= 0) return 0;
+    auto impl = static_cast<SwbtSessionImpl*>(session->impl);
+    int n = impl->status_ring.wait_and_pop(timeout_ms, out_statuses, max_count);
+    // room was made for spilled records; refill now rather than on the pump's next timer
+    if (n > 0 && impl->rings_spilled.load(std::memory_order_relaxed)) wake_pump(impl);
+    return n;
+}
+
+void swbt_session_alert_queue_stats(swbt_session_t* session,
+                                    swbt_alert_queue_stats_t* out_stats) {
+    if (!session || !out_stats) return;
+    auto impl = static_cast<SwbtSessionImpl*>(session->impl);
+    impl->status_ring.fill_counters(&out_stats->status);
+    impl->delta_ring.fill_counters(&out_stats->deltas);
+    impl->resume_ring.fill_counters(&out_stats->resume);
+    impl->lifecycle_ring.fill_counters(&out_stats->lifecycle);
+    impl->add_result_ring.fill_counters(&out_stats->add_results);
+    impl->stats_ring.fill_counters(&out_stats->stats);
+    out_stats->lt_overflow_events = static_cast<int64_t>(impl->lt_overflow_events.load(std::memory_order_relaxed));
+}
+
+void swbt_session_set_event_callback(swbt_session_t* session,
+                                     swbt_event_callback_t callback,
+                                     void* context) {
+    if (!session) return;
+    auto impl = static_cast<SwbtSessionImpl*>(session->impl);
+    std::lock_guard<std::mutex> lk(impl->event_mutex);
+    impl->event_callback = callback;
+    impl->event_context = context;
+}
+
+int swbt_session_event_fd(swbt_session_t* session) {
+    if (!session) return -1;
+    auto impl = static_cast<SwbtSessionImpl*>(session->impl);
+    std::lock_guard<std::mutex> lk(impl->event_mutex);
+    if (impl->event_pipe[0] >= 0) return impl->event_pipe[0];
+    int fds[2];
+    if (::pipe(fds) != 0) return -1;
+    for (int fd : fds) {
+        ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+        ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+    }
+    impl->event_pipe[0] = fds[0];
+    impl->event_pipe[1] = fds[1];
+    // events raised before anyone listened
+    if (impl->pending_events.load(std::memory_order_acquire) != 0) {
+        char b = 1;
+        (void)!::write(fds[1], &b, 1);
+    }
+    return fds[0];
+}
+
+uint32_t swbt_session_take_events(swbt_session_t* session) {
+    if (!session) return 0;
+    return static_cast<SwbtSessionImpl*>(session->impl)->pending_events.exchange(0, std::memory_order_acq_rel);
+}
+
+void swbt_session_set_update_mode(swbt_session_t* session,
+                                  swbt_update_mode_e mode,
+                                  int enabled) {
+    if (!session) return;
+    auto impl = static_cast<SwbtSessionImpl*>(session->impl);
+    uint32_t bit = static_cast<uint32_t>(mode);
+    if (enabled) {
+        uint32_t prev = impl->update_modes.fetch_or(bit);
+        if ((bit & SWBT_UPDATE_MODE_DELTA) && !(prev & SWBT_UPDATE_MODE_DELTA)) {
+            // a new delta consumer has seen nothing yet: re-announce every torrent
+            std::lock_guard<std::mutex> lk(impl->registry.mutex);
+            for (auto& kv : impl->registry.by_id) kv.second.announced = false;
+        }
+    } else {
+        impl->update_modes.fetch_and(~bit);
+    }
+}
+
+int swbt_session_poll_status_deltas(swbt_session_t* session,
+                                    int timeout_ms,
+                                    swbt_status_delta_t* out_records,
+                                    int max_count) {
+    if (!session || !out_records || max_count <= 0) return 0;
+    return static_cast<SwbtSessionImpl*>(session->impl)->delta_ring.wait_and_pop(timeout_ms, out_records, max_count);
+}
+
+swbt_error_code_e swbt_session_torrent_identity(swbt_session_t* session,
+                                                uint32_t torrent_id,
+                                                swbt_torrent_identity_t* out_identity) {
+    if (!session || !out_identity || torrent_id == 0) return SWBT_ERR_INVALID_ARG;
+    auto impl = static_cast<SwbtSessionImpl*>(session->impl);
+    std::lock_guard<std::mutex> lk(impl->registry.mutex);
+    auto it = impl->registry.by_id.find(torrent_id);
+    if (it == impl->registry.by_id.end()) return SWBT_ERR_GENERIC;
+    const SwbtTorrentRecord& rec = it->second;
+    out_identity->torrent_id = rec.id;
+    fill_infohash_hex(rec.info_hashes, out_identity->info_hash, sizeof(out_identity->info_hash));
+    copy_cstr_safe(out_identity->name, sizeof(out_identity->name), rec.name);
+    return SWBT_OK;
+}
+
+uint32_t swbt_torrent_id(swbt_session_t* session, swbt_torrent_handle_t* handle) {
+    if (!session || !handle) return 0;
+    auto impl = static_cast<SwbtSessionImpl*>(session->impl);
+    const lt::torrent_handle& th = static_cast<SwbtTorrentHandleImpl*>(handle->impl)->handle;
+    if (!th.is_valid()) return 0;
+    // The pump may not have seen the add_torrent_alert yet; assigning here keeps ids stable either way.
+    lt::info_hash_t ih = th.info_hashes();
+    std::lock_guard<std::mutex> lk(impl->registry.mutex);
+    return registry_ensure_locked(impl->registry, ih).id;
+}
+
+swbt_error_code_e swbt_torrent_infohash(swbt_torrent_handle_t* handle, char* out_hex, int out_len) {
+    if (!handle || !out_hex || out_len <= 0) return SWBT_ERR_INVALID_ARG;
+    fill_infohash_hex(static_cast<SwbtTorrentHandleImpl*>(handle->impl)->handle, out_hex, out_len);
+    return SWBT_OK;
+}
+
+void swbt_torrent_save_resume(swbt_torrent_handle_t* handle) {
+    if (!handle) return;
+#if LT_VERSION_NUM >= 10200
+    static_cast<SwbtTorrentHandleImpl*>(handle->impl)->handle.save_resume_data(lt::torrent_handle::save_info_dict);
+#else
+    static_cast<SwbtTorrentHandleImpl*>(handle->impl)->handle.save_resume_data(lt::torrent_handle::save_info_dict);
+#endif
+}
+
+int swbt_session_poll_resume(swbt_session_t* session,
+                             int timeout_ms,
+                             swbt_resume_data_t* out_items,
+                             int max_count) {
+    if (!session || !out_items || max_count <= 0) return 0;
+    auto impl = static_cast<SwbtSessionImpl*>(session->impl);
+    int n = impl->resume_ring.wait_and_pop(timeout_ms, out_items, max_count);
+    if (n > 0 && impl->rings_spilled.load(std::memory_order_relaxed)) wake_pump(impl);
+    return n;
+}
+
+void swbt_resume_data_free(swbt_resume_data_t* items, int count) {
+    if (!items || count <= 0) return;
+    for (int i = 0; i < count; ++i) {
+        if (items[i].data) std::free(const_cast<uint8_t*>(items[i].data));
+        items[i].data = nullptr;
+        items[i].size = 0;
+    }
+}
+
+static lt::add_torrent_params build_add_params_with_resume(const lt::add_torrent_params& base,
+                                                           const uint8_t* resume_data,
+                                                           int resume_size) {
+    lt::add_torrent_params p = base;
+    if (resume_data && resume_size > 0) {
+        p.resume_data.assign(reinterpret_cast<const char*>(resume_data), reinterpret_cast<const char*>(resume_data) + resume_size);
+    }
+    return p;
+}
+
+// Maps swbt_add_flags_e onto the params; has_resume says resume data came with them.
+static void apply_add_flags(lt::add_torrent_params& p, uint32_t flags, bool has_resume) {
+    if ((flags & SWBT_ADD_SEED_MODE) && p.ti) p.flags |= lt::torrent_flags::seed_mode;
+    if ((flags & SWBT_ADD_SKIP_CHECK) && has_resume) p.flags |= lt::torrent_flags::no_verify_files;
+    if (flags & SWBT_ADD_SCHEDULED_CHECK) {
+        // a paused torrent isn't checked until the scheduler resumes it
+        p.flags |= lt::torrent_flags::paused;
+        p.flags &= ~lt::torrent_flags::auto_managed;
+    }
+}
+
+swbt_error_code_e swbt_add_magnet_with_resume(swbt_session_t* session,
+                                              const char* magnet_uri,
+                                              const char* save_path,
                                               const uint8_t* resume_data,
                                               int resume_size,
                                               swbt_torrent_handle_t** out_handle) {
@@ -321,10 +2645,13 @@ swbt_error_code_e swbt_add_magnet_with_resume(swbt_session_t* session,
     else if (!static_cast<SwbtSessionImpl*>(session->impl)->default_save_path.empty()) base.save_path = static_cast<SwbtSessionImpl*>(session->impl)->default_save_path;
     else base.save_path = ".";
     lt::add_torrent_params p = build_add_params_with_resume(base, resume_data, resume_size);
-    lt::torrent_handle th = static_cast<SwbtSessionImpl*>(session->impl)->session->add_torrent(std::move(p), ec);
+    fill_from_metadata_cache(static_cast<SwbtSessionImpl*>(session->impl), p);
+    std::size_t shard = shard_of(static_cast<SwbtSessionImpl*>(session->impl), p);
+    lt::torrent_handle th = static_cast<SwbtSessionImpl*>(session->impl)->shards[shard]->add_torrent(std::move(p), ec);
     if (ec) return SWBT_ERR_GENERIC;
+    registry_add(static_cast<SwbtSessionImpl*>(session->impl)->registry, th, shard);
     auto h = new swbt_torrent_handle_t{};
-    h->impl = new SwbtTorrentHandleImpl{th};
+    h->impl = new SwbtTorrentHandleImpl{th, shard, static_cast<SwbtSessionImpl*>(session->impl)};
     *out_handle = h;
     return SWBT_OK;
 }
@@ -335,105 +2662,1066 @@ swbt_error_code_e swbt_add_torrent_file_with_resume(swbt_session_t* session,
                                                     const uint8_t* resume_data,
                                                     int resume_size,
                                                     swbt_torrent_handle_t** out_handle) {
+    return swbt_add_torrent_file_with_flags(session, torrent_file_path, save_path, resume_data, resume_size, 0, out_handle);
+}
+
+swbt_error_code_e swbt_add_torrent_file_with_flags(swbt_session_t* session,
+                                                   const char* torrent_file_path,
+                                                   const char* save_path,
+                                                   const uint8_t* resume_data,
+                                                   int resume_size,
+                                                   uint32_t flags,
+                                                   swbt_torrent_handle_t** out_handle) {
     if (!session || !torrent_file_path || !out_handle) return SWBT_ERR_INVALID_ARG;
+    auto impl = static_cast<SwbtSessionImpl*>(session->impl);
     lt::error_code ec;
     auto ti = std::make_shared<lt::torrent_info>(torrent_file_path, ec);
     if (ec) return SWBT_ERR_GENERIC;
     lt::add_torrent_params base;
     base.ti = std::move(ti);
     if (save_path && save_path[0] != '\0') base.save_path = save_path;
-    else if (!static_cast<SwbtSessionImpl*>(session->impl)->default_save_path.empty()) base.save_path = static_cast<SwbtSessionImpl*>(session->impl)->default_save_path;
+    else if (!impl->default_save_path.empty()) base.save_path = impl->default_save_path;
     else base.save_path = ".";
     lt::add_torrent_params p = build_add_params_with_resume(base, resume_data, resume_size);
-    lt::torrent_handle th = static_cast<SwbtSessionImpl*>(session->impl)->session->add_torrent(std::move(p), ec);
+    apply_add_flags(p, flags, resume_data && resume_size > 0);
+    std::size_t shard = shard_of(impl, p);
+    lt::torrent_handle th = impl->shards[shard]->add_torrent(std::move(p), ec);
     if (ec) return SWBT_ERR_GENERIC;
+    uint32_t id = registry_add(impl->registry, th, shard);
+    if (flags & SWBT_ADD_SCHEDULED_CHECK) enqueue_recheck(impl, id, th, base.save_path, true);
     auto h = new swbt_torrent_handle_t{};
-    h->impl = new SwbtTorrentHandleImpl{th};
+    h->impl = new SwbtTorrentHandleImpl{th, shard, static_cast<SwbtSessionImpl*>(session->impl)};
     *out_handle = h;
     return SWBT_OK;
 }
 
+// Owned copy of a swbt_add_item_t; the caller's buffers are only valid during the submit call.
+struct SwbtAddJob {
+    int32_t source = 0;
+    std::string uri;
+    std::string save_path;
+    std::vector<char> resume;
+    uint64_t user_tag = 0;
+    uint32_t flags = 0;
+    bool from_store = false;
+};
+
+static void report_add_failure(SwbtSessionImpl* impl, const SwbtAddJob& job, swbt_error_code_e code, const std::string& message) {
+    swbt_add_result_t r{};
+    r.user_tag = job.user_tag;
+    r.error_code = code;
+    copy_cstr_safe(r.message, sizeof(r.message), message);
+    {
+        std::lock_guard<std::mutex> lk(impl->add_mutex);
+        impl->add_results_waiting.push_back(r);
+    }
+    wake_pump(impl);
+}
+
+// Runs on a pool thread: parse/bdecode the item and hand it to async_add_torrent.
+static void run_add_job(SwbtSessionImpl* impl, SwbtAddJob& job) {
+    lt::error_code ec;
+    lt::add_torrent_params p;
+    if (!job.resume.empty()) {
+        p = lt::read_resume_data(job.resume, ec);
+        if (ec) return report_add_failure(impl, job, SWBT_ERR_INVALID_ARG, "resume data: " + ec.message());
+    }
+    if (job.source == SWBT_ADD_SOURCE_FILE) {
+        if (!p.ti) {
+            auto ti = std::make_shared<lt::torrent_info>(job.uri, ec);
+            if (ec) return report_add_failure(impl, job, SWBT_ERR_GENERIC, ec.message());
+            p.ti = std::move(ti);
+        }
+    } else if (job.source == SWBT_ADD_SOURCE_MAGNET) {
+        lt::add_torrent_params m = lt::parse_magnet_uri(job.uri, ec);
+        if (ec) return report_add_failure(impl, job, SWBT_ERR_INVALID_ARG, ec.message());
+        if (job.resume.empty()) p = std::move(m);
+        else if (!p.ti && !p.info_hashes.has_v1() && !p.info_hashes.has_v2()) p.info_hashes = m.info_hashes;
+        fill_from_metadata_cache(impl, p);
+    }
+    if (!job.save_path.empty()) p.save_path = job.save_path;
+    else if (p.save_path.empty()) p.save_path = !impl->default_save_path.empty() ? impl->default_save_path : ".";
+    apply_add_flags(p, job.flags, !job.resume.empty());
+
+    auto* pending = new SwbtPendingAdd{job.user_tag, job.from_store, (job.flags & SWBT_ADD_SCHEDULED_CHECK) != 0};
+    {
+        std::lock_guard<std::mutex> lk(impl->add_mutex);
+        impl->pending_adds.insert(pending);
+    }
+    p.userdata = lt::client_data_t(pending);
+    impl->shards[shard_of(impl, p)]->async_add_torrent(std::move(p));
+}
+
+// Hands jobs to the add pool in chunks so each pool task amortizes its queueing cost.
+static int submit_add_jobs(SwbtSessionImpl* impl, std::vector<SwbtAddJob> jobs) {
+    const size_t kChunk = 64;
+    std::vector<std::shared_ptr<std::vector<SwbtAddJob>>> chunks;
+    for (size_t i = 0; i < jobs.size(); i += kChunk) {
+        size_t end = std::min(jobs.size(), i + kChunk);
+        chunks.push_back(std::make_shared<std::vector<SwbtAddJob>>(
+            std::make_move_iterator(jobs.begin() + i), std::make_move_iterator(jobs.begin() + end)));
+    }
+
+    std::lock_guard<std::mutex> lk(impl->add_mutex);
+    if (!impl->add_pool) {
+        unsigned n = std::thread::hardware_concurrency();
+        impl->add_pool = std::make_unique<SwbtWorkerPool>(std::max(2u, std::min(n, 16u)));
+    }
+    for (auto& c : chunks) {
+        impl->add_pool->submit([impl, c] {
+            for (auto& job : *c) run_add_job(impl, job);
+        });
+    }
+    return static_cast<int>(jobs.size());
+}
+
+int swbt_session_add_torrents_async(swbt_session_t* session,
+                                    const swbt_add_item_t* items,
+                                    int count) {
+    if (!session || !items || count <= 0) return 0;
+    auto impl = static_cast<SwbtSessionImpl*>(session->impl);
+
+    std::vector<SwbtAddJob> jobs;
+    jobs.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        const swbt_add_item_t& it = items[i];
+        SwbtAddJob job;
+        job.source = it.source;
+        job.user_tag = it.user_tag;
+        job.flags = it.flags;
+        if (it.save_path) job.save_path = it.save_path;
+        if (it.resume_data && it.resume_size > 0) {
+            job.resume.assign(reinterpret_cast<const char*>(it.resume_data),
+                              reinterpret_cast<const char*>(it.resume_data) + it.resume_size);
+        }
+        bool needs_uri = it.source == SWBT_ADD_SOURCE_FILE || it.source == SWBT_ADD_SOURCE_MAGNET;
+        bool valid = needs_uri ? (it.uri && it.uri[0] != '\0') : (it.source == SWBT_ADD_SOURCE_RESUME && !job.resume.empty());
+        if (!valid) {
+            report_add_failure(impl, job, SWBT_ERR_INVALID_ARG, "invalid add item");
+            continue;
+        }
+        if (needs_uri) job.uri = it.uri;
+        jobs.push_back(std::move(job));
+    }
+    return submit_add_jobs(impl, std::move(jobs));
+}
+
+int swbt_session_poll_add_results(swbt_session_t* session,
+                                  int timeout_ms,
+                                  swbt_add_result_t* out_results,
+                                  int max_count) {
+    if (!session || !out_results || max_count <= 0) return 0;
+    auto impl = static_cast<SwbtSessionImpl*>(session->impl);
+    int n = impl->add_result_ring.wait_and_pop(timeout_ms, out_results, max_count);
+    bool waiting = false;
+    {
+        std::lock_guard<std::mutex> lk(impl->add_mutex);
+        waiting = !impl->add_results_waiting.empty();
+    }
+    // room was made; refill now rather than on the pump's next timer
+    if (n > 0 && waiting) wake_pump(impl);
+    return n;
+}
+
+swbt_error_code_e swbt_session_open_resume_store(swbt_session_t* session,
+                                                 const char* directory,
+                                                 const swbt_resume_store_options_t* options) {
+    if (!session || !directory || directory[0] == '\0') return SWBT_ERR_INVALID_ARG;
+    auto impl = static_cast<SwbtSessionImpl*>(session->impl);
+    SwbtResumeStoreOptions opts;
+    int checkpoint_ms = 30000;
+    if (options) {
+        checkpoint_ms = std::max(0, options->checkpoint_interval_ms);
+        if (options->flush_interval_ms > 0) opts.flush_interval_ms = options->flush_interval_ms;
+        opts.fsync = options->fsync != 0;
+        if (options->compact_min_dead_bytes > 0) opts.compact_min_dead_bytes = options->compact_min_dead_bytes;
+    }
+    {
+        // one store per session
+        std::lock_guard<std::mutex> lk(impl->store_mutex);
+        if (impl->resume_store) return SWBT_ERR_INVALID_ARG;
+        std::string error;
+        impl->resume_store = SwbtResumeStore::open(directory, opts, error);
+        if (!impl->resume_store) return SWBT_ERR_GENERIC;
+    }
+    {
+        std::lock_guard<std::mutex> lk(impl->registry.mutex);
+        for (auto& kv : impl->registry.by_id) kv.second.need_save_resume = true;
+    }
+    impl->checkpoint_interval_ms = checkpoint_ms;
+    return SWBT_OK;
+}
+
+int swbt_session_checkpoint(swbt_session_t* session, int timeout_ms) {
+    if (!session) return 0;
+    auto impl = static_cast<SwbtSessionImpl*>(session->impl);
+    std::shared_ptr<SwbtResumeStore> store = current_store(impl);
+    if (!store) return 0;
+    int requested = request_checkpoint(impl);
+    {
+        std::unique_lock<std::mutex> lk(impl->checkpoint_mutex);
+        impl->checkpoint_cv.wait_for(lk, std::chrono::milliseconds(std::max(0, timeout_ms)),
+                                     [impl] { return impl->checkpoint_saves.empty(); });
+    }
+    store->flush();
+    return requested;
+}
+
+int swbt_session_restore_all(swbt_session_t* session) {
+    return swbt_session_restore_all_tagged(session, 0);
+}
+
+int swbt_session_restore_all_tagged(swbt_session_t* session, uint64_t first_tag) {
+    if (!session) return 0;
+    auto impl = static_cast<SwbtSessionImpl*>(session->impl);
+    std::shared_ptr<SwbtResumeStore> store = current_store(impl);
+    if (!store) return 0;
+    std::vector<SwbtAddJob> jobs;
+    store->for_each([&jobs, first_tag](const std::string&, const char* data, size_t size) {
+        SwbtAddJob job;
+        job.source = SWBT_ADD_SOURCE_RESUME;
+        job.user_tag = first_tag + jobs.size();
+        job.resume.assign(data, data + size);
+        job.from_store = true;
+        jobs.push_back(std::move(job));
+    });
+    return submit_add_jobs(impl, std::move(jobs));
+}
+
+swbt_error_code_e swbt_session_resume_store_stats(swbt_session_t* session,
+                                                  swbt_resume_store_stats_t* out_stats) {
+    if (!session || !out_stats) return SWBT_ERR_INVALID_ARG;
+    std::shared_ptr<SwbtResumeStore> store = current_store(static_cast<SwbtSessionImpl*>(session->impl));
+    if (!store) return SWBT_ERR_GENERIC;
+    SwbtResumeStoreStats st = store->stats();
+    out_stats->live_records = st.live_records;
+    out_stats->live_bytes = st.live_bytes;
+    out_stats->dead_bytes = st.dead_bytes;
+    out_stats->file_bytes = st.file_bytes;
+    out_stats->batches_written = st.batches_written;
+    out_stats->records_written = st.records_written;
+    out_stats->compactions = st.compactions;
+    out_stats->write_failures = st.write_failures;
+    out_stats->last_write_error = st.last_write_error;
+    out_stats->queued_records = st.queued_records;
+    return SWBT_OK;
+}
+
+swbt_error_code_e swbt_session_open_metadata_cache(swbt_session_t* session,
+                                                   const char* directory,
+                                                   const swbt_metadata_cache_options_t* options) {
+    if (!session || !directory || directory[0] == '\0') return SWBT_ERR_INVALID_ARG;
+    auto impl = static_cast<SwbtSessionImpl*>(session->impl);
+    SwbtMetadataCacheOptions opts;
+    if (options) {
+        if (options->max_entries < 0) return SWBT_ERR_INVALID_ARG;
+        if (options->max_bytes > 0) opts.max_bytes = options->max_bytes;
+        opts.max_entries = options->max_entries;
+    }
+    // one cache per session
+    std::lock_guard<std::mutex> lk(impl->metadata_mutex);
+    if (impl->metadata_cache) return SWBT_ERR_INVALID_ARG;
+    std::string error;
+    impl->metadata_cache = SwbtMetadataCache::open(directory, opts, error);
+    return impl->metadata_cache ? SWBT_OK : SWBT_ERR_GENERIC;
+}
+
+void swbt_session_metadata_cache_stats(swbt_session_t* session, swbt_metadata_cache_stats_t* out_stats) {
+    if (!out_stats) return;
+    *out_stats = swbt_metadata_cache_stats_t{};
+    if (!session) return;
+    auto impl = static_cast<SwbtSessionImpl*>(session->impl);
+    if (std::shared_ptr<SwbtMetadataCache> cache = current_metadata_cache(impl)) {
+        SwbtMetadataCacheStats st = cache->stats();
+        out_stats->open = 1;
+        out_stats->entries = st.entries;
+        out_stats->bytes = st.bytes;
+        out_stats->stores = st.stores;
+        out_stats->evictions = st.evictions;
+    }
+    out_stats->lookups = impl->metadata_lookups.load(std::memory_order_relaxed);
+    out_stats->hits = impl->metadata_hits.load(std::memory_order_relaxed);
+    out_stats->corrupt = impl->metadata_corrupt.load(std::memory_order_relaxed);
+    out_stats->metadata_downloads = impl->metadata_downloads.load(std::memory_order_relaxed);
+    out_stats->time_to_metadata_total_ms = impl->time_to_metadata_total_ms.load(std::memory_order_relaxed);
+    out_stats->time_to_metadata_max_ms = impl->time_to_metadata_max_ms.load(std::memory_order_relaxed);
+    out_stats->time_to_metadata_last_ms = impl->time_to_metadata_last_ms.load(std::memory_order_relaxed);
+}
+
 int swbt_session_list_overview(swbt_session_t* session,
                                swbt_torrent_overview_t* out_items,
                                int max_count) {
     if (!session || !out_items || max_count <= 0) return 0;
-    lt::session* s = static_cast<SwbtSessionImpl*>(session->impl)->session.get();
-    std::vector<lt::torrent_handle> v = s->get_torrents();
+    SwbtTorrentRegistry& reg = static_cast<SwbtSessionImpl*>(session->impl)->registry;
+    std::lock_guard<std::mutex> lk(reg.mutex);
     int written = 0;
-    for (auto& th : v) {
+    for (const auto& kv : reg.by_id) {
         if (written >= max_count) break;
         auto& o = out_items[written++];
-        fill_infohash_hex(th, o.info_hash, sizeof(o.info_hash));
-        std::string name;
-        lt::torrent_status st = th.status(lt::torrent_handle::query_name);
-        name = st.name;
-        copy_cstr_safe(o.name, sizeof(o.name), name);
+        fill_infohash_hex(kv.second.info_hashes, o.info_hash, sizeof(o.info_hash));
+        copy_cstr_safe(o.name, sizeof(o.name), kv.second.name);
+    }
+    return written;
+}
+
+static bool snapshot_matches(const SwbtTorrentRecord& rec, const swbt_snapshot_query_t* q) {
+    if (!q) return true;
+    if (q->state_filter >= 0 && rec.state != q->state_filter) return false;
+    if (q->only_incomplete && rec.has_metadata && rec.total_wanted_done >= rec.total_wanted) return false;
+    if (q->name_contains && q->name_contains[0] != '\0'
+        && rec.name.find(q->name_contains) == std::string::npos) return false;
+    return true;
+}
+
+int swbt_session_query_snapshot(swbt_session_t* session,
+                                const swbt_snapshot_query_t* query,
+                                swbt_torrent_snapshot_t* out_items,
+                                int max_count,
+                                int* out_total_matches) {
+    if (!session || !out_items || max_count <= 0) return 0;
+    SwbtTorrentRegistry& reg = static_cast<SwbtSessionImpl*>(session->impl)->registry;
+    int offset = query && query->offset > 0 ? query->offset : 0;
+    int matches = 0;
+    int written = 0;
+    std::lock_guard<std::mutex> lk(reg.mutex);
+    for (const auto& kv : reg.by_id) {
+        const SwbtTorrentRecord& rec = kv.second;
+        if (!snapshot_matches(rec, query)) continue;
+        if (matches++ < offset || written >= max_count) continue;
+        auto& o = out_items[written++];
+        o.torrent_id = rec.id;
+        fill_infohash_hex(rec.info_hashes, o.info_hash, sizeof(o.info_hash));
+        copy_cstr_safe(o.name, sizeof(o.name), rec.name);
+        o.state = rec.state;
+        o.has_metadata = rec.has_metadata ? 1 : 0;
+        o.progress = rec.progress;
+        o.total_wanted = rec.total_wanted;
+        o.total_wanted_done = rec.total_wanted_done;
+    }
+    if (out_total_matches) *out_total_matches = matches;
+    return written;
+}
+
+int64_t swbt_session_snapshot_age_ms(swbt_session_t* session) {
+    if (!session) return -1;
+    SwbtTorrentRegistry& reg = static_cast<SwbtSessionImpl*>(session->impl)->registry;
+    std::lock_guard<std::mutex> lk(reg.mutex);
+    if (reg.snapshot_updated_ms < 0) return -1;
+    return steady_now_ms() - reg.snapshot_updated_ms;
+}
+
+swbt_error_code_e swbt_session_find_torrent(swbt_session_t* session,
+                                            const char* info_hash_hex,
+                                            swbt_torrent_handle_t** out_handle) {
+    if (!session || !info_hash_hex || !out_handle) return SWBT_ERR_INVALID_ARG;
+    *out_handle = nullptr;
+    uint8_t raw[32];
+    int len = hex_decode(info_hash_hex, raw, sizeof(raw));
+    // a string that isn't a hash matches no torrent, as it always did
+    if (len != 20 && len != 32) return SWBT_ERR_GENERIC;
+    return swbt_session_find_torrent_binary(session, raw, len, out_handle);
+}
+
+swbt_error_code_e swbt_session_find_torrent_binary(swbt_session_t* session,
+                                                   const uint8_t* info_hash,
+                                                   int info_hash_len,
+                                                   swbt_torrent_handle_t** out_handle) {
+    if (!session || !info_hash || !out_handle) return SWBT_ERR_INVALID_ARG;
+    *out_handle = nullptr;
+    lt::info_hash_t ih;
+    if (info_hash_len == 20) ih.v1 = lt::sha1_hash(reinterpret_cast<const char*>(info_hash));
+    else if (info_hash_len == 32) ih.v2 = lt::sha256_hash(reinterpret_cast<const char*>(info_hash));
+    else return SWBT_ERR_INVALID_ARG;
+    std::size_t shard = 0;
+    lt::torrent_handle th = registry_find_handle(static_cast<SwbtSessionImpl*>(session->impl), ih, shard);
+    if (!th.is_valid()) return SWBT_ERR_GENERIC;
+    auto h = new swbt_torrent_handle_t{};
+    h->impl = new SwbtTorrentHandleImpl{th, shard, static_cast<SwbtSessionImpl*>(session->impl)};
+    *out_handle = h;
+    return SWBT_OK;
+}
+
+int64_t swbt_torrent_total_size(swbt_torrent_handle_t* handle) {
+    if (!handle) return 0;
+    auto th = static_cast<SwbtTorrentHandleImpl*>(handle->impl)->handle;
+    std::shared_ptr<const lt::torrent_info> ti = th.torrent_file();
+    if (!ti) return 0;
+    return ti->total_size();
+}
+
+int swbt_torrent_file_count(swbt_torrent_handle_t* handle) {
+    if (!handle) return 0;
+    auto th = static_cast<SwbtTorrentHandleImpl*>(handle->impl)->handle;
+    std::shared_ptr<const lt::torrent_info> ti = th.torrent_file();
+    if (!ti) return 0;
+    return static_cast<int>(ti->num_files());
+}
+
+swbt_error_code_e swbt_torrent_file_info(swbt_torrent_handle_t* handle,
+                                         int index,
+                                         swbt_file_info_t* out_info) {
+    if (!handle || !out_info || index < 0) return SWBT_ERR_INVALID_ARG;
+    auto th = static_cast<SwbtTorrentHandleImpl*>(handle->impl)->handle;
+    std::shared_ptr<const lt::torrent_info> ti = th.torrent_file();
+    if (!ti) return SWBT_ERR_GENERIC;
+    if (index >= ti->num_files()) return SWBT_ERR_INVALID_ARG;
+    const lt::file_storage& fs = ti->files();
+    lt::file_index_t idx(index);
+    out_info->index = index;
+    out_info->size = fs.file_size(idx);
+    out_info->offset = fs.file_offset(idx);
+    copy_cstr_safe(out_info->path, sizeof(out_info->path), fs.file_path(idx));
+    // get priority
+    int prio = static_cast<int>(th.file_priority(idx));
+    out_info->priority = prio;
+    return SWBT_OK;
+}
+
+void swbt_torrent_set_file_priority(swbt_torrent_handle_t* handle,
+                                    int index,
+                                    int priority) {
+    if (!handle || index < 0) return;
+    auto th = static_cast<SwbtTorrentHandleImpl*>(handle->impl)->handle;
+    th.file_priority(lt::file_index_t(index), lt::download_priority_t(priority));
+}
+
+static uint32_t map_file_flags(lt::file_flags_t f) {
+    uint32_t out = 0;
+    if (f & lt::file_storage::flag_pad_file) out |= SWBT_FILE_PAD;
+    if (f & lt::file_storage::flag_hidden) out |= SWBT_FILE_HIDDEN;
+    if (f & lt::file_storage::flag_executable) out |= SWBT_FILE_EXECUTABLE;
+    if (f & lt::file_storage::flag_symlink) out |= SWBT_FILE_SYMLINK;
+    return out;
+}
+
+static lt::download_priority_t clamp_priority(int32_t priority) {
+    return lt::download_priority_t(static_cast<std::uint8_t>(std::clamp(priority, 0, 7)));
+}
+
+swbt_error_code_e swbt_torrent_file_table(swbt_torrent_handle_t* handle, swbt_file_table_t* out_table) {
+    if (!handle || !out_table) return SWBT_ERR_INVALID_ARG;
+    *out_table = swbt_file_table_t{};
+    const lt::torrent_handle& th = static_cast<SwbtTorrentHandleImpl*>(handle->impl)->handle;
+    std::shared_ptr<const lt::torrent_info> ti;
+    std::vector<lt::download_priority_t> prios;
+    try {
+        ti = th.torrent_file();
+        if (!ti) return SWBT_ERR_GENERIC;
+        prios = th.get_file_priorities();
+    } catch (const std::exception&) {
+        return SWBT_ERR_GENERIC;
+    }
+    const lt::file_storage& fs = ti->files();
+    const int n = fs.num_files();
+    std::vector<std::string> paths(static_cast<std::size_t>(n));
+    int64_t arena = 0;
+    for (int i = 0; i < n; ++i) {
+        paths[i] = fs.file_path(lt::file_index_t(i));
+        arena += static_cast<int64_t>(paths[i].size()) + 1;
+    }
+    auto* files = static_cast<swbt_file_entry_t*>(std::malloc(sizeof(swbt_file_entry_t) * std::max(n, 1)));
+    auto* chars = static_cast<char*>(std::malloc(static_cast<std::size_t>(std::max<int64_t>(arena, 1))));
+    if (!files || !chars) {
+        std::free(files);
+        std::free(chars);
+        return SWBT_ERR_GENERIC;
+    }
+    int64_t at = 0;
+    for (int i = 0; i < n; ++i) {
+        lt::file_index_t idx(i);
+        swbt_file_entry_t& e = files[i];
+        e.size = fs.file_size(idx);
+        e.offset = fs.file_offset(idx);
+        e.path_offset = at;
+        e.path_len = static_cast<int32_t>(paths[i].size());
+        // libtorrent returns an empty vector before priorities were ever set
+        lt::download_priority_t prio = i < static_cast<int>(prios.size()) ? prios[i] : lt::default_priority;
+        e.priority = static_cast<int32_t>(static_cast<std::uint8_t>(prio));
+        e.flags = map_file_flags(fs.file_flags(idx));
+        std::memcpy(chars + at, paths[i].c_str(), paths[i].size() + 1);
+        at += static_cast<int64_t>(paths[i].size()) + 1;
+    }
+    out_table->count = n;
+    out_table->files = files;
+    out_table->paths = chars;
+    out_table->paths_len = arena;
+    return SWBT_OK;
+}
+
+// file_progress refills the vector it is given; one per calling thread keeps
+// its capacity between polls.
+static std::vector<int64_t>& progress_scratch() {
+    thread_local std::vector<int64_t> progress;
+    return progress;
+}
+
+int swbt_torrent_file_progress(swbt_torrent_handle_t* handle,
+                               uint32_t flags,
+                               int64_t* out_bytes,
+                               int max_count) {
+    if (!handle) return 0;
+    const lt::torrent_handle& th = static_cast<SwbtTorrentHandleImpl*>(handle->impl)->handle;
+    std::vector<int64_t>& progress = progress_scratch();
+    try {
+        th.file_progress(progress, (flags & SWBT_FILE_PROGRESS_PIECE_GRANULARITY) ? lt::torrent_handle::piece_granularity : lt::file_progress_flags_t{});
+    } catch (const std::exception&) {
+        return 0;
+    }
+    int n = static_cast<int>(progress.size());
+    if (out_bytes && max_count >= n) std::copy(progress.begin(), progress.end(), out_bytes);
+    return n;
+}
+
+swbt_error_code_e swbt_torrent_prioritize_files(swbt_torrent_handle_t* handle,
+                                                const int32_t* priorities,
+                                                int count) {
+    if (!handle || (!priorities && count > 0) || count < 0) return SWBT_ERR_INVALID_ARG;
+    std::vector<lt::download_priority_t> prios(static_cast<std::size_t>(count));
+    for (int i = 0; i < count; ++i) prios[i] = clamp_priority(priorities[i]);
+    static_cast<SwbtTorrentHandleImpl*>(handle->impl)->handle.prioritize_files(prios);
+    return SWBT_OK;
+}
+
+swbt_error_code_e swbt_torrent_set_file_priorities(swbt_torrent_handle_t* handle,
+                                                   const int32_t* indices,
+                                                   const int32_t* priorities,
+                                                   int count) {
+    if (!handle || count < 0 || (count > 0 && (!indices || !priorities))) return SWBT_ERR_INVALID_ARG;
+    if (count == 0) return SWBT_OK;
+    const lt::torrent_handle& th = static_cast<SwbtTorrentHandleImpl*>(handle->impl)->handle;
+    // one read and one write instead of a round-trip per file
+    std::vector<lt::download_priority_t> prios;
+    int n = 0;
+    try {
+        std::shared_ptr<const lt::torrent_info> ti = th.torrent_file();
+        if (!ti) return SWBT_ERR_GENERIC;
+        n = ti->num_files();
+        prios = th.get_file_priorities();
+    } catch (const std::exception&) {
+        return SWBT_ERR_GENERIC;
+    }
+    for (int i = 0; i < count; ++i) {
+        if (indices[i] < 0 || indices[i] >= n) return SWBT_ERR_INVALID_ARG;
+    }
+    prios.resize(static_cast<std::size_t>(n), lt::default_priority);
+    for (int i = 0; i < count; ++i) prios[indices[i]] = clamp_priority(priorities[i]);
+    th.prioritize_files(prios);
+    return SWBT_OK;
+}
+
+static uint32_t map_peer_flags(lt::peer_flags_t f) {
+    uint32_t out = 0;
+    if (f & lt::peer_info::interesting) out |= SWBT_PEER_INTERESTING;
+    if (f & lt::peer_info::choked) out |= SWBT_PEER_CHOKED;
+    if (f & lt::peer_info::remote_interested) out |= SWBT_PEER_REMOTE_INTERESTED;
+    if (f & lt::peer_info::remote_choked) out |= SWBT_PEER_REMOTE_CHOKED;
+    if (f & lt::peer_info::snubbed) out |= SWBT_PEER_SNUBBED;
+    if (f & lt::peer_info::seed) out |= SWBT_PEER_SEED;
+    if (f & lt::peer_info::upload_only) out |= SWBT_PEER_UPLOAD_ONLY;
+    if (f & lt::peer_info::outgoing_connection) out |= SWBT_PEER_OUTGOING;
+    if (f & lt::peer_info::utp_socket) out |= SWBT_PEER_UTP;
+    if (f & (lt::peer_info::rc4_encrypted | lt::peer_info::plaintext_encrypted)) out |= SWBT_PEER_ENCRYPTED;
+    if (f & lt::peer_info::ssl_socket) out |= SWBT_PEER_SSL;
+    if (f & lt::peer_info::connecting) out |= SWBT_PEER_CONNECTING;
+    if (f & lt::peer_info::optimistic_unchoke) out |= SWBT_PEER_OPTIMISTIC_UNCHOKE;
+    if (f & lt::peer_info::endgame_mode) out |= SWBT_PEER_ENDGAME;
+    return out;
+}
+
+static uint32_t map_peer_source(lt::peer_source_flags_t f) {
+    uint32_t out = 0;
+    if (f & lt::peer_info::tracker) out |= SWBT_PEER_SOURCE_TRACKER;
+    if (f & lt::peer_info::dht) out |= SWBT_PEER_SOURCE_DHT;
+    if (f & lt::peer_info::pex) out |= SWBT_PEER_SOURCE_PEX;
+    if (f & lt::peer_info::lsd) out |= SWBT_PEER_SOURCE_LSD;
+    if (f & lt::peer_info::resume_data) out |= SWBT_PEER_SOURCE_RESUME_DATA;
+    if (f & lt::peer_info::incoming) out |= SWBT_PEER_SOURCE_INCOMING;
+    return out;
+}
+
+static void fill_peer_info(const lt::peer_info& p, uint32_t torrent_id, swbt_peer_info_t& o) {
+    o.torrent_id = torrent_id;
+    // formatted in place: address::to_string would allocate for every peer
+    lt::address addr = p.ip.address();
+    if (addr.is_v4()) {
+        auto bytes = addr.to_v4().to_bytes();
+        ::inet_ntop(AF_INET, bytes.data(), o.ip, sizeof(o.ip));
+    } else {
+        auto bytes = addr.to_v6().to_bytes();
+        ::inet_ntop(AF_INET6, bytes.data(), o.ip, sizeof(o.ip));
+    }
+    o.port = p.ip.port();
+    copy_cstr_safe(o.client, sizeof(o.client), p.client);
+    o.flags = map_peer_flags(p.flags);
+    o.source = map_peer_source(p.source);
+    o.download_rate = p.down_speed;
+    o.upload_rate = p.up_speed;
+    o.payload_download_rate = p.payload_down_speed;
+    o.payload_upload_rate = p.payload_up_speed;
+    o.total_download = p.total_download;
+    o.total_upload = p.total_upload;
+    o.progress = p.progress;
+    o.download_queue_length = p.download_queue_length;
+    o.upload_queue_length = p.upload_queue_length;
+    o.send_queue_bytes = p.used_send_buffer;
+    o.pending_disk_bytes = p.pending_disk_bytes;
+    o.rtt_ms = p.rtt;
+    o.num_hashfails = p.num_hashfails;
+}
+
+// get_peer_info clears and refills the vector it is given. Keeping one per calling
+// thread lets its capacity carry over between polls.
+static std::vector<lt::peer_info>& peer_scratch() {
+    thread_local std::vector<lt::peer_info> peers;
+    return peers;
+}
+
+// Appends th's peers to out[written..max_count); returns the number of peers it has.
+static int collect_peers(const lt::torrent_handle& th, uint32_t torrent_id,
+                         swbt_peer_info_t* out, int max_count, int& written) {
+    std::vector<lt::peer_info>& peers = peer_scratch();
+    try {
+        th.get_peer_info(peers);
+    } catch (const std::exception&) {
+        // removed meanwhile
+        return 0;
+    }
+    for (const lt::peer_info& p : peers) {
+        if (written >= max_count) break;
+        fill_peer_info(p, torrent_id, out[written++]);
+    }
+    return static_cast<int>(peers.size());
+}
+
+int swbt_torrent_peers(swbt_torrent_handle_t* handle,
+                       swbt_peer_info_t* out_peers,
+                       int max_count,
+                       int* out_total) {
+    if (out_total) *out_total = 0;
+    if (!handle || !out_peers || max_count <= 0) return 0;
+    int written = 0;
+    int total = collect_peers(static_cast<SwbtTorrentHandleImpl*>(handle->impl)->handle, 0, out_peers, max_count, written);
+    if (out_total) *out_total = total;
+    return written;
+}
+
+int swbt_session_peers(swbt_session_t* session,
+                       int only_active,
+                       swbt_peer_info_t* out_peers,
+                       int max_count,
+                       int* out_total) {
+    if (out_total) *out_total = 0;
+    if (!session || !out_peers || max_count <= 0) return 0;
+    SwbtTorrentRegistry& reg = static_cast<SwbtSessionImpl*>(session->impl)->registry;
+    // copy the targets out so no session round trip happens under the registry lock
+    thread_local std::vector<std::pair<uint32_t, lt::torrent_handle>> targets;
+    targets.clear();
+    {
+        std::lock_guard<std::mutex> lk(reg.mutex);
+        for (const auto& kv : reg.by_id) {
+            if (only_active && kv.second.num_peers == 0) continue;
+            if (kv.second.handle.is_valid()) targets.emplace_back(kv.first, kv.second.handle);
+        }
+    }
+    int written = 0;
+    int total = 0;
+    for (const auto& t : targets) {
+        total += collect_peers(t.second, t.first, out_peers, max_count, written);
+    }
+    if (out_total) *out_total = total;
+    return written;
+}
+
+swbt_error_code_e swbt_torrent_piece_info(swbt_torrent_handle_t* handle,
+                                          int32_t* out_num_pieces,
+                                          int32_t* out_piece_length) {
+    if (!handle) return SWBT_ERR_INVALID_ARG;
+    auto ti = static_cast<SwbtTorrentHandleImpl*>(handle->impl)->handle.torrent_file();
+    if (!ti) return SWBT_ERR_GENERIC;
+    if (out_num_pieces) *out_num_pieces = ti->num_pieces();
+    if (out_piece_length) *out_piece_length = ti->piece_length();
+    return SWBT_OK;
+}
+
+int swbt_torrent_piece_bitfield(swbt_torrent_handle_t* handle,
+                                uint8_t* out_bits,
+                                int out_len) {
+    if (!handle) return 0;
+    lt::torrent_status st = static_cast<SwbtTorrentHandleImpl*>(handle->impl)->handle.status(lt::torrent_handle::query_pieces);
+    if (!st.has_metadata) return 0;
+    int count = st.pieces.size();
+    int bytes = (count + 7) / 8;
+    if (out_bits && out_len >= bytes) {
+        // libtorrent keeps bitfields in wire order already
+        if (st.pieces.num_bytes() >= bytes && st.pieces.data()) {
+            std::memcpy(out_bits, st.pieces.data(), static_cast<std::size_t>(bytes));
+        } else {
+            std::memset(out_bits, 0, static_cast<std::size_t>(bytes));
+        }
+    }
+    return count;
+}
+
+int swbt_torrent_piece_availability(swbt_torrent_handle_t* handle,
+                                    uint8_t* out_counts,
+                                    int out_len) {
+    if (!handle) return 0;
+    thread_local std::vector<int> avail;
+    static_cast<SwbtTorrentHandleImpl*>(handle->impl)->handle.piece_availability(avail);
+    int count = static_cast<int>(avail.size());
+    if (out_counts && out_len >= count) {
+        for (int i = 0; i < count; ++i) out_counts[i] = static_cast<uint8_t>(std::min(std::max(avail[i], 0), 255));
+    }
+    return count;
+}
+
+int swbt_torrent_file_piece_ranges(swbt_torrent_handle_t* handle,
+                                   swbt_piece_range_t* out_ranges,
+                                   int max_count) {
+    if (!handle) return 0;
+    auto ti = static_cast<SwbtTorrentHandleImpl*>(handle->impl)->handle.torrent_file();
+    if (!ti) return 0;
+    const lt::file_storage& fs = ti->files();
+    int n = fs.num_files();
+    if (!out_ranges) return n;
+    int64_t piece_length = ti->piece_length();
+    for (int i = 0; i < n && i < max_count; ++i) {
+        int64_t offset = fs.file_offset(lt::file_index_t(i));
+        int64_t size = fs.file_size(lt::file_index_t(i));
+        auto first = static_cast<int32_t>(offset / piece_length);
+        out_ranges[i].first = first;
+        out_ranges[i].last = size > 0 ? static_cast<int32_t>((offset + size - 1) / piece_length + 1) : first;
+    }
+    return n;
+}
+
+struct SwbtStreamImpl {
+    SwbtSessionImpl* session = nullptr;
+    lt::torrent_handle handle;
+    std::string path;
+    int64_t file_offset = 0;      // position of the file inside the torrent
+    int64_t size = 0;
+    int64_t piece_length = 0;
+    int64_t readahead = 0;
+    int deadline_ms = 0;
+    int deadline_step_ms = 0;
+
+    std::mutex mutex;             // serializes reads on this stream
+    int fd = -1;
+    int window_first = -1;        // pieces currently holding deadlines
+    int window_last = -1;
+};
+
+// The categories the pump dispatches, plus piece progress while a stream is open,
+// blocked peers while a blocklist is applied and whatever a running trace
+// records. Caller holds stream_mutex.
+static void apply_alert_mask_locked(SwbtSessionImpl* impl) {
+    lt::alert_category_t mask = kBaseAlertMask | trace_alert_mask(impl->trace_categories.load(std::memory_order_relaxed));
+    if (impl->open_streams > 0) mask |= lt::alert_category::piece_progress;
+    if (impl->blocklist_active.load(std::memory_order_relaxed)) mask |= lt::alert_category::ip_block;
+    lt::settings_pack pack;
+    pack.set_int(lt::settings_pack::alert_mask, mask);
+    apply_to_shards(impl, pack);
+}
+
+// Piece-progress alerts are only worth their cost while someone is streaming.
+static void count_stream(SwbtSessionImpl* impl, int delta) {
+    std::lock_guard<std::mutex> lk(impl->stream_mutex);
+    int before = impl->open_streams;
+    impl->open_streams += delta;
+    if ((before == 0) == (impl->open_streams == 0)) return;
+    apply_alert_mask_locked(impl);
+}
+
+static int stream_piece_at(const SwbtStreamImpl* s, int64_t offset) {
+    return static_cast<int>((s->file_offset + offset) / s->piece_length);
+}
+
+// Moves the deadline window to start at the piece under `offset`. Deadlines grow
+// with distance from the cursor so the picker fetches in read order. Pieces
+// still in the window keep the deadline they were given on entering it, which
+// is earlier than any new one; only pieces that left or entered are touched.
+static void stream_move_window(SwbtStreamImpl* s, int64_t offset) {
+    int first = stream_piece_at(s, offset);
+    int last = stream_piece_at(s, std::min(s->size - 1, offset + s->readahead - 1));
+    if (first == s->window_first && last == s->window_last) return;
+    auto in_window = [s](int p) { return s->window_first >= 0 && p >= s->window_first && p <= s->window_last; };
+    for (int p = s->window_first; p >= 0 && p <= s->window_last; ++p) {
+        if (p < first || p > last) s->handle.reset_piece_deadline(lt::piece_index_t(p));
+    }
+    for (int p = first; p <= last; ++p) {
+        if (in_window(p)) continue;
+        s->handle.set_piece_deadline(lt::piece_index_t(p), s->deadline_ms + (p - first) * s->deadline_step_ms);
+    }
+    s->window_first = first;
+    s->window_last = last;
+}
+
+static bool stream_wait_piece(SwbtStreamImpl* s, int piece, int timeout_ms) {
+    SwbtSessionImpl* impl = s->session;
+    auto until = std::chrono::steady_clock::now() + std::chrono::milliseconds(std::max(0, timeout_ms));
+    for (;;) {
+        uint64_t seen;
+        {
+            std::lock_guard<std::mutex> lk(impl->piece_mutex);
+            seen = impl->piece_events;
+        }
+        // checked after sampling the counter so a piece finishing in between still wakes us
+        if (s->handle.have_piece(lt::piece_index_t(piece))) return true;
+        std::unique_lock<std::mutex> lk(impl->piece_mutex);
+        if (!impl->piece_cv.wait_until(lk, until, [&] { return impl->piece_events != seen; })) {
+            lk.unlock();
+            return s->handle.have_piece(lt::piece_index_t(piece));
+        }
+    }
+}
+
+swbt_error_code_e swbt_torrent_open_stream(swbt_session_t* session,
+                                           swbt_torrent_handle_t* handle,
+                                           int file_index,
+                                           const swbt_stream_options_t* options,
+                                           swbt_stream_t** out_stream) {
+    if (!session || !handle || !out_stream || file_index < 0) return SWBT_ERR_INVALID_ARG;
+    auto impl = static_cast<SwbtSessionImpl*>(session->impl);
+    // nothing to pread: the memory backend never writes files
+    if (impl->disk_options.backend == SWBT_STORAGE_MEMORY) return SWBT_ERR_INVALID_ARG;
+    auto th = static_cast<SwbtTorrentHandleImpl*>(handle->impl)->handle;
+    std::shared_ptr<const lt::torrent_info> ti = th.torrent_file();
+    if (!ti) return SWBT_ERR_GENERIC;
+    if (file_index >= ti->num_files()) return SWBT_ERR_INVALID_ARG;
+    const lt::file_storage& fs = ti->files();
+    lt::file_index_t idx(file_index);
+
+    auto s = new SwbtStreamImpl{};
+    s->session = impl;
+    s->handle = th;
+    s->path = fs.file_path(idx, th.status(lt::torrent_handle::query_save_path).save_path);
+    s->file_offset = fs.file_offset(idx);
+    s->size = fs.file_size(idx);
+    s->piece_length = fs.piece_length();
+    s->readahead = (options && options->readahead_bytes > 0) ? options->readahead_bytes : (8 << 20);
+    s->deadline_ms = (options && options->deadline_ms > 0) ? options->deadline_ms : 1000;
+    s->deadline_step_ms = (options && options->deadline_step_ms > 0) ? options->deadline_step_ms : 250;
+    count_stream(impl, 1);
+
+    auto out = new swbt_stream_t{};
+    out->impl = s;
+    *out_stream = out;
+    return SWBT_OK;
+}
+
+int64_t swbt_stream_size(swbt_stream_t* stream) {
+    if (!stream) return 0;
+    return static_cast<SwbtStreamImpl*>(stream->impl)->size;
+}
+
+int64_t swbt_stream_read(swbt_stream_t* stream,
+                         int64_t offset,
+                         uint8_t* out_buf,
+                         int64_t len,
+                         int timeout_ms) {
+    if (!stream || !out_buf || offset < 0 || len < 0) return -2;
+    auto s = static_cast<SwbtStreamImpl*>(stream->impl);
+    std::lock_guard<std::mutex> lk(s->mutex);
+    if (offset >= s->size || len == 0) return 0;
+    len = std::min(len, s->size - offset);
+
+    int64_t end = offset;
+    try {
+        stream_move_window(s, offset);
+        int piece = stream_piece_at(s, offset);
+        if (!stream_wait_piece(s, piece, timeout_ms)) return -1;
+
+        // Extend over whatever follows contiguously so sequential readers get large reads.
+        for (int p = piece; end < offset + len; ++p) {
+            if (p != piece && !s->handle.have_piece(lt::piece_index_t(p))) break;
+            end = std::min(offset + len, (p + 1) * s->piece_length - s->file_offset);
+        }
+    } catch (const std::exception&) {
+        return -2; // torrent removed meanwhile
+    }
+
+    if (s->fd < 0) {
+        s->fd = ::open(s->path.c_str(), O_RDONLY);
+        if (s->fd < 0) return -2;
+    }
+    int64_t done = 0;
+    while (offset + done < end) {
+        ssize_t n = ::pread(s->fd, out_buf + done, static_cast<size_t>(end - offset - done), offset + done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        done += n;
+    }
+    return done > 0 ? done : -2;
+}
+
+void swbt_stream_close(swbt_stream_t* stream) {
+    if (!stream) return;
+    auto s = static_cast<SwbtStreamImpl*>(stream->impl);
+    try {
+        for (int p = s->window_first; p >= 0 && p <= s->window_last; ++p) {
+            s->handle.reset_piece_deadline(lt::piece_index_t(p));
+        }
+    } catch (const std::exception&) {
+        // torrent removed meanwhile; its deadlines went with it
+    }
+    if (s->fd >= 0) ::close(s->fd);
+    count_stream(s->session, -1);
+    delete s;
+    delete stream;
+}
+
+void swbt_session_set_stats_interval(swbt_session_t* session, int interval_ms) {
+    if (!session) return;
+    auto impl = static_cast<SwbtSessionImpl*>(session->impl);
+    impl->stats_interval_ms.store(std::max(0, interval_ms), std::memory_order_relaxed);
+    // let the pump re-arm its timer now rather than after its current sleep
+    wake_pump(impl);
+}
+
+void swbt_session_post_stats(swbt_session_t* session) {
+    if (!session) return;
+    for (auto& shard : static_cast<SwbtSessionImpl*>(session->impl)->shards) shard->post_session_stats();
+}
+
+int swbt_session_poll_stats(swbt_session_t* session,
+                            int timeout_ms,
+                            swbt_session_stats_t* out_stats,
+                            int max_count) {
+    if (!session || !out_stats || max_count <= 0) return 0;
+    return static_cast<SwbtSessionImpl*>(session->impl)->stats_ring.wait_and_pop(timeout_ms, out_stats, max_count);
+}
+
+int swbt_stats_metric_count(void) {
+    return static_cast<int>(stats_metrics().size());
+}
+
+const char* swbt_stats_metric_name(int index) {
+    const auto& metrics = stats_metrics();
+    if (index < 0 || index >= static_cast<int>(metrics.size())) return nullptr;
+    return metrics[index].name;
+}
+
+int swbt_stats_metric_type(int index) {
+    const auto& metrics = stats_metrics();
+    if (index < 0 || index >= static_cast<int>(metrics.size())) return -1;
+    return metrics[index].type == lt::metric_type_t::counter ? SWBT_METRIC_COUNTER : SWBT_METRIC_GAUGE;
+}
+
+int swbt_stats_find_metric(const char* name) {
+    if (!name) return -1;
+    const auto& metrics = stats_metrics();
+    for (std::size_t i = 0; i < metrics.size(); ++i) {
+        if (std::strcmp(metrics[i].name, name) == 0) return static_cast<int>(i);
     }
-    return written;
+    return -1;
 }
 
-swbt_error_code_e swbt_session_find_torrent(swbt_session_t* session,
-                                            const char* info_hash_hex,
-                                            swbt_torrent_handle_t** out_handle) {
-    if (!session || !info_hash_hex || !out_handle) return SWBT_ERR_INVALID_ARG;
-    *out_handle = nullptr;
-    lt::session* s = static_cast<SwbtSessionImpl*>(session->impl)->session.get();
-    std::vector<lt::torrent_handle> v = s->get_torrents();
-    for (auto& th : v) {
-        char buf[65] = {0};
-        fill_infohash_hex(th, buf, sizeof(buf));
-        if (std::strcmp(buf, info_hash_hex) == 0) {
-            auto h = new swbt_torrent_handle_t{};
-            h->impl = new SwbtTorrentHandleImpl{th};
-            *out_handle = h;
-            return SWBT_OK;
+int swbt_session_stats_values(swbt_session_t* session,
+                              int64_t* out_values,
+                              double* out_rates,
+                              int max_count,
+                              int64_t* out_timestamp_us) {
+    if (!session || !out_values || max_count <= 0) return 0;
+    auto impl = static_cast<SwbtSessionImpl*>(session->impl);
+    const auto& metrics = stats_metrics();
+    std::lock_guard<std::mutex> lk(impl->stats_mutex);
+    const SwbtStatsSample& cur = impl->stats_latest;
+    if (cur.counters.empty()) return 0;
+    int n = std::min(max_count, static_cast<int>(metrics.size()));
+    for (int i = 0; i < n; ++i) {
+        int idx = metrics[i].value_index;
+        out_values[i] = sample_value(cur, idx);
+        if (out_rates) {
+            out_rates[i] = metrics[i].type == lt::metric_type_t::counter
+                ? sample_rate(cur, impl->stats_previous, idx)
+                : static_cast<double>(out_values[i]);
         }
     }
-    return SWBT_ERR_GENERIC;
+    if (out_timestamp_us) *out_timestamp_us = cur.timestamp_us;
+    return n;
 }
 
-int64_t swbt_torrent_total_size(swbt_torrent_handle_t* handle) {
-    if (!handle) return 0;
-    auto th = static_cast<SwbtTorrentHandleImpl*>(handle->impl)->handle;
-    std::shared_ptr<const lt::torrent_info> ti = th.torrent_file();
-    if (!ti) return 0;
-    return ti->total_size();
+// "net.recv_bytes" -> "libtorrent_net_recv_bytes_total"
+static std::string prometheus_name(const char* metric, bool counter) {
+    std::string out = "libtorrent_";
+    for (const char* p = metric; *p; ++p) {
+        char c = *p;
+        bool ok = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+        out.push_back(ok ? c : '_');
+    }
+    if (counter) out += "_total";
+    return out;
 }
 
-int swbt_torrent_file_count(swbt_torrent_handle_t* handle) {
-    if (!handle) return 0;
-    auto th = static_cast<SwbtTorrentHandleImpl*>(handle->impl)->handle;
-    std::shared_ptr<const lt::torrent_info> ti = th.torrent_file();
-    if (!ti) return 0;
-    return static_cast<int>(ti->num_files());
+static void prometheus_append(std::string& out, const std::string& name, const char* type, int64_t value) {
+    out += "# TYPE ";
+    out += name;
+    out += ' ';
+    out += type;
+    out += '\n';
+    out += name;
+    out += ' ';
+    out += std::to_string(value);
+    out += '\n';
 }
 
-swbt_error_code_e swbt_torrent_file_info(swbt_torrent_handle_t* handle,
-                                         int index,
-                                         swbt_file_info_t* out_info) {
-    if (!handle || !out_info || index < 0) return SWBT_ERR_INVALID_ARG;
-    auto th = static_cast<SwbtTorrentHandleImpl*>(handle->impl)->handle;
-    std::shared_ptr<const lt::torrent_info> ti = th.torrent_file();
-    if (!ti) return SWBT_ERR_GENERIC;
-    if (index >= ti->num_files()) return SWBT_ERR_INVALID_ARG;
-    const lt::file_storage& fs = ti->files();
-    lt::file_index_t idx(index);
-    out_info->index = index;
-    out_info->size = fs.file_size(idx);
-    out_info->offset = fs.file_offset(idx);
-    copy_cstr_safe(out_info->path, sizeof(out_info->path), fs.file_path(idx));
-    // get priority
-    int prio = static_cast<int>(th.file_priority(idx));
-    out_info->priority = prio;
-    return SWBT_OK;
-}
+int swbt_session_stats_prometheus(swbt_session_t* session,
+                                  char* buf,
+                                  int buf_size) {
+    if (!session) return 0;
+    auto impl = static_cast<SwbtSessionImpl*>(session->impl);
+    std::string text;
+    text.reserve(32 * 1024);
+    {
+        const auto& metrics = stats_metrics();
+        std::lock_guard<std::mutex> lk(impl->stats_mutex);
+        const SwbtStatsSample& cur = impl->stats_latest;
+        if (!cur.counters.empty()) {
+            for (const lt::stats_metric& m : metrics) {
+                bool counter = m.type == lt::metric_type_t::counter;
+                prometheus_append(text, prometheus_name(m.name, counter), counter ? "counter" : "gauge",
+                                  sample_value(cur, m.value_index));
+            }
+        }
+    }
 
-void swbt_torrent_set_file_priority(swbt_torrent_handle_t* handle,
-                                    int index,
-                                    int priority) {
-    if (!handle || index < 0) return;
-    auto th = static_cast<SwbtTorrentHandleImpl*>(handle->impl)->handle;
-    th.file_priority(lt::file_index_t(index), lt::download_priority_t(priority));
+    // core dispatcher queues, labelled by queue
+    swbt_alert_queue_stats_t q{};
+    swbt_session_alert_queue_stats(session, &q);
+    const std::pair<const char*, const swbt_alert_queue_counters_t*> queues[] = {
+        {"status", &q.status}, {"deltas", &q.deltas}, {"resume", &q.resume},
+        {"lifecycle", &q.lifecycle}, {"stats", &q.stats}, {"add_results", &q.add_results}};
+    const std::pair<const char*, const char*> families[] = {
+        {"swbt_queue_pushed_total", "counter"}, {"swbt_queue_dropped_total", "counter"}, {"swbt_queue_depth", "gauge"}};
+    for (std::size_t f = 0; f < 3; ++f) {
+        text += "# TYPE ";
+        text += families[f].first;
+        text += ' ';
+        text += families[f].second;
+        text += '\n';
+        for (const auto& queue : queues) {
+            int64_t v = f == 0 ? queue.second->pushed : f == 1 ? queue.second->dropped : queue.second->depth;
+            text += families[f].first;
+            text += "{queue=\"";
+            text += queue.first;
+            text += "\"} ";
+            text += std::to_string(v);
+            text += '\n';
+        }
+    }
+    prometheus_append(text, "swbt_libtorrent_alert_overflows_total", "counter", q.lt_overflow_events);
+    if (impl->disk_shared) {
+        prometheus_append(text, "swbt_storage_resident_bytes", "gauge", impl->disk_shared->resident_bytes.load(std::memory_order_relaxed));
+        prometheus_append(text, "swbt_storage_evicted_pieces_total", "counter", impl->disk_shared->evicted_pieces.load(std::memory_order_relaxed));
+    }
+
+    if (buf && buf_size > 0) {
+        std::size_t n = std::min(text.size(), static_cast<std::size_t>(buf_size - 1));
+        std::memcpy(buf, text.data(), n);
+        buf[n] = '\0';
+    }
+    return static_cast<int>(text.size());
 }
 
 int swbt_session_poll_alerts(swbt_session_t* session,
@@ -441,45 +3729,7 @@ int swbt_session_poll_alerts(swbt_session_t* session,
                               swbt_alert_t* out_alerts,
                               int max_count) {
     if (!session || !out_alerts || max_count <= 0) return 0;
-    lt::session* s = static_cast<SwbtSessionImpl*>(session->impl)->session.get();
-    s->wait_for_alert(lt::milliseconds(timeout_ms));
-    std::vector<lt::alert*> alerts;
-    s->pop_alerts(&alerts);
-    int written = 0;
-    for (lt::alert* a : alerts) {
-        if (written >= max_count) break;
-        swbt_alert_t* out = &out_alerts[written];
-        bool matched = false;
-        if (auto* fin = lt::alert_cast<lt::torrent_finished_alert>(a)) {
-            out->type = SWBT_ALERT_TORRENT_FINISHED;
-            fill_infohash_hex(fin->handle, out->info_hash, sizeof(out->info_hash));
-            out->error_code = 0;
-            copy_cstr_safe(out->message, sizeof(out->message), a->message());
-            matched = true;
-        } else if (auto* md = lt::alert_cast<lt::metadata_received_alert>(a)) {
-            out->type = SWBT_ALERT_METADATA_RECEIVED;
-            fill_infohash_hex(md->handle, out->info_hash, sizeof(out->info_hash));
-            out->error_code = 0;
-            copy_cstr_safe(out->message, sizeof(out->message), a->message());
-            matched = true;
-        } else if (auto* te = lt::alert_cast<lt::torrent_error_alert>(a)) {
-            out->type = SWBT_ALERT_TORRENT_ERROR;
-            fill_infohash_hex(te->handle, out->info_hash, sizeof(out->info_hash));
-            out->error_code = te->error.value();
-            copy_cstr_safe(out->message, sizeof(out->message), te->error.message());
-            matched = true;
-        } else if (auto* tr = lt::alert_cast<lt::tracker_error_alert>(a)) {
-            out->type = SWBT_ALERT_TRACKER_ERROR;
-            fill_infohash_hex(tr->handle, out->info_hash, sizeof(out->info_hash));
-            out->error_code = tr->error.value();
-            copy_cstr_safe(out->message, sizeof(out->message), tr->error.message());
-            matched = true;
-        }
-        if (matched) {
-            ++written;
-        }
-    }
-    return written;
+    return static_cast<SwbtSessionImpl*>(session->impl)->lifecycle_ring.wait_and_pop(timeout_ms, out_alerts, max_count);
 }
 
 swbt_error_code_e swbt_torrent_move_storage(swbt_torrent_handle_t* handle,
@@ -496,7 +3746,147 @@ void swbt_session_set_rate_limits(swbt_session_t* session,
     lt::settings_pack p;
     if (download_rate >= 0) p.set_int(lt::settings_pack::download_rate_limit, download_rate);
     if (upload_rate >= 0) p.set_int(lt::settings_pack::upload_rate_limit, upload_rate);
-    static_cast<SwbtSessionImpl*>(session->impl)->session->apply_settings(p);
+    auto impl = static_cast<SwbtSessionImpl*>(session->impl);
+    if (impl->shards.size() > 1) {
+        set_global_rate_limits(impl, download_rate, upload_rate);
+        return;
+    }
+    impl->shards[0]->apply_settings(p);
+}
+
+static int setting_type_of(int key) {
+    switch (key & lt::settings_pack::type_mask) {
+        case lt::settings_pack::int_type_base: return SWBT_SETTING_INT;
+        case lt::settings_pack::bool_type_base: return SWBT_SETTING_BOOL;
+        default: return SWBT_SETTING_STRING;
+    }
+}
+
+// Setting id for a user-settable name, -1 if unknown or reserved by the core.
+static int user_setting_key(const char* name) {
+    if (!name) return -1;
+    int key = lt::setting_by_name(name);
+    if (key < 0 || key == lt::settings_pack::alert_mask) return -1;
+    return key;
+}
+
+int swbt_setting_type(const char* name) {
+    if (!name) return -1;
+    int key = lt::setting_by_name(name);
+    return key < 0 ? -1 : setting_type_of(key);
+}
+
+swbt_error_code_e swbt_session_apply_settings(swbt_session_t* session,
+                                             const swbt_setting_t* items,
+                                             int count,
+                                             int* out_bad_index) {
+    if (!session || !items || count <= 0) return SWBT_ERR_INVALID_ARG;
+    auto impl = static_cast<SwbtSessionImpl*>(session->impl);
+    const bool sharded = impl->shards.size() > 1;
+    lt::settings_pack pack;
+    for (int i = 0; i < count; ++i) {
+        const swbt_setting_t& it = items[i];
+        int key = user_setting_key(it.name);
+        // shards listen on consecutive ports picked at startup
+        bool ok = key >= 0 && setting_type_of(key) == it.type && !(sharded && key == lt::settings_pack::listen_interfaces);
+        if (ok && it.type == SWBT_SETTING_INT) {
+            ok = it.int_value >= INT32_MIN && it.int_value <= INT32_MAX;
+            if (ok) pack.set_int(key, static_cast<int>(it.int_value));
+        } else if (ok && it.type == SWBT_SETTING_BOOL) {
+            pack.set_bool(key, it.int_value != 0);
+        } else if (ok) {
+            ok = it.str_value != nullptr;
+            if (ok) pack.set_str(key, it.str_value);
+        }
+        if (!ok) {
+            if (out_bad_index) *out_bad_index = i;
+            return SWBT_ERR_INVALID_ARG;
+        }
+    }
+    if (sharded) {
+        // session-wide limits go through the shard balancer
+        const int dl = lt::settings_pack::download_rate_limit;
+        const int ul = lt::settings_pack::upload_rate_limit;
+        if (pack.has_val(dl) || pack.has_val(ul)) {
+            set_global_rate_limits(impl, pack.has_val(dl) ? pack.get_int(dl) : -1, pack.has_val(ul) ? pack.get_int(ul) : -1);
+            pack.clear(dl);
+            pack.clear(ul);
+        }
+    }
+    apply_to_shards(impl, pack);
+    return SWBT_OK;
+}
+
+swbt_error_code_e swbt_session_get_int_setting(swbt_session_t* session,
+                                               const char* name,
+                                               int64_t* out_value) {
+    if (!session || !name || !out_value) return SWBT_ERR_INVALID_ARG;
+    int key = lt::setting_by_name(name);
+    if (key < 0) return SWBT_ERR_INVALID_ARG;
+    auto impl = static_cast<SwbtSessionImpl*>(session->impl);
+    if (impl->shards.size() > 1 && key == lt::settings_pack::download_rate_limit) {
+        *out_value = impl->global_download_limit.load(std::memory_order_relaxed);
+        return SWBT_OK;
+    }
+    if (impl->shards.size() > 1 && key == lt::settings_pack::upload_rate_limit) {
+        *out_value = impl->global_upload_limit.load(std::memory_order_relaxed);
+        return SWBT_OK;
+    }
+    lt::settings_pack pack = impl->shards[0]->get_settings();
+    switch (setting_type_of(key)) {
+        case SWBT_SETTING_INT: *out_value = pack.get_int(key); return SWBT_OK;
+        case SWBT_SETTING_BOOL: *out_value = pack.get_bool(key) ? 1 : 0; return SWBT_OK;
+        default: return SWBT_ERR_INVALID_ARG;
+    }
+}
+
+swbt_error_code_e swbt_session_get_str_setting(swbt_session_t* session,
+                                               const char* name,
+                                               char* out_value,
+                                               int out_len) {
+    if (!session || !name || !out_value || out_len <= 0) return SWBT_ERR_INVALID_ARG;
+    int key = lt::setting_by_name(name);
+    if (key < 0 || setting_type_of(key) != SWBT_SETTING_STRING) return SWBT_ERR_INVALID_ARG;
+    lt::settings_pack pack = static_cast<SwbtSessionImpl*>(session->impl)->shards[0]->get_settings();
+    copy_cstr_safe(out_value, out_len, pack.get_str(key));
+    return SWBT_OK;
+}
+
+// Active-torrent limits and a slower tick for sessions holding thousands of
+// torrents where only a handful move data at any time.
+static lt::settings_pack many_idle_profile() {
+    lt::settings_pack p;
+    p.set_int(lt::settings_pack::active_downloads, 8);
+    p.set_int(lt::settings_pack::active_seeds, 64);
+    p.set_int(lt::settings_pack::active_checking, 1);
+    p.set_int(lt::settings_pack::active_limit, 128);
+    p.set_bool(lt::settings_pack::dont_count_slow_torrents, true);
+    p.set_int(lt::settings_pack::auto_manage_interval, 60);
+    p.set_int(lt::settings_pack::tick_interval, 1000);
+    p.set_int(lt::settings_pack::connections_limit, 400);
+    p.set_int(lt::settings_pack::torrent_connect_boost, 0);
+    p.set_int(lt::settings_pack::max_peerlist_size, 500);
+    p.set_int(lt::settings_pack::max_paused_peerlist_size, 100);
+    p.set_int(lt::settings_pack::file_pool_size, 100);
+    p.set_int(lt::settings_pack::auto_scrape_interval, 3600);
+    p.set_int(lt::settings_pack::auto_scrape_min_interval, 600);
+    return p;
+}
+
+swbt_error_code_e swbt_session_apply_profile(swbt_session_t* session, int32_t profile) {
+    if (!session) return SWBT_ERR_INVALID_ARG;
+    lt::settings_pack pack;
+    switch (profile) {
+        case SWBT_PROFILE_SEEDBOX: pack = lt::high_performance_seed(); break;
+        case SWBT_PROFILE_LOW_MEMORY: pack = lt::min_memory_usage(); break;
+        case SWBT_PROFILE_MANY_IDLE: pack = many_idle_profile(); break;
+        default: return SWBT_ERR_INVALID_ARG;
+    }
+    // the pump depends on its alert categories and queue headroom
+    pack.clear(lt::settings_pack::alert_mask);
+    pack.clear(lt::settings_pack::alert_queue_size);
+    apply_to_shards(static_cast<SwbtSessionImpl*>(session->impl), pack);
+    return SWBT_OK;
 }
 
 void swbt_torrent_set_rate_limits(swbt_torrent_handle_t* handle,
@@ -508,8 +3898,688 @@ void swbt_torrent_set_rate_limits(swbt_torrent_handle_t* handle,
     if (upload_rate >= 0) th.set_upload_limit(upload_rate);
 }
 
+int swbt_core_has_libtorrent(void) {
+    return 1;
+}
+
+int swbt_session_listen_port(swbt_session_t* session) {
+    if (!session) return 0;
+    return static_cast<SwbtSessionImpl*>(session->impl)->shards[0]->listen_port();
+}
+
+swbt_error_code_e swbt_torrent_connect_peer(swbt_torrent_handle_t* handle,
+                                            const char* ip,
+                                            int port) {
+    if (!handle || !ip || port <= 0 || port > 65535) return SWBT_ERR_INVALID_ARG;
+    lt::error_code ec;
+    lt::address addr = lt::make_address(ip, ec);
+    if (ec) return SWBT_ERR_INVALID_ARG;
+    static_cast<SwbtTorrentHandleImpl*>(handle->impl)->handle.connect_peer(lt::tcp::endpoint(addr, static_cast<unsigned short>(port)));
+    return SWBT_OK;
+}
+
+swbt_error_code_e swbt_session_storage_stats(swbt_session_t* session, swbt_storage_stats_t* out) {
+    if (!session || !out) return SWBT_ERR_INVALID_ARG;
+    auto impl = static_cast<SwbtSessionImpl*>(session->impl);
+    *out = swbt_storage_stats_t{};
+    out->backend = impl->disk_options.backend;
+    out->memory_cap_bytes = impl->disk_options.memory_cap_bytes;
+    if (const auto& shared = impl->disk_shared) {
+        out->resident_bytes = shared->resident_bytes.load(std::memory_order_relaxed);
+        out->evicted_pieces = shared->evicted_pieces.load(std::memory_order_relaxed);
+        out->bytes_read = shared->bytes_read.load(std::memory_order_relaxed);
+        out->bytes_written = shared->bytes_written.load(std::memory_order_relaxed);
+    }
+    return SWBT_OK;
+}
+
+int swbt_session_shard_info(swbt_session_t* session,
+                            swbt_shard_info_t* out_shards,
+                            int max_count) {
+    if (!session) return 0;
+    auto impl = static_cast<SwbtSessionImpl*>(session->impl);
+    const int n = static_cast<int>(impl->shards.size());
+    if (!out_shards || max_count <= 0) return n;
+    const int count = std::min(n, max_count);
+    for (int i = 0; i < count; ++i) {
+        swbt_shard_info_t& o = out_shards[i];
+        o = swbt_shard_info_t{};
+        o.shard = i;
+        o.listen_port = impl->shards[i]->listen_port();
+        lt::settings_pack pack = impl->shards[i]->get_settings();
+        o.download_rate_limit = pack.get_int(lt::settings_pack::download_rate_limit);
+        o.upload_rate_limit = pack.get_int(lt::settings_pack::upload_rate_limit);
+    }
+    std::lock_guard<std::mutex> lk(impl->registry.mutex);
+    for (const auto& kv : impl->registry.by_id) {
+        auto k = static_cast<int>(record_shard(impl, kv.second));
+        if (k >= count) continue;
+        out_shards[k].num_torrents += 1;
+        out_shards[k].download_rate += kv.second.download_rate;
+        out_shards[k].upload_rate += kv.second.upload_rate;
+    }
+    return n;
+}
+
+swbt_error_code_e swbt_session_configure_queue(swbt_session_t* session,
+                                               const swbt_queue_config_t* config) {
+    if (!session || !config) return SWBT_ERR_INVALID_ARG;
+    if (config->share_ratio_goal < 0 || config->seed_time_goal_s < 0) return SWBT_ERR_INVALID_ARG;
+    if (config->goal_action != SWBT_GOAL_ACTION_NONE && config->goal_action != SWBT_GOAL_ACTION_PAUSE) return SWBT_ERR_INVALID_ARG;
+    auto impl = static_cast<SwbtSessionImpl*>(session->impl);
+    const int n = static_cast<int>(impl->shards.size());
+    auto per_shard = [n](int v) { return v > 0 ? std::max(1, (v + n - 1) / n) : v; };
+    lt::settings_pack pack;
+    if (config->active_downloads != 0) pack.set_int(lt::settings_pack::active_downloads, per_shard(config->active_downloads));
+    if (config->active_seeds != 0) pack.set_int(lt::settings_pack::active_seeds, per_shard(config->active_seeds));
+    if (config->active_checking > 0) pack.set_int(lt::settings_pack::active_checking, per_shard(config->active_checking));
+    if (config->active_limit != 0) pack.set_int(lt::settings_pack::active_limit, per_shard(config->active_limit));
+    pack.set_bool(lt::settings_pack::dont_count_slow_torrents, config->dont_count_slow_torrents != 0);
+    // libtorrent ranks seeds past these limits below the rest, so they yield their slots first
+    if (config->share_ratio_goal > 0) pack.set_int(lt::settings_pack::share_ratio_limit, static_cast<int>(config->share_ratio_goal * 100));
+    if (config->seed_time_goal_s > 0) {
+        pack.set_int(lt::settings_pack::seed_time_limit, static_cast<int>(std::min<int64_t>(config->seed_time_goal_s, INT32_MAX)));
+    }
+    apply_to_shards(impl, pack);
+
+    impl->goal_ratio.store(config->share_ratio_goal, std::memory_order_relaxed);
+    impl->goal_seed_s.store(config->seed_time_goal_s, std::memory_order_relaxed);
+    impl->goal_action.store(config->goal_action, std::memory_order_relaxed);
+    impl->demand_priority.store(config->demand_priority != 0, std::memory_order_relaxed);
+    // new goals, new alerts
+    std::lock_guard<std::mutex> lk(impl->registry.mutex);
+    for (auto& kv : impl->registry.by_id) kv.second.goal_reached = false;
+    return SWBT_OK;
+}
+
+swbt_error_code_e swbt_session_set_torrent_goals(swbt_session_t* session,
+                                                 swbt_torrent_handle_t* handle,
+                                                 double share_ratio_goal,
+                                                 int64_t seed_time_goal_s) {
+    if (!session || !handle) return SWBT_ERR_INVALID_ARG;
+    auto impl = static_cast<SwbtSessionImpl*>(session->impl);
+    lt::info_hash_t ih = static_cast<SwbtTorrentHandleImpl*>(handle->impl)->handle.info_hashes();
+    std::lock_guard<std::mutex> lk(impl->registry.mutex);
+    uint32_t id = registry_find_locked(impl->registry, ih);
+    if (id == 0) return SWBT_ERR_INVALID_ARG;
+    SwbtTorrentRecord& rec = impl->registry.by_id[id];
+    rec.goal_ratio = share_ratio_goal;
+    rec.goal_seed_s = seed_time_goal_s;
+    rec.goal_reached = false;
+    impl->torrent_goals.store(true, std::memory_order_relaxed);
+    return SWBT_OK;
+}
+
+void swbt_torrent_queue_move(swbt_torrent_handle_t* handle, int32_t move) {
+    if (!handle) return;
+    const lt::torrent_handle& th = static_cast<SwbtTorrentHandleImpl*>(handle->impl)->handle;
+    switch (move) {
+        case SWBT_QUEUE_UP: th.queue_position_up(); break;
+        case SWBT_QUEUE_DOWN: th.queue_position_down(); break;
+        case SWBT_QUEUE_TOP: th.queue_position_top(); break;
+        case SWBT_QUEUE_BOTTOM: th.queue_position_bottom(); break;
+        default: break;
+    }
+}
+
+void swbt_torrent_set_auto_managed(swbt_torrent_handle_t* handle, int auto_managed) {
+    if (!handle) return;
+    auto himpl = static_cast<SwbtTorrentHandleImpl*>(handle->impl);
+    const lt::torrent_handle& th = himpl->handle;
+    // an explicit choice overrides what a later resume would restore
+    registry_exchange_pause_unmanaged(himpl->session->registry, th, false);
+    if (auto_managed) th.set_flags(lt::torrent_flags::auto_managed);
+    else th.unset_flags(lt::torrent_flags::auto_managed);
+}
+
+int swbt_session_queue_snapshot(swbt_session_t* session,
+                                swbt_queue_entry_t* out_entries,
+                                int max_count,
+                                int* out_total) {
+    if (!session) return 0;
+    auto impl = static_cast<SwbtSessionImpl*>(session->impl);
+    std::lock_guard<std::mutex> lk(impl->registry.mutex);
+    int total = static_cast<int>(impl->registry.by_id.size());
+    if (out_total) *out_total = total;
+    if (!out_entries || max_count <= 0) return 0;
+    std::vector<const SwbtTorrentRecord*> order;
+    order.reserve(impl->registry.by_id.size());
+    for (const auto& kv : impl->registry.by_id) order.push_back(&kv.second);
+    std::sort(order.begin(), order.end(), [](const SwbtTorrentRecord* a, const SwbtTorrentRecord* b) {
+        bool qa = a->queue_position >= 0, qb = b->queue_position >= 0;
+        if (qa != qb) return qa;
+        if (qa) return a->queue_position != b->queue_position ? a->queue_position < b->queue_position : a->id < b->id;
+        return a->seed_rank != b->seed_rank ? a->seed_rank > b->seed_rank : a->id < b->id;
+    });
+    int64_t now = steady_now_ms();
+    int written = std::min(total, max_count);
+    for (int i = 0; i < written; ++i) {
+        const SwbtTorrentRecord& rec = *order[i];
+        swbt_queue_entry_t& o = out_entries[i];
+        o = swbt_queue_entry_t{};
+        o.torrent_id = rec.id;
+        fill_infohash_hex(rec.info_hashes, o.info_hash, sizeof(o.info_hash));
+        o.queue_position = rec.queue_position;
+        o.state = rec.state;
+        o.auto_managed = rec.auto_managed ? 1 : 0;
+        o.paused = rec.paused ? 1 : 0;
+        o.seed_rank = rec.seed_rank;
+        o.num_complete = rec.num_complete;
+        o.num_incomplete = rec.num_incomplete;
+        o.share_ratio = record_ratio(rec);
+        o.seeding_s = record_seeding_s(rec, now);
+        o.goal_reached = rec.goal_reached ? 1 : 0;
+    }
+    return written;
+}
+
+static bool valid_group_config(const swbt_bandwidth_group_config_t* c) {
+    return c && c->download_rate_limit >= 0 && c->upload_rate_limit >= 0
+        && c->download_priority >= 0 && c->download_priority <= 255
+        && c->upload_priority >= 0 && c->upload_priority <= 255
+        && c->max_connections >= 0 && c->connection_limit_factor >= 0;
+}
+
+int32_t swbt_session_create_bandwidth_group(swbt_session_t* session,
+                                            const char* name,
+                                            const swbt_bandwidth_group_config_t* config) {
+    if (!session || !name || !*name || !valid_group_config(config)) return -1;
+    auto impl = static_cast<SwbtSessionImpl*>(session->impl);
+    std::lock_guard<std::mutex> lk(impl->group_mutex);
+    int32_t id = -1;
+    for (int32_t g = SWBT_BANDWIDTH_GROUP_LOCAL + 1; g < 32; ++g) {
+        if (!impl->groups.count(g)) {
+            id = g;
+            break;
+        }
+    }
+    if (id < 0) return -1;
+    SwbtBandwidthGroup group;
+    group.name = name;
+    group.config = *config;
+    bool fits = true;
+    for (auto& shard : impl->shards) {
+        group.classes.push_back(shard->create_peer_class(name));
+        // class ids are bits of the peer class filter
+        if (static_cast<uint32_t>(group.classes.back()) >= 32) fits = false;
+    }
+    if (!fits) {
+        for (std::size_t i = 0; i < group.classes.size(); ++i) impl->shards[i]->delete_peer_class(group.classes[i]);
+        return -1;
+    }
+    apply_group_config_locked(impl, id, group);
+    impl->groups.emplace(id, std::move(group));
+    return id;
+}
+
+swbt_error_code_e swbt_session_configure_bandwidth_group(swbt_session_t* session,
+                                                         int32_t group,
+                                                         const swbt_bandwidth_group_config_t* config) {
+    if (!session || !valid_group_config(config)) return SWBT_ERR_INVALID_ARG;
+    auto impl = static_cast<SwbtSessionImpl*>(session->impl);
+    std::lock_guard<std::mutex> lk(impl->group_mutex);
+    auto it = impl->groups.find(group);
+    if (it == impl->groups.end()) return SWBT_ERR_INVALID_ARG;
+    it->second.config = *config;
+    apply_group_config_locked(impl, group, it->second);
+    return SWBT_OK;
+}
+
+swbt_error_code_e swbt_session_delete_bandwidth_group(swbt_session_t* session, int32_t group) {
+    if (!session || group <= SWBT_BANDWIDTH_GROUP_LOCAL) return SWBT_ERR_INVALID_ARG;
+    auto impl = static_cast<SwbtSessionImpl*>(session->impl);
+    std::lock_guard<std::mutex> lk(impl->group_mutex);
+    auto it = impl->groups.find(group);
+    if (it == impl->groups.end()) return SWBT_ERR_INVALID_ARG;
+    auto& ranges = impl->group_ranges;
+    ranges.erase(std::remove_if(ranges.begin(), ranges.end(), [group](const SwbtGroupRange& r) { return r.group == group; }), ranges.end());
+    rebuild_class_filters_locked(impl);
+    for (std::size_t i = 0; i < impl->shards.size(); ++i) impl->shards[i]->delete_peer_class(it->second.classes[i]);
+    impl->groups.erase(it);
+    // the pump clears the members' limits on its next pass
+    std::lock_guard<std::mutex> rlk(impl->registry.mutex);
+    for (auto& kv : impl->registry.by_id) {
+        if (kv.second.bandwidth_group == group) kv.second.bandwidth_group = -1;
+    }
+    return SWBT_OK;
+}
+
+swbt_error_code_e swbt_session_set_torrent_bandwidth_group(swbt_session_t* session,
+                                                           swbt_torrent_handle_t* handle,
+                                                           int32_t group) {
+    if (!session || !handle) return SWBT_ERR_INVALID_ARG;
+    if (group != -1 && group <= SWBT_BANDWIDTH_GROUP_LOCAL) return SWBT_ERR_INVALID_ARG;
+    auto impl = static_cast<SwbtSessionImpl*>(session->impl);
+    lt::info_hash_t ih = static_cast<SwbtTorrentHandleImpl*>(handle->impl)->handle.info_hashes();
+    std::lock_guard<std::mutex> lk(impl->group_mutex);
+    if (group != -1 && !impl->groups.count(group)) return SWBT_ERR_INVALID_ARG;
+    std::lock_guard<std::mutex> rlk(impl->registry.mutex);
+    uint32_t id = registry_find_locked(impl->registry, ih);
+    if (id == 0) return SWBT_ERR_INVALID_ARG;
+    impl->registry.by_id[id].bandwidth_group = group;
+    impl->grouped_torrents.store(true, std::memory_order_relaxed);
+    return SWBT_OK;
+}
+
+swbt_error_code_e swbt_session_add_bandwidth_group_range(swbt_session_t* session,
+                                                         int32_t group,
+                                                         const char* first_ip,
+                                                         const char* last_ip) {
+    if (!session || !first_ip || !last_ip || group <= SWBT_BANDWIDTH_GROUP_LOCAL) return SWBT_ERR_INVALID_ARG;
+    lt::error_code ec;
+    lt::address first = lt::make_address(first_ip, ec);
+    if (ec) return SWBT_ERR_INVALID_ARG;
+    lt::address last = lt::make_address(last_ip, ec);
+    if (ec || first.is_v4() != last.is_v4() || last < first) return SWBT_ERR_INVALID_ARG;
+    auto impl = static_cast<SwbtSessionImpl*>(session->impl);
+    std::lock_guard<std::mutex> lk(impl->group_mutex);
+    if (!impl->groups.count(group)) return SWBT_ERR_INVALID_ARG;
+    impl->group_ranges.push_back(SwbtGroupRange{group, first, last});
+    rebuild_class_filters_locked(impl);
+    return SWBT_OK;
+}
+
+swbt_error_code_e swbt_session_clear_bandwidth_group_ranges(swbt_session_t* session, int32_t group) {
+    if (!session || group <= SWBT_BANDWIDTH_GROUP_LOCAL) return SWBT_ERR_INVALID_ARG;
+    auto impl = static_cast<SwbtSessionImpl*>(session->impl);
+    std::lock_guard<std::mutex> lk(impl->group_mutex);
+    if (!impl->groups.count(group)) return SWBT_ERR_INVALID_ARG;
+    auto& ranges = impl->group_ranges;
+    ranges.erase(std::remove_if(ranges.begin(), ranges.end(), [group](const SwbtGroupRange& r) { return r.group == group; }), ranges.end());
+    rebuild_class_filters_locked(impl);
+    return SWBT_OK;
+}
+
+int swbt_session_bandwidth_groups(swbt_session_t* session,
+                                  int include_peers,
+                                  swbt_bandwidth_group_stats_t* out_groups,
+                                  int max_count) {
+    if (!session) return 0;
+    auto impl = static_cast<SwbtSessionImpl*>(session->impl);
+    std::vector<swbt_bandwidth_group_stats_t> rows;
+    int row_of[32];
+    std::fill(std::begin(row_of), std::end(row_of), -1);
+    lt::ip_filter filter;
+    {
+        std::lock_guard<std::mutex> lk(impl->group_mutex);
+        for (const auto& kv : impl->groups) {
+            swbt_bandwidth_group_stats_t st{};
+            st.group = kv.first;
+            copy_cstr_safe(st.name, sizeof(st.name), kv.second.name);
+            st.config = kv.second.config;
+            row_of[kv.first] = static_cast<int>(rows.size());
+            rows.push_back(st);
+        }
+        filter = impl->class_filter;
+    }
+    swbt_bandwidth_group_config_t& global = rows[row_of[SWBT_BANDWIDTH_GROUP_GLOBAL]].config;
+    global_rate_limits(impl, global.download_rate_limit, global.upload_rate_limit);
+
+    // peers come from every torrent, since IP ranges apply to all of them
+    thread_local std::vector<std::pair<int32_t, lt::torrent_handle>> targets;
+    targets.clear();
+    {
+        std::lock_guard<std::mutex> lk(impl->registry.mutex);
+        for (const auto& kv : impl->registry.by_id) {
+            const SwbtTorrentRecord& rec = kv.second;
+            int32_t g = rec.bandwidth_group >= 0 && row_of[rec.bandwidth_group] >= 0 ? rec.bandwidth_group : -1;
+            if (g >= 0) {
+                swbt_bandwidth_group_stats_t& st = rows[row_of[g]];
+                st.num_torrents += 1;
+                st.torrent_download_rate += rec.download_rate;
+                st.torrent_upload_rate += rec.upload_rate;
+            }
+            if (include_peers && rec.handle.is_valid()) targets.emplace_back(g, rec.handle);
+        }
+    }
+    for (const auto& t : targets) {
+        std::vector<lt::peer_info>& peers = peer_scratch();
+        try {
+            t.second.get_peer_info(peers);
+        } catch (const std::exception&) {
+            continue;
+        }
+        for (const lt::peer_info& p : peers) {
+            uint32_t mask = filter.access(p.ip.address());
+            // libtorrent's type filter puts every non-uTP socket in TCP
+            if (!(p.flags & lt::peer_info::utp_socket)) mask |= uint32_t{1} << SWBT_BANDWIDTH_GROUP_TCP;
+            if (t.first >= 0) mask |= uint32_t{1} << t.first;
+            for (int g = 0; g < 32; ++g) {
+                if (!(mask & (uint32_t{1} << g)) || row_of[g] < 0) continue;
+                swbt_bandwidth_group_stats_t& st = rows[row_of[g]];
+                st.num_peers += 1;
+                st.peer_download_rate += p.down_speed;
+                st.peer_upload_rate += p.up_speed;
+            }
+        }
+    }
+    int total = static_cast<int>(rows.size());
+    if (!out_groups || max_count <= 0) return total;
+    std::copy_n(rows.begin(), std::min(total, max_count), out_groups);
+    return total;
+}
+
+swbt_error_code_e swbt_session_configure_recheck(swbt_session_t* session,
+                                                 const swbt_recheck_config_t* config) {
+    if (!session || !config || config->max_total < 0 || config->progress_step > 100) return SWBT_ERR_INVALID_ARG;
+    auto impl = static_cast<SwbtSessionImpl*>(session->impl);
+    {
+        std::lock_guard<std::mutex> lk(impl->recheck_mutex);
+        impl->recheck_max_per_device = config->max_per_device > 0 ? config->max_per_device : 1;
+        impl->recheck_max_total = config->max_total;
+        impl->recheck_step = config->progress_step > 0 ? config->progress_step : 10;
+    }
+    // checks libtorrent starts on its own (adds without resume data) queue behind this
+    if (config->max_total > 0) {
+        lt::settings_pack pack;
+        pack.set_int(lt::settings_pack::active_checking, per_shard_limit(impl, config->max_total));
+        apply_to_shards(impl, pack);
+    }
+    impl->rechecks_pending.store(true, std::memory_order_relaxed);
+    wake_pump(impl);
+    return SWBT_OK;
+}
+
+static swbt_error_code_e queue_recheck(SwbtSessionImpl* impl, const lt::torrent_handle& th, bool immediate) {
+    std::string save_path;
+    try {
+        if (!th.torrent_file()) return SWBT_ERR_INVALID_ARG;
+        save_path = th.status(lt::torrent_handle::query_save_path).save_path;
+    } catch (const std::exception&) {
+        return SWBT_ERR_INVALID_ARG;
+    }
+    uint32_t id;
+    {
+        std::lock_guard<std::mutex> lk(impl->registry.mutex);
+        id = registry_find_locked(impl->registry, th.info_hashes());
+    }
+    if (id == 0) return SWBT_ERR_INVALID_ARG;
+    enqueue_recheck(impl, id, th, save_path, false, immediate);
+    return SWBT_OK;
+}
+
+swbt_error_code_e swbt_session_recheck_torrent(swbt_session_t* session, swbt_torrent_handle_t* handle) {
+    if (!session || !handle) return SWBT_ERR_INVALID_ARG;
+    return queue_recheck(static_cast<SwbtSessionImpl*>(session->impl), static_cast<SwbtTorrentHandleImpl*>(handle->impl)->handle, false);
+}
+
+swbt_error_code_e swbt_torrent_force_recheck(swbt_torrent_handle_t* handle) {
+    if (!handle) return SWBT_ERR_INVALID_ARG;
+    auto himpl = static_cast<SwbtTorrentHandleImpl*>(handle->impl);
+    return queue_recheck(himpl->session, himpl->handle, true);
+}
+
+int swbt_session_recheck_queue(swbt_session_t* session,
+                               swbt_recheck_entry_t* out_entries,
+                               int max_count) {
+    if (!session) return 0;
+    auto impl = static_cast<SwbtSessionImpl*>(session->impl);
+    std::vector<swbt_recheck_entry_t> entries;
+    {
+        std::lock_guard<std::mutex> lk(impl->recheck_mutex);
+        auto add = [&entries](const SwbtRecheckJob& j, bool checking) {
+            swbt_recheck_entry_t e{};
+            e.torrent_id = j.torrent_id;
+            fill_infohash_hex(j.info_hashes, e.info_hash, sizeof(e.info_hash));
+            e.checking = checking ? 1 : 0;
+            e.device = j.device;
+            entries.push_back(e);
+        };
+        for (const SwbtRecheckJob& j : impl->rechecks_running) add(j, true);
+        for (const SwbtRecheckJob& j : impl->recheck_queue) add(j, false);
+    }
+    {
+        std::lock_guard<std::mutex> lk(impl->registry.mutex);
+        for (swbt_recheck_entry_t& e : entries) {
+            if (!e.checking) continue;
+            auto rec = impl->registry.by_id.find(e.torrent_id);
+            if (rec != impl->registry.by_id.end() && rec->second.state == static_cast<int32_t>(lt::torrent_status::checking_files)) {
+                e.progress = static_cast<float>(rec->second.progress);
+            }
+        }
+    }
+    int total = static_cast<int>(entries.size());
+    if (out_entries && max_count > 0) std::copy_n(entries.begin(), std::min(total, max_count), out_entries);
+    return total;
+}
+
+swbt_error_code_e swbt_session_trace_start(swbt_session_t* session,
+                                           const char* path,
+                                           int64_t capacity_records,
+                                           uint32_t categories) {
+    if (!session || !path || path[0] == '\0' || capacity_records <= 0) return SWBT_ERR_INVALID_ARG;
+    auto impl = static_cast<SwbtSessionImpl*>(session->impl);
+    swbt_session_trace_stop(session);
+    std::vector<std::string> names(lt::num_alert_types);
+    for (int i = 0; i < lt::num_alert_types; ++i) names[i] = lt::alert_name(i);
+    auto trace = std::make_shared<SwbtTrace>();
+    trace->t0 = lt::clock_type::now();
+    std::string error;
+    trace->recorder = SwbtTraceRecorder::open(path, static_cast<uint64_t>(capacity_records), categories, names, error);
+    if (!trace->recorder) return SWBT_ERR_GENERIC;
+    {
+        std::lock_guard<std::mutex> lk(impl->trace_mutex);
+        impl->trace = std::move(trace);
+    }
+    std::lock_guard<std::mutex> lk(impl->stream_mutex);
+    impl->trace_categories.store(categories, std::memory_order_relaxed);
+    apply_alert_mask_locked(impl);
+    return SWBT_OK;
+}
+
+void swbt_session_trace_stop(swbt_session_t* session) {
+    if (!session) return;
+    auto impl = static_cast<SwbtSessionImpl*>(session->impl);
+    std::shared_ptr<SwbtTrace> trace;
+    {
+        std::lock_guard<std::mutex> lk(impl->trace_mutex);
+        trace.swap(impl->trace);
+    }
+    if (!trace) return;
+    {
+        std::lock_guard<std::mutex> lk(impl->stream_mutex);
+        impl->trace_categories.store(0, std::memory_order_relaxed);
+        apply_alert_mask_locked(impl);
+    }
+    // the file is synced and closed once the pump lets go of its batch's reference
+}
+
+swbt_error_code_e swbt_session_trace_set_categories(swbt_session_t* session, uint32_t categories) {
+    if (!session) return SWBT_ERR_INVALID_ARG;
+    auto impl = static_cast<SwbtSessionImpl*>(session->impl);
+    if (!current_trace(impl)) return SWBT_ERR_GENERIC;
+    std::lock_guard<std::mutex> lk(impl->stream_mutex);
+    impl->trace_categories.store(categories, std::memory_order_relaxed);
+    apply_alert_mask_locked(impl);
+    return SWBT_OK;
+}
+
+void swbt_session_trace_mark(swbt_session_t* session, const char* label) {
+    if (!session) return;
+    std::shared_ptr<SwbtTrace> trace = current_trace(static_cast<SwbtSessionImpl*>(session->impl));
+    if (!trace) return;
+    int64_t offset_us = std::chrono::duration_cast<std::chrono::microseconds>(lt::clock_type::now() - trace->t0).count();
+    trace->recorder->mark(trace->recorder->started_us() + offset_us, label);
+}
+
+void swbt_session_trace_stats(swbt_session_t* session, swbt_trace_stats_t* out_stats) {
+    if (!out_stats) return;
+    *out_stats = swbt_trace_stats_t{};
+    if (!session) return;
+    auto impl = static_cast<SwbtSessionImpl*>(session->impl);
+    std::shared_ptr<SwbtTrace> trace = current_trace(impl);
+    if (!trace) return;
+    out_stats->active = 1;
+    out_stats->categories = impl->trace_categories.load(std::memory_order_relaxed);
+    out_stats->records_written = trace->recorder->records_written();
+    out_stats->capacity = trace->recorder->capacity();
+}
+
+static lt::ip_filter build_ip_filter(const SwbtBlocklist& list) {
+    lt::ip_filter filter;
+    for (const SwbtBlocklist::V4Range& r : list.v4()) {
+        filter.add_rule(lt::address_v4(r.first), lt::address_v4(r.last), lt::ip_filter::blocked);
+    }
+    for (const SwbtBlocklist::V6Range& r : list.v6()) {
+        std::array<unsigned char, 16> first, last;
+        SwbtBlocklist::v6_to_bytes(r.first, first.data());
+        SwbtBlocklist::v6_to_bytes(r.last, last.data());
+        filter.add_rule(lt::address_v6(first), lt::address_v6(last), lt::ip_filter::blocked);
+    }
+    return filter;
+}
+
+// libtorrent's ip_filter keeps a std::set node per range boundary for each
+// address family.
+static int64_t ip_filter_bytes_estimate(const SwbtBlocklist& list) {
+    const int64_t node = 4 * sizeof(void*);   // rb-tree links and colour
+    const int64_t v4 = (2 * static_cast<int64_t>(list.v4().size()) + 1) * (node + 8);
+    const int64_t v6 = (2 * static_cast<int64_t>(list.v6().size()) + 1) * (node + 20);
+    return v4 + v6;
+}
+
+static void post_blocklist_alert(SwbtSessionImpl* impl, int error_code, const std::string& message) {
+    swbt_alert_t a{};
+    a.type = SWBT_ALERT_BLOCKLIST_LOADED;
+    a.error_code = error_code;
+    copy_cstr_safe(a.message, sizeof(a.message), message);
+    {
+        std::lock_guard<std::mutex> lk(impl->blocklist_mutex);
+        impl->blocklist_alerts.push_back(a);
+    }
+    wake_pump(impl);
+}
+
+// Runs on blocklist_pool. No paths clears the list.
+static void run_blocklist_load(SwbtSessionImpl* impl, uint64_t generation, const std::vector<std::string>& paths) {
+    auto superseded = [impl, generation] {
+        return impl->blocklist_generation.load(std::memory_order_acquire) != generation;
+    };
+    if (superseded()) return;
+    int64_t started_ms = steady_now_ms();
+    SwbtBlocklistLoadStats load_stats;
+    std::shared_ptr<const SwbtBlocklist> list;
+    if (!paths.empty()) {
+        std::string error;
+        list = SwbtBlocklist::load(paths, load_stats, error);
+        if (!list) {
+            {
+                std::lock_guard<std::mutex> lk(impl->blocklist_mutex);
+                ++impl->blocklist_stats.failed_loads;
+                copy_cstr_safe(impl->blocklist_stats.last_error, sizeof(impl->blocklist_stats.last_error), error);
+            }
+            post_blocklist_alert(impl, SWBT_ERR_GENERIC, error);
+            return;
+        }
+    }
+    // a newer request would replace this list right away; don't pay for building it
+    if (superseded()) return;
+    int64_t parsed_ms = steady_now_ms();
+    lt::ip_filter filter = list ? build_ip_filter(*list) : lt::ip_filter();
+    for (std::size_t i = 0; i + 1 < impl->shards.size(); ++i) impl->shards[i]->set_ip_filter(filter);
+    impl->shards.back()->set_ip_filter(std::move(filter));
+    int64_t applied_ms = steady_now_ms();
+
+    swbt_blocklist_stats_t& st = impl->blocklist_stats;
+    {
+        std::lock_guard<std::mutex> lk(impl->blocklist_mutex);
+        impl->blocklist = list;
+        st.files = load_stats.files;
+        st.lines = load_stats.lines;
+        st.entries = load_stats.entries;
+        st.allowed_lines = load_stats.allowed_lines;
+        st.malformed_lines = load_stats.malformed_lines;
+        st.ranges_v4 = list ? static_cast<int64_t>(list->v4().size()) : 0;
+        st.ranges_v6 = list ? static_cast<int64_t>(list->v6().size()) : 0;
+        st.addresses_v4 = list ? list->v4_addresses() : 0;
+        st.memory_bytes = list ? list->memory_bytes() : 0;
+        st.filter_copies = list ? static_cast<int32_t>(impl->shards.size()) : 0;
+        st.filter_memory_bytes = list ? ip_filter_bytes_estimate(*list) * static_cast<int64_t>(impl->shards.size()) : 0;
+        st.parse_ms = parsed_ms - started_ms;
+        st.apply_ms = applied_ms - parsed_ms;
+        ++st.loads;
+    }
+    {
+        std::lock_guard<std::mutex> lk(impl->stream_mutex);
+        impl->blocklist_active.store(list != nullptr, std::memory_order_relaxed);
+        apply_alert_mask_locked(impl);
+    }
+    char message[256];
+    if (list) {
+        std::snprintf(message, sizeof(message), "blocklist: %lld ranges (%lld IPv6) from %lld lines in %lld ms",
+                      static_cast<long long>(list->v4().size() + list->v6().size()), static_cast<long long>(list->v6().size()),
+                      static_cast<long long>(load_stats.lines), static_cast<long long>(applied_ms - started_ms));
+    } else {
+        std::snprintf(message, sizeof(message), "blocklist cleared");
+    }
+    post_blocklist_alert(impl, 0, message);
+}
+
+static void queue_blocklist_job(SwbtSessionImpl* impl, std::vector<std::string> paths) {
+    std::lock_guard<std::mutex> lk(impl->blocklist_mutex);
+    if (!impl->blocklist_pool) impl->blocklist_pool = std::make_unique<SwbtWorkerPool>(1);
+    uint64_t generation = impl->blocklist_generation.fetch_add(1, std::memory_order_acq_rel) + 1;
+    impl->blocklist_jobs.fetch_add(1, std::memory_order_relaxed);
+    impl->blocklist_pool->submit([impl, generation, paths = std::move(paths)] {
+        run_blocklist_load(impl, generation, paths);
+        impl->blocklist_jobs.fetch_sub(1, std::memory_order_relaxed);
+    });
+}
+
+swbt_error_code_e swbt_session_load_blocklist(swbt_session_t* session,
+                                              const char* const* paths,
+                                              int count) {
+    if (!session || !paths || count <= 0) return SWBT_ERR_INVALID_ARG;
+    std::vector<std::string> files;
+    for (int i = 0; i < count; ++i) {
+        if (!paths[i] || paths[i][0] == '\0') return SWBT_ERR_INVALID_ARG;
+        files.emplace_back(paths[i]);
+    }
+    queue_blocklist_job(static_cast<SwbtSessionImpl*>(session->impl), std::move(files));
+    return SWBT_OK;
+}
+
+void swbt_session_clear_blocklist(swbt_session_t* session) {
+    if (!session) return;
+    queue_blocklist_job(static_cast<SwbtSessionImpl*>(session->impl), {});
+}
+
+int swbt_session_blocklist_contains(swbt_session_t* session, const char* ip) {
+    if (!session || !ip) return -1;
+    auto impl = static_cast<SwbtSessionImpl*>(session->impl);
+    uint8_t bytes[16];
+    bool v4 = ::inet_pton(AF_INET, ip, bytes) == 1;
+    if (!v4 && ::inet_pton(AF_INET6, ip, bytes) != 1) return -1;
+    std::shared_ptr<const SwbtBlocklist> list;
+    {
+        std::lock_guard<std::mutex> lk(impl->blocklist_mutex);
+        list = impl->blocklist;
+    }
+    if (!list) return 0;
+    if (v4) return list->contains(uint32_t{bytes[0]} << 24 | uint32_t{bytes[1]} << 16 | uint32_t{bytes[2]} << 8 | bytes[3]) ? 1 : 0;
+    return list->contains(SwbtBlocklist::v6_from_bytes(bytes)) ? 1 : 0;
+}
+
+void swbt_session_blocklist_stats(swbt_session_t* session, swbt_blocklist_stats_t* out_stats) {
+    if (!out_stats) return;
+    *out_stats = swbt_blocklist_stats_t{};
+    if (!session) return;
+    auto impl = static_cast<SwbtSessionImpl*>(session->impl);
+    {
+        std::lock_guard<std::mutex> lk(impl->blocklist_mutex);
+        *out_stats = impl->blocklist_stats;
+        out_stats->active = impl->blocklist ? 1 : 0;
+    }
+    out_stats->loading = impl->blocklist_jobs.load(std::memory_order_relaxed) > 0 ? 1 : 0;
+    out_stats->blocked_peers = impl->blocklist_blocked.load(std::memory_order_relaxed);
+}
+
 #else // non-macOS (stubs)
 
+int swbt_core_has_libtorrent(void) {
+    return 0;
+}
+
 swbt_session_t* swbt_session_new(const swbt_session_config_t* /*config*/) {
     return new swbt_session_t{};
 }
@@ -532,6 +4602,10 @@ void swbt_remove_torrent(swbt_session_t* /*session*/, swbt_torrent_handle_t* han
     delete handle;
 }
 
+void swbt_torrent_handle_free(swbt_torrent_handle_t* handle) {
+    delete handle;
+}
+
 void swbt_torrent_pause(swbt_torrent_handle_t* /*handle*/) {}
 void swbt_torrent_resume(swbt_torrent_handle_t* /*handle*/) {}
 void swbt_torrent_force_reannounce(swbt_torrent_handle_t* /*handle*/) {}
@@ -550,4 +4624,10 @@ int swbt_session_poll_updates(swbt_session_t* /*session*/, int /*timeout_ms*/, s
 
 #endif // platform guard
 
-
+// Frees what swbt_torrent_file_table allocated; available in every build.
+void swbt_file_table_free(swbt_file_table_t* table) {
+    if (!table) return;
+    std::free(table->files);
+    std::free(table->paths);
+    *table = swbt_file_table_t{};
+}
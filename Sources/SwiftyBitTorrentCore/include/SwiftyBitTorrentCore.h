@@ -17,6 +17,13 @@ typedef enum swbt_error_code_e {
     SWBT_ERR_INVALID_ARG = 2
 } swbt_error_code_e;
 
+typedef enum swbt_storage_backend_e {
+    SWBT_STORAGE_DEFAULT = 0,  // libtorrent's default disk I/O
+    SWBT_STORAGE_POSIX = 1,    // libtorrent's portable pread/pwrite disk I/O
+    SWBT_STORAGE_MEMORY = 2,   // pieces held in RAM only; nothing survives the torrent or session
+    SWBT_STORAGE_MMAP = 3      // core's memory-mapped files with madvise read-ahead
+} swbt_storage_backend_e;
+
 typedef struct swbt_session_config_t {
     const char* save_path; // optional default save path
     int32_t listen_port;   // 0 for auto
@@ -26,7 +33,14 @@ typedef struct swbt_session_config_t {
     int32_t enable_natpmp; // bool
     int32_t download_rate_limit; // bytes/sec, 0 = unlimited
     int32_t upload_rate_limit;   // bytes/sec, 0 = unlimited
-    int32_t post_status_interval_ms; // e.g. 1000
+    int32_t post_status_interval_ms; // e.g. 1000; cadence of the core's torrent snapshot refresh
+    int32_t storage_backend;         // swbt_storage_backend_e
+    int32_t storage_threads;         // MEMORY/MMAP: disk job threads, 0 = 2
+    int64_t storage_memory_cap_bytes; // MEMORY: evict least recently used pieces above this, 0 = no cap;
+                                      // split across shards, and torrents larger than their shard's
+                                      // part fail their file check with ENOSPC
+    int64_t storage_readahead_bytes;  // MMAP: madvise(WILLNEED) window past each read, 0 = kernel default
+    int32_t shards;                   // lt::session instances behind this session, 0 or 1 = one (see swbt_shard_info_t)
 } swbt_session_config_t;
 
 typedef struct swbt_torrent_status_t {
@@ -47,6 +61,52 @@ typedef struct swbt_torrent_status_t {
 swbt_session_t* swbt_session_new(const swbt_session_config_t* config);
 void swbt_session_free(swbt_session_t* session);
 
+// Session state persistence (settings and DHT routing table) for warm restarts.
+// DHT nodes restored this way let magnet-only torrents find peers without a
+// full bootstrap. Values in config are applied on top of saved settings.
+typedef enum swbt_session_state_flags_e {
+    SWBT_SESSION_STATE_SETTINGS = 1 << 0,
+    SWBT_SESSION_STATE_DHT = 1 << 1,
+    SWBT_SESSION_STATE_ALL = SWBT_SESSION_STATE_SETTINGS | SWBT_SESSION_STATE_DHT
+} swbt_session_state_flags_e;
+
+// Unreadable state falls back to a cold start; check swbt_startup_metrics_t.warm_start.
+swbt_session_t* swbt_session_new_with_state(const swbt_session_config_t* config,
+                                            const uint8_t* state,
+                                            int state_size);
+swbt_session_t* swbt_session_new_from_state_file(const swbt_session_config_t* config,
+                                                 const char* path);
+
+// flags: swbt_session_state_flags_e bits, 0 = all. Free the buffer with swbt_session_state_free.
+swbt_error_code_e swbt_session_save_state(swbt_session_t* session,
+                                          uint32_t flags,
+                                          uint8_t** out_data,
+                                          int32_t* out_size);
+void swbt_session_state_free(uint8_t* data);
+
+// Written to a temporary file and renamed over path.
+swbt_error_code_e swbt_session_save_state_file(swbt_session_t* session,
+                                               uint32_t flags,
+                                               const char* path);
+
+// Startup metrics. Time to first peer is measured from when the core first sees
+// a torrent to the first snapshot refresh reporting a connected peer, so its
+// resolution is post_status_interval_ms.
+typedef struct swbt_startup_metrics_t {
+    int32_t warm_start;            // bool, session was built from saved state
+    int32_t dht_nodes_restored;    // routing table entries loaded from saved state
+    int32_t torrents;
+    int32_t torrents_with_peers;   // torrents that have connected at least one peer
+    int64_t first_peer_ms_min;     // -1 until a torrent has connected a peer
+    int64_t first_peer_ms_median;
+    int64_t first_peer_ms_max;
+} swbt_startup_metrics_t;
+
+void swbt_session_startup_metrics(swbt_session_t* session, swbt_startup_metrics_t* out_metrics);
+
+// -1 for unknown ids and torrents without a peer yet.
+int64_t swbt_session_time_to_first_peer_ms(swbt_session_t* session, uint32_t torrent_id);
+
 // Torrent operations
 swbt_error_code_e swbt_add_magnet(swbt_session_t* session,
                                   const char* magnet_uri,
@@ -61,8 +121,12 @@ swbt_error_code_e swbt_add_torrent_file(swbt_session_t* session,
 void swbt_remove_torrent(swbt_session_t* session,
                          swbt_torrent_handle_t* handle,
                          int with_data);
+// Release a handle without touching the torrent (e.g. one returned by
+// swbt_session_find_torrent). Do not pass it to swbt_remove_torrent afterwards.
+void swbt_torrent_handle_free(swbt_torrent_handle_t* handle);
 
-// Control
+// Control. Pause takes the torrent out of the queue; resume hands it back, so it
+// may stay queued until a slot frees up (see swbt_queue_config_t).
 void swbt_torrent_pause(swbt_torrent_handle_t* handle);
 void swbt_torrent_resume(swbt_torrent_handle_t* handle);
 void swbt_torrent_force_reannounce(swbt_torrent_handle_t* handle);
@@ -75,11 +139,85 @@ swbt_error_code_e swbt_torrent_status(swbt_torrent_handle_t* handle,
 void swbt_session_post_torrent_updates(swbt_session_t* session);
 // Wait up to timeout_ms and collect torrent_status from state_update_alerts.
 // Returns number of entries written to out_statuses (<= max_count).
+// Full records are only queued while someone polls: once no call has been made
+// for SWBT_STATUS_CONSUMER_WINDOW_MS they stop (the snapshot and delta records
+// are unaffected), and the first poll after that pause starts them again, so
+// it may return nothing. Poll at least this often to receive every update.
+#define SWBT_STATUS_CONSUMER_WINDOW_MS 10000
 int swbt_session_poll_updates(swbt_session_t* session,
                               int timeout_ms,
                               swbt_torrent_status_t* out_statuses,
                               int max_count);
 
+// Compact update mode. Each torrent gets a stable session-local 32-bit id.
+// In delta mode the status queue carries fixed-size records: an ADDED record
+// the first time a torrent is seen (fetch its hash/name once through
+// swbt_session_torrent_identity), UPDATE records with the numeric counters and
+// a bitmask of changed fields, and a REMOVED record when it leaves the session.
+typedef enum swbt_update_mode_e {
+    SWBT_UPDATE_MODE_FULL = 1,   // swbt_torrent_status_t via swbt_session_poll_updates (default)
+    SWBT_UPDATE_MODE_DELTA = 2   // swbt_status_delta_t via swbt_session_poll_status_deltas
+} swbt_update_mode_e;
+
+typedef enum swbt_status_record_kind_e {
+    SWBT_STATUS_RECORD_ADDED = 1,
+    SWBT_STATUS_RECORD_UPDATE = 2,
+    SWBT_STATUS_RECORD_REMOVED = 3
+} swbt_status_record_kind_e;
+
+// Bits of swbt_status_delta_t.changed
+typedef enum swbt_status_field_e {
+    SWBT_STATUS_FIELD_PROGRESS = 1 << 0,
+    SWBT_STATUS_FIELD_DOWNLOAD_RATE = 1 << 1,
+    SWBT_STATUS_FIELD_UPLOAD_RATE = 1 << 2,
+    SWBT_STATUS_FIELD_TOTAL_DOWNLOADED = 1 << 3,
+    SWBT_STATUS_FIELD_TOTAL_UPLOADED = 1 << 4,
+    SWBT_STATUS_FIELD_NUM_PEERS = 1 << 5,
+    SWBT_STATUS_FIELD_NUM_SEEDS = 1 << 6,
+    SWBT_STATUS_FIELD_STATE = 1 << 7,
+    SWBT_STATUS_FIELD_HAS_METADATA = 1 << 8,
+    SWBT_STATUS_FIELD_IDENTITY = 1 << 9  // name changed (e.g. metadata arrived); re-fetch identity
+} swbt_status_field_e;
+
+typedef struct swbt_status_delta_t {
+    uint32_t torrent_id;
+    int32_t kind;              // swbt_status_record_kind_e
+    uint32_t changed;          // swbt_status_field_e bits
+    int32_t state;
+    double progress;
+    int64_t download_rate;
+    int64_t upload_rate;
+    int64_t total_downloaded;
+    int64_t total_uploaded;
+    int32_t num_peers;
+    int32_t num_seeds;
+    int32_t has_metadata;
+} swbt_status_delta_t;
+
+typedef struct swbt_torrent_identity_t {
+    uint32_t torrent_id;
+    char info_hash[65];
+    char name[256];
+} swbt_torrent_identity_t;
+
+// Enable or disable an update mode (both may be active at once).
+void swbt_session_set_update_mode(swbt_session_t* session,
+                                  swbt_update_mode_e mode,
+                                  int enabled);
+
+// Wait up to timeout_ms for delta records. Returns number written (<= max_count).
+int swbt_session_poll_status_deltas(swbt_session_t* session,
+                                    int timeout_ms,
+                                    swbt_status_delta_t* out_records,
+                                    int max_count);
+
+swbt_error_code_e swbt_session_torrent_identity(swbt_session_t* session,
+                                                uint32_t torrent_id,
+                                                swbt_torrent_identity_t* out_identity);
+
+// Session-local id of a torrent, 0 if the handle is no longer valid.
+uint32_t swbt_torrent_id(swbt_session_t* session, swbt_torrent_handle_t* handle);
+
 // Identification
 // Writes hex id (up to 64 hex chars + NUL) to out_hex buffer.
 swbt_error_code_e swbt_torrent_infohash(swbt_torrent_handle_t* handle,
@@ -119,21 +257,261 @@ swbt_error_code_e swbt_add_torrent_file_with_resume(swbt_session_t* session,
                                                     int resume_size,
                                                     swbt_torrent_handle_t** out_handle);
 
+// Add flags, for importing data that is already on disk.
+typedef enum swbt_add_flags_e {
+    // Trust the files: no hash check at add, each piece is verified the first time
+    // a peer requests it. Needs metadata (a .torrent or resume data with the info
+    // dict); ignored for bare magnets.
+    SWBT_ADD_SEED_MODE = 1 << 0,
+    // With resume data, trust its piece state without checking that the files
+    // exist and have the right sizes. Ignored without resume data.
+    SWBT_ADD_SKIP_CHECK = 1 << 1,
+    // Add stopped and queue a full check with the recheck scheduler (see
+    // swbt_session_configure_recheck); the torrent starts once it is checked.
+    SWBT_ADD_SCHEDULED_CHECK = 1 << 2
+} swbt_add_flags_e;
+
+// swbt_add_torrent_file_with_resume plus swbt_add_flags_e; resume_data may be NULL.
+swbt_error_code_e swbt_add_torrent_file_with_flags(swbt_session_t* session,
+                                                   const char* torrent_file_path,
+                                                   const char* save_path,
+                                                   const uint8_t* resume_data,
+                                                   int resume_size,
+                                                   uint32_t flags,
+                                                   swbt_torrent_handle_t** out_handle);
+
+// Bulk asynchronous add. Items are copied during the call, parsed/bdecoded on a
+// worker pool and submitted with async_add_torrent; each item produces exactly
+// one swbt_add_result_t (matched by user_tag) via swbt_session_poll_add_results.
+// Results are never dropped: when the queue is full they wait in the core until
+// polled. A result can still go missing if libtorrent's own alert queue
+// overflows (lt_overflow_events in swbt_alert_queue_stats_t grows); waiters
+// should watch that counter and not wait forever. Concurrent bulk adds need
+// distinct user_tags; all of them share one result queue.
+typedef enum swbt_add_source_e {
+    SWBT_ADD_SOURCE_FILE = 1,    // uri is a .torrent path; resume_data optional
+    SWBT_ADD_SOURCE_MAGNET = 2,  // uri is a magnet link; resume_data optional
+    SWBT_ADD_SOURCE_RESUME = 3   // resume_data only (must contain the info dict or info-hash)
+} swbt_add_source_e;
+
+typedef struct swbt_add_item_t {
+    int32_t source;              // swbt_add_source_e
+    const char* uri;
+    const char* save_path;       // optional, falls back to resume data, then session default
+    const uint8_t* resume_data;  // optional
+    int32_t resume_size;
+    uint64_t user_tag;           // echoed in the result
+    uint32_t flags;              // swbt_add_flags_e
+} swbt_add_item_t;
+
+typedef struct swbt_add_result_t {
+    uint64_t user_tag;
+    int32_t error_code;          // swbt_error_code_e
+    uint32_t torrent_id;         // session-local id, 0 on failure
+    char info_hash[65];
+    char message[256];           // error description, empty on success
+} swbt_add_result_t;
+
+// Returns the number of items queued; invalid items are reported as failed results.
+int swbt_session_add_torrents_async(swbt_session_t* session,
+                                    const swbt_add_item_t* items,
+                                    int count);
+
+int swbt_session_poll_add_results(swbt_session_t* session,
+                                  int timeout_ms,
+                                  swbt_add_result_t* out_results,
+                                  int max_count);
+
+// Built-in resume store: an append-only, checksummed log under a directory.
+// While a store is open, save_resume_data results are written to it instead of
+// being delivered through swbt_session_poll_resume.
+typedef struct swbt_resume_store_options_t {
+    int32_t checkpoint_interval_ms;  // request resume data for changed torrents this often; 0 = only on swbt_session_checkpoint
+    int32_t flush_interval_ms;       // batch window for disk writes; <= 0 uses 1000
+    int32_t fsync;                   // bool, sync after each batch
+    int64_t compact_min_dead_bytes;  // rewrite the log once this much is stale (and it outweighs live data); <= 0 uses 32 MiB
+} swbt_resume_store_options_t;
+
+typedef struct swbt_resume_store_stats_t {
+    int64_t live_records;
+    int64_t live_bytes;
+    int64_t dead_bytes;
+    int64_t file_bytes;
+    int64_t batches_written;
+    int64_t records_written;
+    int64_t compactions;
+    int64_t write_failures;     // batches that failed to write; they stay queued and are retried
+    int32_t last_write_error;   // errno of the latest failure, 0 once a batch is written again
+    int64_t queued_records;     // saves and erases waiting to be written
+} swbt_resume_store_stats_t;
+
+// options may be NULL for defaults (30 s checkpoints, 1 s batches, fsync on).
+// Torrents already in the session are marked for the next checkpoint.
+swbt_error_code_e swbt_session_open_resume_store(swbt_session_t* session,
+                                                 const char* directory,
+                                                 const swbt_resume_store_options_t* options);
+
+// Requests resume data for every changed torrent, waits up to timeout_ms for it
+// to arrive and writes it out. Returns the number of torrents requested.
+int swbt_session_checkpoint(swbt_session_t* session, int timeout_ms);
+
+// Re-adds every torrent in the store through the bulk add path. Returns the
+// number queued; outcomes arrive via swbt_session_poll_add_results with
+// user_tag set to the item's position in the restore batch.
+int swbt_session_restore_all(swbt_session_t* session);
+
+// Same, with user_tag = first_tag + position, so the results can be told apart
+// from those of other bulk adds in flight.
+int swbt_session_restore_all_tagged(swbt_session_t* session, uint64_t first_tag);
+
+swbt_error_code_e swbt_session_resume_store_stats(swbt_session_t* session,
+                                                  swbt_resume_store_stats_t* out_stats);
+
+// Magnet metadata cache: a directory of <info-hash>.torrent files. While it is
+// open, metadata fetched from peers (metadata_received) is written to it, and
+// magnet adds (single, with resume data and bulk) whose info-hash is cached
+// start with the metadata in place instead of asking peers for it again.
+// Entries are verified against the magnet's info-hash on use. Hybrid torrents
+// are stored under their v1 hash with a symlink under the v2 hash, so magnets
+// carrying either one hit. The least recently used entries are evicted past
+// the limits.
+typedef struct swbt_metadata_cache_options_t {
+    int64_t max_bytes;           // <= 0 uses 256 MiB
+    int64_t max_entries;         // 0 = no count limit
+} swbt_metadata_cache_options_t;
+
+// options may be NULL for defaults. SWBT_ERR_INVALID_ARG if a cache is already open.
+swbt_error_code_e swbt_session_open_metadata_cache(swbt_session_t* session,
+                                                   const char* directory,
+                                                   const swbt_metadata_cache_options_t* options);
+
+typedef struct swbt_metadata_cache_stats_t {
+    int32_t open;                // bool
+    int64_t entries;
+    int64_t bytes;
+    int64_t lookups;             // magnet adds that consulted the cache
+    int64_t hits;
+    int64_t corrupt;             // entries dropped for not matching their info-hash
+    int64_t stores;
+    int64_t evictions;
+    // Magnets that got their metadata from peers: time from add to metadata_received.
+    int64_t metadata_downloads;
+    int64_t time_to_metadata_total_ms;
+    int64_t time_to_metadata_max_ms;
+    int64_t time_to_metadata_last_ms;
+} swbt_metadata_cache_stats_t;
+
+// The time-to-metadata counters are kept with or without a cache.
+void swbt_session_metadata_cache_stats(swbt_session_t* session, swbt_metadata_cache_stats_t* out_stats);
+
+// Torrent creation. Pieces are hashed by libtorrent's disk threads, hash_threads
+// of them in parallel. Hidden files (names starting with '.') are skipped.
+typedef enum swbt_torrent_version_e {
+    SWBT_TORRENT_HYBRID = 0,   // v1 and v2 metadata, reachable by either swarm
+    SWBT_TORRENT_V1 = 1,
+    SWBT_TORRENT_V2 = 2
+} swbt_torrent_version_e;
+
+// Called on the creating thread after each hashed piece.
+typedef void (*swbt_create_progress_t)(void* context, int32_t pieces_done, int32_t num_pieces);
+
+typedef struct swbt_create_params_t {
+    const char* path;                 // file or directory to publish
+    int32_t version;                  // swbt_torrent_version_e
+    int32_t piece_size;               // power of two >= 16 KiB; 0 = chosen from the total size
+    int32_t hash_threads;             // 0 = one per core
+    int32_t is_private;               // bool
+    const char* const* trackers;      // optional announce URLs
+    const int32_t* tracker_tiers;     // optional, one per tracker; NULL = tier i for tracker i
+    int32_t num_trackers;
+    const char* const* web_seeds;     // optional BEP 19 URLs
+    int32_t num_web_seeds;
+    const char* comment;              // optional
+    const char* creator;              // optional
+    const char* output_path;          // optional: also write the .torrent file here
+    swbt_create_progress_t progress;  // optional
+    void* progress_context;
+} swbt_create_params_t;
+
+typedef struct swbt_create_result_t {
+    uint8_t* data;                    // bencoded .torrent, owned by the core
+    int32_t size;
+    char info_hash[65];               // hex id as elsewhere: v2 hash when present, else v1
+    int32_t num_pieces;
+    int32_t piece_size;
+    int64_t total_size;
+    char message[256];                // reason on failure
+} swbt_create_result_t;
+
+// Blocks until every piece is hashed. On failure out_result->message says why.
+swbt_error_code_e swbt_create_torrent(const swbt_create_params_t* params,
+                                      swbt_create_result_t* out_result);
+
+// Creates the torrent and adds it to the session in seed mode: the files were
+// just hashed, so libtorrent serves them without a recheck. out_handle is optional.
+swbt_error_code_e swbt_session_create_and_seed(swbt_session_t* session,
+                                               const swbt_create_params_t* params,
+                                               swbt_create_result_t* out_result,
+                                               swbt_torrent_handle_t** out_handle);
+
+void swbt_create_result_free(swbt_create_result_t* result);
+
 // Overview listing (id + name) without handles
 typedef struct swbt_torrent_overview_t {
     char info_hash[65];
     char name[256];
 } swbt_torrent_overview_t;
 
+// Answered from the core's cached torrent table; never blocks on the session thread.
 int swbt_session_list_overview(swbt_session_t* session,
                                swbt_torrent_overview_t* out_items,
                                int max_count);
 
-// Find torrent by hex info-hash and return a handle (caller owns and must free via remove_torrent)
+// Cached torrent snapshot. The core refreshes it from state_update_alerts it
+// requests every post_status_interval_ms, plus add/metadata/remove alerts.
+typedef struct swbt_torrent_snapshot_t {
+    uint32_t torrent_id;
+    char info_hash[65];
+    char name[256];
+    int32_t state;             // same values as swbt_torrent_status_t.state
+    int32_t has_metadata;      // bool
+    double progress;           // 0.0..1.0
+    int64_t total_wanted;      // bytes selected for download
+    int64_t total_wanted_done; // bytes of those already downloaded
+} swbt_torrent_snapshot_t;
+
+typedef struct swbt_snapshot_query_t {
+    int32_t offset;              // skip this many matches (paging)
+    int32_t state_filter;        // -1 = any state
+    int32_t only_incomplete;     // bool
+    const char* name_contains;   // optional substring filter (case-sensitive)
+} swbt_snapshot_query_t;
+
+// Writes up to max_count matching entries, ordered by torrent id. query may be
+// NULL (match all). out_total_matches (optional) receives the number of matches
+// ignoring offset/max_count.
+int swbt_session_query_snapshot(swbt_session_t* session,
+                                const swbt_snapshot_query_t* query,
+                                swbt_torrent_snapshot_t* out_items,
+                                int max_count,
+                                int* out_total_matches);
+
+// Milliseconds since the snapshot was last refreshed, -1 if never.
+int64_t swbt_session_snapshot_age_ms(swbt_session_t* session);
+
+// Find torrent by hex info-hash and return a handle (caller owns and must free via remove_torrent).
+// Accepts a v1 (40 hex chars) or v2 (64 hex chars) hash; hybrid torrents match either.
+// SWBT_ERR_GENERIC if no torrent matches, including for a string that isn't a hash.
 swbt_error_code_e swbt_session_find_torrent(swbt_session_t* session,
                                             const char* info_hash_hex,
                                             swbt_torrent_handle_t** out_handle);
 
+// Same as swbt_session_find_torrent with a binary hash: 20 bytes (SHA-1, v1) or 32 bytes (SHA-256, v2).
+swbt_error_code_e swbt_session_find_torrent_binary(swbt_session_t* session,
+                                                   const uint8_t* info_hash,
+                                                   int info_hash_len,
+                                                   swbt_torrent_handle_t** out_handle);
+
 // File metadata and priorities
 typedef struct swbt_file_info_t {
     int32_t index;
@@ -152,12 +530,230 @@ void swbt_torrent_set_file_priority(swbt_torrent_handle_t* handle,
                                     int index,
                                     int priority);
 
+// Whole file table in one call: one metadata fetch and one priority query, with
+// every path in a single NUL-separated arena instead of a buffer per file.
+typedef enum swbt_file_flags_e {
+    SWBT_FILE_PAD = 1 << 0,          // alignment padding, never written to disk
+    SWBT_FILE_HIDDEN = 1 << 1,
+    SWBT_FILE_EXECUTABLE = 1 << 2,
+    SWBT_FILE_SYMLINK = 1 << 3
+} swbt_file_flags_e;
+
+typedef struct swbt_file_entry_t {
+    int64_t size;
+    int64_t offset;
+    int64_t path_offset;             // into swbt_file_table_t.paths, NUL-terminated
+    int32_t path_len;
+    int32_t priority;                // 0=skip, 1..7 increasing priority
+    uint32_t flags;                  // swbt_file_flags_e
+} swbt_file_entry_t;
+
+typedef struct swbt_file_table_t {
+    int32_t count;
+    swbt_file_entry_t* files;
+    char* paths;
+    int64_t paths_len;
+} swbt_file_table_t;
+
+// Fills out_table (owned by the caller, release with swbt_file_table_free).
+// SWBT_ERR_GENERIC while the torrent has no metadata.
+swbt_error_code_e swbt_torrent_file_table(swbt_torrent_handle_t* handle, swbt_file_table_t* out_table);
+void swbt_file_table_free(swbt_file_table_t* table);
+
+typedef enum swbt_file_progress_flags_e {
+    // count only complete pieces; much cheaper on large torrents, but files
+    // smaller than a piece read 0 until the piece completes
+    SWBT_FILE_PROGRESS_PIECE_GRANULARITY = 1 << 0
+} swbt_file_progress_flags_e;
+
+// Downloaded bytes per file in file order. Returns the file count (0 without
+// metadata) and writes only when max_count is large enough.
+int swbt_torrent_file_progress(swbt_torrent_handle_t* handle,
+                               uint32_t flags,
+                               int64_t* out_bytes,
+                               int max_count);
+
+// All priorities at once, in file order; files past count get the default (4).
+swbt_error_code_e swbt_torrent_prioritize_files(swbt_torrent_handle_t* handle,
+                                                const int32_t* priorities,
+                                                int count);
+// Priorities for a subset of files; the others keep theirs.
+swbt_error_code_e swbt_torrent_set_file_priorities(swbt_torrent_handle_t* handle,
+                                                   const int32_t* indices,
+                                                   const int32_t* priorities,
+                                                   int count);
+
+// Connected peers, from libtorrent's get_peer_info.
+typedef enum swbt_peer_flags_e {
+    SWBT_PEER_INTERESTING = 1 << 0,         // we want pieces it has
+    SWBT_PEER_CHOKED = 1 << 1,              // we are choking it
+    SWBT_PEER_REMOTE_INTERESTED = 1 << 2,
+    SWBT_PEER_REMOTE_CHOKED = 1 << 3,       // it is choking us
+    SWBT_PEER_SNUBBED = 1 << 4,             // sent nothing for a while despite requests
+    SWBT_PEER_SEED = 1 << 5,
+    SWBT_PEER_UPLOAD_ONLY = 1 << 6,
+    SWBT_PEER_OUTGOING = 1 << 7,            // we connected to it
+    SWBT_PEER_UTP = 1 << 8,                 // uTP, otherwise TCP
+    SWBT_PEER_ENCRYPTED = 1 << 9,           // RC4 or plaintext-encrypted handshake
+    SWBT_PEER_SSL = 1 << 10,
+    SWBT_PEER_CONNECTING = 1 << 11,         // handshake not finished
+    SWBT_PEER_OPTIMISTIC_UNCHOKE = 1 << 12,
+    SWBT_PEER_ENDGAME = 1 << 13
+} swbt_peer_flags_e;
+
+typedef enum swbt_peer_source_e {
+    SWBT_PEER_SOURCE_TRACKER = 1 << 0,
+    SWBT_PEER_SOURCE_DHT = 1 << 1,
+    SWBT_PEER_SOURCE_PEX = 1 << 2,
+    SWBT_PEER_SOURCE_LSD = 1 << 3,
+    SWBT_PEER_SOURCE_RESUME_DATA = 1 << 4,
+    SWBT_PEER_SOURCE_INCOMING = 1 << 5
+} swbt_peer_source_e;
+
+typedef struct swbt_peer_info_t {
+    uint32_t torrent_id;            // swbt_session_peers: session-local id as in swbt_torrent_snapshot_t; else 0
+    char ip[46];                    // textual IPv4/IPv6 address
+    int32_t port;
+    char client[64];                // from the extension handshake or peer id
+    uint32_t flags;                 // swbt_peer_flags_e
+    uint32_t source;                // swbt_peer_source_e
+    int32_t download_rate;          // bytes/sec, including protocol overhead
+    int32_t upload_rate;
+    int32_t payload_download_rate;  // bytes/sec, piece data only
+    int32_t payload_upload_rate;
+    int64_t total_download;         // payload bytes over this connection
+    int64_t total_upload;
+    double progress;                // 0.0..1.0 of the peer's pieces
+    int32_t download_queue_length;  // our requests outstanding to the peer
+    int32_t upload_queue_length;    // its requests outstanding to us
+    int32_t send_queue_bytes;       // bytes waiting in our send buffer
+    int32_t pending_disk_bytes;     // bytes received and waiting to be written
+    int32_t rtt_ms;                 // estimated round-trip time
+    int32_t num_hashfails;
+} swbt_peer_info_t;
+
+// Writes up to max_count peers of one torrent. out_total (optional) receives
+// the number connected. Calls block on the session thread for the torrent.
+// The core keeps its own buffers across calls and formats in place, but
+// libtorrent still allocates per peer while building the list (client name,
+// piece bitfield), so each poll costs some short-lived heap traffic.
+int swbt_torrent_peers(swbt_torrent_handle_t* handle,
+                       swbt_peer_info_t* out_peers,
+                       int max_count,
+                       int* out_total);
+
+// Same for every torrent in the session, ordered by torrent id. Costs one
+// session round trip per torrent visited; with only_active, torrents the cached
+// snapshot shows without peers are skipped (peers connected since the last
+// snapshot refresh are missed until the next one).
+int swbt_session_peers(swbt_session_t* session,
+                       int only_active,
+                       swbt_peer_info_t* out_peers,
+                       int max_count,
+                       int* out_total);
+
+// Piece maps. Bitfields are packed MSB first as on the wire: piece i is bit
+// (7 - i % 8) of byte i / 8. Both getters return the torrent's piece count (0
+// without metadata) and write only when the buffer is large enough, so call
+// with NULL/0 first to size it.
+swbt_error_code_e swbt_torrent_piece_info(swbt_torrent_handle_t* handle,
+                                          int32_t* out_num_pieces,
+                                          int32_t* out_piece_length);
+// Pieces we have; needs (count + 7) / 8 bytes.
+int swbt_torrent_piece_bitfield(swbt_torrent_handle_t* handle,
+                                uint8_t* out_bits,
+                                int out_len);
+// Connected peers holding each piece, saturated at 255; needs count bytes.
+int swbt_torrent_piece_availability(swbt_torrent_handle_t* handle,
+                                    uint8_t* out_counts,
+                                    int out_len);
+
+// Pieces overlapping a file, [first, last); equal for empty files.
+typedef struct swbt_piece_range_t {
+    int32_t first;
+    int32_t last;
+} swbt_piece_range_t;
+
+// Writes up to max_count ranges in file order; returns the file count.
+int swbt_torrent_file_piece_ranges(swbt_torrent_handle_t* handle,
+                                   swbt_piece_range_t* out_ranges,
+                                   int max_count);
+
+// Helpers over caller memory; they need no session and work in any build.
+// Set bits in [first, last) of a bitfield of num_bits bits.
+int64_t swbt_bitfield_count(const uint8_t* bits, int num_bits, int first, int last);
+// Set bits per range, e.g. have-pieces per file from swbt_torrent_file_piece_ranges.
+void swbt_bitfield_count_ranges(const uint8_t* bits,
+                                int num_bits,
+                                const swbt_piece_range_t* ranges,
+                                int count,
+                                int32_t* out_counts);
+
+typedef struct swbt_availability_stats_t {
+    int32_t pieces;              // pieces considered
+    int32_t min_availability;    // copies of the rarest piece, -1 if none considered
+    int32_t pieces_at_min;       // how many pieces are that rare
+    int32_t unavailable;         // pieces no connected peer has
+    double mean_availability;
+    double distributed_copies;   // min plus the share of pieces above it
+} swbt_availability_stats_t;
+
+// Rarity over pieces [first, last) of an availability array. With have_bits,
+// pieces already had are skipped, which is what a scheduler asks about.
+void swbt_availability_stats(const uint8_t* availability,
+                             const uint8_t* have_bits,
+                             int first,
+                             int last,
+                             swbt_availability_stats_t* out_stats);
+
+// Streaming reads of one file. Reads wait for the pieces under the cursor and
+// keep piece deadlines on a read-ahead window that follows it; completed
+// pieces are read straight from the file on disk. Close every stream before
+// freeing its session.
+typedef struct swbt_stream_t { void* impl; } swbt_stream_t;
+
+typedef struct swbt_stream_options_t {
+    int64_t readahead_bytes;   // window ahead of the cursor given deadlines; <= 0 uses 8 MiB
+    int32_t deadline_ms;       // deadline of the piece under the cursor; <= 0 uses 1000
+    int32_t deadline_step_ms;  // added per piece further into the window; <= 0 uses 250
+} swbt_stream_options_t;
+
+// options may be NULL. Requires metadata. Streams read the file under the
+// save path, so sessions on SWBT_STORAGE_MEMORY, which keeps pieces in RAM
+// only, get SWBT_ERR_INVALID_ARG.
+swbt_error_code_e swbt_torrent_open_stream(swbt_session_t* session,
+                                           swbt_torrent_handle_t* handle,
+                                           int file_index,
+                                           const swbt_stream_options_t* options,
+                                           swbt_stream_t** out_stream);
+
+int64_t swbt_stream_size(swbt_stream_t* stream);
+
+// Reads up to len bytes at offset, returning as much as the contiguous pieces
+// already downloaded allow. Waits up to timeout_ms for the first piece; with
+// timeout_ms = 0, retry on SWBT_EVENT_PIECES instead of blocking a thread.
+// Returns bytes read, 0 at end of file, -1 on timeout, -2 on I/O error or once
+// the torrent has been removed.
+int64_t swbt_stream_read(swbt_stream_t* stream,
+                         int64_t offset,
+                         uint8_t* out_buf,
+                         int64_t len,
+                         int timeout_ms);
+
+// Clears the stream's piece deadlines, if its torrent is still in the session.
+void swbt_stream_close(swbt_stream_t* stream);
+
 // Alerts (simplified)
 typedef enum swbt_alert_type_e {
     SWBT_ALERT_TORRENT_FINISHED = 1,
     SWBT_ALERT_TORRENT_ERROR = 2,
     SWBT_ALERT_METADATA_RECEIVED = 3,
-    SWBT_ALERT_TRACKER_ERROR = 4
+    SWBT_ALERT_TRACKER_ERROR = 4,
+    SWBT_ALERT_SEED_GOAL_REACHED = 5,  // share ratio or seed time goal met (see swbt_queue_config_t)
+    SWBT_ALERT_RECHECK_STARTED = 6,    // the recheck scheduler started a check
+    SWBT_ALERT_RECHECK_PROGRESS = 7,   // every progress_step percent of a scheduled check
+    SWBT_ALERT_RECHECK_FINISHED = 8,   // error_code set if the check failed or the torrent went away
+    SWBT_ALERT_BLOCKLIST_LOADED = 9    // a blocklist load or clear finished; error_code set if it failed
 } swbt_alert_type_e;
 
 typedef struct swbt_alert_t {
@@ -165,6 +761,7 @@ typedef struct swbt_alert_t {
     char info_hash[65];
     int32_t error_code;     // if any
     char message[256];
+    float progress;         // SWBT_ALERT_RECHECK_*: share of the torrent checked
 } swbt_alert_t;
 
 int swbt_session_poll_alerts(swbt_session_t* session,
@@ -172,6 +769,62 @@ int swbt_session_poll_alerts(swbt_session_t* session,
                               swbt_alert_t* out_alerts,
                               int max_count);
 
+// Alert dispatcher queues. A single pump thread drains libtorrent alerts and
+// sorts them into bounded per-category queues; swbt_session_poll_updates,
+// swbt_session_poll_resume and swbt_session_poll_alerts each read only their
+// own queue, so running them concurrently no longer loses alerts. When the
+// status queue is full, further records wait in the core and coalesce to the
+// latest one per torrent; resume data waits in the core until polled and is
+// never dropped. Neither counts as dropped.
+typedef struct swbt_alert_queue_counters_t {
+    int64_t pushed;    // items accepted since session start
+    int64_t dropped;   // items rejected because the queue was full (consumer too slow)
+    int32_t depth;     // items currently waiting
+    int32_t capacity;
+} swbt_alert_queue_counters_t;
+
+typedef struct swbt_alert_queue_stats_t {
+    swbt_alert_queue_counters_t status;     // state_update_alert entries
+    swbt_alert_queue_counters_t deltas;     // swbt_status_delta_t records
+    swbt_alert_queue_counters_t resume;     // save_resume_data_alert
+    swbt_alert_queue_counters_t lifecycle;  // finished/metadata/error alerts
+    swbt_alert_queue_counters_t stats;      // session_stats_alert samples
+    swbt_alert_queue_counters_t add_results; // swbt_add_result_t from bulk adds
+    int64_t lt_overflow_events;             // alerts_dropped_alert seen (libtorrent's own queue overflowed)
+} swbt_alert_queue_stats_t;
+
+void swbt_session_alert_queue_stats(swbt_session_t* session,
+                                    swbt_alert_queue_stats_t* out_stats);
+
+// Event notification, so consumers can wait on the core instead of blocking a
+// thread in swbt_session_poll_*. After each batch of alerts the core reports
+// which queues received records; poll those with timeout_ms = 0.
+typedef enum swbt_event_e {
+    SWBT_EVENT_STATUS = 1 << 0,          // swbt_session_poll_updates
+    SWBT_EVENT_STATUS_DELTAS = 1 << 1,   // swbt_session_poll_status_deltas
+    SWBT_EVENT_RESUME_DATA = 1 << 2,     // swbt_session_poll_resume
+    SWBT_EVENT_ALERTS = 1 << 3,          // swbt_session_poll_alerts
+    SWBT_EVENT_SESSION_STATS = 1 << 4,   // swbt_session_poll_stats
+    SWBT_EVENT_ADD_RESULTS = 1 << 5,     // swbt_session_poll_add_results
+    SWBT_EVENT_PIECES = 1 << 6           // a piece finished while streams are open; retry swbt_stream_read
+} swbt_event_e;
+
+// Called on the core's alert thread with swbt_event_e bits. Must return quickly
+// and must not call back into the session. Pass NULL to unregister; once that
+// call returns the previous callback is no longer running.
+typedef void (*swbt_event_callback_t)(void* context, uint32_t events);
+void swbt_session_set_event_callback(swbt_session_t* session,
+                                     swbt_event_callback_t callback,
+                                     void* context);
+
+// Read end of a non-blocking pipe that becomes readable when events are pending
+// (for select/poll/kqueue/run loops). Drain it, then call swbt_session_take_events.
+// Owned by the session; -1 on failure.
+int swbt_session_event_fd(swbt_session_t* session);
+
+// Returns and clears the swbt_event_e bits raised since the last call.
+uint32_t swbt_session_take_events(swbt_session_t* session);
+
 // Storage and rate limits
 swbt_error_code_e swbt_torrent_move_storage(swbt_torrent_handle_t* handle,
                                             const char* new_path);
@@ -180,10 +833,510 @@ void swbt_session_set_rate_limits(swbt_session_t* session,
                                   int download_rate,
                                   int upload_rate);
 
+// Generic settings_pack access by libtorrent setting name ("aio_threads",
+// "connections_limit", "mixed_mode_algorithm", ...), applied at runtime.
+// alert_mask is owned by the core and rejected.
+typedef enum swbt_setting_type_e {
+    SWBT_SETTING_STRING = 0,
+    SWBT_SETTING_INT = 1,
+    SWBT_SETTING_BOOL = 2
+} swbt_setting_type_e;
+
+typedef struct swbt_setting_t {
+    const char* name;
+    int32_t type;           // swbt_setting_type_e, must match the setting
+    int64_t int_value;      // INT, and BOOL as 0/1
+    const char* str_value;  // STRING
+} swbt_setting_t;
+
+// Returns swbt_setting_type_e for name, or -1 if libtorrent has no such setting.
+int swbt_setting_type(const char* name);
+
+// Validates the whole batch, then applies it in one settings update. On an
+// invalid item nothing is applied and out_bad_index (optional) receives its index.
+swbt_error_code_e swbt_session_apply_settings(swbt_session_t* session,
+                                             const swbt_setting_t* items,
+                                             int count,
+                                             int* out_bad_index);
+
+// INT and BOOL settings (bools read as 0/1).
+swbt_error_code_e swbt_session_get_int_setting(swbt_session_t* session,
+                                               const char* name,
+                                               int64_t* out_value);
+swbt_error_code_e swbt_session_get_str_setting(swbt_session_t* session,
+                                               const char* name,
+                                               char* out_value,
+                                               int out_len);
+
+// Built-in tuning profiles, applied on top of the current settings.
+typedef enum swbt_settings_profile_e {
+    SWBT_PROFILE_SEEDBOX = 1,      // high-throughput seeding: libtorrent's high_performance_seed
+    SWBT_PROFILE_LOW_MEMORY = 2,   // small buffers and queues: libtorrent's min_memory_usage
+    SWBT_PROFILE_MANY_IDLE = 3     // thousands of mostly idle torrents: tight active limits, slow ticks
+} swbt_settings_profile_e;
+
+swbt_error_code_e swbt_session_apply_profile(swbt_session_t* session, int32_t profile);
+
 void swbt_torrent_set_rate_limits(swbt_torrent_handle_t* handle,
                                   int download_rate,
                                   int upload_rate);
 
+// Build and connectivity helpers
+// 0 when the core was built without SWBT_USE_LIBTORRENT and every call is a stub.
+int swbt_core_has_libtorrent(void);
+// Port the session is listening on, 0 if not listening.
+int swbt_session_listen_port(swbt_session_t* session);
+// Connect to a known peer directly, bypassing trackers and DHT.
+swbt_error_code_e swbt_torrent_connect_peer(swbt_torrent_handle_t* handle,
+                                            const char* ip,
+                                            int port);
+
+// Storage backend counters. A torrent that loses a verified piece to the memory
+// cap is rechecked by the core, which makes it download that piece again.
+typedef struct swbt_storage_stats_t {
+    int32_t backend;              // swbt_storage_backend_e in use
+    int64_t memory_cap_bytes;
+    int64_t resident_bytes;       // MEMORY: piece bytes held
+    int64_t evicted_pieces;       // MEMORY
+    int64_t bytes_read;           // MEMORY/MMAP only; zero for libtorrent's backends
+    int64_t bytes_written;
+} swbt_storage_stats_t;
+
+swbt_error_code_e swbt_session_storage_stats(swbt_session_t* session,
+                                             swbt_storage_stats_t* out_stats);
+
+// Sharded sessions. With config.shards > 1 the session runs that many
+// lt::session instances, each with its own network and disk threads, and routes
+// every torrent by info-hash (v1 when present). Callers still see one session:
+// adds, removes, lookups, status updates, alerts and counters are fanned out
+// and merged by the core. Shard i listens on listen_port + i (any free port when
+// listen_port is 0). Session rate limits are global; the core splits them between
+// shards every second by recent transfer, favouring shards running at their share.
+// Settings apply to every shard, except listen_interfaces, which is refused.
+// Saved state (settings, DHT) is taken from and restored into shard 0.
+typedef struct swbt_shard_info_t {
+    int32_t shard;
+    int32_t listen_port;
+    int32_t num_torrents;
+    int32_t download_rate_limit;  // this shard's current share, 0 = unlimited
+    int32_t upload_rate_limit;
+    int64_t download_rate;        // bytes/sec, from the latest status snapshot
+    int64_t upload_rate;
+} swbt_shard_info_t;
+
+// Returns the number of shards (1 for an unsharded session) and fills up to max_count.
+int swbt_session_shard_info(swbt_session_t* session,
+                            swbt_shard_info_t* out_shards,
+                            int max_count);
+
+// Queueing and seeding goals. Torrents are auto-managed: libtorrent runs at most
+// active_downloads / active_seeds of them and queues the rest by queue position.
+// On top of that the core checks share-ratio and seed-time goals as state
+// updates reach the alert pump (idle seeds, which post no updates, are checked
+// every few seconds). A torrent meeting its goal raises
+// SWBT_ALERT_SEED_GOAL_REACHED once and, with SWBT_GOAL_ACTION_PAUSE, is paused
+// and taken out of the queue. In a sharded session the active limits are per shard.
+typedef enum swbt_goal_action_e {
+    SWBT_GOAL_ACTION_NONE = 0,    // only raise the alert
+    SWBT_GOAL_ACTION_PAUSE = 1
+} swbt_goal_action_e;
+
+typedef struct swbt_queue_config_t {
+    int32_t active_downloads;         // -1 = unlimited, 0 = libtorrent default
+    int32_t active_seeds;             // -1 = unlimited, 0 = libtorrent default
+    int32_t active_checking;          // 0 = libtorrent default
+    int32_t active_limit;             // downloads + seeds; -1 = unlimited, 0 = libtorrent default
+    int32_t dont_count_slow_torrents; // bool: torrents below the slow-rate thresholds free their slot
+    int32_t demand_priority;          // bool: queued downloads ordered by swarm seeds, best seeded first
+    double share_ratio_goal;          // uploaded / size, 0 = none
+    int64_t seed_time_goal_s;         // seconds spent seeding, 0 = none
+    int32_t goal_action;              // swbt_goal_action_e
+} swbt_queue_config_t;
+
+swbt_error_code_e swbt_session_configure_queue(swbt_session_t* session,
+                                               const swbt_queue_config_t* config);
+
+// Per-torrent goals overriding the session's; negative values fall back to it,
+// 0 disables that goal for this torrent. Re-arms the goal alert.
+swbt_error_code_e swbt_session_set_torrent_goals(swbt_session_t* session,
+                                                 swbt_torrent_handle_t* handle,
+                                                 double share_ratio_goal,
+                                                 int64_t seed_time_goal_s);
+
+typedef enum swbt_queue_move_e {
+    SWBT_QUEUE_UP = 0,
+    SWBT_QUEUE_DOWN = 1,
+    SWBT_QUEUE_TOP = 2,
+    SWBT_QUEUE_BOTTOM = 3
+} swbt_queue_move_e;
+
+void swbt_torrent_queue_move(swbt_torrent_handle_t* handle, int32_t move);
+// Auto-managed torrents are started and stopped by the queue. swbt_torrent_pause
+// clears this flag and swbt_torrent_resume sets it again, but only on torrents
+// the pause took it from; setting it here in between overrides that.
+void swbt_torrent_set_auto_managed(swbt_torrent_handle_t* handle, int auto_managed);
+
+typedef struct swbt_queue_entry_t {
+    uint32_t torrent_id;
+    char info_hash[65];
+    int32_t queue_position;   // download queue slot, -1 once finished
+    int32_t state;
+    int32_t auto_managed;     // bool
+    int32_t paused;           // bool
+    int32_t seed_rank;        // libtorrent's seeding priority, higher runs first
+    int32_t num_complete;     // swarm seeds from the last scrape, -1 unknown
+    int32_t num_incomplete;   // swarm leechers, -1 unknown
+    double share_ratio;
+    int64_t seeding_s;
+    int32_t goal_reached;     // bool
+} swbt_queue_entry_t;
+
+// Download queue by position, then finished torrents by seed rank. Answered from
+// the core's snapshot. Returns entries written; out_total (optional) gets the count.
+int swbt_session_queue_snapshot(swbt_session_t* session,
+                                swbt_queue_entry_t* out_entries,
+                                int max_count,
+                                int* out_total);
+
+// Recheck scheduler. Scheduled checks start in request order as long as their
+// storage device (the st_dev of the save path) and the session are below their
+// limits, so one disk isn't read by several full checks at once. A torrent is
+// taken out of the auto-managed queue while it is checked and gets its queue
+// and pause state back afterwards.
+typedef struct swbt_recheck_config_t {
+    int32_t max_per_device;      // concurrent checks per device, <= 0 uses 1
+    int32_t max_total;           // across devices, 0 = unlimited; also caps the checks libtorrent starts itself
+    int32_t progress_step;       // percent between SWBT_ALERT_RECHECK_PROGRESS alerts, <= 0 uses 10
+} swbt_recheck_config_t;
+
+swbt_error_code_e swbt_session_configure_recheck(swbt_session_t* session,
+                                                 const swbt_recheck_config_t* config);
+
+// Queues a full hash check of the torrent's files. SWBT_ERR_INVALID_ARG if it
+// has no metadata yet; queuing a torrent twice is a no-op. A check starts only
+// once the torrent has finished loading its resume data.
+swbt_error_code_e swbt_session_recheck_torrent(swbt_session_t* session, swbt_torrent_handle_t* handle);
+// Checks without waiting for a free slot: the check bypasses max_per_device and
+// max_total but still reports SWBT_ALERT_RECHECK_*. SWBT_ERR_INVALID_ARG if the
+// torrent has no metadata yet or is no longer in the session.
+swbt_error_code_e swbt_torrent_force_recheck(swbt_torrent_handle_t* handle);
+
+typedef struct swbt_recheck_entry_t {
+    uint32_t torrent_id;
+    char info_hash[65];
+    int32_t checking;            // bool: started, else waiting for a slot
+    float progress;              // share checked while checking
+    uint64_t device;
+} swbt_recheck_entry_t;
+
+// Running checks first, then the queue in start order. Returns the total.
+int swbt_session_recheck_queue(swbt_session_t* session,
+                               swbt_recheck_entry_t* out_entries,
+                               int max_count);
+
+// Bandwidth groups, backed by libtorrent peer classes. Ids 0-2 are libtorrent's
+// built-in classes: GLOBAL holds every WAN peer, LOCAL the peers on private,
+// link-local and loopback networks (unlimited by default), TCP the peers on TCP
+// sockets. Created groups take peers two ways:
+//   - by IP range: matching peers join the group's peer class in addition to
+//     GLOBAL or LOCAL, and libtorrent enforces the group's limits and priority on
+//     them. Where ranges of different groups overlap, the last one added wins.
+//     Ranges apply to connections made after the change.
+//   - by torrent: the core splits the group's limits and connection cap between
+//     member torrents every second, by recent transfer, as per-torrent limits
+//     (replacing any set with swbt_torrent_set_rate_limits).
+// Up to 29 groups can be created.
+typedef enum swbt_bandwidth_group_builtin_e {
+    SWBT_BANDWIDTH_GROUP_GLOBAL = 0,
+    SWBT_BANDWIDTH_GROUP_TCP = 1,
+    SWBT_BANDWIDTH_GROUP_LOCAL = 2
+} swbt_bandwidth_group_builtin_e;
+
+typedef struct swbt_bandwidth_group_config_t {
+    int32_t download_rate_limit;      // bytes/sec, 0 = unlimited
+    int32_t upload_rate_limit;
+    int32_t download_priority;        // 1..255, share of a contended parent limit; 0 = 1
+    int32_t upload_priority;
+    int32_t max_connections;          // across member torrents, 0 = unlimited
+    int32_t connection_limit_factor;  // percent of the connection limit for peers matched by IP, 0 = 100
+    int32_t ignore_unchoke_slots;     // bool: peers matched by IP don't use up unchoke slots
+} swbt_bandwidth_group_config_t;
+
+// Returns the new group id, or -1 if the name is empty or no peer class is left.
+int32_t swbt_session_create_bandwidth_group(swbt_session_t* session,
+                                            const char* name,
+                                            const swbt_bandwidth_group_config_t* config);
+swbt_error_code_e swbt_session_configure_bandwidth_group(swbt_session_t* session,
+                                                         int32_t group,
+                                                         const swbt_bandwidth_group_config_t* config);
+// Built-in groups can't be deleted. Member torrents get their limits cleared.
+swbt_error_code_e swbt_session_delete_bandwidth_group(swbt_session_t* session, int32_t group);
+
+// group -1 takes the torrent out of its group and clears its limits.
+swbt_error_code_e swbt_session_set_torrent_bandwidth_group(swbt_session_t* session,
+                                                           swbt_torrent_handle_t* handle,
+                                                           int32_t group);
+// Inclusive range of IPv4 or IPv6 addresses, both of the same family.
+swbt_error_code_e swbt_session_add_bandwidth_group_range(swbt_session_t* session,
+                                                         int32_t group,
+                                                         const char* first_ip,
+                                                         const char* last_ip);
+swbt_error_code_e swbt_session_clear_bandwidth_group_ranges(swbt_session_t* session, int32_t group);
+
+typedef struct swbt_bandwidth_group_stats_t {
+    int32_t group;
+    char name[64];
+    swbt_bandwidth_group_config_t config;
+    int32_t num_torrents;             // member torrents
+    int64_t torrent_download_rate;    // bytes/sec summed over member torrents
+    int64_t torrent_upload_rate;
+    int32_t num_peers;                // include_peers only: peers in the group by IP, plus peers of member torrents
+    int64_t peer_download_rate;       // bytes/sec summed over those peers
+    int64_t peer_upload_rate;
+} swbt_bandwidth_group_stats_t;
+
+// Returns the number of groups and fills up to max_count, ordered by id. With
+// include_peers the core walks every torrent's peer list to attribute peers to
+// groups, so poll that at a modest rate.
+int swbt_session_bandwidth_groups(swbt_session_t* session,
+                                  int include_peers,
+                                  swbt_bandwidth_group_stats_t* out_groups,
+                                  int max_count);
+
+// Session performance counters. With a stats interval set, the core requests
+// libtorrent's session_stats on that cadence, keeps the two newest samples and
+// derives per-second rates from their difference. Counters are named as in
+// libtorrent's session_stats_metrics() ("net.recv_bytes", "disk.queued_disk_jobs").
+typedef enum swbt_metric_type_e {
+    SWBT_METRIC_COUNTER = 0,   // monotonic total
+    SWBT_METRIC_GAUGE = 1      // current level
+} swbt_metric_type_e;
+
+// A stable subset of the counters. Fields whose metric the linked libtorrent
+// does not provide read -1 (rates 0).
+typedef struct swbt_session_stats_t {
+    int64_t timestamp_us;
+    int64_t interval_us;              // since the previous sample, 0 for the first
+
+    int64_t peers_connected;          // peer.num_peers_connected
+    int64_t peers_half_open;          // peer.num_peers_half_open
+    int64_t peers_up_interested;      // peer.num_peers_up_interested
+    int64_t peers_down_interested;    // peer.num_peers_down_interested
+    int64_t peers_up_unchoked;        // peer.num_peers_up_unchoked
+    int64_t peers_down_unchoked;      // peer.num_peers_down_unchoked
+    int64_t peers_up_disk;            // peer.num_peers_up_disk: waiting on disk reads to send
+    int64_t peers_down_disk;          // peer.num_peers_down_disk: waiting on disk writes to receive
+
+    int64_t torrents_checking;        // ses.num_checking_torrents
+    int64_t torrents_downloading;     // ses.num_downloading_torrents
+    int64_t torrents_seeding;         // ses.num_seeding_torrents
+    int64_t torrents_queued;          // ses.num_queued_download_torrents + ses.num_queued_seeding_torrents
+    int64_t torrents_stopped;         // ses.num_stopped_torrents
+    int64_t torrents_error;           // ses.num_error_torrents
+
+    int64_t disk_queued_jobs;         // disk.queued_disk_jobs
+    int64_t disk_running_jobs;        // disk.num_running_disk_jobs
+    int64_t disk_queued_write_bytes;  // disk.queued_write_bytes
+    int64_t disk_blocks_in_use;       // disk.disk_blocks_in_use: disk buffers held
+    int64_t limiter_up_bytes;         // net.limiter_up_bytes: send bytes waiting for rate limit quota
+    int64_t limiter_down_bytes;       // net.limiter_down_bytes
+
+    int64_t recv_bytes;               // net.recv_bytes
+    int64_t sent_bytes;               // net.sent_bytes
+    int64_t alerts_dropped;           // core queue drops plus libtorrent alert queue overflows
+
+    double recv_bytes_per_s;          // net.recv_bytes
+    double sent_bytes_per_s;          // net.sent_bytes
+    double recv_payload_per_s;        // net.recv_payload_bytes
+    double sent_payload_per_s;        // net.sent_payload_bytes
+    double disk_blocks_read_per_s;    // disk.num_blocks_read (16 KiB blocks)
+    double disk_blocks_written_per_s; // disk.num_blocks_written
+    double disk_blocks_hashed_per_s;  // disk.num_blocks_hashed
+} swbt_session_stats_t;
+
+// Sampling cadence; 0 (the default) stops periodic sampling.
+void swbt_session_set_stats_interval(swbt_session_t* session, int interval_ms);
+// Requests one sample now.
+void swbt_session_post_stats(swbt_session_t* session);
+// Wait up to timeout_ms and collect samples in arrival order.
+int swbt_session_poll_stats(swbt_session_t* session,
+                            int timeout_ms,
+                            swbt_session_stats_t* out_stats,
+                            int max_count);
+
+// libtorrent's full metric list, fixed for the process.
+int swbt_stats_metric_count(void);
+const char* swbt_stats_metric_name(int index);   // NULL if out of range
+int swbt_stats_metric_type(int index);           // swbt_metric_type_e, -1 if out of range
+int swbt_stats_find_metric(const char* name);    // index, -1 if unknown
+
+// Newest sample of every metric, by metric index. out_rates (optional) receives
+// per-second rates for counters and the current value for gauges. Returns the
+// number of entries written, 0 before the first sample.
+int swbt_session_stats_values(swbt_session_t* session,
+                              int64_t* out_values,
+                              double* out_rates,
+                              int max_count,
+                              int64_t* out_timestamp_us);
+
+// Renders the newest sample plus the core's queue counters in the Prometheus
+// text exposition format (version 0.0.4). Writes at most buf_size - 1 bytes and
+// a terminating NUL; returns the full length, so a result >= buf_size means the
+// text was truncated. buf may be NULL with buf_size 0 to size the buffer.
+int swbt_session_stats_prometheus(swbt_session_t* session,
+                                  char* buf,
+                                  int buf_size);
+
+// IP blocklist, applied as the session's ip_filter. Files are read, parsed and
+// merged into sorted ranges on a background thread; the finished filter then
+// replaces the previous one (connected peers it covers are disconnected) and
+// SWBT_ALERT_BLOCKLIST_LOADED is posted. With several shards every shard gets
+// its own copy of libtorrent's filter and they are swapped one after another,
+// so memory grows with the shard count (see filter_memory_bytes). If a file can't be
+// read the previous list stays. A load still queued when the next is requested
+// is dropped, so periodic reloads don't pile up.
+//
+// Line formats, detected per line:
+//   P2P        some description:1.2.3.0-1.2.3.255
+//   DAT        001.002.003.000 - 001.002.003.255 , 000 , description
+//              (access level above 127 means allowed; such lines are skipped)
+//   CIDR       1.2.3.0/24, 2001:db8::/32; also plain ranges and single addresses
+// Blank lines and lines starting with '#' or '//' are ignored.
+swbt_error_code_e swbt_session_load_blocklist(swbt_session_t* session,
+                                              const char* const* paths,
+                                              int count);
+// Queued behind running loads like a load.
+void swbt_session_clear_blocklist(swbt_session_t* session);
+// 1 if the active blocklist covers ip, 0 if not, -1 if ip isn't an address.
+int swbt_session_blocklist_contains(swbt_session_t* session, const char* ip);
+
+typedef struct swbt_blocklist_stats_t {
+    int32_t loading;              // bool: a load or clear is queued or running
+    int32_t active;               // bool: a blocklist is applied
+    int64_t files;                // of the active list
+    int64_t lines;                // non-blank, non-comment lines
+    int64_t entries;              // ranges read, before merging
+    int64_t allowed_lines;        // DAT entries above level 127
+    int64_t malformed_lines;
+    int64_t ranges_v4;            // after merging
+    int64_t ranges_v6;
+    uint64_t addresses_v4;        // IPv4 addresses covered
+    int64_t memory_bytes;         // the core's range index (libtorrent keeps its own copies)
+    int32_t filter_copies;        // libtorrent ip_filters holding the list, one per shard
+    int64_t filter_memory_bytes;  // estimate for all of them: tree nodes of each range boundary
+    int64_t parse_ms;             // last load: reading, parsing and merging
+    int64_t apply_ms;             // last load: building and swapping in the session filter
+    int64_t loads;                // successful loads and clears
+    int64_t failed_loads;
+    uint64_t blocked_peers;       // peers refused by the filter since the session started
+    char last_error[256];         // of the last failed load
+} swbt_blocklist_stats_t;
+
+void swbt_session_blocklist_stats(swbt_session_t* session, swbt_blocklist_stats_t* out_stats);
+
+// Alert trace. While a trace runs, the pump copies every alert in the enabled
+// categories into a ring of fixed-size records in a memory-mapped file, without
+// allocating; the oldest records are overwritten once the ring is full. The
+// pages belong to the kernel, so the file is intact after a crash of the
+// process. `swiftybt-trace <file>` prints it as a timeline.
+typedef enum swbt_trace_category_e {
+    SWBT_TRACE_ERROR = 1 << 0,
+    SWBT_TRACE_PEER = 1 << 1,
+    SWBT_TRACE_PORT_MAPPING = 1 << 2,
+    SWBT_TRACE_STORAGE = 1 << 3,
+    SWBT_TRACE_TRACKER = 1 << 4,
+    SWBT_TRACE_CONNECT = 1 << 5,
+    SWBT_TRACE_STATUS = 1 << 6,
+    SWBT_TRACE_IP_BLOCK = 1 << 7,
+    SWBT_TRACE_PERFORMANCE = 1 << 8,
+    SWBT_TRACE_DHT = 1 << 9,
+    SWBT_TRACE_STATS = 1 << 10,
+    SWBT_TRACE_FILE_PROGRESS = 1 << 11,
+    SWBT_TRACE_PIECE_PROGRESS = 1 << 12,
+    SWBT_TRACE_BLOCK_PROGRESS = 1 << 13,
+    SWBT_TRACE_UPLOAD = 1 << 14,
+    SWBT_TRACE_MARK = 1 << 15       // swbt_session_trace_mark, always recorded
+} swbt_trace_category_e;
+
+// alert_type of a swbt_session_trace_mark record.
+#define SWBT_TRACE_TYPE_MARK 0xFFFF
+
+// File layout (host byte order): this header, name_count alert names of name_len
+// bytes each at names_offset (indexed by alert_type), then `capacity` records at
+// records_offset. Record seq n lives in slot (n - 1) % capacity; a slot whose
+// seq is 0 is empty or being written.
+typedef struct swbt_trace_header_t {
+    char magic[8];               // "SWBTTRC" NUL
+    uint32_t version;            // 2 (1 stored only the lowest category bit)
+    uint32_t record_size;        // sizeof(swbt_trace_record_t)
+    uint64_t capacity;
+    uint64_t names_offset;
+    uint32_t name_count;
+    uint32_t name_len;
+    uint64_t records_offset;
+    uint64_t next_seq;           // seq of the next record; next_seq - 1 were written
+    int64_t started_us;          // unix time, microseconds
+    uint32_t categories;         // swbt_trace_category_e at start
+    uint32_t reserved;
+} swbt_trace_header_t;
+
+// Payload by alert (anything else carries only the common fields):
+//   state_changed               value0 state, value1 previous state (swbt_torrent_status_t.state)
+//   add_torrent                 error_code, data = first 16 bytes of the info-hash (v2 if any)
+//   peer alerts                 data = IPv6 or IPv4-mapped address, value2 port
+//   peer_disconnected           + error_code;  peer_blocked: + value0 reason
+//   tracker_reply               value0 peers returned
+//   tracker_error               error_code, value0 failures in a row
+//   piece_finished, hash_failed value0 piece
+//   file_completed              value0 file index
+//   performance                 value0 libtorrent performance warning code
+//   listen_succeeded/failed     value2 port, error_code
+//   state_update                value0 torrents in the update
+//   alerts_dropped              value0 alert types dropped
+//   other errors                error_code
+//   mark                        data = label, NUL-padded
+typedef struct swbt_trace_record_t {
+    uint64_t seq;                // 1-based write order
+    int64_t time_us;             // unix time the alert was posted, microseconds
+    uint32_t torrent_id;         // session-local id; 0 for session alerts and async adds (see data)
+    uint16_t alert_type;         // libtorrent alert type, or SWBT_TRACE_TYPE_MARK
+    uint16_t category;           // swbt_trace_category_e bits of the alert within the traced ones
+    int64_t value0;
+    int64_t value1;
+    int32_t value2;
+    int32_t error_code;
+    uint8_t data[16];
+} swbt_trace_record_t;
+
+// Starts tracing into the file at path (replaced; capacity_records * 64 bytes
+// plus a small header), stopping a running trace first. The file's blocks are
+// allocated up front, so a disk too small for it fails here with
+// SWBT_ERR_GENERIC rather than while recording. Categories can widen the
+// session's alert mask; it is narrowed again on stop.
+swbt_error_code_e swbt_session_trace_start(swbt_session_t* session,
+                                           const char* path,
+                                           int64_t capacity_records,
+                                           uint32_t categories);
+// Syncs and closes the file. No-op without a running trace.
+void swbt_session_trace_stop(swbt_session_t* session);
+// SWBT_ERR_GENERIC without a running trace.
+swbt_error_code_e swbt_session_trace_set_categories(swbt_session_t* session, uint32_t categories);
+// Records a marker (first 16 bytes of label) to find a moment in the timeline.
+void swbt_session_trace_mark(swbt_session_t* session, const char* label);
+
+typedef struct swbt_trace_stats_t {
+    int32_t active;              // bool
+    uint32_t categories;
+    uint64_t records_written;    // since start, including overwritten ones
+    uint64_t capacity;
+} swbt_trace_stats_t;
+
+void swbt_session_trace_stats(swbt_session_t* session, swbt_trace_stats_t* out_stats);
+
+// Cumulative C++ allocations made on the calling thread. Returns 1 when the
+// core was built with SWBT_COUNT_ALLOCATIONS, 0 (counters stay zero) otherwise.
+int swbt_debug_thread_allocations(uint64_t* out_count, uint64_t* out_bytes);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
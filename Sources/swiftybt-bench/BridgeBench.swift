@@ -0,0 +1,248 @@
+import Foundation
+import SwiftyBitTorrent
+import SwiftyBitTorrentCore
+
+/// Per-call cost of the C bridge's hot paths with `count` torrents loaded, and of
+/// the Swift mapping layered on top. Torrents come from generated metadata with
+/// no payload on disk and no network, so nothing moves while calls are timed.
+///
+/// Allocation columns count C++ allocations on the calling thread and need a core
+/// built with `-Xcxx -DSWBT_COUNT_ALLOCATIONS`; without it they are -1. Swift-side
+/// allocations are not counted, so Swift rows report latency only.
+enum BridgeBench {
+    struct Options {
+        var fileCounts: [Int] = [1, 100, 1000]
+        var iterations = 5000
+    }
+
+    static func run(count: Int, options: Options, workDir: URL) async throws {
+        guard BTSession.hasLibtorrent else {
+            throw NSError(domain: "SwiftyBT", code: -1, userInfo: [
+                NSLocalizedDescriptionKey: "bridge benchmark needs the libtorrent-backed core; this build links the stubs"
+            ])
+        }
+        let urls = try SyntheticCorpus.generate(count: count, into: workDir.appendingPathComponent("corpus", isDirectory: true))
+        let session = BTSession(config: StartupBench.offlineConfig(workDir.appendingPathComponent("bridge")))
+        let results = await session.addTorrents(urls.map { BTAddItem(.file($0)) })
+        let loaded = results.filter { $0.succeeded }.count
+        guard loaded > 0 else {
+            throw NSError(domain: "SwiftyBT", code: -2, userInfo: [NSLocalizedDescriptionKey: "no torrents loaded"])
+        }
+        // let the missing-file checks finish so states are stable while timing
+        try await Task.sleep(nanoseconds: 3_000_000_000)
+
+        let base: [String: Any] = ["bench": "bridge", "torrents": loaded, "counting_allocations": countingAllocations]
+        session.withUnsafeCoreSession { raw in
+            let ids = overviewIDs(raw, count: loaded)
+            emit(base, "c.list_overview", measure(iterations: min(options.iterations, 200)) { _ in
+                _ = overviewBuffer.withUnsafeMutableBufferPointer { swbt_session_list_overview(raw, $0.baseAddress, Int32($0.count)) }
+            })
+            emit(base, "c.find_torrent", measure(iterations: options.iterations) { i in
+                var h: UnsafeMutablePointer<swbt_torrent_handle_t>?
+                _ = ids[i % ids.count].withUnsafeBufferPointer { swbt_session_find_torrent(raw, $0.baseAddress, &h) }
+                swbt_torrent_handle_free(h)
+            })
+
+            let handles = ids.prefix(256).compactMap { findHandle(raw, $0) }
+            defer { handles.forEach { swbt_torrent_handle_free($0) } }
+            var status = swbt_torrent_status_t()
+            emit(base, "c.torrent_status", measure(iterations: options.iterations) { i in
+                _ = swbt_torrent_status(handles[i % handles.count], &status)
+            })
+        }
+        measureStatusUpdates(session, ids: session.withUnsafeCoreSession { overviewIDs($0, count: loaded) } ?? [], base: base)
+
+        for files in options.fileCounts {
+            try await measureFiles(session, files: files, iterations: options.iterations, workDir: workDir, base: base)
+        }
+        measurePieceHelpers(base: base)
+    }
+
+    // MARK: - piece map helpers
+
+    /// Piece map aggregation over caller memory for a 1M-piece torrent split into
+    /// 100k files; no session involved.
+    private static func measurePieceHelpers(base: [String: Any]) {
+        let pieces = 1 << 20
+        let files = 100_000
+        var rng = SystemRandomNumberGenerator()
+        let have = (0..<(pieces + 7) / 8).map { _ in UInt8.random(in: 0...255, using: &rng) }
+        let availability = (0..<pieces).map { _ in UInt8.random(in: 0...40, using: &rng) }
+        let step = pieces / files
+        let ranges = (0..<files).map { swbt_piece_range_t(first: Int32($0 * step), last: Int32($0 * step + step)) }
+        var counts = [Int32](repeating: 0, count: files)
+        var stats = swbt_availability_stats_t()
+        var row = base
+        row["pieces"] = pieces
+        row["ranges"] = files
+
+        have.withUnsafeBufferPointer { bits in
+            emit(row, "c.bitfield_count", measure(iterations: 200) { _ in
+                _ = swbt_bitfield_count(bits.baseAddress, Int32(pieces), 0, Int32(pieces))
+            })
+            ranges.withUnsafeBufferPointer { r in
+                counts.withUnsafeMutableBufferPointer { c in
+                    emit(row, "c.bitfield_count_ranges", measure(iterations: 200) { _ in
+                        swbt_bitfield_count_ranges(bits.baseAddress, Int32(pieces), r.baseAddress, Int32(files), c.baseAddress)
+                    })
+                }
+            }
+            availability.withUnsafeBufferPointer { a in
+                emit(row, "c.availability_stats", measure(iterations: 200) { _ in
+                    swbt_availability_stats(a.baseAddress, nil, 0, Int32(pieces), &stats)
+                })
+                emit(row, "c.availability_stats.missing_only", measure(iterations: 200) { _ in
+                    swbt_availability_stats(a.baseAddress, bits.baseAddress, 0, Int32(pieces), &stats)
+                })
+            }
+        }
+    }
+
+    // MARK: - status updates
+
+    /// Each round pauses or resumes up to one ring's worth of torrents so they all
+    /// report a change, asks for an update, then drains it: even rounds through the
+    /// C call, odd rounds through `pollStatusUpdates` (C call plus Swift mapping).
+    private static func measureStatusUpdates(_ session: BTSession, ids: [[CChar]], base: [String: Any]) {
+        let batch = 256
+        let touched = Array(ids.prefix(16384))
+        var cSamples = LatencySamples(capacity: 1024)
+        var swiftSamples = LatencySamples(capacity: 1024)
+        var cRecords = 0
+        var swiftRecords = 0
+        var buffer = Array(repeating: swbt_torrent_status_t(), count: batch)
+
+        for round in 0..<6 {
+            session.withUnsafeCoreSession { raw in
+                for id in touched {
+                    guard let h = findHandle(raw, id) else { continue }
+                    if round % 2 == 0 { swbt_torrent_pause(h) } else { swbt_torrent_resume(h) }
+                    swbt_torrent_handle_free(h)
+                }
+                // registers this thread as a consumer and discards anything stale
+                while buffer.withUnsafeMutableBufferPointer({ swbt_session_poll_updates(raw, 0, $0.baseAddress, Int32(batch)) }) > 0 {}
+                swbt_session_post_torrent_updates(raw)
+            }
+            Thread.sleep(forTimeInterval: 1.0)
+
+            while true {
+                let start = DispatchTime.now().uptimeNanoseconds
+                let n: Int
+                if round % 2 == 0 {
+                    n = Int(session.withUnsafeCoreSession { raw in
+                        buffer.withUnsafeMutableBufferPointer { swbt_session_poll_updates(raw, 0, $0.baseAddress, Int32(batch)) }
+                    } ?? 0)
+                } else {
+                    n = session.pollStatusUpdates(timeoutMs: 0, batch: batch).count
+                }
+                guard n > 0 else { break }
+                let ns = Double(DispatchTime.now().uptimeNanoseconds - start) / Double(n)
+                if round % 2 == 0 { cSamples.append(ns); cRecords += n } else { swiftSamples.append(ns); swiftRecords += n }
+            }
+        }
+        // per-record latency: each sample is one drain call divided by the records it returned
+        emit(base, "c.poll_updates.per_record", cSamples, extra: ["records": cRecords, "batch": batch])
+        emit(base, "swift.pollStatusUpdates.per_record", swiftSamples, extra: ["records": swiftRecords, "batch": batch])
+    }
+
+    // MARK: - file table
+
+    private static func measureFiles(_ session: BTSession, files: Int, iterations: Int, workDir: URL, base: [String: Any]) async throws {
+        let url = workDir.appendingPathComponent("files-\(files).torrent")
+        let bytes = SyntheticCorpus.multiFileTorrentBytes(name: "bridge-files-\(files)", files: files, fileSize: 64 << 10, pieceLength: 256 << 10)
+        try Data(bytes).write(to: url)
+        let torrent = try await session.addTorrent(fileURL: url)
+        let id = Array(torrent.id().utf8CString)
+        var row = base
+        row["files"] = files
+
+        session.withUnsafeCoreSession { raw in
+            guard let h = findHandle(raw, id) else { return }
+            defer { swbt_torrent_handle_free(h) }
+            var info = swbt_file_info_t()
+            emit(row, "c.torrent_file_info", measure(iterations: iterations) { i in
+                _ = swbt_torrent_file_info(h, Int32(i % files), &info)
+            })
+            // whole table per sample, compare against files x c.torrent_file_info
+            let tableIterations = max(1, min(iterations, 200_000 / files))
+            emit(row, "c.torrent_file_table", measure(iterations: tableIterations) { _ in
+                var table = swbt_file_table_t()
+                _ = swbt_torrent_file_table(h, &table)
+                swbt_file_table_free(&table)
+            })
+            var progress = [Int64](repeating: 0, count: files)
+            emit(row, "c.torrent_file_progress.piece_granularity", measure(iterations: tableIterations) { _ in
+                _ = progress.withUnsafeMutableBufferPointer {
+                    swbt_torrent_file_progress(h, UInt32(SWBT_FILE_PROGRESS_PIECE_GRANULARITY.rawValue), $0.baseAddress, Int32($0.count))
+                }
+            })
+        }
+        var swiftSamples = LatencySamples(capacity: 64)
+        for _ in 0..<max(1, min(iterations, 200_000 / files)) {
+            let start = DispatchTime.now().uptimeNanoseconds
+            let list = torrent.files()
+            swiftSamples.append(Double(DispatchTime.now().uptimeNanoseconds - start))
+            precondition(list.count == files)
+        }
+        emit(row, "swift.files", swiftSamples)
+    }
+
+    // MARK: - helpers
+
+    private static var overviewBuffer: [swbt_torrent_overview_t] = []
+
+    private static func overviewIDs(_ raw: UnsafeMutablePointer<swbt_session_t>, count: Int) -> [[CChar]] {
+        overviewBuffer = Array(repeating: swbt_torrent_overview_t(), count: max(count, 1))
+        let n = overviewBuffer.withUnsafeMutableBufferPointer { swbt_session_list_overview(raw, $0.baseAddress, Int32($0.count)) }
+        var ids = (0..<Int(max(n, 0))).map { i -> [CChar] in
+            var item = overviewBuffer[i]
+            return withUnsafeBytes(of: &item.info_hash) { Array($0.bindMemory(to: CChar.self)) }
+        }
+        ids.shuffle()
+        return ids
+    }
+
+    private static func findHandle(_ raw: UnsafeMutablePointer<swbt_session_t>, _ id: [CChar]) -> UnsafeMutablePointer<swbt_torrent_handle_t>? {
+        var h: UnsafeMutablePointer<swbt_torrent_handle_t>?
+        let rc = id.withUnsafeBufferPointer { swbt_session_find_torrent(raw, $0.baseAddress, &h) }
+        return rc == SWBT_OK ? h : nil
+    }
+
+    private static var countingAllocations: Bool { swbt_debug_thread_allocations(nil, nil) != 0 }
+
+    struct Measurement {
+        var latency: LatencySamples
+        var allocs: UInt64
+        var allocBytes: UInt64
+    }
+
+    /// Times each call on this thread; allocation counters bracket the whole loop.
+    private static func measure(iterations: Int, _ body: (Int) -> Void) -> Measurement {
+        var latency = LatencySamples(capacity: iterations)
+        var c0: UInt64 = 0, b0: UInt64 = 0, c1: UInt64 = 0, b1: UInt64 = 0
+        swbt_debug_thread_allocations(&c0, &b0)
+        for i in 0..<iterations {
+            let start = DispatchTime.now().uptimeNanoseconds
+            body(i)
+            latency.append(Double(DispatchTime.now().uptimeNanoseconds - start))
+        }
+        swbt_debug_thread_allocations(&c1, &b1)
+        return Measurement(latency: latency, allocs: c1 - c0, allocBytes: b1 - b0)
+    }
+
+    private static func emit(_ base: [String: Any], _ op: String, _ m: Measurement) {
+        let calls = Double(max(m.latency.values.count, 1))
+        emit(base, op, m.latency, extra: [
+            "allocs_per_call": countingAllocations ? Double(m.allocs) / calls : -1,
+            "alloc_bytes_per_call": countingAllocations ? Double(m.allocBytes) / calls : -1
+        ])
+    }
+
+    private static func emit(_ base: [String: Any], _ op: String, _ samples: LatencySamples, extra: [String: Any] = [:]) {
+        var row = base
+        row["op"] = op
+        row.merge(samples.summary()) { $1 }
+        row.merge(extra) { $1 }
+        emitResult(row)
+    }
+}
@@ -0,0 +1,143 @@
+import Foundation
+
+/// Minimal bencode writer, enough to emit .torrent files for benchmarks.
+enum Bencode {
+    static func string(_ bytes: [UInt8]) -> [UInt8] { Array("\(bytes.count):".utf8) + bytes }
+    static func string(_ s: String) -> [UInt8] { string(Array(s.utf8)) }
+    static func int(_ v: Int64) -> [UInt8] { Array("i\(v)e".utf8) }
+
+    static func list(_ items: [[UInt8]]) -> [UInt8] {
+        var out: [UInt8] = [UInt8(ascii: "l")]
+        for i in items { out += i }
+        out.append(UInt8(ascii: "e"))
+        return out
+    }
+
+    /// Keys are emitted in raw byte order as the spec requires.
+    static func dict(_ entries: [(String, [UInt8])]) -> [UInt8] {
+        var out: [UInt8] = [UInt8(ascii: "d")]
+        for (k, v) in entries.sorted(by: { Array($0.0.utf8).lexicographicallyPrecedes(Array($1.0.utf8)) }) {
+            out += string(k)
+            out += v
+        }
+        out.append(UInt8(ascii: "e"))
+        return out
+    }
+}
+
+/// Generates synthetic single-file torrents. Piece hashes are random, so the
+/// payload never verifies; these are for add/restore paths, not transfers.
+enum SyntheticCorpus {
+    static func randomBytes(_ count: Int) -> [UInt8] {
+        (0..<count).map { _ in UInt8.random(in: 0...255) }
+    }
+
+    static func torrentBytes(name: String, size: Int64, pieceLength: Int64) -> [UInt8] {
+        let pieces = Int((size + pieceLength - 1) / pieceLength)
+        let info = Bencode.dict([
+            ("length", Bencode.int(size)),
+            ("name", Bencode.string(name)),
+            ("piece length", Bencode.int(pieceLength)),
+            ("pieces", Bencode.string(randomBytes(pieces * 20)))
+        ])
+        return Bencode.dict([("info", info)])
+    }
+
+    /// Multi-file variant: `files` entries of `fileSize` bytes under a `name` directory.
+    static func multiFileTorrentBytes(name: String, files: Int, fileSize: Int64, pieceLength: Int64) -> [UInt8] {
+        let pieces = Int((Int64(files) * fileSize + pieceLength - 1) / pieceLength)
+        let entries = (0..<files).map { i in
+            Bencode.dict([
+                ("length", Bencode.int(fileSize)),
+                ("path", Bencode.list([Bencode.string("dir\(i / 100)"), Bencode.string("file-\(i).bin")]))
+            ])
+        }
+        let info = Bencode.dict([
+            ("files", Bencode.list(entries)),
+            ("name", Bencode.string(name)),
+            ("piece length", Bencode.int(pieceLength)),
+            ("pieces", Bencode.string(randomBytes(pieces * 20)))
+        ])
+        return Bencode.dict([("info", info)])
+    }
+
+    /// Writes `count` .torrent files into `dir` and returns their URLs.
+    static func generate(count: Int, into dir: URL, size: Int64 = 4 << 20, pieceLength: Int64 = 256 << 10) throws -> [URL] {
+        try FileManager.default.createDirectory(at: dir, withIntermediateDirectories: true)
+        var urls: [URL] = []
+        urls.reserveCapacity(count)
+        for i in 0..<count {
+            let url = dir.appendingPathComponent("t\(i).torrent")
+            let bytes = torrentBytes(name: "bench-\(i)", size: size, pieceLength: pieceLength)
+            try Data(bytes).write(to: url)
+            urls.append(url)
+        }
+        return urls
+    }
+}
+
+/// Random payload files with real piece hashes, for transfers that must verify.
+enum SwarmPayload {
+    /// Writes `size` random bytes to `file` and returns a .torrent for it.
+    static func create(name: String, size: Int64, pieceLength: Int64, file: URL) throws -> [UInt8] {
+        FileManager.default.createFile(atPath: file.path, contents: nil)
+        let out = try FileHandle(forWritingTo: file)
+        defer { try? out.close() }
+
+        var pieces: [UInt8] = []
+        var piece = [UInt8](repeating: 0, count: Int(pieceLength))
+        var remaining = size
+        var rng = SystemRandomNumberGenerator()
+        while remaining > 0 {
+            let n = Int(min(pieceLength, remaining))
+            piece.withUnsafeMutableBytes { buf in
+                // fill 8 bytes at a time; byte-wise random is far too slow for GBs
+                let words = buf.bindMemory(to: UInt64.self)
+                for i in 0..<words.count { words[i] = rng.next() }
+            }
+            let chunk = piece[0..<n]
+            chunk.withUnsafeBytes { pieces += SHA1.digest($0) }
+            out.write(Data(chunk))
+            remaining -= Int64(n)
+        }
+
+        let info = Bencode.dict([
+            ("length", Bencode.int(size)),
+            ("name", Bencode.string(name)),
+            ("piece length", Bencode.int(pieceLength)),
+            ("pieces", Bencode.string(pieces))
+        ])
+        return Bencode.dict([("info", info)])
+    }
+}
+
+/// Monotonic stopwatch in seconds.
+struct Stopwatch {
+    private let start = DispatchTime.now().uptimeNanoseconds
+    var elapsed: Double { Double(DispatchTime.now().uptimeNanoseconds - start) / 1e9 }
+}
+
+/// Latency samples in nanoseconds.
+struct LatencySamples {
+    private(set) var values: [Double] = []
+
+    init(capacity: Int) { values.reserveCapacity(capacity) }
+
+    mutating func append(_ ns: Double) { values.append(ns) }
+
+    /// p50/p90/p99/max keyed for `emitResult`; empty when nothing was recorded.
+    func summary() -> [String: Any] {
+        guard !values.isEmpty else { return [:] }
+        let sorted = values.sorted()
+        func at(_ q: Double) -> Double { sorted[min(sorted.count - 1, Int(Double(sorted.count) * q))] }
+        return ["calls": sorted.count, "p50_ns": at(0.50), "p90_ns": at(0.90), "p99_ns": at(0.99), "max_ns": sorted.last!]
+    }
+}
+
+/// One JSON object per line on stdout so results can be diffed and collected by CI.
+func emitResult(_ fields: [String: Any]) {
+    if let data = try? JSONSerialization.data(withJSONObject: fields, options: [.sortedKeys]),
+       let line = String(data: data, encoding: .utf8) {
+        print(line)
+    }
+}
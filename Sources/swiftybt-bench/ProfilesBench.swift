@@ -0,0 +1,74 @@
+import Foundation
+import SwiftyBitTorrent
+
+/// Loads the same corpus into one session per settings profile (and one on defaults)
+/// and reports add time, snapshot query latency and resident memory growth.
+/// Profiles run one after another in this process, so `rss_delta_bytes` is only
+/// indicative; pass `--profile` to measure a single profile in a fresh process.
+enum ProfilesBench {
+    static func run(count: Int, workDir: URL, only: String?) async throws {
+        let corpusDir = workDir.appendingPathComponent("corpus", isDirectory: true)
+        let urls = try SyntheticCorpus.generate(count: count, into: corpusDir)
+
+        let candidates: [(String, BTSettingsProfile?)] = [
+            ("defaults", nil),
+            ("seedbox", .seedbox),
+            ("low-memory", .lowMemory),
+            ("many-idle", .manyIdle)
+        ]
+        for (name, profile) in candidates where only == nil || only == name {
+            try await measure(name: name, profile: profile, urls: urls, workDir: workDir)
+        }
+    }
+
+    private static func measure(name: String, profile: BTSettingsProfile?, urls: [URL], workDir: URL) async throws {
+        let rssBefore = residentBytes()
+        let session = BTSession(config: StartupBench.offlineConfig(workDir.appendingPathComponent("profile-\(name)")))
+        if let profile { try session.applyProfile(profile) }
+
+        let addClock = Stopwatch()
+        let results = await session.addTorrents(urls.map { BTAddItem(.file($0)) })
+        let addSeconds = addClock.elapsed
+
+        // let checking and the first snapshot refreshes settle
+        try await Task.sleep(nanoseconds: 3_000_000_000)
+
+        var latencies: [Double] = []
+        for _ in 0..<200 {
+            let clock = Stopwatch()
+            _ = session.querySnapshot(limit: 1000)
+            latencies.append(clock.elapsed * 1e6)
+        }
+        latencies.sort()
+
+        emitResult([
+            "bench": "profiles",
+            "profile": name,
+            "count": urls.count,
+            "add_s": addSeconds,
+            "add_failures": results.filter { !$0.succeeded }.count + (urls.count - results.count),
+            "snapshot_p50_us": latencies[latencies.count / 2],
+            "snapshot_p99_us": latencies[latencies.count * 99 / 100],
+            "rss_delta_bytes": residentBytes() - rssBefore
+        ])
+    }
+}
+
+/// Resident set size of this process, 0 where unsupported.
+func residentBytes() -> Int64 {
+#if canImport(Darwin)
+    var info = mach_task_basic_info()
+    var count = mach_msg_type_number_t(MemoryLayout<mach_task_basic_info>.size / MemoryLayout<natural_t>.size)
+    let kr = withUnsafeMutablePointer(to: &info) { ptr in
+        ptr.withMemoryRebound(to: integer_t.self, capacity: Int(count)) {
+            task_info(mach_task_self_, task_flavor_t(MACH_TASK_BASIC_INFO), $0, &count)
+        }
+    }
+    return kr == KERN_SUCCESS ? Int64(info.resident_size) : 0
+#else
+    guard let statm = try? String(contentsOfFile: "/proc/self/statm", encoding: .utf8) else { return 0 }
+    let fields = statm.split(separator: " ")
+    guard fields.count > 1, let pages = Int64(fields[1]) else { return 0 }
+    return pages * Int64(sysconf(Int32(_SC_PAGESIZE)))
+#endif
+}
@@ -0,0 +1,69 @@
+import Foundation
+#if canImport(CryptoKit)
+import CryptoKit
+#endif
+
+/// SHA-1 for v1 piece hashes of generated payloads. Uses CryptoKit where it exists
+/// and a plain implementation elsewhere (Linux has no system hash in Foundation).
+enum SHA1 {
+    static func digest(_ bytes: UnsafeRawBufferPointer) -> [UInt8] {
+#if canImport(CryptoKit)
+        return Array(Insecure.SHA1.hash(data: bytes))
+#else
+        return portable(bytes)
+#endif
+    }
+
+    static func portable(_ bytes: UnsafeRawBufferPointer) -> [UInt8] {
+        var h: (UInt32, UInt32, UInt32, UInt32, UInt32) = (0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0)
+        let bitLength = UInt64(bytes.count) * 8
+        var tail = [UInt8](bytes[(bytes.count / 64 * 64)...])
+        tail.append(0x80)
+        while tail.count % 64 != 56 { tail.append(0) }
+        for i in (0..<8).reversed() { tail.append(UInt8(truncatingIfNeeded: bitLength >> (UInt64(i) * 8))) }
+
+        var w = [UInt32](repeating: 0, count: 80)
+        func block(_ p: UnsafeRawBufferPointer) {
+            for i in 0..<16 {
+                w[i] = UInt32(p[i * 4]) << 24 | UInt32(p[i * 4 + 1]) << 16 | UInt32(p[i * 4 + 2]) << 8 | UInt32(p[i * 4 + 3])
+            }
+            for i in 16..<80 {
+                let x = w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16]
+                w[i] = x << 1 | x >> 31
+            }
+            var (a, b, c, d, e) = h
+            for i in 0..<80 {
+                let f: UInt32
+                let k: UInt32
+                switch i {
+                case 0..<20: f = (b & c) | (~b & d); k = 0x5A827999
+                case 20..<40: f = b ^ c ^ d; k = 0x6ED9EBA1
+                case 40..<60: f = (b & c) | (b & d) | (c & d); k = 0x8F1BBCDC
+                default: f = b ^ c ^ d; k = 0xCA62C1D6
+                }
+                let t = (a << 5 | a >> 27) &+ f &+ e &+ k &+ w[i]
+                e = d
+                d = c
+                c = b << 30 | b >> 2
+                b = a
+                a = t
+            }
+            h = (h.0 &+ a, h.1 &+ b, h.2 &+ c, h.3 &+ d, h.4 &+ e)
+        }
+
+        let full = bytes.count / 64
+        for i in 0..<full {
+            block(UnsafeRawBufferPointer(rebasing: bytes[(i * 64)..<(i * 64 + 64)]))
+        }
+        tail.withUnsafeBytes { t in
+            for i in 0..<(t.count / 64) {
+                block(UnsafeRawBufferPointer(rebasing: t[(i * 64)..<(i * 64 + 64)]))
+            }
+        }
+        var out: [UInt8] = []
+        for v in [h.0, h.1, h.2, h.3, h.4] {
+            out += [UInt8(v >> 24), UInt8(v >> 16 & 0xFF), UInt8(v >> 8 & 0xFF), UInt8(v & 0xFF)]
+        }
+        return out
+    }
+}
@@ -0,0 +1,49 @@
+import Foundation
+import SwiftyBitTorrent
+
+/// Measures how long it takes to get a generated corpus into a session: one
+/// synchronous add per torrent versus a single bulk `addTorrents` call.
+enum StartupBench {
+    static func run(count: Int, workDir: URL) async throws {
+        let corpusDir = workDir.appendingPathComponent("corpus", isDirectory: true)
+        let genClock = Stopwatch()
+        let urls = try SyntheticCorpus.generate(count: count, into: corpusDir)
+        let generateSeconds = genClock.elapsed
+
+        let sequential = BTSession(config: offlineConfig(workDir.appendingPathComponent("seq")))
+        let seqClock = Stopwatch()
+        var seqFailures = 0
+        for url in urls {
+            do { _ = try await sequential.addTorrent(fileURL: url) } catch { seqFailures += 1 }
+        }
+        let sequentialSeconds = seqClock.elapsed
+
+        let bulk = BTSession(config: offlineConfig(workDir.appendingPathComponent("bulk")))
+        let bulkClock = Stopwatch()
+        let results = await bulk.addTorrents(urls.map { BTAddItem(.file($0)) })
+        let bulkSeconds = bulkClock.elapsed
+
+        emitResult([
+            "bench": "startup",
+            "count": count,
+            "generate_s": generateSeconds,
+            "sequential_s": sequentialSeconds,
+            "sequential_failures": seqFailures,
+            "bulk_s": bulkSeconds,
+            "bulk_failures": results.filter { !$0.succeeded }.count + (count - results.count),
+            "speedup": bulkSeconds > 0 ? sequentialSeconds / bulkSeconds : 0
+        ])
+    }
+
+    /// No discovery or port mapping: the benchmark must not touch the network.
+    static func offlineConfig(_ savePath: URL) -> BTSessionConfig {
+        BTSessionConfig(
+            savePath: savePath,
+            listenPort: 0,
+            enableDHT: false,
+            enableLSD: false,
+            enableUPnP: false,
+            enableNATPMP: false
+        )
+    }
+}
@@ -0,0 +1,187 @@
+import Foundation
+import SwiftyBitTorrent
+
+/// End-to-end transfer over loopback: one seeder and N leecher sessions in this
+/// process, DHT/LSD off, leechers dialling the seeder directly. Every piece is
+/// real (random payload, real hashes), so the numbers include hashing and disk.
+/// One result line per (storage backend, piece size, torrent count); the payload
+/// is split evenly across that configuration's torrents. The memory backend cannot
+/// seed a payload that only exists on disk, so with it only the leechers use RAM
+/// and the seeder reads through the posix backend.
+enum SwarmBench {
+    struct Options {
+        var totalBytes: Int64 = 256 << 20
+        var pieceSizesKiB: [Int] = [256, 1024, 4096]
+        var torrentCounts: [Int] = [1, 8]
+        var leechers = 1
+        var timeoutSeconds: Double = 300
+        var backends: [BTStorageBackend] = [.default]
+        var readaheadBytes: Int64 = 0
+        var memoryCapBytes: Int64 = 0
+    }
+
+    static func run(options: Options, workDir: URL) async throws {
+        guard BTSession.hasLibtorrent else {
+            // the stub core accepts every call and never moves a byte
+            throw NSError(domain: "SwiftyBT", code: -1, userInfo: [
+                NSLocalizedDescriptionKey: "swarm benchmark needs the libtorrent-backed core; this build links the stubs"
+            ])
+        }
+        for backend in options.backends {
+            for pieceKiB in options.pieceSizesKiB {
+                for torrents in options.torrentCounts {
+                    try await measure(backend: backend, pieceLength: Int64(pieceKiB) << 10, torrents: torrents, options: options,
+                                      workDir: workDir.appendingPathComponent("swarm-\(backend)-\(pieceKiB)k-\(torrents)t", isDirectory: true))
+                }
+            }
+        }
+    }
+
+    /// Loopback only, and several sessions share 127.0.0.1.
+    static func loopbackSettings() -> [String: BTSettingValue] {
+        [
+            "listen_interfaces": .string("127.0.0.1:0"),
+            "allow_multiple_connections_per_ip": .bool(true),
+            "enable_incoming_utp": .bool(false),
+            "enable_outgoing_utp": .bool(false)
+        ]
+    }
+
+    static func backendName(_ backend: BTStorageBackend) -> String {
+        switch backend {
+        case .default: return "default"
+        case .posix: return "posix"
+        case .memory: return "memory"
+        case .mmap: return "mmap"
+        }
+    }
+
+    /// Parses a comma-separated list such as "posix,mmap"; nil if any name is unknown.
+    static func backends(named list: String) -> [BTStorageBackend]? {
+        let names = list.split(separator: ",").map(String.init)
+        let backends = names.compactMap { name in BTStorageBackend.allCases.first { backendName($0) == name } }
+        return !backends.isEmpty && backends.count == names.count ? backends : nil
+    }
+
+    private static func config(_ savePath: URL, backend: BTStorageBackend, options: Options) -> BTSessionConfig {
+        var config = StartupBench.offlineConfig(savePath)
+        config.storageBackend = backend
+        config.storageReadaheadBytes = options.readaheadBytes
+        config.storageMemoryCapBytes = options.memoryCapBytes
+        return config
+    }
+
+    private static func measure(backend: BTStorageBackend, pieceLength: Int64, torrents: Int, options: Options, workDir: URL) async throws {
+        let fm = FileManager.default
+        let seedDir = workDir.appendingPathComponent("seed", isDirectory: true)
+        let metaDir = workDir.appendingPathComponent("meta", isDirectory: true)
+        try fm.createDirectory(at: seedDir, withIntermediateDirectories: true)
+        try fm.createDirectory(at: metaDir, withIntermediateDirectories: true)
+
+        let perTorrent = max(pieceLength, options.totalBytes / Int64(torrents))
+        var torrentFiles: [URL] = []
+        let genClock = Stopwatch()
+        for i in 0..<torrents {
+            let name = "payload-\(i).bin"
+            let meta = try SwarmPayload.create(name: name, size: perTorrent, pieceLength: pieceLength,
+                                               file: seedDir.appendingPathComponent(name))
+            let url = metaDir.appendingPathComponent("\(name).torrent")
+            try Data(meta).write(to: url)
+            torrentFiles.append(url)
+        }
+        let generateSeconds = genClock.elapsed
+
+        let seeder = BTSession(config: config(seedDir, backend: backend == .memory ? .posix : backend, options: options))
+        try seeder.applySettings(loopbackSettings())
+        var seeds: [BTTorrent] = []
+        for url in torrentFiles { seeds.append(try await seeder.addTorrent(fileURL: url)) }
+        let checkClock = Stopwatch()
+        guard await waitComplete(seeds, timeout: options.timeoutSeconds) else {
+            throw NSError(domain: "SwiftyBT", code: -2, userInfo: [NSLocalizedDescriptionKey: "seeder never finished checking"])
+        }
+        let seedCheckSeconds = checkClock.elapsed
+        let port = seeder.listenPort
+
+        var leechers: [BTSession] = []
+        var downloads: [[BTTorrent]] = []
+        for l in 0..<options.leechers {
+            let session = BTSession(config: config(workDir.appendingPathComponent("leech-\(l)", isDirectory: true), backend: backend, options: options))
+            try session.applySettings(loopbackSettings())
+            leechers.append(session)
+            var mine: [BTTorrent] = []
+            for url in torrentFiles { mine.append(try await session.addTorrent(fileURL: url)) }
+            downloads.append(mine)
+        }
+
+        let cpuBefore = cpuSeconds()
+        let clock = Stopwatch()
+        for mine in downloads {
+            for t in mine { try t.connectPeer(ip: "127.0.0.1", port: port) }
+        }
+        var completion = [Double?](repeating: nil, count: options.leechers)
+        while clock.elapsed < options.timeoutSeconds {
+            for (l, mine) in downloads.enumerated() where completion[l] == nil {
+                if mine.allSatisfy({ $0.status().progress >= 1.0 }) { completion[l] = clock.elapsed }
+            }
+            if completion.allSatisfy({ $0 != nil }) { break }
+            try await Task.sleep(nanoseconds: 100_000_000)
+        }
+        let elapsed = clock.elapsed
+        let cpu = cpuSeconds() - cpuBefore
+
+        let finished = completion.compactMap { $0 }
+        let leechStorage = leechers.compactMap { $0.storageStats() }
+        let movedBytes = Double(perTorrent) * Double(torrents) * Double(finished.count)
+        let gigabytes = movedBytes / Double(1 << 30)
+        emitResult([
+            "bench": "swarm",
+            "backend": backendName(backend),
+            "piece_kib": Int(pieceLength >> 10),
+            "torrents": torrents,
+            "leechers": options.leechers,
+            "bytes_per_leecher": perTorrent * Int64(torrents),
+            "generate_s": generateSeconds,
+            "seed_check_s": seedCheckSeconds,
+            "seed_check_mb_per_s": seedCheckSeconds > 0 ? Double(perTorrent) * Double(torrents) / seedCheckSeconds / 1e6 : 0,
+            "completed_leechers": finished.count,
+            "elapsed_s": elapsed,
+            "complete_s_max": finished.max() ?? -1,
+            "complete_s_min": finished.min() ?? -1,
+            "mb_per_s": elapsed > 0 ? movedBytes / elapsed / 1e6 : 0,
+            "cpu_s_per_gb": gigabytes > 0 ? cpu / gigabytes : -1,
+            "peak_rss_bytes": peakResidentBytes(),
+            "leech_resident_bytes_max": leechStorage.map { $0.residentBytes }.max() ?? 0,
+            "leech_evicted_pieces": leechStorage.reduce(0) { $0 + $1.evictedPieces }
+        ])
+
+        withExtendedLifetime((seeder, leechers)) {}
+        try? fm.removeItem(at: workDir)
+    }
+
+    private static func waitComplete(_ torrents: [BTTorrent], timeout: Double) async -> Bool {
+        let clock = Stopwatch()
+        while clock.elapsed < timeout {
+            if torrents.allSatisfy({ $0.status().progress >= 1.0 }) { return true }
+            try? await Task.sleep(nanoseconds: 100_000_000)
+        }
+        return false
+    }
+
+    /// User plus system CPU time of this process; all sessions live here.
+    private static func cpuSeconds() -> Double {
+        var ru = rusage()
+        getrusage(RUSAGE_SELF, &ru)
+        return Double(ru.ru_utime.tv_sec) + Double(ru.ru_utime.tv_usec) / 1e6
+            + Double(ru.ru_stime.tv_sec) + Double(ru.ru_stime.tv_usec) / 1e6
+    }
+
+    private static func peakResidentBytes() -> Int64 {
+        var ru = rusage()
+        getrusage(RUSAGE_SELF, &ru)
+#if canImport(Darwin)
+        return Int64(ru.ru_maxrss)          // bytes on Darwin
+#else
+        return Int64(ru.ru_maxrss) * 1024   // KiB on Linux
+#endif
+    }
+}
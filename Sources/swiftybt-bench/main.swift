@@ -0,0 +1,119 @@
+import Foundation
+import Dispatch
+
+struct Bench {
+    static func run() async throws {
+        var args = Array(CommandLine.arguments.dropFirst())
+        guard let suite = args.first else {
+            fputs("Usage: swiftybt-bench <startup|profiles|swarm|bridge> [--count N] [--dir <path>] [--profile <name>]\n"
+                  + "       swarm: [--size-mb N] [--piece-kib 256,1024] [--torrents 1,8] [--leechers N] [--timeout S]\n"
+                  + "              [--backends default,posix,memory,mmap] [--readahead-kib N] [--memory-cap-mb N]\n"
+                  + "       bridge: [--files 1,100,1000] [--iterations N]\n", stderr)
+            exit(2)
+        }
+        args.removeFirst()
+
+        var count = 10_000
+        var profile: String?
+        var swarm = SwarmBench.Options()
+        var bridge = BridgeBench.Options()
+        var workDir = FileManager.default.temporaryDirectory.appendingPathComponent("swiftybt-bench-\(getpid())", isDirectory: true)
+        var i = 0
+        while i < args.count {
+            let a = args[i]
+            if a == "--count", i + 1 < args.count, let n = Int(args[i + 1]) {
+                count = n
+                i += 2
+                continue
+            }
+            if a == "--profile", i + 1 < args.count {
+                profile = args[i + 1]
+                i += 2
+                continue
+            }
+            if a == "--dir", i + 1 < args.count {
+                workDir = URL(fileURLWithPath: args[i + 1], isDirectory: true)
+                i += 2
+                continue
+            }
+            if i + 1 < args.count, parseSwarmOption(a, args[i + 1], into: &swarm) || parseBridgeOption(a, args[i + 1], into: &bridge) {
+                i += 2
+                continue
+            }
+            fputs("Unknown argument: \(a)\n", stderr)
+            exit(2)
+        }
+
+        try FileManager.default.createDirectory(at: workDir, withIntermediateDirectories: true)
+        switch suite {
+        case "startup":
+            try await StartupBench.run(count: count, workDir: workDir)
+        case "profiles":
+            try await ProfilesBench.run(count: count, workDir: workDir, only: profile)
+        case "swarm":
+            try await SwarmBench.run(options: swarm, workDir: workDir)
+        case "bridge":
+            try await BridgeBench.run(count: count, options: bridge, workDir: workDir)
+        default:
+            fputs("Unknown suite: \(suite)\n", stderr)
+            exit(2)
+        }
+        exit(0)
+    }
+
+    private static func parseSwarmOption(_ name: String, _ value: String, into o: inout SwarmBench.Options) -> Bool {
+        let list = value.split(separator: ",").compactMap { Int($0) }
+        switch name {
+        case "--size-mb":
+            guard let n = Int64(value) else { return false }
+            o.totalBytes = n << 20
+        case "--piece-kib":
+            guard !list.isEmpty else { return false }
+            o.pieceSizesKiB = list
+        case "--torrents":
+            guard !list.isEmpty else { return false }
+            o.torrentCounts = list
+        case "--leechers":
+            guard let n = Int(value), n > 0 else { return false }
+            o.leechers = n
+        case "--timeout":
+            guard let s = Double(value) else { return false }
+            o.timeoutSeconds = s
+        case "--backends":
+            guard let backends = SwarmBench.backends(named: value) else { return false }
+            o.backends = backends
+        case "--readahead-kib":
+            guard let n = Int64(value), n >= 0 else { return false }
+            o.readaheadBytes = n << 10
+        case "--memory-cap-mb":
+            guard let n = Int64(value), n >= 0 else { return false }
+            o.memoryCapBytes = n << 20
+        default:
+            return false
+        }
+        return true
+    }
+
+    private static func parseBridgeOption(_ name: String, _ value: String, into o: inout BridgeBench.Options) -> Bool {
+        switch name {
+        case "--files":
+            let list = value.split(separator: ",").compactMap { Int($0) }.filter { $0 > 0 }
+            guard !list.isEmpty else { return false }
+            o.fileCounts = list
+        case "--iterations":
+            guard let n = Int(value), n > 0 else { return false }
+            o.iterations = n
+        default:
+            return false
+        }
+        return true
+    }
+}
+
+Task {
+    do { try await Bench.run() } catch {
+        fputs("\(error)\n", stderr)
+        exit(1)
+    }
+}
+dispatchMain()
@@ -0,0 +1,239 @@
+import Foundation
+import SwiftyBitTorrentCore
+
+// Prints an alert trace written by swbt_session_trace_start (BTSession.startTrace)
+// as a timeline, oldest record first. The file carries its own alert name table,
+// so a trace can be read on a machine with a different libtorrent.
+
+let usage = """
+    Usage: swiftybt-trace <file> [--torrent ID] [--type NAME] [--category NAME] [--last N] [--summary]
+           categories: \(TraceFile.categoryNames.joined(separator: ","))
+           --category matches alerts in that category among others; traces from
+           older cores (version 1) only kept an alert's lowest category
+
+    """
+
+struct TraceFile {
+    static let categoryNames = ["error", "peer", "port_mapping", "storage", "tracker", "connect", "status", "ip_block",
+                                "performance", "dht", "stats", "file_progress", "piece_progress", "block_progress",
+                                "upload", "mark"]
+
+    let header: swbt_trace_header_t
+    let names: [String]
+    let records: [swbt_trace_record_t]   // published records in seq order
+
+    init(path: String) throws {
+        let data = try Data(contentsOf: URL(fileURLWithPath: path), options: .alwaysMapped)
+        let headerSize = MemoryLayout<swbt_trace_header_t>.size
+        let recordSize = MemoryLayout<swbt_trace_record_t>.size
+        guard data.count >= headerSize else { throw TraceFile.error("\(path): too short for a trace header") }
+        let parsed = try data.withUnsafeBytes { raw -> (swbt_trace_header_t, [String], [swbt_trace_record_t]) in
+            var h = raw.loadUnaligned(as: swbt_trace_header_t.self)
+            let magic = withUnsafeBytes(of: &h.magic) { Array($0) }
+            guard magic == Array("SWBTTRC\0".utf8) else { throw TraceFile.error("\(path): not a trace file") }
+            // version 1 stored only the lowest category bit; filtering works on either
+            guard h.version == 1 || h.version == 2, h.record_size == UInt32(recordSize) else {
+                throw TraceFile.error("\(path): unsupported trace version \(h.version)")
+            }
+            let namesEnd = Int(h.names_offset) + Int(h.name_count) * Int(h.name_len)
+            let recordsEnd = Int(h.records_offset) + Int(h.capacity) * recordSize
+            guard namesEnd <= raw.count, recordsEnd <= raw.count else { throw TraceFile.error("\(path): truncated") }
+
+            var names: [String] = []
+            names.reserveCapacity(Int(h.name_count))
+            for i in 0..<Int(h.name_count) {
+                let start = Int(h.names_offset) + i * Int(h.name_len)
+                let bytes = raw[start..<(start + Int(h.name_len))].prefix { $0 != 0 }
+                names.append(String(decoding: bytes, as: UTF8.self))
+            }
+
+            var records: [swbt_trace_record_t] = []
+            for slot in 0..<Int(h.capacity) {
+                let r = raw.loadUnaligned(fromByteOffset: Int(h.records_offset) + slot * recordSize, as: swbt_trace_record_t.self)
+                // empty, or caught mid-write while the session was still running
+                guard r.seq != 0, Int((r.seq - 1) % h.capacity) == slot else { continue }
+                records.append(r)
+            }
+            records.sort { $0.seq < $1.seq }
+            return (h, names, records)
+        }
+        header = parsed.0
+        names = parsed.1
+        records = parsed.2
+    }
+
+    func name(of r: swbt_trace_record_t) -> String {
+        if Int32(r.alert_type) == SWBT_TRACE_TYPE_MARK { return "mark" }
+        let i = Int(r.alert_type)
+        return i < names.count && !names[i].isEmpty ? names[i] : "type#\(i)"
+    }
+
+    static func categoryName(_ bits: UInt16) -> String {
+        guard bits != 0 else { return "-" }
+        return (0..<16).filter { bits & (UInt16(1) << UInt16($0)) != 0 }
+            .map { $0 < categoryNames.count ? categoryNames[$0] : "bit\($0)" }
+            .joined(separator: "+")
+    }
+
+    static func error(_ message: String) -> NSError {
+        NSError(domain: "SwiftyBT", code: 1, userInfo: [NSLocalizedDescriptionKey: message])
+    }
+}
+
+let isoFormatter = ISO8601DateFormatter()
+
+func timestamp(_ us: Int64) -> String {
+    let seconds = us >= 0 ? us / 1_000_000 : (us - 999_999) / 1_000_000
+    let date = Date(timeIntervalSince1970: TimeInterval(seconds))
+    return String(isoFormatter.string(from: date).dropLast()) + String(format: ".%06lldZ", us - seconds * 1_000_000)
+}
+
+func dataBytes(_ r: swbt_trace_record_t) -> [UInt8] {
+    var d = r.data
+    return withUnsafeBytes(of: &d) { Array($0) }
+}
+
+func hex(_ bytes: [UInt8]) -> String {
+    bytes.map { String(format: "%02x", $0) }.joined()
+}
+
+func endpoint(_ bytes: [UInt8], port: Int32) -> String {
+    if bytes[0..<10].allSatisfy({ $0 == 0 }) && bytes[10] == 0xFF && bytes[11] == 0xFF {
+        return bytes[12..<16].map { String($0) }.joined(separator: ".") + ":\(port)"
+    }
+    let groups = stride(from: 0, to: 16, by: 2).map { String(UInt16(bytes[$0]) << 8 | UInt16(bytes[$0 + 1]), radix: 16) }
+    return "[" + groups.joined(separator: ":") + "]:\(port)"
+}
+
+let stateNames = [1: "checking_files", 2: "downloading_metadata", 3: "downloading", 4: "finished", 5: "seeding",
+                  7: "checking_resume_data"]
+
+func stateName(_ v: Int64) -> String {
+    stateNames[Int(v)] ?? "state\(v)"
+}
+
+// Payload as documented with swbt_trace_record_t.
+func describe(_ r: swbt_trace_record_t, name: String) -> String {
+    let bytes = dataBytes(r)
+    var parts: [String] = []
+    switch name {
+    case "mark":
+        parts.append("\"" + String(decoding: bytes.prefix { $0 != 0 }, as: UTF8.self) + "\"")
+    case "state_changed":
+        parts.append("\(stateName(r.value1)) -> \(stateName(r.value0))")
+    case "add_torrent":
+        parts.append("hash=\(hex(bytes))")
+    case "state_update":
+        parts.append("torrents=\(r.value0)")
+    case "piece_finished", "hash_failed":
+        parts.append("piece=\(r.value0)")
+    case "file_completed":
+        parts.append("file=\(r.value0)")
+    case "tracker_reply":
+        parts.append("peers=\(r.value0)")
+    case "tracker_error":
+        parts.append("failures=\(r.value0)")
+    case "performance":
+        parts.append("warning=\(r.value0)")
+    case "listen_succeeded", "listen_failed":
+        parts.append("port=\(r.value2)")
+    case "alerts_dropped":
+        parts.append("types=\(r.value0)")
+    default:
+        if r.value2 != 0 && bytes.contains(where: { $0 != 0 }) {
+            parts.append("peer=\(endpoint(bytes, port: r.value2))")
+            if name == "peer_blocked" { parts.append("reason=\(r.value0)") }
+        }
+    }
+    if r.error_code != 0 { parts.append("error=\(r.error_code)") }
+    return parts.joined(separator: " ")
+}
+
+func fail(_ message: String) -> Never {
+    fputs(message.hasSuffix("\n") ? message : message + "\n", stderr)
+    exit(2)
+}
+
+var args = Array(CommandLine.arguments.dropFirst())
+guard let path = args.first, !path.hasPrefix("--") else { fail(usage) }
+args.removeFirst()
+
+var torrentFilter: UInt32?
+var typeFilter: String?
+var categoryFilter: UInt16?
+var last: Int?
+var summary = false
+var i = 0
+while i < args.count {
+    let a = args[i]
+    if a == "--summary" {
+        summary = true
+        i += 1
+        continue
+    }
+    guard i + 1 < args.count else { fail("Missing value for \(a)\n" + usage) }
+    let v = args[i + 1]
+    switch a {
+    case "--torrent":
+        guard let n = UInt32(v) else { fail("Bad torrent id: \(v)") }
+        torrentFilter = n
+    case "--type":
+        typeFilter = v
+    case "--category":
+        guard let bit = TraceFile.categoryNames.firstIndex(of: v) else { fail("Unknown category: \(v)\n" + usage) }
+        categoryFilter = UInt16(1) << UInt16(bit)
+    case "--last":
+        guard let n = Int(v), n > 0 else { fail("Bad count: \(v)") }
+        last = n
+    default:
+        fail("Unknown argument: \(a)\n" + usage)
+    }
+    i += 2
+}
+
+let trace: TraceFile
+do {
+    trace = try TraceFile(path: path)
+} catch {
+    fail(error.localizedDescription)
+}
+
+var selected = trace.records.filter { r in
+    if let t = torrentFilter, r.torrent_id != t { return false }
+    if let c = categoryFilter, r.category & c == 0 { return false }
+    if let n = typeFilter, trace.name(of: r) != n { return false }
+    return true
+}
+if let n = last, selected.count > n { selected.removeFirst(selected.count - n) }
+
+if summary {
+    let written = trace.header.next_seq - 1
+    print("started    \(timestamp(trace.header.started_us))")
+    print("records    \(trace.records.count) of \(written) written, capacity \(trace.header.capacity)")
+    if let first = selected.first, let end = selected.last {
+        print("span       \(timestamp(first.time_us)) .. \(timestamp(end.time_us))")
+    }
+    var byType: [String: Int] = [:]
+    var torrents: [UInt32: String] = [:]
+    for r in selected {
+        byType[trace.name(of: r), default: 0] += 1
+        if r.torrent_id != 0 && trace.name(of: r) == "add_torrent" { torrents[r.torrent_id] = hex(dataBytes(r)) }
+    }
+    for (name, count) in byType.sorted(by: { $0.value != $1.value ? $0.value > $1.value : $0.key < $1.key }) {
+        print(String(format: "%10d ", count) + name)
+    }
+    for (id, hash) in torrents.sorted(by: { $0.key < $1.key }) {
+        print("torrent \(id) \(hash)")
+    }
+    exit(0)
+}
+
+var previous: Int64?
+for r in selected {
+    let delta = previous.map { String(format: "+%.6f", Double(r.time_us - $0) / 1e6) } ?? "+0.000000"
+    previous = r.time_us
+    let torrent = r.torrent_id != 0 ? "t\(r.torrent_id)" : "-"
+    let name = trace.name(of: r)
+    let line = "\(timestamp(r.time_us)) \(delta) #\(r.seq) \(torrent) \(TraceFile.categoryName(r.category))/\(name) \(describe(r, name: name))"
+    print(line.trimmingCharacters(in: .whitespaces))
+}